@@ -1,154 +1,629 @@
-// #include <jni.h>
-// #include <string>
-// #include <vector>
-// #include <thread>
-// #include <mutex>
-// #include <atomic>
-// // Remove deque if TTS ring buffer is no longer needed here
-
-// #include "dart_api_dl.h"
-// #include <android/log.h>
-// #define APPNAME "AIBridgeCPP_LLM"
-
-// // --- Global State for LLM ---
-// std::atomic<bool> g_is_llm_processing_active(false); // To control the LLM loop if needed
-// std::thread g_llm_thread;
-// // Mutex and CV for LLM input queue if you implement one
-// std::mutex g_llm_input_mutex;
-// std::condition_variable g_llm_input_cv;
-// std::string g_llm_input_text;
-
-
-// Dart_Port g_llm_token_port = ILLEGAL_PORT;
-// Dart_Port g_llm_error_port = ILLEGAL_PORT;
-
-
-// void SendStringToDart(Dart_Port port_id, const std::string& message) {
-//     if (port_id == ILLEGAL_PORT) return;
-//     Dart_CObject dart_object;
-//     dart_object.type = Dart_CObject_kString;
-//     char* cstr = new char[message.length() + 1];
-//     strcpy(cstr, message.c_str());
-//     dart_object.value.as_string = cstr;
-
-//     const bool result = Dart_PostCObject_DL(port_id, &dart_object);
-//     if (!result) {
-//         __android_log_print(ANDROID_LOG_ERROR, APPNAME, "Dart_PostCObject_DL failed for string to port %lld", port_id);
-//     }
-//     delete[] cstr; // Free the copied string
-// }
-
-// // --- LLM Thread Function (Placeholder - Integrate your Llama.cpp here) ---
-// void llm_processing_loop() {
-//     // Initialize Llama.cpp (with QNN delegate on NPU) ONCE when thread starts
-//     // llama_context * ctx = llama_init_from_file(...);
-//     // if (!ctx) { SendStringToDart(g_llm_error_port, "Failed to load LLM model"); return; }
-
-//     __android_log_print(ANDROID_LOG_INFO, APPNAME, "LLM processing thread started.");
-
-//     while (g_is_llm_processing_active) {
-//         std::string current_input;
-//         {
-//             std::unique_lock<std::mutex> lock(g_llm_input_mutex);
-//             g_llm_input_cv.wait(lock, [] { return !g_llm_input_text.empty() || !g_is_llm_processing_active; });
-
-//             if (!g_is_llm_processing_active && g_llm_input_text.empty()) {
-//                 break; // Exit if shutting down and no pending input
-//             }
-//             current_input = std::move(g_llm_input_text);
-//             g_llm_input_text.clear(); // Clear after moving
-//         }
-
-//         if (current_input.empty()) continue;
-
-//         __android_log_print(ANDROID_LOG_INFO, APPNAME, "LLM received input: %s", current_input.c_str());
-
-//         // --- LLAMA.CPP INFERENCE ---
-//         // 1. Tokenize input: std::vector<llama_token> tokens_list = llama_tokenize(ctx, current_input.c_str(), true);
-//         // 2. Configure batch, eval: llama_batch batch = llama_batch_get_one(tokens_list.data(), tokens_list.size(), 0, 0);
-//         //                          if (llama_decode(ctx, batch) != 0) { /* error */ }
-//         // 3. Sampling loop to generate output tokens:
-//         //    while (current_token != llama_token_eos(ctx) && g_is_llm_processing_active) {
-//         //        auto logits = llama_get_logits_ith(ctx, batch.n_tokens - 1);
-//         //        // ... (apply samplers: temp, top_k, top_p etc.) ...
-//         //        current_token = llama_sample_token(ctx, nullptr /* candidates */);
-//         //        if (current_token == llama_token_eos(ctx)) break;
-//         //        std::string token_text = llama_token_to_piece(ctx, current_token);
-//         //        SendStringToDart(g_llm_token_port, token_text);
-//         //        llama_batch_clear(&batch);
-//         //        llama_batch_add(&batch, current_token, batch.n_tokens, { 0 }, true);
-//         //        if (llama_decode(ctx, batch) != 0) { /* error */ break; }
-//         //    }
-//         // --- END LLAMA.CPP ---
-        
-//         // Placeholder simulation:
-//         SendStringToDart(g_llm_token_port, "LLM got: " + current_input + ". ");
-//         std::this_thread::sleep_for(std::chrono::milliseconds(500));
-//         SendStringToDart(g_llm_token_port, "Thinking... ");
-//         std::this_thread::sleep_for(std::chrono::milliseconds(500));
-//         SendStringToDart(g_llm_token_port, "Response part 1. ");
-//          std::this_thread::sleep_for(std::chrono::milliseconds(300));
-//         SendStringToDart(g_llm_token_port, "Response part 2.\n");
-
-
-//         // Ensure a small yield to prevent busy-looping if input comes fast
-//         std::this_thread::sleep_for(std::chrono::milliseconds(10));
-//     }
-
-//     // llama_free(ctx); // Cleanup Llama.cpp context
-//     __android_log_print(ANDROID_LOG_INFO, APPNAME, "LLM processing thread finished.");
-// }
-
-
-// extern "C" {
-//     DART_EXPORT void native_initialize_dart_api(void* data) {
-//         if (Dart_InitializeApiDL(data) != 0) {
-//             __android_log_print(ANDROID_LOG_ERROR, APPNAME, "Failed to initialize Dart API DL for LLM");
-//         } else {
-//              __android_log_print(ANDROID_LOG_INFO, APPNAME, "Dart API DL Initialized successfully for LLM.");
-//         }
-//     }
-
-//     DART_EXPORT void native_initialize_llm_ports(Dart_Port llm_token_port, Dart_Port llm_error_port_id) {
-//         g_llm_token_port = llm_token_port;
-//         g_llm_error_port = llm_error_port_id;
-//         __android_log_print(ANDROID_LOG_INFO, APPNAME, "Native LLM ports initialized.");
-
-//         // Start the LLM processing thread ONCE here
-//         if (!g_llm_thread.joinable()) {
-//              g_is_llm_processing_active = true;
-//              g_llm_thread = std::thread(llm_processing_loop);
-//         }
-//     }
-
-//     DART_EXPORT void native_process_llm_input(const char* text_input) {
-//         if (text_input == nullptr) {
-//             SendStringToDart(g_llm_error_port, "Received null input for LLM.");
-//             return;
-//         }
-//         std::string input_str(text_input);
-//         {
-//             std::lock_guard<std::mutex> lock(g_llm_input_mutex);
-//             g_llm_input_text = input_str; // Set new input
-//         }
-//         g_llm_input_cv.notify_one(); // Notify the LLM thread
-//         __android_log_print(ANDROID_LOG_INFO, APPNAME, "LLM input queued via FFI: %s", input_str.c_str());
-//     }
-
-//     DART_EXPORT void native_dispose_llm() {
-//         __android_log_print(ANDROID_LOG_INFO, APPNAME, "Disposing LLM native resources...");
-//         g_is_llm_processing_active = false;
-//         {
-//             std::lock_guard<std::mutex> lock(g_llm_input_mutex);
-//             g_llm_input_text.clear(); // Clear any pending input
-//         }
-//         g_llm_input_cv.notify_all(); // Wake up thread to exit
-
-//         if (g_llm_thread.joinable()) {
-//             g_llm_thread.join();
-//         }
-//         g_llm_token_port = ILLEGAL_PORT;
-//         g_llm_error_port = ILLEGAL_PORT;
-//         __android_log_print(ANDROID_LOG_INFO, APPNAME, "LLM native resources disposed.");
-//     }
-// }
\ No newline at end of file
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+
+#include "ai_bridge.h"
+#include "asr/asr_service.h"
+#include "audio/vad_service.h"
+#include "core/dart_messages.h"
+#include "core/log.h"
+#include "core/metrics.h"
+#include "core/turn_trace.h"
+#include "llm/llm_scheduler.h"
+#include "llm/model_file.h"
+#include "llm/quant.h"
+#include "llm/request_queue.h"
+#include "llm/sim_engine.h"
+#include "llm/token_stream.h"
+#include "llm/transformer_engine.h"
+#include "tts/tts_service.h"
+
+// --- Global State for TTS ---
+// Declared ahead of the token stream so it outlives the flusher feeding it.
+ai_bridge::TtsService g_tts;
+ai_bridge::TtsChunkOptions g_tts_chunking;
+
+
+// --- Global State for LLM ---
+std::atomic<bool> g_is_llm_processing_active(false); // To control the LLM loop if needed
+std::thread g_llm_thread;
+// Every input becomes a request here; bursts queue up instead of overwriting.
+ai_bridge::LlmRequestQueue g_llm_requests;
+
+
+Dart_Port g_llm_token_port = ILLEGAL_PORT;
+Dart_Port g_llm_error_port = ILLEGAL_PORT;
+std::atomic<Dart_Port> g_llm_metrics_port(ILLEGAL_PORT);
+
+// Generated tokens go through this ring to a flusher thread; the decode loop
+// never calls into Dart itself.
+ai_bridge::TokenStream g_token_stream;
+
+// Seed of the reference engine's built-in synthetic weights.
+constexpr uint64_t kReferenceModelSeed = 0x5eed;
+
+// Cost of one decode step of the placeholder engine.
+std::atomic<int32_t> g_llm_sim_token_delay_us(ai_bridge::SimEngineTiming().decode_step_us);
+
+// While set, every new request cancels whatever its session has queued or
+// generating, so the user talking over a reply gets an answer after one
+// decode step.
+std::atomic<bool> g_llm_barge_in(false);
+
+// Engine and scheduler of the running LLM thread. Both are replaced on the
+// next start rather than freed on dispose, so stats stay readable.
+ai_bridge::LlmSchedulerOptions g_llm_scheduler_options;
+std::mutex g_llm_system_prompt_mutex;
+std::string g_llm_system_prompt;
+std::atomic<int32_t> g_llm_engine_kind(AI_BRIDGE_LLM_ENGINE_SIM);
+std::atomic<int32_t> g_llm_weight_type(AI_BRIDGE_LLM_WEIGHTS_F32);
+std::atomic<int32_t> g_llm_threads(0);
+std::unique_ptr<ai_bridge::LlmEngine> g_llm_engine;
+// g_llm_engine as its concrete type; the other one is null.
+ai_bridge::SimLlmEngine* g_llm_sim_engine = nullptr;
+ai_bridge::TransformerEngine* g_llm_reference_engine = nullptr;
+std::unique_ptr<ai_bridge::LlmScheduler> g_llm_scheduler;
+
+// Weights file mapped by the LLM thread at startup; like the engine, kept
+// until the next start. Path and prefetch depth are read at start.
+std::mutex g_llm_model_mutex;
+std::string g_llm_model_path;
+int32_t g_llm_prefetch_layers = 2;
+std::unique_ptr<ai_bridge::MappedModelFile> g_llm_model;
+std::chrono::steady_clock::time_point g_llm_started_at;
+
+
+// --- Global State for VAD and ASR ---
+// g_asr is declared first so it outlives g_vad, whose thread feeds it.
+ai_bridge::AsrService g_asr;
+ai_bridge::VadOptions g_vad_options;
+ai_bridge::VadService g_vad;
+
+
+// Metric/event records go to the metrics port, or to the error port when Dart
+// did not register one.
+Dart_Port MetricsPort() {
+    const Dart_Port port = g_llm_metrics_port.load(std::memory_order_acquire);
+    return port != ILLEGAL_PORT ? port : g_llm_error_port;
+}
+
+// g_llm_weight_type as the tensor format of the built-in model.
+ai_bridge::TensorType ReferenceWeightType() {
+    switch (g_llm_weight_type.load(std::memory_order_relaxed)) {
+        case AI_BRIDGE_LLM_WEIGHTS_Q8_0:
+            return ai_bridge::TensorType::kQ8_0;
+        case AI_BRIDGE_LLM_WEIGHTS_Q4_0:
+            return ai_bridge::TensorType::kQ4_0;
+        default:
+            return ai_bridge::TensorType::kF32;
+    }
+}
+
+int64_t MicrosSinceStart() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - g_llm_started_at).count();
+}
+
+// Maps the weights, pages in the first layers and runs a warm-up decode, so
+// the first request finds a warm engine. Posts
+// ["llm_startup", open_us, map_us, first_layers_us, first_token_us,
+//  mapped_bytes, prefetched_bytes]; the *_us values are measured from
+// native_initialize_llm_ports and are 0 for steps that did not run.
+void start_llm_engine() {
+    std::string path;
+    int32_t prefetch_layers = 0;
+    {
+        std::lock_guard<std::mutex> lock(g_llm_model_mutex);
+        path = g_llm_model_path;
+        prefetch_layers = g_llm_prefetch_layers;
+    }
+    int64_t open_us = 0, map_us = 0, first_layers_us = 0;
+    int64_t mapped_bytes = 0, prefetched_bytes = 0;
+    if (!path.empty()) {
+        auto model = std::make_unique<ai_bridge::MappedModelFile>();
+        int64_t open_cost_us = 0, map_cost_us = 0;
+        std::string error;
+        const int64_t opening_at_us = MicrosSinceStart();
+        if (model->open(path, &open_cost_us, &map_cost_us, &error)) {
+            open_us = opening_at_us + open_cost_us;
+            map_us = open_us + map_cost_us;
+            mapped_bytes = static_cast<int64_t>(model->size());
+            // The rest of the file pages in lazily as decoding reaches it.
+            const uint64_t prefix = model->prefetch_layers(static_cast<uint32_t>(prefetch_layers));
+            model->page_in(prefix);
+            prefetched_bytes = static_cast<int64_t>(prefix);
+            first_layers_us = MicrosSinceStart();
+            g_llm_model = std::move(model);
+            if (g_llm_reference_engine != nullptr && !g_llm_reference_engine->use_weights(*g_llm_model, &error)) {
+                // The synthetic weights keep answering.
+                SendStringToDart(g_llm_error_port, "LLM model " + path + " not usable by the reference engine: " + error);
+            }
+        } else {
+            // The placeholder engine still answers without weights.
+            SendStringToDart(g_llm_error_port, "Failed to load LLM model: " + error);
+        }
+    }
+    // A llama.cpp (with QNN delegate on NPU) backend implementing LlmEngine
+    // would take g_llm_model here too; the placeholder engine needs no weights.
+    if (g_llm_reference_engine != nullptr) {
+        LOGI("Reference engine: %s weights, %s quantized kernels",
+             ai_bridge::TensorTypeName(g_llm_reference_engine->weight_type()), ai_bridge::QuantKernelBackend());
+    }
+    const int64_t first_token_us = g_llm_scheduler->warm_up() ? MicrosSinceStart() : 0;
+
+    SendEventToDart(MetricsPort(), "llm_startup",
+                    {open_us, map_us, first_layers_us, first_token_us, mapped_bytes, prefetched_bytes});
+    LOGI("LLM startup: open %lld us, map %lld us, first layers %lld us, first token %lld us (%lld of %lld bytes prefetched)",
+         (long long)open_us, (long long)map_us, (long long)first_layers_us, (long long)first_token_us,
+         (long long)prefetched_bytes, (long long)mapped_bytes);
+}
+
+// --- LLM Thread Function ---
+void llm_processing_loop() {
+    LOGI("LLM processing thread started (%s engine).", g_llm_engine->name());
+    // Requests submitted meanwhile wait in the queue.
+    start_llm_engine();
+    g_llm_scheduler->run(g_is_llm_processing_active);
+    LOGI("LLM processing thread finished.");
+}
+
+
+extern "C" {
+    DART_EXPORT void native_initialize_dart_api(void* data) {
+        if (Dart_InitializeApiDL(data) != 0) {
+            LOGE("Failed to initialize Dart API DL for LLM");
+        } else {
+             LOGI("Dart API DL Initialized successfully for LLM.");
+        }
+    }
+
+    DART_EXPORT void native_initialize_llm_ports(Dart_Port llm_token_port, Dart_Port llm_error_port_id) {
+        g_llm_token_port = llm_token_port;
+        g_llm_error_port = llm_error_port_id;
+        LOGI("Native LLM ports initialized.");
+
+        // Start the LLM processing thread ONCE here
+        if (!g_llm_thread.joinable()) {
+             g_llm_started_at = std::chrono::steady_clock::now();
+             g_llm_scheduler.reset();
+             g_llm_model.reset();
+             g_llm_sim_engine = nullptr;
+             g_llm_reference_engine = nullptr;
+             if (g_llm_engine_kind.load(std::memory_order_relaxed) == AI_BRIDGE_LLM_ENGINE_REFERENCE) {
+                 auto engine = ai_bridge::TransformerEngine::CreateSynthetic(ai_bridge::TransformerConfig::Tiny(),
+                                                                             kReferenceModelSeed, ReferenceWeightType());
+                 engine->set_threads(g_llm_threads.load(std::memory_order_relaxed));
+                 g_llm_reference_engine = engine.get();
+                 g_llm_engine = std::move(engine);
+             } else {
+                 auto engine = std::make_unique<ai_bridge::SimLlmEngine>();
+                 ai_bridge::SimEngineTiming timing;
+                 timing.decode_step_us = g_llm_sim_token_delay_us.load(std::memory_order_relaxed);
+                 engine->set_timing(timing);
+                 g_llm_sim_engine = engine.get();
+                 g_llm_engine = std::move(engine);
+             }
+             ai_bridge::LlmSchedulerPorts ports;
+             ports.errors = [] { return g_llm_error_port; };
+             ports.metrics = MetricsPort;
+             g_llm_scheduler = std::make_unique<ai_bridge::LlmScheduler>(g_llm_engine.get(), &g_llm_requests, &g_token_stream,
+                                                                         ports, g_llm_scheduler_options);
+             {
+                 std::lock_guard<std::mutex> lock(g_llm_system_prompt_mutex);
+                 g_llm_scheduler->set_system_prompt(g_llm_system_prompt);
+             }
+             g_llm_requests.reopen();
+             g_token_stream.start(g_llm_token_port);
+             g_is_llm_processing_active = true;
+             g_llm_thread = std::thread(llm_processing_loop);
+        }
+    }
+
+    DART_EXPORT void native_initialize_metrics_port(Dart_Port metrics_port) {
+        g_llm_metrics_port = metrics_port;
+    }
+
+    DART_EXPORT int64_t native_submit_llm_session_request(int64_t session_id, const char* text_input, int32_t priority) {
+        if (text_input == nullptr) {
+            SendStringToDart(g_llm_error_port, "Received null input for LLM.");
+            return ai_bridge::kInvalidRequestId;
+        }
+        if (session_id < 0) {
+            SendStringToDart(g_llm_error_port, "Invalid LLM session id " + std::to_string(session_id));
+            return ai_bridge::kInvalidRequestId;
+        }
+        if (g_llm_barge_in.load(std::memory_order_relaxed)) {
+            const size_t preempted = g_llm_requests.cancel_session(session_id);
+            if (preempted > 0) {
+                LOGI("Barge-in: new input preempts %zu LLM request(s)", preempted);
+            }
+        }
+        int64_t request_id = ai_bridge::kInvalidRequestId;
+        switch (g_llm_requests.push(text_input, priority, session_id, &request_id)) {
+            case ai_bridge::LlmRequestQueue::PushResult::kQueued:
+                ai_bridge::Metrics().add(ai_bridge::MetricCounter::kRequestsQueued);
+                break;
+            case ai_bridge::LlmRequestQueue::PushResult::kFull:
+                ai_bridge::Metrics().add(ai_bridge::MetricCounter::kRequestsRejected);
+                SendStringToDart(g_llm_error_port, "LLM request queue is full (" + std::to_string(g_llm_requests.capacity()) +
+                                                   " pending); input rejected.");
+                break;
+            case ai_bridge::LlmRequestQueue::PushResult::kClosed:
+                ai_bridge::Metrics().add(ai_bridge::MetricCounter::kRequestsRejected);
+                SendStringToDart(g_llm_error_port, "LLM is not running; input rejected.");
+                break;
+        }
+        return request_id;
+    }
+
+    DART_EXPORT int64_t native_submit_llm_request(const char* text_input, int32_t priority) {
+        return native_submit_llm_session_request(0, text_input, priority);
+    }
+
+    DART_EXPORT int64_t native_process_llm_input(const char* text_input) {
+        return native_submit_llm_session_request(0, text_input, 0);
+    }
+
+    DART_EXPORT void native_configure_llm_scheduler(int32_t max_active_sessions, int32_t batch_token_budget, int32_t prefill_chunk) {
+        g_llm_scheduler_options.max_active_sessions = max_active_sessions;
+        g_llm_scheduler_options.batch_token_budget = batch_token_budget;
+        g_llm_scheduler_options.prefill_chunk = prefill_chunk;
+    }
+
+    DART_EXPORT void native_set_llm_max_reply_tokens(int32_t max_tokens) {
+        g_llm_scheduler_options.max_reply_tokens = max_tokens < 0 ? 0 : max_tokens;
+    }
+
+    DART_EXPORT void native_set_llm_engine(int32_t engine) {
+        g_llm_engine_kind = engine == AI_BRIDGE_LLM_ENGINE_REFERENCE ? AI_BRIDGE_LLM_ENGINE_REFERENCE
+                                                                     : AI_BRIDGE_LLM_ENGINE_SIM;
+    }
+
+    DART_EXPORT int32_t native_write_reference_model(const char* path) {
+        const auto engine = ai_bridge::TransformerEngine::CreateSynthetic(ai_bridge::TransformerConfig::Tiny(),
+                                                                          kReferenceModelSeed, ReferenceWeightType(), 1);
+        std::string error;
+        if (path == nullptr || engine->WriteModel(path, &error) == 0) {
+            SendStringToDart(g_llm_error_port, path == nullptr ? "No path for the reference model" : error);
+            return 0;
+        }
+        return 1;
+    }
+
+    DART_EXPORT void native_set_llm_weight_type(int32_t weight_type) {
+        g_llm_weight_type = weight_type == AI_BRIDGE_LLM_WEIGHTS_Q8_0 || weight_type == AI_BRIDGE_LLM_WEIGHTS_Q4_0
+                                ? weight_type
+                                : AI_BRIDGE_LLM_WEIGHTS_F32;
+    }
+
+    DART_EXPORT void native_set_llm_threads(int32_t threads) {
+        g_llm_threads = threads < 0 ? 0 : threads;
+    }
+
+    DART_EXPORT void native_set_llm_model(const char* path, int32_t prefetch_layers) {
+        std::lock_guard<std::mutex> lock(g_llm_model_mutex);
+        g_llm_model_path = path != nullptr ? path : "";
+        g_llm_prefetch_layers = prefetch_layers < 0 ? 0 : prefetch_layers;
+    }
+
+    DART_EXPORT void native_set_llm_system_prompt(const char* text) {
+        std::lock_guard<std::mutex> lock(g_llm_system_prompt_mutex);
+        g_llm_system_prompt = text != nullptr ? text : "";
+        if (g_llm_scheduler) g_llm_scheduler->set_system_prompt(g_llm_system_prompt);
+    }
+
+    DART_EXPORT int32_t native_save_session(const char* path) {
+        if (path == nullptr || !g_llm_scheduler) {
+            SendStringToDart(g_llm_error_port, "LLM session not saved: no session path or LLM not initialized.");
+            return 0;
+        }
+        return g_llm_scheduler->save_sessions(path) ? 1 : 0;
+    }
+
+    DART_EXPORT int32_t native_load_session(const char* path) {
+        if (path == nullptr || !g_llm_scheduler) {
+            SendStringToDart(g_llm_error_port, "LLM session not loaded: no session path or LLM not initialized.");
+            return 0;
+        }
+        return g_llm_scheduler->load_sessions(path) ? 1 : 0;
+    }
+
+    DART_EXPORT void native_get_llm_scheduler_stats(AiBridgeSchedulerStats* out_stats) {
+        if (out_stats == nullptr) return;
+        const ai_bridge::LlmSchedulerStats stats = g_llm_scheduler ? g_llm_scheduler->stats() : ai_bridge::LlmSchedulerStats();
+        out_stats->decode_steps = stats.decode_steps;
+        out_stats->prefill_tokens = stats.prefill_tokens;
+        out_stats->reused_tokens = stats.reused_tokens;
+        out_stats->generated_tokens = stats.generated_tokens;
+        out_stats->max_batch_sessions = stats.max_batch_sessions;
+        out_stats->sessions_evicted = stats.sessions_evicted;
+    }
+
+    DART_EXPORT int32_t native_cancel_request(int64_t request_id) {
+        return g_llm_requests.cancel(request_id) ? 1 : 0;
+    }
+
+    DART_EXPORT int32_t native_cancel_all_llm_requests() {
+        return static_cast<int32_t>(g_llm_requests.cancel_all());
+    }
+
+    DART_EXPORT void native_set_llm_barge_in(int32_t enabled) {
+        g_llm_barge_in = enabled != 0;
+    }
+
+    DART_EXPORT void native_dispose_llm() {
+        LOGI("Disposing LLM native resources...");
+        g_is_llm_processing_active = false;
+        g_llm_requests.close(); // Drop pending input and wake the thread to exit
+
+        if (g_llm_thread.joinable()) {
+            g_llm_thread.join();
+        }
+        g_token_stream.stop(); // Posts whatever the loop already produced
+        g_llm_token_port = ILLEGAL_PORT;
+        g_llm_error_port = ILLEGAL_PORT;
+        g_llm_metrics_port = ILLEGAL_PORT;
+        LOGI("LLM native resources disposed.");
+        ai_bridge::FlushLog();
+    }
+
+    DART_EXPORT void native_set_sim_token_delay_us(int32_t delay_us) {
+        g_llm_sim_token_delay_us = delay_us < 0 ? 0 : delay_us;
+        if (g_llm_sim_engine != nullptr) {
+            ai_bridge::SimEngineTiming timing;
+            timing.decode_step_us = g_llm_sim_token_delay_us.load(std::memory_order_relaxed);
+            g_llm_sim_engine->set_timing(timing);
+        }
+    }
+
+    DART_EXPORT void native_set_token_flush_policy(int32_t max_tokens, int32_t max_bytes, int32_t max_delay_ms) {
+        ai_bridge::TokenFlushPolicy policy;
+        policy.max_tokens = max_tokens;
+        policy.max_bytes = max_bytes;
+        policy.max_delay_ms = max_delay_ms;
+        g_token_stream.set_flush_policy(policy);
+        LOGI("Token flush policy: %d tokens, %d bytes, %d ms", max_tokens, max_bytes, max_delay_ms);
+    }
+
+    DART_EXPORT void native_set_token_transport(int32_t transport) {
+        if (transport != AI_BRIDGE_TOKEN_TRANSPORT_STRING && transport != AI_BRIDGE_TOKEN_TRANSPORT_EXTERNAL_TYPED_DATA) {
+            SendStringToDart(g_llm_error_port, "Unknown token transport " + std::to_string(transport));
+            return;
+        }
+        g_token_stream.set_transport(static_cast<ai_bridge::TokenTransport>(transport));
+    }
+
+    DART_EXPORT void native_get_token_stats(AiBridgeTokenStats* out_stats) {
+        if (out_stats == nullptr) return;
+        const ai_bridge::TokenStreamStats stats = g_token_stream.stats();
+        out_stats->tokens_published = stats.tokens_published;
+        out_stats->tokens_dropped = stats.tokens_dropped;
+        out_stats->producer_stalls = stats.producer_stalls;
+        out_stats->tokens_drained = stats.tokens_drained;
+        out_stats->messages_posted = stats.messages_posted;
+        out_stats->post_failures = stats.post_failures;
+        out_stats->replies_completed = stats.replies_completed;
+        out_stats->slabs_allocated = stats.slabs_allocated;
+        out_stats->slabs_in_flight = stats.slabs_in_flight;
+    }
+
+    DART_EXPORT void native_vad_configure(int32_t frame_samples, int32_t min_speech_frames, int32_t pre_speech_pad_frames,
+                                          int32_t redemption_frames, float positive_speech_threshold,
+                                          float negative_speech_threshold, int32_t submit_user_speech_on_pause) {
+        g_vad_options.frame_samples = frame_samples;
+        g_vad_options.min_speech_frames = min_speech_frames;
+        g_vad_options.pre_speech_pad_frames = pre_speech_pad_frames < 0 ? 0 : pre_speech_pad_frames;
+        g_vad_options.redemption_frames = redemption_frames;
+        g_vad_options.positive_speech_threshold = positive_speech_threshold;
+        g_vad_options.negative_speech_threshold = negative_speech_threshold;
+        g_vad_options.submit_user_speech_on_pause = submit_user_speech_on_pause != 0;
+    }
+
+    DART_EXPORT void native_vad_configure_gate(int32_t enabled, float silence_db, float noise_margin_db) {
+        g_vad_options.gate.enabled = enabled != 0;
+        g_vad_options.gate.silence_db = silence_db;
+        g_vad_options.gate.noise_margin_db = noise_margin_db < 0.0f ? 0.0f : noise_margin_db;
+    }
+
+    DART_EXPORT int32_t native_vad_start(Dart_Port event_port, int32_t native_capture) {
+        std::string error;
+        if (!g_vad.start(g_vad_options, event_port, native_capture != 0, &error)) {
+            LOGE("VAD not started: %s", error.c_str());
+            SendStringToDart(event_port, error);
+            return 0;
+        }
+        return 1;
+    }
+
+    DART_EXPORT void native_vad_stop() {
+        g_vad.stop();
+    }
+
+    DART_EXPORT int32_t native_vad_push_pcm(const float* samples, int32_t count) {
+        if (samples == nullptr || count <= 0) return 0;
+        return static_cast<int32_t>(g_vad.push(samples, static_cast<size_t>(count)));
+    }
+
+    DART_EXPORT void native_get_vad_stats(AiBridgeVadStats* out_stats) {
+        if (out_stats == nullptr) return;
+        const ai_bridge::VadStats stats = g_vad.stats();
+        out_stats->frames_processed = stats.frames_processed;
+        out_stats->frames_gated = stats.frames_gated;
+        out_stats->speech_segments = stats.speech_segments;
+        out_stats->misfires = stats.misfires;
+        out_stats->samples_dropped = stats.samples_dropped;
+        out_stats->model_us = stats.model_us;
+        out_stats->gate_us = stats.gate_us;
+    }
+
+    DART_EXPORT int32_t native_asr_start(Dart_Port transcript_port, int32_t partial_interval_ms) {
+        ai_bridge::AsrOptions options;
+        if (partial_interval_ms > 0) options.partial_interval_ms = partial_interval_ms;
+        std::string error;
+        if (!g_asr.start(options, transcript_port, MetricsPort(), &error)) {
+            LOGE("ASR start failed: %s", error.c_str());
+            SendStringToDart(transcript_port, error);
+            return 0;
+        }
+        g_vad.set_speech_sink(&g_asr);
+        return 1;
+    }
+
+    DART_EXPORT void native_asr_stop() {
+        g_vad.set_speech_sink(nullptr);
+        g_asr.stop();
+    }
+
+    DART_EXPORT void native_tts_configure(int32_t first_chunk_min_chars, int32_t clause_min_chars, int32_t max_chunk_chars) {
+        g_tts_chunking.first_chunk_min_chars = first_chunk_min_chars;
+        g_tts_chunking.clause_min_chars = clause_min_chars;
+        g_tts_chunking.max_chunk_chars = max_chunk_chars;
+    }
+
+    DART_EXPORT int32_t native_tts_start(Dart_Port event_port, int32_t native_playback) {
+        ai_bridge::TtsOptions options;
+        options.chunking = g_tts_chunking;
+        options.native_playback = native_playback != 0;
+        std::string error;
+        if (!g_tts.start(options, event_port, MetricsPort(), &error)) {
+            LOGE("TTS start failed: %s", error.c_str());
+            SendStringToDart(event_port, error);
+            return 0;
+        }
+        g_token_stream.set_tap(&g_tts);
+        return 1;
+    }
+
+    DART_EXPORT void native_tts_stop() {
+        g_token_stream.set_tap(nullptr);
+        g_tts.stop();
+    }
+
+    DART_EXPORT void native_tts_interrupt() {
+        g_tts.interrupt();
+    }
+
+    DART_EXPORT int32_t native_tts_sample_rate() {
+        return g_tts.sample_rate();
+    }
+
+    DART_EXPORT int32_t native_tts_pull_pcm(float* out, int32_t count) {
+        if (out == nullptr || count <= 0 || g_tts.native_playback()) return 0;
+        return static_cast<int32_t>(g_tts.pull(out, static_cast<size_t>(count)));
+    }
+
+    DART_EXPORT void native_get_tts_stats(AiBridgeTtsStats* out_stats) {
+        if (out_stats == nullptr) return;
+        const ai_bridge::TtsStats stats = g_tts.stats();
+        out_stats->replies = stats.replies;
+        out_stats->interrupted = stats.interrupted;
+        out_stats->chunks = stats.chunks;
+        out_stats->audio_ms = stats.audio_ms;
+        out_stats->synthesize_us = stats.synthesize_us;
+        out_stats->first_audio_us = stats.first_audio_us;
+    }
+
+    DART_EXPORT void native_get_audio_output_stats(AiBridgeAudioOutputStats* out_stats) {
+        if (out_stats == nullptr) return;
+        const ai_bridge::PcmOutputStats stats = g_tts.output_stats();
+        out_stats->samples_played = stats.samples_played;
+        out_stats->samples_discarded = stats.samples_discarded;
+        out_stats->underruns = stats.underruns;
+        out_stats->underrun_samples = stats.underrun_samples;
+        out_stats->callbacks = stats.callbacks;
+        out_stats->late_callbacks = stats.late_callbacks;
+        out_stats->max_callback_gap_us = stats.max_callback_gap_us;
+        out_stats->fill_samples = stats.fill_samples;
+        out_stats->min_fill_samples = stats.min_fill_samples;
+        out_stats->max_fill_samples = stats.max_fill_samples;
+        out_stats->latency_us_last = stats.latency_us_last;
+        out_stats->latency_us_total = stats.latency_us_total;
+        out_stats->latency_us_max = stats.latency_us_max;
+        out_stats->latency_samples = stats.latency_samples;
+    }
+
+    DART_EXPORT void native_get_asr_stats(AiBridgeAsrStats* out_stats) {
+        if (out_stats == nullptr) return;
+        const ai_bridge::AsrStats stats = g_asr.stats();
+        out_stats->utterances = stats.utterances;
+        out_stats->partials = stats.partials;
+        out_stats->audio_ms = stats.audio_ms;
+        out_stats->encoded_ms = stats.encoded_ms;
+        out_stats->encode_us = stats.encode_us;
+        out_stats->decode_us = stats.decode_us;
+        out_stats->finalize_us = stats.finalize_us;
+        out_stats->samples_dropped = stats.samples_dropped;
+    }
+
+    DART_EXPORT int64_t native_trace_begin_turn() {
+        return ai_bridge::VoiceTurnTrace().begin_turn(ai_bridge::TurnTrace::NowMicros());
+    }
+
+    DART_EXPORT void native_trace_mark(int64_t turn_id, int32_t stage) {
+        if (stage < 0 || stage >= ai_bridge::kTurnStageCount) return;
+        ai_bridge::VoiceTurnTrace().mark(turn_id, static_cast<ai_bridge::TurnStage>(stage),
+                                         ai_bridge::TurnTrace::NowMicros());
+    }
+
+    DART_EXPORT void native_trace_attach_request(int64_t turn_id, int64_t request_id) {
+        ai_bridge::VoiceTurnTrace().attach_request(turn_id, request_id);
+    }
+
+    DART_EXPORT void native_trace_mark_request(int64_t request_id, int32_t stage) {
+        if (stage < 0 || stage >= ai_bridge::kTurnStageCount) return;
+        ai_bridge::VoiceTurnTrace().mark_request(request_id, static_cast<ai_bridge::TurnStage>(stage),
+                                                 ai_bridge::TurnTrace::NowMicros());
+    }
+
+    DART_EXPORT void native_trace_abandon_request(int64_t request_id) {
+        ai_bridge::VoiceTurnTrace().abandon_request(request_id);
+    }
+
+    DART_EXPORT int32_t native_get_turn_spans(AiBridgeTurnSpanStats* out_spans, int32_t count) {
+        if (out_spans == nullptr || count <= 0) return 0;
+        const int32_t filled = std::min<int32_t>(count, ai_bridge::kTurnSpanCount);
+        for (int32_t s = 0; s < filled; ++s) {
+            const ai_bridge::HdrHistogram& histogram =
+                ai_bridge::VoiceTurnTrace().histogram(static_cast<ai_bridge::TurnSpan>(s));
+            out_spans[s].count = histogram.count();
+            out_spans[s].mean_us = histogram.mean();
+            out_spans[s].p50_us = histogram.percentile(50);
+            out_spans[s].p90_us = histogram.percentile(90);
+            out_spans[s].p99_us = histogram.percentile(99);
+            out_spans[s].max_us = histogram.max();
+        }
+        return filled;
+    }
+
+    DART_EXPORT int32_t native_trace_dump_json(char* out, int32_t capacity) {
+        const std::string json = ai_bridge::VoiceTurnTrace().chrome_trace();
+        if (out != nullptr && capacity > 0) {
+            const size_t copied = std::min(json.size(), static_cast<size_t>(capacity) - 1);
+            memcpy(out, json.data(), copied);
+            out[copied] = '\0';
+        }
+        return static_cast<int32_t>(json.size());
+    }
+
+    DART_EXPORT int32_t native_snapshot_metrics(uint8_t* out, int32_t capacity) {
+        return static_cast<int32_t>(
+            ai_bridge::Metrics().snapshot(out, capacity > 0 ? static_cast<size_t>(capacity) : 0));
+    }
+
+    DART_EXPORT int32_t native_post_metrics_snapshot(Dart_Port port) {
+        if (port == ILLEGAL_PORT) return 0;
+        std::vector<uint8_t> snapshot(ai_bridge::MetricsRegistry::SnapshotSize());
+        ai_bridge::Metrics().snapshot(snapshot.data(), snapshot.size());
+        Dart_CObject message;
+        message.type = Dart_CObject_kTypedData;
+        message.value.as_typed_data.type = Dart_TypedData_kUint8;
+        message.value.as_typed_data.length = static_cast<intptr_t>(snapshot.size());
+        message.value.as_typed_data.values = snapshot.data();
+        return Dart_PostCObject_DL(port, &message) ? 1 : 0;
+    }
+}
@@ -0,0 +1,391 @@
+#ifndef AI_BRIDGE_AI_BRIDGE_H_
+#define AI_BRIDGE_AI_BRIDGE_H_
+
+// C API exported by libai_bridge. These are the symbols looked up from Dart
+// via dart:ffi, and the entry points host tools drive directly.
+
+#include "dart_api_dl.h"
+
+// Snapshot of the token path between the decode loop and the Dart port.
+typedef struct AiBridgeTokenStats {
+    int64_t tokens_published;   // pieces handed to the ring by the decode loop
+    int64_t tokens_dropped;     // pieces lost because the flusher was stopped
+    int64_t producer_stalls;    // decode-loop spins on a full ring
+    int64_t tokens_drained;     // ring slots consumed by the flusher
+    int64_t messages_posted;    // successful Dart_PostCObject_DL calls
+    int64_t post_failures;      // failed Dart_PostCObject_DL calls
+    int64_t replies_completed;  // end-of-reply markers drained
+    int64_t slabs_allocated;    // token batch buffers owned by the pool
+    int64_t slabs_in_flight;    // batch buffers currently lent to Dart
+} AiBridgeTokenStats;
+
+// Snapshot of the LLM scheduler of the current (or last) LLM thread.
+typedef struct AiBridgeSchedulerStats {
+    int64_t decode_steps;        // engine decode() calls
+    int64_t prefill_tokens;      // prompt tokens evaluated
+    int64_t reused_tokens;       // prompt tokens served from cached KV prefixes
+    int64_t generated_tokens;    // reply tokens sampled
+    int64_t max_batch_sessions;  // most sessions sharing one decode step
+    int64_t sessions_evicted;    // idle sessions whose KV slot was reclaimed
+} AiBridgeSchedulerStats;
+
+// Snapshot of the native VAD since the library was loaded.
+typedef struct AiBridgeVadStats {
+    int64_t frames_processed;  // frames taken from the capture ring
+    int64_t frames_gated;      // of those, rejected by the pre-gate without running the model
+    int64_t speech_segments;   // "vad_speech_end" events
+    int64_t misfires;          // segments shorter than min_speech_frames
+    int64_t samples_dropped;   // captured samples the VAD thread had no room for
+    int64_t model_us;          // total time spent in the VAD model
+    int64_t gate_us;           // total time spent in the pre-gate
+} AiBridgeVadStats;
+
+// Snapshot of the native speech recognizer since the library was loaded.
+typedef struct AiBridgeAsrStats {
+    int64_t utterances;       // final transcripts posted
+    int64_t partials;         // partial transcripts posted
+    int64_t audio_ms;         // speech in the final transcripts
+    int64_t encoded_ms;       // audio run through the encoder, re-encoded tails included
+    int64_t encode_us;        // total time in the encoder
+    int64_t decode_us;        // total time in the decoder
+    int64_t finalize_us;      // total time from VAD speech end to final transcript
+    int64_t samples_dropped;  // speech the recognizer had no room for
+} AiBridgeAsrStats;
+
+// Snapshot of native speech output since the library was loaded.
+typedef struct AiBridgeTtsStats {
+    int64_t replies;         // replies spoken to the end
+    int64_t interrupted;     // replies cut off by native_tts_interrupt, a newer reply or cancellation
+    int64_t chunks;          // sentences and clauses synthesized
+    int64_t audio_ms;        // speech synthesized
+    int64_t synthesize_us;   // total time in the voice model
+    int64_t first_audio_us;  // total over spoken replies, first reply token to first played sample
+} AiBridgeTtsStats;
+
+// Snapshot of the speech output ring since the library was loaded. Underruns
+// with on-time callbacks mean synthesis (or generation) fell behind; late
+// callbacks mean the audio thread was not scheduled in time.
+typedef struct AiBridgeAudioOutputStats {
+    int64_t samples_played;       // speech handed to playback
+    int64_t samples_discarded;    // speech cut off before it was played
+    int64_t underruns;            // callbacks that ran dry in the middle of a reply
+    int64_t underrun_samples;     // silence they played instead
+    int64_t callbacks;            // playback callbacks (or pulls)
+    int64_t late_callbacks;       // callbacks more than twice their own length after the previous one
+    int64_t max_callback_gap_us;  // longest time between two callbacks
+    int64_t fill_samples;         // buffered now
+    int64_t min_fill_samples;     // lowest fill found in the middle of a reply
+    int64_t max_fill_samples;     // highest fill found by a callback
+    int64_t latency_us_last;      // synthesized audio written -> its first sample played, last write
+    int64_t latency_us_total;     // the same, summed over latency_samples writes
+    int64_t latency_us_max;
+    int64_t latency_samples;
+} AiBridgeAudioOutputStats;
+
+// One interval of the voice turns traced so far (see native_get_turn_spans),
+// in microseconds. Percentiles are within 6.25% of the true value.
+typedef struct AiBridgeTurnSpanStats {
+    int64_t count;  // turns that reached both ends of the span
+    int64_t mean_us;
+    int64_t p50_us;
+    int64_t p90_us;
+    int64_t p99_us;
+    int64_t max_us;
+} AiBridgeTurnSpanStats;
+
+// Status reported with the end of each reply: ["reply_end", request_id, status].
+#define AI_BRIDGE_REPLY_COMPLETED 0
+#define AI_BRIDGE_REPLY_CANCELLED 1
+#define AI_BRIDGE_REPLY_FAILED 2
+
+// Values for native_set_token_transport.
+#define AI_BRIDGE_TOKEN_TRANSPORT_STRING 0
+#define AI_BRIDGE_TOKEN_TRANSPORT_EXTERNAL_TYPED_DATA 1
+
+// Stages of a voice turn, for native_trace_mark and native_trace_mark_request.
+#define AI_BRIDGE_TURN_STAGE_SPEECH_END 0
+#define AI_BRIDGE_TURN_STAGE_TRANSCRIPT_FINAL 1
+#define AI_BRIDGE_TURN_STAGE_FIRST_TOKEN 2
+#define AI_BRIDGE_TURN_STAGE_LAST_TOKEN 3
+#define AI_BRIDGE_TURN_STAGE_FIRST_AUDIO 4
+#define AI_BRIDGE_TURN_STAGE_AUDIO_DONE 5
+
+// Intervals of a voice turn, the order native_get_turn_spans fills them in.
+#define AI_BRIDGE_TURN_SPAN_TRANSCRIBE 0   // speech end -> final transcript
+#define AI_BRIDGE_TURN_SPAN_FIRST_TOKEN 1  // final transcript -> first token
+#define AI_BRIDGE_TURN_SPAN_GENERATE 2     // first token -> last token
+#define AI_BRIDGE_TURN_SPAN_FIRST_AUDIO 3  // first token -> first sample played
+#define AI_BRIDGE_TURN_SPAN_PLAYBACK 4     // first sample -> last sample played
+#define AI_BRIDGE_TURN_SPAN_RESPONSE 5     // speech end -> first sample played
+#define AI_BRIDGE_TURN_SPAN_COUNT 6
+
+DART_EXPORT void native_initialize_dart_api(void* data);
+DART_EXPORT void native_initialize_llm_ports(Dart_Port llm_token_port, Dart_Port llm_error_port_id);
+
+// Queues `text_input` (priority 0) and returns its request id, or 0 if it was
+// rejected because the queue is full or the LLM is not running; the reason is
+// posted to the error port.
+DART_EXPORT int64_t native_process_llm_input(const char* text_input);
+// Same, with an explicit priority: higher priorities are served first, equal
+// priorities in arrival order.
+DART_EXPORT int64_t native_submit_llm_request(const char* text_input, int32_t priority);
+// Same, continuing conversation `session_id` (>= 0; the calls above use
+// session 0). Sessions generate concurrently, sharing decode batches; each
+// keeps its turns in its own KV slot; a session that lost its slot to a newer
+// one is rebuilt from its remembered history on its next turn.
+DART_EXPORT int64_t native_submit_llm_session_request(int64_t session_id, const char* text_input, int32_t priority);
+
+// Scheduler limits, applied the next time native_initialize_llm_ports starts
+// the LLM thread: sessions generating at once, tokens per decode step, and
+// prompt tokens one session may add to a step. Defaults (4, 256, 64).
+DART_EXPORT void native_configure_llm_scheduler(int32_t max_active_sessions, int32_t batch_token_budget, int32_t prefill_chunk);
+// Longest reply, in tokens, before it ends as if the model had finished; 0
+// for no limit but the context. Applied at the next start. Default 512.
+DART_EXPORT void native_set_llm_max_reply_tokens(int32_t max_tokens);
+
+// Inference backends.
+#define AI_BRIDGE_LLM_ENGINE_SIM 0        // scripted replies, timed decode steps
+#define AI_BRIDGE_LLM_ENGINE_REFERENCE 1  // CPU transformer forward pass
+
+// Backend started by the next native_initialize_llm_ports; SIM by default.
+// The reference engine runs the built-in synthetic model unless the model
+// file set with native_set_llm_model holds transformer weights (the
+// built-in model as written by native_write_reference_model, say).
+DART_EXPORT void native_set_llm_engine(int32_t engine);
+// Writes the built-in synthetic model to `path` as a model file; returns 1
+// on success, or 0 after posting the error to the error port.
+DART_EXPORT int32_t native_write_reference_model(const char* path);
+
+// Storage of the built-in model's weight matrices (see llm/quant.h). Fewer
+// bytes per weight means fewer bytes streamed per decoded token, which is
+// what bounds decode speed.
+#define AI_BRIDGE_LLM_WEIGHTS_F32 0
+#define AI_BRIDGE_LLM_WEIGHTS_Q8_0 1  // 8.5 bits per weight
+#define AI_BRIDGE_LLM_WEIGHTS_Q4_0 2  // 4.5 bits per weight
+
+// Format the next engine start and native_write_reference_model use for
+// the built-in model; F32 by default. Model files carry their own formats.
+DART_EXPORT void native_set_llm_weight_type(int32_t weight_type);
+// Most compute-pool threads a reference-engine decode step uses; 0 (the
+// default) for one per core. Applies from the next engine start.
+DART_EXPORT void native_set_llm_threads(int32_t threads);
+DART_EXPORT void native_get_llm_scheduler_stats(AiBridgeSchedulerStats* out_stats);
+
+// Weights file (see llm/model_file.h) mapped when native_initialize_llm_ports
+// next starts the LLM; "" runs without one. Startup happens on the LLM
+// thread: the file is mapped, the first `prefetch_layers` layers are paged in
+// ahead of the rest, and a warm-up decode evaluates the system prompt, all
+// while requests already queue. It ends with
+// ["llm_startup", open_us, map_us, first_layers_us, first_token_us,
+//  mapped_bytes, prefetched_bytes] on the metrics port, times counted from
+// native_initialize_llm_ports and 0 for steps that did not run.
+DART_EXPORT void native_set_llm_model(const char* path, int32_t prefetch_layers);
+
+// Text every new conversation starts with. Its KV state is computed once and
+// shared by all sessions through the prefix cache, as is any other prefix
+// sessions have in common; a follow-up turn only prefills itself.
+DART_EXPORT void native_set_llm_system_prompt(const char* text);
+
+// Snapshot of every remembered conversation and its KV cache, written to
+// `path` in a versioned file that native_load_session maps in place, so a
+// restarted app resumes a conversation without prefilling it. Saving waits
+// for the decode step in progress; loading is refused while requests are in
+// flight and needs native_initialize_llm_ports first. Both return 1 on
+// success, else 0 with the reason on the error port, and post
+// ["llm_session_save" | "llm_session_load", sessions, kv_tokens, bytes,
+// elapsed_us] to the metrics port.
+DART_EXPORT int32_t native_save_session(const char* path);
+DART_EXPORT int32_t native_load_session(const char* path);
+
+// Stops a queued or generating request. Generation stops before the next
+// decode step; the conversation's KV cache keeps everything decoded so far
+// and the reply ends with AI_BRIDGE_REPLY_CANCELLED. Returns 1 if the request
+// was still queued or generating, else 0.
+DART_EXPORT int32_t native_cancel_request(int64_t request_id);
+// Cancels every queued and generating request; returns how many.
+DART_EXPORT int32_t native_cancel_all_llm_requests();
+// With barge-in enabled, each new request first cancels all earlier ones of
+// its session, so a user interrupting a reply is answered after at most one
+// decode step.
+DART_EXPORT void native_set_llm_barge_in(int32_t enabled);
+
+// Optional port for metric/event records, each a List [String tag, int...].
+// Without it the records go to the error port. Tags:
+//   "llm_queue"  [request_id, priority, depth_after_dequeue, wait_us]
+//   "llm_cancel" [request_id, tokens_generated, abort_latency_us]
+//   "llm_reply"  [request_id, session_id, prompt_tokens, generated_tokens,
+//                 first_token_us, total_us] (both times since submission)
+DART_EXPORT void native_initialize_metrics_port(Dart_Port metrics_port);
+DART_EXPORT void native_dispose_llm();
+
+// Duration of one decode step of the placeholder engine; 0 runs it flat out.
+DART_EXPORT void native_set_sim_token_delay_us(int32_t delay_us);
+DART_EXPORT void native_get_token_stats(AiBridgeTokenStats* out_stats);
+
+// Coalesces tokens into one Dart message, flushed when max_tokens tokens,
+// max_bytes bytes or max_delay_ms milliseconds accumulate (whichever comes
+// first) and at the end of every reply. (1, 1, 1) posts every token alone.
+DART_EXPORT void native_set_token_flush_policy(int32_t max_tokens, int32_t max_bytes, int32_t max_delay_ms);
+
+// Selects how token batches reach the token port: as Dart strings (copied by
+// the VM) or as Uint8List views of pooled native UTF-8 buffers that Dart
+// decodes in place. Each batch is a List [request_id, text]; a
+// ["reply_end", request_id, status] list follows the last batch of each reply.
+DART_EXPORT void native_set_token_transport(int32_t transport);
+
+// --- Voice activity detection ---
+
+// VadSettings for the next native_vad_start. frame_samples must be 512 (v5)
+// or 1536 (legacy); audio is 16 kHz mono.
+DART_EXPORT void native_vad_configure(int32_t frame_samples, int32_t min_speech_frames, int32_t pre_speech_pad_frames,
+                                      int32_t redemption_frames, float positive_speech_threshold,
+                                      float negative_speech_threshold, int32_t submit_user_speech_on_pause);
+// Pre-gate for the next native_vad_start: frames below silence_db dBFS,
+// within noise_margin_db of the tracked background level, or quiet and
+// hiss-like skip the model and count as non-speech. On by default
+// (-60 dBFS, 3 dB).
+DART_EXPORT void native_vad_configure_gate(int32_t enabled, float silence_db, float noise_margin_db);
+// Starts the VAD thread, capturing the microphone natively when
+// native_capture is set (otherwise PCM comes from native_vad_push_pcm). Only
+// events reach event_port, each a List [tag, start_sample, end_sample] with
+// positions counted in samples from start:
+//   "vad_speech_start", "vad_speech_real_start" (end_sample is the current
+//   position), "vad_speech_end", "vad_misfire".
+// Returns 0 and posts the reason as a String to event_port on failure.
+DART_EXPORT int32_t native_vad_start(Dart_Port event_port, int32_t native_capture);
+// Stops capture; an open segment ends as VadSettings.submitUserSpeechOnPause
+// says.
+DART_EXPORT void native_vad_stop();
+// Feeds 16 kHz mono float PCM when capture is not native. Returns the samples
+// accepted.
+DART_EXPORT int32_t native_vad_push_pcm(const float* samples, int32_t count);
+DART_EXPORT void native_get_vad_stats(AiBridgeVadStats* out_stats);
+
+// --- Speech recognition ---
+
+// Transcribes the native VAD's speech segments as they grow, replacing a
+// separate recognizer started after each speech end. transcript_port gets
+// ["asr_partial", utterance_id, text, stable] every partial_interval_ms of
+// new speech when the hypothesis changed (stable is the prefix of text no
+// later transcript of the utterance changes), ["asr_final", utterance_id,
+// text] on the VAD's speech end and ["asr_discarded", utterance_id] for
+// speech dropped on pause. An ["asr_utterance", utterance_id, audio_ms,
+// encoded_ms, encode_us, decode_us, finalize_us] record per final
+// transcript goes to the metrics port. Works with native capture and with
+// native_vad_push_pcm, and may be started before or while the VAD runs.
+// Returns 0 and posts the reason as a String to transcript_port on
+// failure.
+DART_EXPORT int32_t native_asr_start(Dart_Port transcript_port, int32_t partial_interval_ms);
+DART_EXPORT void native_asr_stop();
+DART_EXPORT void native_get_asr_stats(AiBridgeAsrStats* out_stats);
+
+// --- Speech output ---
+
+// Where reply text is cut for synthesis (see TtsChunkOptions): the first
+// piece at a clause boundary past first_chunk_min_chars, later ones at
+// sentence ends or clause boundaries past clause_min_chars, any piece at a
+// space past max_chunk_chars. Takes effect on the next native_tts_start.
+DART_EXPORT void native_tts_configure(int32_t first_chunk_min_chars, int32_t clause_min_chars, int32_t max_chunk_chars);
+// Speaks LLM replies natively as they are generated, instead of handing the
+// finished reply to a platform TTS: sentence N+1 is synthesized while
+// sentence N plays. The newest reply is spoken; a later one or a
+// cancellation cuts it off. event_port gets ["tts_start", request_id] when
+// a reply becomes audible and ["tts_done", request_id, interrupted] when it
+// has played out or was cut off; ["tts_chunk", request_id, index, chars,
+// audio_ms, synthesize_us] and ["tts_reply", request_id, first_audio_us,
+// chunks, audio_ms, synthesize_us] records go to the metrics port. With
+// native_playback 0 nothing is played and the host pulls the PCM with
+// native_tts_pull_pcm. Returns 0 and posts the reason as a String to
+// event_port on failure.
+DART_EXPORT int32_t native_tts_start(Dart_Port event_port, int32_t native_playback);
+DART_EXPORT void native_tts_stop();
+// Cuts off the reply being spoken, e.g. when the user barges in.
+DART_EXPORT void native_tts_interrupt();
+// Voice sample rate of the running (or last) TTS, 0 before the first start.
+DART_EXPORT int32_t native_tts_sample_rate();
+// Without native playback: copies the next `count` samples to be played to
+// `out`, padding with silence, and returns how many were speech. Returns 0
+// while native playback is running.
+DART_EXPORT int32_t native_tts_pull_pcm(float* out, int32_t count);
+DART_EXPORT void native_get_tts_stats(AiBridgeTtsStats* out_stats);
+// Underruns, fill level and buffer latency of the ring between synthesis and
+// playback, to tell stutter from slow synthesis apart from stutter from a
+// late audio thread. Sample counts are at native_tts_sample_rate.
+DART_EXPORT void native_get_audio_output_stats(AiBridgeAudioOutputStats* out_stats);
+
+// --- Voice turn tracing ---
+
+// Every voice turn is stamped, on the monotonic clock, at each
+// AI_BRIDGE_TURN_STAGE_*: the native VAD, recognizer, LLM and TTS stamp
+// their own stages, and the app stamps the ones a platform recognizer or
+// TTS reports. A turn opens at speech end (the native VAD opens one per
+// segment); the LLM request answering it is attached with
+// native_trace_attach_request, after which the LLM and TTS stages are
+// stamped by request id. Where turn_id is 0, the newest turn is meant.
+//
+// Opens a turn whose speech ended now and returns its id.
+DART_EXPORT int64_t native_trace_begin_turn();
+// Stamps `stage` of a turn now; a stage already stamped keeps its time.
+DART_EXPORT void native_trace_mark(int64_t turn_id, int32_t stage);
+DART_EXPORT void native_trace_attach_request(int64_t turn_id, int64_t request_id);
+// Stamps `stage` of the turn answered by request_id now.
+DART_EXPORT void native_trace_mark_request(int64_t request_id, int32_t stage);
+// Ends the turn answered by request_id where it is, e.g. when the user cut
+// its reply off. Cancelled replies end their turn by themselves.
+DART_EXPORT void native_trace_abandon_request(int64_t request_id);
+// Fills up to `count` AI_BRIDGE_TURN_SPAN_* histograms summarized over the
+// turns finished so far (played out, or abandoned); returns how many.
+DART_EXPORT int32_t native_get_turn_spans(AiBridgeTurnSpanStats* out_spans, int32_t count);
+// Writes the last 64 turns as Chrome trace event JSON (chrome://tracing,
+// Perfetto) to `out`, NUL-terminated and truncated to `capacity` bytes, and
+// returns the full length without the NUL, as snprintf does. Call with
+// capacity 0 to size the buffer.
+DART_EXPORT int32_t native_trace_dump_json(char* out, int32_t capacity);
+
+
+// --- Metrics ---
+
+// Counters, gauges and histograms the native side keeps instead of logging
+// a line per event. Indices into a snapshot; new ones are only appended.
+#define AI_BRIDGE_METRIC_COUNTER_TOKENS_GENERATED 0
+#define AI_BRIDGE_METRIC_COUNTER_PREFILL_TOKENS 1
+#define AI_BRIDGE_METRIC_COUNTER_DECODE_STEPS 2
+#define AI_BRIDGE_METRIC_COUNTER_REQUESTS_QUEUED 3
+#define AI_BRIDGE_METRIC_COUNTER_REQUESTS_REJECTED 4
+#define AI_BRIDGE_METRIC_COUNTER_REQUESTS_CANCELLED 5
+#define AI_BRIDGE_METRIC_COUNTER_REPLIES_COMPLETED 6
+#define AI_BRIDGE_METRIC_COUNTER_REPLIES_FAILED 7
+#define AI_BRIDGE_METRIC_COUNTER_DART_POSTS 8
+#define AI_BRIDGE_METRIC_COUNTER_DART_POST_FAILURES 9
+#define AI_BRIDGE_METRIC_COUNTER_LOG_RECORDS_DROPPED 10
+#define AI_BRIDGE_METRIC_COUNTER_POOL_TASKS_STOLEN 11
+#define AI_BRIDGE_METRIC_COUNTER_POOL_HELPER_YIELDS 12
+
+#define AI_BRIDGE_METRIC_GAUGE_QUEUE_DEPTH 0
+#define AI_BRIDGE_METRIC_GAUGE_ACTIVE_SESSIONS 1
+#define AI_BRIDGE_METRIC_GAUGE_KV_PAGES_IN_USE 2
+#define AI_BRIDGE_METRIC_GAUGE_KV_PAGES_SHARED 3
+
+#define AI_BRIDGE_METRIC_HISTOGRAM_QUEUE_WAIT_US 0
+#define AI_BRIDGE_METRIC_HISTOGRAM_FIRST_TOKEN_US 1
+#define AI_BRIDGE_METRIC_HISTOGRAM_DECODE_STEP_US 2
+#define AI_BRIDGE_METRIC_HISTOGRAM_PREFILL_TOKENS_PER_SECOND 3
+#define AI_BRIDGE_METRIC_HISTOGRAM_DECODE_TOKENS_PER_SECOND 4
+#define AI_BRIDGE_METRIC_HISTOGRAM_POOL_HIGH_PRIORITY_WAIT_US 5
+
+// Writes a snapshot of every metric to `out` if `capacity` bytes hold it
+// and returns its size either way; call with capacity 0 to size the buffer.
+// Little-endian:
+//   u32 magic 0x4d424941 ("AIBM"), u16 version (1), u16 counters,
+//   u16 gauges, u16 histograms, u32 reserved, i64 taken_at_us (monotonic)
+//   i64 value                                    per counter
+//   i64 value, i64 max                           per gauge
+//   i64 count, sum, max, p50, p90, p99           per histogram
+// A reader skips entries past the counts it knows.
+DART_EXPORT int32_t native_snapshot_metrics(uint8_t* out, int32_t capacity);
+
+// Posts the same snapshot to `port` as a Uint8List; returns 1 if it was
+// posted.
+DART_EXPORT int32_t native_post_metrics_snapshot(Dart_Port port);
+
+#endif  // AI_BRIDGE_AI_BRIDGE_H_
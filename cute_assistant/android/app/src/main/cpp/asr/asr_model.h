@@ -0,0 +1,63 @@
+#ifndef AI_BRIDGE_ASR_ASR_MODEL_H_
+#define AI_BRIDGE_ASR_ASR_MODEL_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ai_bridge {
+
+using AsrToken = int32_t;
+
+constexpr int32_t kAsrSampleRate = 16000;
+
+// A decoded token and the encoder frames [start_frame, end_frame) it was
+// read from.
+struct AsrDecodedToken {
+    AsrToken token = 0;
+    int32_t start_frame = 0;
+    int32_t end_frame = 0;
+};
+
+// Speech recognizer shaped after streaming encoder/decoder ASR (chunked
+// conformer transducers; whisper.cpp over sliding windows): 16 kHz mono
+// audio is encoded into one feature vector per frame_samples() samples, and
+// a greedy decoder turns encoder frames into tokens. A whisper or
+// transducer backend slots in behind this interface. Models are driven from
+// one thread.
+//
+// The encoder works in chunks of chunk_frames() frames, each attending to
+// itself and up to context_frames() frames before it (from states it keeps,
+// or recomputed from the audio). Frames of a complete chunk therefore never
+// change as audio is appended, and a streaming caller encodes each chunk
+// once; only the incomplete last chunk is re-encoded.
+class AsrModel {
+public:
+    virtual ~AsrModel() = default;
+
+    virtual const char* name() const = 0;
+    // Audio per encoder frame.
+    virtual int32_t frame_samples() const = 0;
+    // Floats per encoder frame.
+    virtual int32_t feature_size() const = 0;
+    virtual int32_t chunk_frames() const = 0;
+    virtual int32_t context_frames() const = 0;
+
+    // Encodes frames [begin_frame, begin_frame + frame_count) of the
+    // utterance starting at `utterance` (which must hold their audio and
+    // their left context), appending them to `frames`. begin_frame is a
+    // multiple of chunk_frames().
+    virtual void encode(const float* utterance, size_t begin_frame, size_t frame_count, std::vector<float>* frames) = 0;
+    // Greedy decode of encoder frames [begin_frame, frame_count) of
+    // `frames`, continuing after the tokens in `prefix` (already decoded from
+    // the frames before begin_frame). Replaces `tokens`.
+    virtual void decode(const float* frames, size_t begin_frame, size_t frame_count,
+                        const std::vector<AsrToken>& prefix, std::vector<AsrDecodedToken>* tokens) = 0;
+    // Text of one token, with a leading space where a word starts.
+    virtual std::string token_text(AsrToken token) const = 0;
+};
+
+}  // namespace ai_bridge
+
+#endif  // AI_BRIDGE_ASR_ASR_MODEL_H_
@@ -0,0 +1,272 @@
+#include "asr/asr_service.h"
+
+#include <algorithm>
+#include <cstddef>
+
+#include "asr/sim_asr_model.h"
+#include "core/dart_messages.h"
+#include "core/log.h"
+#include "core/thread_pool.h"
+#include "core/turn_trace.h"
+
+namespace ai_bridge {
+
+namespace {
+
+// Speech in flight between the VAD and ASR threads: room for the ASR thread
+// to spend a few seconds inside the model before the VAD has to drop audio.
+constexpr size_t kAudioRingSeconds = 5;
+constexpr size_t kControlSlots = 64;
+constexpr auto kIdleWait = std::chrono::milliseconds(10);
+
+int64_t MicrosSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+int64_t SamplesToMs(size_t samples) { return static_cast<int64_t>(samples) * 1000 / kAsrSampleRate; }
+
+}  // namespace
+
+AsrService::AsrService()
+    : audio_(kAudioRingSeconds * kAsrSampleRate, 0), controls_(kControlSlots) {}
+
+AsrService::~AsrService() { stop(); }
+
+bool AsrService::start(const AsrOptions& options, Dart_Port transcripts, Dart_Port metrics, std::string* error) {
+    stop();
+    if (options.partial_interval_ms <= 0 || options.max_utterance_ms <= 0) {
+        *error = "ASR partial interval and utterance limit must be positive";
+        return false;
+    }
+    options_ = options;
+    transcript_port_ = transcripts;
+    metrics_port_ = metrics;
+    // A whisper or transducer backend replaces the placeholder here once
+    // its weights ship.
+    if (!model_) model_.reset(new SimAsrModel());
+    utterance_.reserve(static_cast<size_t>(options_.max_utterance_ms) * kAsrSampleRate / 1000);
+    frames_.reserve(utterance_.capacity() / static_cast<size_t>(model_->frame_samples()) *
+                    static_cast<size_t>(model_->feature_size()));
+
+    running_.store(true, std::memory_order_release);
+    thread_ = std::thread(&AsrService::run, this);
+    LOGI("ASR started (%s model, partials every %d ms)", model_->name(),
+         options_.partial_interval_ms);
+    return true;
+}
+
+void AsrService::stop() {
+    if (!thread_.joinable()) return;
+    running_.store(false, std::memory_order_release);
+    thread_.join();
+}
+
+void AsrService::on_speech_start(int64_t) {
+    if (!running()) return;
+    Control control;
+    control.type = Control::kStart;
+    control.position = written_;
+    push_control(control);
+}
+
+void AsrService::on_speech_audio(const PcmSpan& audio) {
+    if (!running()) return;
+    size_t accepted = audio_.write(audio.first, audio.first_size);
+    if (accepted == audio.first_size) accepted += audio_.write(audio.second, audio.second_size);
+    written_ += accepted;
+    if (accepted < audio.size()) {
+        samples_dropped_.fetch_add(static_cast<int64_t>(audio.size() - accepted), std::memory_order_relaxed);
+    }
+}
+
+void AsrService::on_speech_end(int64_t, int64_t, bool submitted, int64_t turn_id) {
+    if (!running()) return;
+    Control control;
+    control.type = Control::kEnd;
+    control.position = written_;
+    control.submitted = submitted;
+    control.turn_id = turn_id;
+    control.at = std::chrono::steady_clock::now();
+    push_control(control);
+}
+
+void AsrService::push_control(const Control& control) {
+    Control* slot = controls_.try_claim();
+    if (slot == nullptr) {
+        LOGE("ASR control ring full; utterance boundary lost");
+        return;
+    }
+    *slot = control;
+    controls_.publish();
+}
+
+void AsrService::run() {
+    // Whatever an earlier run left behind belongs to no utterance.
+    open_ = false;
+    while (audio_.available() > 0) audio_.consume(audio_.available());
+    while (controls_.front() != nullptr) controls_.pop();
+
+    const size_t max_samples = utterance_.capacity();
+    const size_t partial_samples = static_cast<size_t>(options_.partial_interval_ms) * kAsrSampleRate / 1000;
+    for (;;) {
+        // Sink calls stop with running_, so once it is clear only what is
+        // queued remains: finish that without further partials.
+        const bool stopping = !running_.load(std::memory_order_acquire);
+        bool progressed = false;
+        // Audio up to the next boundary, then the boundary itself. A
+        // boundary pushed while run() was discarding stale audio may lie
+        // behind the read position; it applies at once.
+        const Control* control = controls_.front();
+        const uint64_t read = audio_.read_position();
+        const size_t until_control =
+            control != nullptr ? static_cast<size_t>(control->position > read ? control->position - read : 0)
+                               : audio_.available();
+        const size_t take = std::min(audio_.available(), until_control);
+        PcmSpan span;
+        if (take > 0 && audio_.peek(take, &span)) {
+            if (open_) {
+                const size_t room = max_samples - utterance_.size();
+                const size_t first = std::min(span.first_size, room);
+                utterance_.insert(utterance_.end(), span.first, span.first + first);
+                const size_t second = std::min(span.second_size, room - first);
+                utterance_.insert(utterance_.end(), span.second, span.second + second);
+            }
+            audio_.consume(take);
+            progressed = true;
+        }
+        if (control != nullptr && audio_.read_position() >= control->position) {
+            apply(*control);
+            controls_.pop();
+            progressed = true;
+        }
+        if (!stopping && open_ && utterance_.size() >= partial_at_ + partial_samples) {
+            partial_at_ = utterance_.size();
+            std::string stable;
+            std::string text = recognize(false, &stable);
+            if (text != last_partial_) {
+                SendTextEventToDart(transcript_port_, "asr_partial", utterance_id_, {text, stable});
+                partials_.fetch_add(1, std::memory_order_relaxed);
+                last_partial_ = std::move(text);
+            }
+            progressed = true;
+        }
+        if (!progressed) {
+            if (stopping) break;
+            std::this_thread::sleep_for(kIdleWait);
+        }
+    }
+}
+
+void AsrService::apply(const Control& control) {
+    if (control.type == Control::kStart) {
+        open_ = true;
+        ++utterance_id_;
+        utterance_.clear();
+        partial_at_ = 0;
+        last_partial_.clear();
+        frames_.clear();
+        committed_frame_ = 0;
+        committed_.clear();
+        committed_text_.clear();
+        previous_.clear();
+        utterance_encoded_ms_ = utterance_encode_us_ = utterance_decode_us_ = 0;
+        return;
+    }
+    if (!open_) return;
+    open_ = false;
+    if (!control.submitted) {
+        SendEventToDart(transcript_port_, "asr_discarded", {utterance_id_});
+        return;
+    }
+    std::string stable;
+    const std::string text = recognize(true, &stable);
+    SendTextEventToDart(transcript_port_, "asr_final", utterance_id_, {text});
+    // Not the newest turn: speech may have ended again since.
+    if (control.turn_id != 0) {
+        VoiceTurnTrace().mark(control.turn_id, TurnStage::kTranscriptFinal, TurnTrace::NowMicros());
+    }
+    const int64_t finalize_us = MicrosSince(control.at);
+    const int64_t audio_ms = SamplesToMs(utterance_.size());
+    SendEventToDart(metrics_port_, "asr_utterance",
+                    {utterance_id_, audio_ms, utterance_encoded_ms_, utterance_encode_us_, utterance_decode_us_,
+                     finalize_us});
+    utterances_.fetch_add(1, std::memory_order_relaxed);
+    audio_ms_.fetch_add(audio_ms, std::memory_order_relaxed);
+    finalize_us_.fetch_add(finalize_us, std::memory_order_relaxed);
+}
+
+std::string AsrService::recognize(bool final, std::string* stable) {
+    const size_t hop = static_cast<size_t>(model_->frame_samples());
+    const size_t width = static_cast<size_t>(model_->feature_size());
+    const size_t chunk = static_cast<size_t>(model_->chunk_frames());
+    const size_t frame_count = utterance_.size() / hop;
+    const size_t complete = frame_count / chunk * chunk;
+
+    // Complete chunks are encoded once and kept; the incomplete tail is
+    // encoded into the same buffer and dropped again after decoding.
+    // The model runs on the compute pool ahead of any prefill, since the
+    // reply cannot start before the transcript is final.
+    const size_t cached = frames_.size() / width;
+    int64_t encode_us = 0;
+    int64_t decode_us = 0;
+    ComputePool().run_sync(TaskPriority::kHigh, CoreHint::kBig, [&] {
+        const auto encode_start = std::chrono::steady_clock::now();
+        if (complete > cached) model_->encode(utterance_.data(), cached, complete - cached, &frames_);
+        if (frame_count > complete) model_->encode(utterance_.data(), complete, frame_count - complete, &frames_);
+        encode_us = MicrosSince(encode_start);
+        const auto decode_start = std::chrono::steady_clock::now();
+        model_->decode(frames_.data(), committed_frame_, frame_count, committed_, &hypothesis_);
+        decode_us = MicrosSince(decode_start);
+    });
+    const size_t encoded = frame_count - cached;
+    frames_.resize(complete * width);
+
+    const int64_t encoded_ms = SamplesToMs(encoded * hop);
+    utterance_encoded_ms_ += encoded_ms;
+    utterance_encode_us_ += encode_us;
+    utterance_decode_us_ += decode_us;
+    encoded_ms_.fetch_add(encoded_ms, std::memory_order_relaxed);
+    encode_us_.fetch_add(encode_us, std::memory_order_relaxed);
+    decode_us_.fetch_add(decode_us, std::memory_order_relaxed);
+
+    // Local agreement: commit the common prefix of this hypothesis and the
+    // previous one. A token reaching the end of the audio may still be
+    // growing, so it is never committed before the final.
+    size_t agreed = 0;
+    if (final) {
+        agreed = hypothesis_.size();
+    } else {
+        while (agreed < hypothesis_.size() && agreed < previous_.size() &&
+               hypothesis_[agreed].token == previous_[agreed].token &&
+               static_cast<size_t>(hypothesis_[agreed].end_frame) < frame_count) {
+            ++agreed;
+        }
+    }
+    for (size_t i = 0; i < agreed; ++i) {
+        committed_.push_back(hypothesis_[i].token);
+        committed_text_ += model_->token_text(hypothesis_[i].token);
+        committed_frame_ = static_cast<size_t>(hypothesis_[i].end_frame);
+    }
+    previous_.assign(hypothesis_.begin() + static_cast<std::ptrdiff_t>(agreed), hypothesis_.end());
+
+    std::string text = committed_text_;
+    for (const AsrDecodedToken& token : previous_) text += model_->token_text(token.token);
+    const size_t lead = !text.empty() && text[0] == ' ' ? 1 : 0;
+    *stable = committed_text_.substr(std::min(lead, committed_text_.size()));
+    return text.substr(lead);
+}
+
+AsrStats AsrService::stats() const {
+    AsrStats stats;
+    stats.utterances = utterances_.load(std::memory_order_relaxed);
+    stats.partials = partials_.load(std::memory_order_relaxed);
+    stats.audio_ms = audio_ms_.load(std::memory_order_relaxed);
+    stats.encoded_ms = encoded_ms_.load(std::memory_order_relaxed);
+    stats.encode_us = encode_us_.load(std::memory_order_relaxed);
+    stats.decode_us = decode_us_.load(std::memory_order_relaxed);
+    stats.finalize_us = finalize_us_.load(std::memory_order_relaxed);
+    stats.samples_dropped = samples_dropped_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+}  // namespace ai_bridge
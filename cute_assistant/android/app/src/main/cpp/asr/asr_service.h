@@ -0,0 +1,145 @@
+#ifndef AI_BRIDGE_ASR_ASR_SERVICE_H_
+#define AI_BRIDGE_ASR_ASR_SERVICE_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "asr/asr_model.h"
+#include "audio/pcm_ring.h"
+#include "audio/vad_service.h"
+#include "core/spsc_ring.h"
+#include "dart_api_dl.h"
+
+namespace ai_bridge {
+
+struct AsrOptions {
+    // New audio between partial hypotheses.
+    int32_t partial_interval_ms = 300;
+    // Audio beyond this is not transcribed (speech_to_text's listenFor).
+    int32_t max_utterance_ms = 30000;
+};
+
+struct AsrStats {
+    int64_t utterances = 0;      // finalized
+    int64_t partials = 0;        // partial hypotheses posted
+    int64_t audio_ms = 0;        // speech transcribed
+    int64_t encoded_ms = 0;      // audio run through the encoder, re-encoded tails included
+    int64_t encode_us = 0;
+    int64_t decode_us = 0;
+    int64_t finalize_us = 0;     // total, VAD end event to final transcript
+    int64_t samples_dropped = 0; // speech the ASR thread had no room for
+};
+
+// Streaming speech recognition of VAD segments.
+//
+// Registered as the VadService's SpeechSink: confirmed speech, pre-speech
+// pad included, is copied once from the capture ring into the ASR's own
+// ring on the VAD thread, and an ASR thread gathers it per utterance. Every
+// partial_interval_ms of new audio it posts a partial hypothesis; the VAD's
+// end event finalizes the utterance.
+//
+// Work per partial stays bounded however long the dictation runs. Encoder
+// frames of complete chunks are cached, so only new audio and the
+// incomplete last chunk go through the encoder. Hypotheses are stabilized
+// by local agreement: tokens on which two consecutive hypotheses agree are
+// committed, and the decoder restarts after the last committed token
+// instead of at the start of the utterance. On the transcript port:
+//   ["asr_partial", utterance_id, text, stable]  when the hypothesis changed;
+//                                                stable is the committed
+//                                                prefix of text
+//   ["asr_final", utterance_id, text]
+//   ["asr_discarded", utterance_id]       speech dropped on pause
+// and on the metrics port, per final transcript:
+//   ["asr_utterance", utterance_id, audio_ms, encoded_ms, encode_us,
+//    decode_us, finalize_us]
+// finalize_us runs from the VAD end event to the final post. Utterance ids
+// count from 1.
+class AsrService : public SpeechSink {
+public:
+    AsrService();
+    ~AsrService() override;
+
+    AsrService(const AsrService&) = delete;
+    AsrService& operator=(const AsrService&) = delete;
+
+    bool start(const AsrOptions& options, Dart_Port transcripts, Dart_Port metrics, std::string* error);
+    // Finishes the utterance in flight, if its end was already seen, and
+    // discards the rest.
+    void stop();
+    bool running() const { return running_.load(std::memory_order_acquire); }
+
+    AsrModel* model() { return model_.get(); }
+    AsrStats stats() const;
+
+    // SpeechSink, called on the VAD thread. Ignored while stopped.
+    void on_speech_start(int64_t start_sample) override;
+    void on_speech_audio(const PcmSpan& audio) override;
+    void on_speech_end(int64_t start_sample, int64_t end_sample, bool submitted, int64_t turn_id) override;
+
+private:
+    // Utterance boundaries, ordered against the audio by ring position.
+    struct Control {
+        enum Type { kStart, kEnd } type = kStart;
+        uint64_t position = 0;  // audio ring position the control applies at
+        bool submitted = false;
+        int64_t turn_id = 0;  // kEnd: the trace turn the end opened, if any
+        std::chrono::steady_clock::time_point at;
+    };
+
+    void run();
+    void push_control(const Control& control);
+    void apply(const Control& control);
+    // Encodes the open utterance's new audio and decodes after the committed
+    // tokens. A partial commits what agrees with the previous hypothesis;
+    // the final commits everything. Returns the text; *stable is its
+    // committed prefix.
+    std::string recognize(bool final, std::string* stable);
+
+    AsrOptions options_;
+    Dart_Port transcript_port_ = ILLEGAL_PORT;
+    Dart_Port metrics_port_ = ILLEGAL_PORT;
+    std::unique_ptr<AsrModel> model_;
+
+    // VAD thread -> ASR thread. Allocated once so a late sink call never
+    // touches freed memory.
+    PcmRing audio_;
+    SpscRing<Control> controls_;
+    uint64_t written_ = 0;  // VAD thread: samples accepted into audio_
+
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+
+    // ASR thread.
+    bool open_ = false;
+    int64_t utterance_id_ = 0;
+    std::vector<float> utterance_;
+    size_t partial_at_ = 0;  // utterance_ size at the last partial
+    std::string last_partial_;
+    int64_t utterance_encoded_ms_ = 0;
+    int64_t utterance_encode_us_ = 0;
+    int64_t utterance_decode_us_ = 0;
+    std::vector<float> frames_;             // encoder frames of complete chunks
+    size_t committed_frame_ = 0;            // decoding resumes here
+    std::vector<AsrToken> committed_;
+    std::string committed_text_;
+    std::vector<AsrDecodedToken> hypothesis_;  // after committed_
+    std::vector<AsrDecodedToken> previous_;    // the last partial's, rebased
+
+    std::atomic<int64_t> utterances_{0};
+    std::atomic<int64_t> partials_{0};
+    std::atomic<int64_t> audio_ms_{0};
+    std::atomic<int64_t> encoded_ms_{0};
+    std::atomic<int64_t> encode_us_{0};
+    std::atomic<int64_t> decode_us_{0};
+    std::atomic<int64_t> finalize_us_{0};
+    std::atomic<int64_t> samples_dropped_{0};
+};
+
+}  // namespace ai_bridge
+
+#endif  // AI_BRIDGE_ASR_ASR_SERVICE_H_
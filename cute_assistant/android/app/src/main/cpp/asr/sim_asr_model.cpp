@@ -0,0 +1,93 @@
+#include "asr/sim_asr_model.h"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#include "audio/frame_features.h"
+
+namespace ai_bridge {
+
+namespace {
+
+constexpr const char* kVocabulary[] = {
+    "hello", "there", "what", "is",    "the",   "weather", "like",  "today", "can",  "you",   "tell",
+    "me",    "a",     "joke", "about", "cats",  "please",  "set",   "timer", "for",  "ten",   "minutes",
+    "play",  "some",  "music", "how",  "far",   "moon",    "thanks", "good", "night", "morning",
+};
+constexpr int32_t kVocabularySize = static_cast<int32_t>(sizeof(kVocabulary) / sizeof(kVocabulary[0]));
+
+// A frame is voiced when it is loud enough and not hiss.
+constexpr float kVoicedDb = -40.0f;
+constexpr float kVoicedMaxZeroCrossingRate = 0.35f;
+// Runs shorter than this are clicks; gaps shorter than this join runs.
+constexpr int32_t kMinWordFrames = 5;  // 100 ms
+constexpr int32_t kMinGapFrames = 4;   // 80 ms
+
+void SleepMicros(int64_t us) {
+    if (us > 0) std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+}  // namespace
+
+SimAsrModel::SimAsrModel()
+    : encode_us_per_second_(SimAsrTiming().encode_us_per_second),
+      decode_us_per_token_(SimAsrTiming().decode_us_per_token) {}
+
+void SimAsrModel::set_timing(const SimAsrTiming& timing) {
+    encode_us_per_second_.store(std::max(0, timing.encode_us_per_second), std::memory_order_relaxed);
+    decode_us_per_token_.store(std::max(0, timing.decode_us_per_token), std::memory_order_relaxed);
+}
+
+void SimAsrModel::encode(const float* utterance, size_t begin_frame, size_t frame_count, std::vector<float>* frames) {
+    const size_t hop = static_cast<size_t>(frame_samples());
+    const size_t first = frames->size();
+    frames->resize(first + frame_count * 2);
+    for (size_t f = 0; f < frame_count; ++f) {
+        const FrameFeatures features = ComputeFrameFeatures(utterance + (begin_frame + f) * hop, hop);
+        (*frames)[first + 2 * f] = features.rms_db;
+        (*frames)[first + 2 * f + 1] = features.zero_crossing_rate;
+    }
+    SleepMicros(static_cast<int64_t>(encode_us_per_second_.load(std::memory_order_relaxed)) *
+                static_cast<int64_t>(frame_count * hop) / kAsrSampleRate);
+}
+
+void SimAsrModel::decode(const float* frames, size_t begin_frame, size_t frame_count, const std::vector<AsrToken>&,
+                         std::vector<AsrDecodedToken>* tokens) {
+    tokens->clear();
+    int32_t run = 0, gap = 0, run_start = 0;
+    float run_db = 0.0f;
+    auto emit = [&](int32_t end) {
+        if (run >= kMinWordFrames) {
+            // Length in 100 ms steps and level in 6 dB steps pick the word.
+            const int32_t length_bucket = run / kMinWordFrames;
+            const int32_t level_bucket = static_cast<int32_t>(-run_db / static_cast<float>(run) / 6.0f);
+            tokens->push_back({(length_bucket * 7 + level_bucket * 3) % kVocabularySize, run_start, end});
+        }
+        run = 0;
+        run_db = 0.0f;
+    };
+    for (size_t f = begin_frame; f < frame_count; ++f) {
+        const float db = frames[2 * f];
+        const bool voiced = db > kVoicedDb && frames[2 * f + 1] < kVoicedMaxZeroCrossingRate;
+        if (voiced) {
+            if (run == 0) run_start = static_cast<int32_t>(f);
+            ++run;
+            run_db += db;
+            gap = 0;
+        } else if (run > 0 && ++gap >= kMinGapFrames) {
+            emit(static_cast<int32_t>(f + 1));
+            gap = 0;
+        }
+    }
+    emit(static_cast<int32_t>(frame_count));  // a run still open at the end
+    SleepMicros(static_cast<int64_t>(decode_us_per_token_.load(std::memory_order_relaxed)) *
+                static_cast<int64_t>(tokens->size()));
+}
+
+std::string SimAsrModel::token_text(AsrToken token) const {
+    if (token < 0 || token >= kVocabularySize) return std::string();
+    return std::string(" ") + kVocabulary[token];
+}
+
+}  // namespace ai_bridge
@@ -0,0 +1,53 @@
+#ifndef AI_BRIDGE_ASR_SIM_ASR_MODEL_H_
+#define AI_BRIDGE_ASR_SIM_ASR_MODEL_H_
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include "asr/asr_model.h"
+
+namespace ai_bridge {
+
+// Cost model for SimAsrModel: encode() costs encode_us_per_second per
+// second of audio it encodes (left context comes from cached states, as in
+// Emformer-style encoders, and is free); decode() costs
+// decode_us_per_token per token it emits. The defaults are in the range
+// of a small whisper model on a phone CPU.
+struct SimAsrTiming {
+    int32_t encode_us_per_second = 40000;
+    int32_t decode_us_per_token = 1500;
+};
+
+// Placeholder recognizer used until ASR weights are bundled.
+//
+// Its encoder frames are 20 ms of level and zero-crossing rate; its decoder
+// turns every voiced run of 100 ms or more into one word of a fixed
+// vocabulary, picked by the run's length and level. A run still open at the
+// end of the audio yields a word that may change as the run grows, which
+// is what partial hypotheses of real models look like at their edge.
+class SimAsrModel : public AsrModel {
+public:
+    SimAsrModel();
+
+    void set_timing(const SimAsrTiming& timing);
+
+    const char* name() const override { return "sim"; }
+    int32_t frame_samples() const override { return kAsrSampleRate / 50; }
+    int32_t feature_size() const override { return 2; }
+    int32_t chunk_frames() const override { return 16; }    // 320 ms
+    int32_t context_frames() const override { return 50; }  // 1 s
+
+    void encode(const float* utterance, size_t begin_frame, size_t frame_count, std::vector<float>* frames) override;
+    void decode(const float* frames, size_t begin_frame, size_t frame_count, const std::vector<AsrToken>& prefix,
+                std::vector<AsrDecodedToken>* tokens) override;
+    std::string token_text(AsrToken token) const override;
+
+private:
+    std::atomic<int32_t> encode_us_per_second_;
+    std::atomic<int32_t> decode_us_per_token_;
+};
+
+}  // namespace ai_bridge
+
+#endif  // AI_BRIDGE_ASR_SIM_ASR_MODEL_H_
@@ -0,0 +1,47 @@
+#include "audio/aaudio_api.h"
+
+#if defined(__ANDROID__)
+
+#include <dlfcn.h>
+
+namespace ai_bridge {
+
+namespace {
+
+template <typename Fn>
+bool Resolve(void* library, const char* symbol, Fn* out) {
+    *out = reinterpret_cast<Fn>(dlsym(library, symbol));
+    return *out != nullptr;
+}
+
+}  // namespace
+
+const AAudioApi& GetAAudioApi() {
+    static const AAudioApi api = [] {
+        AAudioApi a = {};
+        void* library = dlopen("libaaudio.so", RTLD_NOW | RTLD_LOCAL);
+        if (library == nullptr) return a;
+        a.loaded = Resolve(library, "AAudio_createStreamBuilder", &a.create_builder) &&
+                   Resolve(library, "AAudioStreamBuilder_setDirection", &a.set_direction) &&
+                   Resolve(library, "AAudioStreamBuilder_setSampleRate", &a.set_sample_rate) &&
+                   Resolve(library, "AAudioStreamBuilder_setChannelCount", &a.set_channel_count) &&
+                   Resolve(library, "AAudioStreamBuilder_setFormat", &a.set_format) &&
+                   Resolve(library, "AAudioStreamBuilder_setPerformanceMode", &a.set_performance_mode) &&
+                   Resolve(library, "AAudioStreamBuilder_setDataCallback", &a.set_data_callback) &&
+                   Resolve(library, "AAudioStreamBuilder_openStream", &a.open_stream) &&
+                   Resolve(library, "AAudioStreamBuilder_delete", &a.delete_builder) &&
+                   Resolve(library, "AAudioStream_requestStart", &a.request_start) &&
+                   Resolve(library, "AAudioStream_requestStop", &a.request_stop) &&
+                   Resolve(library, "AAudioStream_close", &a.close) &&
+                   Resolve(library, "AAudioStream_getSampleRate", &a.get_sample_rate) &&
+                   Resolve(library, "AAudio_convertResultToText", &a.result_text);
+        Resolve(library, "AAudioStreamBuilder_setInputPreset", &a.set_input_preset);
+        Resolve(library, "AAudioStreamBuilder_setUsage", &a.set_usage);
+        return a;
+    }();
+    return api;
+}
+
+}  // namespace ai_bridge
+
+#endif  // __ANDROID__
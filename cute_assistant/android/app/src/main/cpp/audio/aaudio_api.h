@@ -0,0 +1,39 @@
+#ifndef AI_BRIDGE_AUDIO_AAUDIO_API_H_
+#define AI_BRIDGE_AUDIO_AAUDIO_API_H_
+
+#if defined(__ANDROID__)
+
+#include <aaudio/AAudio.h>
+
+namespace ai_bridge {
+
+// The subset of libaaudio capture and playback need, resolved once. The
+// app's minSdk predates AAudio (API 26), so the library is loaded at
+// runtime and `loaded` is false where it is missing.
+struct AAudioApi {
+    aaudio_result_t (*create_builder)(AAudioStreamBuilder**);
+    void (*set_direction)(AAudioStreamBuilder*, aaudio_direction_t);
+    void (*set_sample_rate)(AAudioStreamBuilder*, int32_t);
+    void (*set_channel_count)(AAudioStreamBuilder*, int32_t);
+    void (*set_format)(AAudioStreamBuilder*, aaudio_format_t);
+    void (*set_performance_mode)(AAudioStreamBuilder*, aaudio_performance_mode_t);
+    void (*set_input_preset)(AAudioStreamBuilder*, int32_t);  // API 28; may be null
+    void (*set_usage)(AAudioStreamBuilder*, int32_t);         // API 28; may be null
+    void (*set_data_callback)(AAudioStreamBuilder*, AAudioStream_dataCallback, void*);
+    aaudio_result_t (*open_stream)(AAudioStreamBuilder*, AAudioStream**);
+    aaudio_result_t (*delete_builder)(AAudioStreamBuilder*);
+    aaudio_result_t (*request_start)(AAudioStream*);
+    aaudio_result_t (*request_stop)(AAudioStream*);
+    aaudio_result_t (*close)(AAudioStream*);
+    int32_t (*get_sample_rate)(AAudioStream*);
+    const char* (*result_text)(aaudio_result_t);
+    bool loaded = false;
+};
+
+const AAudioApi& GetAAudioApi();
+
+}  // namespace ai_bridge
+
+#endif  // __ANDROID__
+
+#endif  // AI_BRIDGE_AUDIO_AAUDIO_API_H_
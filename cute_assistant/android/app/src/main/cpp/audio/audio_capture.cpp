@@ -0,0 +1,95 @@
+#include "audio/audio_capture.h"
+
+#include "audio/aaudio_api.h"
+
+namespace ai_bridge {
+
+#if defined(__ANDROID__)
+
+namespace {
+
+struct CallbackContext {
+    AudioSink sink;
+    void* user_data;
+};
+
+aaudio_data_callback_result_t OnAudio(AAudioStream*, void* user_data, void* audio_data, int32_t frames) {
+    const auto* context = static_cast<const CallbackContext*>(user_data);
+    context->sink(static_cast<const float*>(audio_data), frames, context->user_data);
+    return AAUDIO_CALLBACK_RESULT_CONTINUE;
+}
+
+// One capture at a time: the VAD owns the microphone.
+CallbackContext g_callback_context;
+
+}  // namespace
+
+AudioCapture::~AudioCapture() { stop(); }
+
+bool AudioCapture::start(int32_t sample_rate, AudioSink sink, void* user_data, std::string* error) {
+    stop();
+    const AAudioApi& api = GetAAudioApi();
+    if (!api.loaded) {
+        *error = "AAudio is not available on this device (API 26+ required)";
+        return false;
+    }
+    AAudioStreamBuilder* builder = nullptr;
+    aaudio_result_t result = api.create_builder(&builder);
+    if (result != AAUDIO_OK) {
+        *error = std::string("AAudio builder failed: ") + api.result_text(result);
+        return false;
+    }
+    g_callback_context = {sink, user_data};
+    api.set_direction(builder, AAUDIO_DIRECTION_INPUT);
+    api.set_sample_rate(builder, sample_rate);
+    api.set_channel_count(builder, 1);
+    api.set_format(builder, AAUDIO_FORMAT_PCM_FLOAT);
+    api.set_performance_mode(builder, AAUDIO_PERFORMANCE_MODE_LOW_LATENCY);
+    if (api.set_input_preset != nullptr) api.set_input_preset(builder, AAUDIO_INPUT_PRESET_VOICE_RECOGNITION);
+    api.set_data_callback(builder, OnAudio, &g_callback_context);
+
+    AAudioStream* stream = nullptr;
+    result = api.open_stream(builder, &stream);
+    api.delete_builder(builder);
+    if (result != AAUDIO_OK) {
+        *error = std::string("AAudio open failed: ") + api.result_text(result);
+        return false;
+    }
+    if (api.get_sample_rate(stream) != sample_rate) {
+        *error = "AAudio input runs at " + std::to_string(api.get_sample_rate(stream)) + " Hz, not " +
+                 std::to_string(sample_rate);
+        api.close(stream);
+        return false;
+    }
+    result = api.request_start(stream);
+    if (result != AAUDIO_OK) {
+        *error = std::string("AAudio start failed: ") + api.result_text(result);
+        api.close(stream);
+        return false;
+    }
+    stream_ = stream;
+    return true;
+}
+
+void AudioCapture::stop() {
+    if (stream_ == nullptr) return;
+    auto* stream = static_cast<AAudioStream*>(stream_);
+    GetAAudioApi().request_stop(stream);
+    GetAAudioApi().close(stream);  // returns once no callback is running
+    stream_ = nullptr;
+}
+
+#else  // !__ANDROID__
+
+AudioCapture::~AudioCapture() = default;
+
+bool AudioCapture::start(int32_t, AudioSink, void*, std::string* error) {
+    *error = "Native audio capture is only available on Android";
+    return false;
+}
+
+void AudioCapture::stop() {}
+
+#endif
+
+}  // namespace ai_bridge
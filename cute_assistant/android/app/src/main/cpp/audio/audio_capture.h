@@ -0,0 +1,38 @@
+#ifndef AI_BRIDGE_AUDIO_AUDIO_CAPTURE_H_
+#define AI_BRIDGE_AUDIO_AUDIO_CAPTURE_H_
+
+#include <cstdint>
+#include <string>
+
+namespace ai_bridge {
+
+// Receives captured mono float PCM on the audio thread. Must not block,
+// allocate or lock.
+using AudioSink = void (*)(const float* samples, int32_t count, void* user_data);
+
+// Microphone capture through AAudio in low-latency mode.
+//
+// The app's minSdk predates AAudio (API 26), so libaaudio is loaded at
+// runtime; start() fails cleanly on older devices and on host builds, where
+// PCM is pushed in through native_vad_push_pcm instead.
+class AudioCapture {
+public:
+    AudioCapture() = default;
+    ~AudioCapture();
+
+    AudioCapture(const AudioCapture&) = delete;
+    AudioCapture& operator=(const AudioCapture&) = delete;
+
+    // Opens the default input at `sample_rate` Hz mono and starts delivering
+    // to `sink`. Returns false with `error` set if capture is unavailable.
+    bool start(int32_t sample_rate, AudioSink sink, void* user_data, std::string* error);
+    void stop();
+    bool running() const { return stream_ != nullptr; }
+
+private:
+    void* stream_ = nullptr;  // AAudioStream*
+};
+
+}  // namespace ai_bridge
+
+#endif  // AI_BRIDGE_AUDIO_AUDIO_CAPTURE_H_
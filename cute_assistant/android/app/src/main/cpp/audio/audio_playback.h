@@ -0,0 +1,37 @@
+#ifndef AI_BRIDGE_AUDIO_AUDIO_PLAYBACK_H_
+#define AI_BRIDGE_AUDIO_AUDIO_PLAYBACK_H_
+
+#include <cstdint>
+#include <string>
+
+namespace ai_bridge {
+
+// Fills `count` mono float samples to be played, on the audio thread. Must
+// not block, allocate or lock; writes silence when it has nothing to play.
+using AudioSource = void (*)(float* samples, int32_t count, void* user_data);
+
+// Speaker output through AAudio in low-latency mode, the counterpart of
+// AudioCapture. start() fails cleanly before API 26 and on host builds,
+// where PCM is pulled out through native_tts_pull_pcm instead.
+class AudioPlayback {
+public:
+    AudioPlayback() = default;
+    ~AudioPlayback();
+
+    AudioPlayback(const AudioPlayback&) = delete;
+    AudioPlayback& operator=(const AudioPlayback&) = delete;
+
+    // Opens the default output at `sample_rate` Hz mono and starts pulling
+    // from `source`. Returns false with `error` set if playback is
+    // unavailable.
+    bool start(int32_t sample_rate, AudioSource source, void* user_data, std::string* error);
+    void stop();
+    bool running() const { return stream_ != nullptr; }
+
+private:
+    void* stream_ = nullptr;  // AAudioStream*
+};
+
+}  // namespace ai_bridge
+
+#endif  // AI_BRIDGE_AUDIO_AUDIO_PLAYBACK_H_
@@ -0,0 +1,181 @@
+#include "audio/frame_features.h"
+
+#include <cmath>
+#include <cstdint>
+
+#include "core/cpu_features.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define AI_BRIDGE_X86_KERNELS 1
+#endif
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace ai_bridge {
+
+namespace {
+
+// Every path accumulates the same three sums over the frame; only the
+// vector width differs:
+//   energy      sum x[i]^2                      i in [0, count)
+//   diff        sum (x[i] - x[i-1])^2           i in [1, count)
+//   crossings   count of sign bit changes       i in [1, count)
+FrameFeatures Finish(float energy, float diff, uint32_t crossings, size_t count) {
+    FrameFeatures features;
+    if (count == 0) return features;
+    const float mean_square = energy / static_cast<float>(count);
+    features.rms_db = mean_square > 1e-12f ? 10.0f * std::log10(mean_square) : -120.0f;
+    if (count > 1) features.zero_crossing_rate = static_cast<float>(crossings) / static_cast<float>(count - 1);
+    features.high_band_ratio = energy > 1e-12f ? diff / (2.0f * energy) : 0.0f;
+    return features;
+}
+
+// Adds the scalar tail [start, count) to the sums. start >= 1.
+void AccumulateTail(const float* x, size_t start, size_t count, float* energy, float* diff, uint32_t* crossings) {
+    for (size_t i = start; i < count; ++i) {
+        const float d = x[i] - x[i - 1];
+        *energy += x[i] * x[i];
+        *diff += d * d;
+        *crossings += std::signbit(x[i]) != std::signbit(x[i - 1]) ? 1 : 0;
+    }
+}
+
+#if defined(AI_BRIDGE_X86_KERNELS)
+
+__attribute__((target("sse2"))) FrameFeatures ComputeSse2(const float* x, size_t count) {
+    if (count < 2) return ComputeFrameFeaturesScalar(x, count);
+    __m128 energy4 = _mm_setzero_ps();
+    __m128 diff4 = _mm_setzero_ps();
+    uint32_t crossings = 0;
+    size_t i = 1;
+    for (; i + 4 <= count; i += 4) {
+        const __m128 v = _mm_loadu_ps(x + i);
+        const __m128 prev = _mm_loadu_ps(x + i - 1);
+        const __m128 d = _mm_sub_ps(v, prev);
+        energy4 = _mm_add_ps(energy4, _mm_mul_ps(v, v));
+        diff4 = _mm_add_ps(diff4, _mm_mul_ps(d, d));
+        crossings += static_cast<uint32_t>(__builtin_popcount(_mm_movemask_ps(v) ^ _mm_movemask_ps(prev)));
+    }
+    alignas(16) float lanes[4];
+    _mm_store_ps(lanes, energy4);
+    float energy = x[0] * x[0] + (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    _mm_store_ps(lanes, diff4);
+    float diff = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    AccumulateTail(x, i, count, &energy, &diff, &crossings);
+    return Finish(energy, diff, crossings, count);
+}
+
+__attribute__((target("avx2"))) FrameFeatures ComputeAvx2(const float* x, size_t count) {
+    if (count < 2) return ComputeFrameFeaturesScalar(x, count);
+    __m256 energy8 = _mm256_setzero_ps();
+    __m256 diff8 = _mm256_setzero_ps();
+    uint32_t crossings = 0;
+    size_t i = 1;
+    for (; i + 8 <= count; i += 8) {
+        const __m256 v = _mm256_loadu_ps(x + i);
+        const __m256 prev = _mm256_loadu_ps(x + i - 1);
+        const __m256 d = _mm256_sub_ps(v, prev);
+        energy8 = _mm256_add_ps(energy8, _mm256_mul_ps(v, v));
+        diff8 = _mm256_add_ps(diff8, _mm256_mul_ps(d, d));
+        crossings += static_cast<uint32_t>(__builtin_popcount(_mm256_movemask_ps(v) ^ _mm256_movemask_ps(prev)));
+    }
+    const __m128 energy4 = _mm_add_ps(_mm256_castps256_ps128(energy8), _mm256_extractf128_ps(energy8, 1));
+    const __m128 diff4 = _mm_add_ps(_mm256_castps256_ps128(diff8), _mm256_extractf128_ps(diff8, 1));
+    alignas(16) float lanes[4];
+    _mm_store_ps(lanes, energy4);
+    float energy = x[0] * x[0] + (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    _mm_store_ps(lanes, diff4);
+    float diff = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    AccumulateTail(x, i, count, &energy, &diff, &crossings);
+    return Finish(energy, diff, crossings, count);
+}
+
+#endif  // AI_BRIDGE_X86_KERNELS
+
+#if defined(__ARM_NEON)
+
+float HorizontalSum(float32x4_t v) {
+#if defined(__aarch64__)
+    return vaddvq_f32(v);
+#else
+    const float32x2_t pair = vadd_f32(vget_low_f32(v), vget_high_f32(v));
+    return vget_lane_f32(vpadd_f32(pair, pair), 0);
+#endif
+}
+
+uint32_t HorizontalSum(uint32x4_t v) {
+#if defined(__aarch64__)
+    return vaddvq_u32(v);
+#else
+    const uint32x2_t pair = vadd_u32(vget_low_u32(v), vget_high_u32(v));
+    return vget_lane_u32(vpadd_u32(pair, pair), 0);
+#endif
+}
+
+FrameFeatures ComputeNeon(const float* x, size_t count) {
+    if (count < 2) return ComputeFrameFeaturesScalar(x, count);
+    float32x4_t energy4 = vdupq_n_f32(0.0f);
+    float32x4_t diff4 = vdupq_n_f32(0.0f);
+    uint32x4_t crossings4 = vdupq_n_u32(0);
+    size_t i = 1;
+    for (; i + 4 <= count; i += 4) {
+        const float32x4_t v = vld1q_f32(x + i);
+        const float32x4_t prev = vld1q_f32(x + i - 1);
+        const float32x4_t d = vsubq_f32(v, prev);
+        energy4 = vmlaq_f32(energy4, v, v);
+        diff4 = vmlaq_f32(diff4, d, d);
+        const uint32x4_t signs = veorq_u32(vreinterpretq_u32_f32(v), vreinterpretq_u32_f32(prev));
+        crossings4 = vaddq_u32(crossings4, vshrq_n_u32(signs, 31));
+    }
+    float energy = x[0] * x[0] + HorizontalSum(energy4);
+    float diff = HorizontalSum(diff4);
+    uint32_t crossings = HorizontalSum(crossings4);
+    AccumulateTail(x, i, count, &energy, &diff, &crossings);
+    return Finish(energy, diff, crossings, count);
+}
+
+#endif  // __ARM_NEON
+
+using ComputeFn = FrameFeatures (*)(const float*, size_t);
+
+struct Backend {
+    ComputeFn compute;
+    const char* name;
+};
+
+const Backend& SelectedBackend() {
+    static const Backend backend = []() -> Backend {
+#if defined(__ARM_NEON)
+        return {ComputeNeon, "neon"};
+#else
+#if defined(AI_BRIDGE_X86_KERNELS)
+        const CpuFeatures& cpu = GetCpuFeatures();
+        if (cpu.avx2) return {ComputeAvx2, "avx2"};
+        if (cpu.sse2) return {ComputeSse2, "sse2"};
+#endif
+        return {ComputeFrameFeaturesScalar, "scalar"};
+#endif
+    }();
+    return backend;
+}
+
+}  // namespace
+
+FrameFeatures ComputeFrameFeaturesScalar(const float* x, size_t count) {
+    if (count == 0) return Finish(0.0f, 0.0f, 0, 0);
+    float energy = x[0] * x[0];
+    float diff = 0.0f;
+    uint32_t crossings = 0;
+    AccumulateTail(x, 1, count, &energy, &diff, &crossings);
+    return Finish(energy, diff, crossings, count);
+}
+
+FrameFeatures ComputeFrameFeatures(const float* samples, size_t count) {
+    return SelectedBackend().compute(samples, count);
+}
+
+const char* FrameFeaturesBackend() { return SelectedBackend().name; }
+
+}  // namespace ai_bridge
@@ -0,0 +1,29 @@
+#ifndef AI_BRIDGE_AUDIO_FRAME_FEATURES_H_
+#define AI_BRIDGE_AUDIO_FRAME_FEATURES_H_
+
+#include <cstddef>
+
+namespace ai_bridge {
+
+// Cheap per-frame statistics, all from a single pass over the samples.
+struct FrameFeatures {
+    float rms_db = -120.0f;  // RMS level in dBFS
+    // Fraction of adjacent sample pairs whose sign differs.
+    float zero_crossing_rate = 0.0f;
+    // Energy of the first difference over twice the frame energy: the share
+    // of energy in the upper half of the band, roughly. About 1 for white
+    // noise and hiss, well under 0.1 for voiced speech, whose energy sits
+    // below 1 kHz.
+    float high_band_ratio = 0.0f;
+};
+
+// Vectorized with AVX2 or SSE2 on x86 (chosen at runtime) and NEON on ARM.
+FrameFeatures ComputeFrameFeatures(const float* samples, size_t count);
+// The portable reference the SIMD paths must match.
+FrameFeatures ComputeFrameFeaturesScalar(const float* samples, size_t count);
+// "avx2", "sse2", "neon" or "scalar": the path ComputeFrameFeatures takes.
+const char* FrameFeaturesBackend();
+
+}  // namespace ai_bridge
+
+#endif  // AI_BRIDGE_AUDIO_FRAME_FEATURES_H_
@@ -0,0 +1,143 @@
+#include "audio/pcm_output_ring.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace ai_bridge {
+
+namespace {
+
+// Writes timed at once: one per synthesized piece, so a few seconds' worth.
+constexpr size_t kMarkSlots = 256;
+
+int64_t NowMicros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+// Only one thread stores to these, so a plain compare suffices.
+void StoreMax(std::atomic<int64_t>& target, int64_t value) {
+    if (value > target.load(std::memory_order_relaxed)) target.store(value, std::memory_order_relaxed);
+}
+
+}  // namespace
+
+PcmOutputRing::PcmOutputRing(size_t capacity) : ring_(capacity, 0), marks_(kMarkSlots) {}
+
+size_t PcmOutputRing::write(const float* samples, size_t count) {
+    const uint64_t position = written_;
+    const size_t fits = ring_.write(samples, count);
+    if (fits == 0) return 0;
+    written_ += fits;
+    // Unstamped if the consumer is that far behind; the fill level says so.
+    if (Mark* mark = marks_.try_claim()) {
+        mark->position = position;
+        mark->written_at_us = NowMicros();
+        marks_.publish();
+    }
+    return fits;
+}
+
+void PcmOutputRing::flush() {
+    // Published after the samples it covers, so they are all there to skip.
+    discard_before_.store(written_, std::memory_order_release);
+}
+
+void PcmOutputRing::watch(uint64_t position) { watch_position_.store(position, std::memory_order_release); }
+
+bool PcmOutputRing::reached(uint64_t position, int64_t* at_us) const {
+    if (reached_position_.load(std::memory_order_acquire) != position) return false;
+    *at_us = reached_at_us_.load(std::memory_order_relaxed);
+    return true;
+}
+
+size_t PcmOutputRing::read(float* out, size_t count) {
+    const int64_t now_us = NowMicros();
+    callbacks_.fetch_add(1, std::memory_order_relaxed);
+    const int32_t rate = sample_rate_.load(std::memory_order_relaxed);
+    if (last_callback_us_ != 0 && rate > 0) {
+        const int64_t gap_us = now_us - last_callback_us_;
+        StoreMax(max_callback_gap_us_, gap_us);
+        if (gap_us > 2 * static_cast<int64_t>(count) * 1000000 / rate) {
+            late_callbacks_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    last_callback_us_ = now_us;
+
+    const uint64_t discard = discard_before_.load(std::memory_order_acquire);
+    const uint64_t before = ring_.read_position();
+    if (before < discard) {
+        const size_t skip = static_cast<size_t>(std::min<uint64_t>(ring_.available(), discard - before));
+        ring_.consume(skip);
+        samples_discarded_.fetch_add(static_cast<int64_t>(skip), std::memory_order_relaxed);
+    }
+
+    const size_t fill = ring_.available();
+    const bool streaming = streaming_.load(std::memory_order_acquire);
+    if (!streaming) primed_ = false;
+    if (primed_) {
+        const int64_t low = min_fill_samples_.load(std::memory_order_relaxed);
+        if (low < 0 || static_cast<int64_t>(fill) < low) {
+            min_fill_samples_.store(static_cast<int64_t>(fill), std::memory_order_relaxed);
+        }
+    }
+    StoreMax(max_fill_samples_, static_cast<int64_t>(fill));
+
+    size_t take = std::min(count, fill);
+    PcmSpan span;
+    if (take > 0 && ring_.peek(take, &span)) {
+        span.copy_to(out);
+        ring_.consume(take);
+    } else {
+        take = 0;
+    }
+    std::fill(out + take, out + count, 0.0f);
+    samples_played_.fetch_add(static_cast<int64_t>(take), std::memory_order_relaxed);
+    if (primed_ && take < count) {
+        underruns_.fetch_add(1, std::memory_order_relaxed);
+        underrun_samples_.fetch_add(static_cast<int64_t>(count - take), std::memory_order_relaxed);
+    }
+    if (streaming && take > 0) primed_ = true;
+
+    // Writes whose first sample went out just now, or was skipped.
+    const uint64_t after = ring_.read_position();
+    while (Mark* mark = marks_.front()) {
+        if (mark->position >= after) break;
+        if (mark->position >= discard) {
+            const int64_t latency_us = now_us - mark->written_at_us;
+            latency_us_last_.store(latency_us, std::memory_order_relaxed);
+            latency_us_total_.fetch_add(latency_us, std::memory_order_relaxed);
+            StoreMax(latency_us_max_, latency_us);
+            latency_samples_.fetch_add(1, std::memory_order_relaxed);
+        }
+        marks_.pop();
+    }
+    uint64_t watch = watch_position_.load(std::memory_order_acquire);
+    if (watch != PcmRing::kNoPin && after > watch && watch >= discard &&
+        watch_position_.compare_exchange_strong(watch, PcmRing::kNoPin, std::memory_order_acq_rel)) {
+        reached_at_us_.store(now_us, std::memory_order_relaxed);
+        reached_position_.store(watch, std::memory_order_release);
+    }
+    return take;
+}
+
+PcmOutputStats PcmOutputRing::stats() const {
+    PcmOutputStats stats;
+    stats.samples_played = samples_played_.load(std::memory_order_relaxed);
+    stats.samples_discarded = samples_discarded_.load(std::memory_order_relaxed);
+    stats.underruns = underruns_.load(std::memory_order_relaxed);
+    stats.underrun_samples = underrun_samples_.load(std::memory_order_relaxed);
+    stats.callbacks = callbacks_.load(std::memory_order_relaxed);
+    stats.late_callbacks = late_callbacks_.load(std::memory_order_relaxed);
+    stats.max_callback_gap_us = max_callback_gap_us_.load(std::memory_order_relaxed);
+    stats.fill_samples = static_cast<int64_t>(ring_.available());
+    stats.min_fill_samples = std::max<int64_t>(0, min_fill_samples_.load(std::memory_order_relaxed));
+    stats.max_fill_samples = max_fill_samples_.load(std::memory_order_relaxed);
+    stats.latency_us_last = latency_us_last_.load(std::memory_order_relaxed);
+    stats.latency_us_total = latency_us_total_.load(std::memory_order_relaxed);
+    stats.latency_us_max = latency_us_max_.load(std::memory_order_relaxed);
+    stats.latency_samples = latency_samples_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+}  // namespace ai_bridge
@@ -0,0 +1,121 @@
+#ifndef AI_BRIDGE_AUDIO_PCM_OUTPUT_RING_H_
+#define AI_BRIDGE_AUDIO_PCM_OUTPUT_RING_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "audio/pcm_ring.h"
+#include "core/spsc_ring.h"
+
+namespace ai_bridge {
+
+struct PcmOutputStats {
+    int64_t samples_played = 0;      // speech handed to the audio callback
+    int64_t samples_discarded = 0;   // written but flushed before playing
+    int64_t underruns = 0;           // callbacks that ran short mid-stream
+    int64_t underrun_samples = 0;    // silence they filled in
+    int64_t callbacks = 0;
+    int64_t late_callbacks = 0;      // came more than twice their own length after the previous one
+    int64_t max_callback_gap_us = 0;
+    int64_t fill_samples = 0;        // buffered now
+    int64_t min_fill_samples = 0;    // lowest fill a mid-stream callback found
+    int64_t max_fill_samples = 0;
+    int64_t latency_us_last = 0;     // written -> first sample played, per write
+    int64_t latency_us_total = 0;
+    int64_t latency_us_max = 0;
+    int64_t latency_samples = 0;     // writes measured
+};
+
+// Speech on its way from a synthesis thread to the audio callback.
+//
+// A PcmRing with the accounting needed to tell why playback stutters. The
+// producer brackets each stream (a spoken reply) with set_streaming(): once
+// a streaming callback has played something, every callback that finds
+// less than it needs is an underrun, meaning synthesis fell behind, while
+// silence outside a stream is just idle. Callbacks arriving late (more
+// than twice their own length apart) point at the audio thread not being
+// scheduled instead. Each write() is stamped so the consumer can tell how
+// long its first sample waited in the ring, and the fill levels show how
+// much margin was left.
+//
+// write(), flush() and watch() are for the producer only; read() is for the
+// audio callback only and never blocks, allocates or locks.
+class PcmOutputRing {
+public:
+    explicit PcmOutputRing(size_t capacity);
+
+    PcmOutputRing(const PcmOutputRing&) = delete;
+    PcmOutputRing& operator=(const PcmOutputRing&) = delete;
+
+    // Rate of the samples, for callback timing. Set before playback starts.
+    void set_sample_rate(int32_t sample_rate) { sample_rate_.store(sample_rate, std::memory_order_relaxed); }
+
+    // --- Producer side ---
+
+    // Appends up to `count` samples; returns how many fit.
+    size_t write(const float* samples, size_t count);
+    // Makes playback skip everything written so far.
+    void flush();
+    // While set, short callbacks count as underruns once the stream has
+    // played its first sample. Clear it once the stream's last sample is
+    // written.
+    void set_streaming(bool streaming) { streaming_.store(streaming, std::memory_order_release); }
+    // Asks the consumer to note when it plays the sample at `position`.
+    void watch(uint64_t position);
+    // True once the watched `position` was played; *at_us is then the
+    // steady_clock time, in microseconds, it was handed to the callback.
+    bool reached(uint64_t position, int64_t* at_us) const;
+    // Samples written since the ring was created.
+    uint64_t written() const { return written_; }
+
+    // --- Consumer side (audio callback) ---
+
+    // Copies up to `count` samples to `out`, pads the rest with silence and
+    // returns how many were speech.
+    size_t read(float* out, size_t count);
+
+    // --- Either side ---
+
+    uint64_t read_position() const { return ring_.read_position(); }
+    PcmOutputStats stats() const;
+
+private:
+    struct Mark {
+        uint64_t position = 0;
+        int64_t written_at_us = 0;
+    };
+
+    PcmRing ring_;
+    SpscRing<Mark> marks_;
+    std::atomic<int32_t> sample_rate_{0};
+
+    // Producer.
+    uint64_t written_ = 0;
+    std::atomic<uint64_t> discard_before_{0};
+    std::atomic<bool> streaming_{false};
+    std::atomic<uint64_t> watch_position_{PcmRing::kNoPin};
+    // Consumer: reached_at_us_ is stored before reached_position_.
+    std::atomic<uint64_t> reached_position_{PcmRing::kNoPin};
+    std::atomic<int64_t> reached_at_us_{0};
+    bool primed_ = false;  // the current stream has played a sample
+    int64_t last_callback_us_ = 0;
+
+    std::atomic<int64_t> samples_played_{0};
+    std::atomic<int64_t> samples_discarded_{0};
+    std::atomic<int64_t> underruns_{0};
+    std::atomic<int64_t> underrun_samples_{0};
+    std::atomic<int64_t> callbacks_{0};
+    std::atomic<int64_t> late_callbacks_{0};
+    std::atomic<int64_t> max_callback_gap_us_{0};
+    std::atomic<int64_t> min_fill_samples_{-1};
+    std::atomic<int64_t> max_fill_samples_{0};
+    std::atomic<int64_t> latency_us_last_{0};
+    std::atomic<int64_t> latency_us_total_{0};
+    std::atomic<int64_t> latency_us_max_{0};
+    std::atomic<int64_t> latency_samples_{0};
+};
+
+}  // namespace ai_bridge
+
+#endif  // AI_BRIDGE_AUDIO_PCM_OUTPUT_RING_H_
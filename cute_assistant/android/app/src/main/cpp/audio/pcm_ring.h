@@ -0,0 +1,186 @@
+#ifndef AI_BRIDGE_AUDIO_PCM_RING_H_
+#define AI_BRIDGE_AUDIO_PCM_RING_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+
+#include "core/spsc_ring.h"
+
+namespace ai_bridge {
+
+// A run of samples in a PcmRing, in at most two pieces where it wraps.
+// Points into the ring: valid until the consumer releases those samples.
+struct PcmSpan {
+    const float* first = nullptr;
+    size_t first_size = 0;
+    const float* second = nullptr;
+    size_t second_size = 0;
+
+    size_t size() const { return first_size + second_size; }
+    bool contiguous() const { return second_size == 0; }
+    void copy_to(float* out) const {
+        std::copy(first, first + first_size, out);
+        std::copy(second, second + second_size, out + first_size);
+    }
+};
+
+// Single-producer/single-consumer ring of mono float PCM samples.
+//
+// The producer is the audio capture callback, so write() never blocks or
+// allocates: it takes what fits and the caller decides what a shortfall
+// means (capture drops it, a pushing host retries). The consumer reads
+// frames in place with peek()/consume().
+//
+// Consumed samples are not released at once. The newest `history` of them
+// stay readable through span(), and pin() holds everything from an older
+// position on, so audio from before a detection (the pre-speech pad) can
+// still be handed on without copying. Only released samples count as free
+// space for the producer.
+//
+// Positions are absolute sample counts since the ring was created, which is
+// also how VAD segments are addressed. The sample buffer starts on a cache
+// line and, like SpscRing, each side caches the other's index so the two
+// threads only touch the shared line when the cached value runs out.
+class PcmRing {
+public:
+    static constexpr uint64_t kNoPin = std::numeric_limits<uint64_t>::max();
+
+    PcmRing(size_t capacity, size_t history)
+        : capacity_(RoundUpToPowerOfTwo(std::max<size_t>(capacity, kFloatsPerLine))),
+          mask_(capacity_ - 1),
+          history_(std::min(history, capacity_)),
+          lines_(new Line[capacity_ / kFloatsPerLine]),
+          samples_(lines_[0].samples) {}
+
+    PcmRing(const PcmRing&) = delete;
+    PcmRing& operator=(const PcmRing&) = delete;
+
+    size_t capacity() const { return capacity_; }
+    size_t history() const { return history_; }
+
+    // --- Producer side ---
+
+    // Appends up to `count` samples; returns how many fit.
+    size_t write(const float* samples, size_t count) {
+        const uint64_t head = head_.load(std::memory_order_relaxed);
+        if (head + count - cached_release_ > capacity_) {
+            cached_release_ = release_.load(std::memory_order_acquire);
+        }
+        const size_t fits = std::min(count, capacity_ - static_cast<size_t>(head - cached_release_));
+        const size_t first = std::min(fits, capacity_ - static_cast<size_t>(head & mask_));
+        std::copy(samples, samples + first, samples_ + (head & mask_));
+        std::copy(samples + first, samples + fits, samples_);
+        head_.store(head + fits, std::memory_order_release);
+        return fits;
+    }
+
+    // --- Consumer side ---
+
+    // Points `out` at the next `count` unread samples without consuming them;
+    // returns false while fewer are available.
+    bool peek(size_t count, PcmSpan* out) {
+        const uint64_t tail = tail_.load(std::memory_order_relaxed);
+        if (cached_head_ - tail < count) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            if (cached_head_ - tail < count) return false;
+        }
+        *out = view(tail, tail + count);
+        return true;
+    }
+
+    // Marks the `count` samples returned by peek() as read. They stay
+    // readable through span() while within the history or the pin.
+    void consume(size_t count) {
+        tail_.store(tail_.load(std::memory_order_relaxed) + count, std::memory_order_release);
+        update_release();
+    }
+
+    // Copies the next `count` samples to `out` and consumes them; returns
+    // false, consuming nothing, while fewer are available.
+    bool read(float* out, size_t count) {
+        PcmSpan span;
+        if (!peek(count, &span)) return false;
+        span.copy_to(out);
+        consume(count);
+        return true;
+    }
+
+    // Keeps samples from `position` on readable (up to the capacity) until
+    // unpin(). Positions older than what is still held are clamped.
+    void pin(uint64_t position) {
+        pin_ = std::max(position, release_.load(std::memory_order_relaxed));
+        update_release();
+    }
+    void unpin() {
+        pin_ = kNoPin;
+        update_release();
+    }
+    uint64_t pinned() const { return pin_; }
+
+    // Read samples [begin, end). Returns false if any of them were released
+    // already or are not read yet.
+    bool span(uint64_t begin, uint64_t end, PcmSpan* out) const {
+        if (begin > end || begin < release_.load(std::memory_order_relaxed) ||
+            end > tail_.load(std::memory_order_relaxed)) {
+            return false;
+        }
+        *out = view(begin, end);
+        return true;
+    }
+
+    // Absolute position of the next sample peek() returns.
+    uint64_t read_position() const { return tail_.load(std::memory_order_relaxed); }
+    // Oldest sample span() can still return.
+    uint64_t oldest_readable() const { return release_.load(std::memory_order_relaxed); }
+
+    // --- Either side ---
+
+    size_t available() const {
+        return static_cast<size_t>(head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire));
+    }
+
+private:
+    static constexpr size_t kFloatsPerLine = kCacheLineSize / sizeof(float);
+    struct alignas(kCacheLineSize) Line {
+        float samples[kFloatsPerLine];
+    };
+
+    PcmSpan view(uint64_t begin, uint64_t end) const {
+        const size_t count = static_cast<size_t>(end - begin);
+        const size_t offset = static_cast<size_t>(begin & mask_);
+        const size_t first = std::min(count, capacity_ - offset);
+        return {samples_ + offset, first, samples_, count - first};
+    }
+
+    void update_release() {
+        const uint64_t tail = tail_.load(std::memory_order_relaxed);
+        uint64_t keep = tail > history_ ? tail - history_ : 0;
+        if (pin_ < keep) keep = pin_;
+        // Never move backwards: the producer may already have reused it.
+        const uint64_t released = release_.load(std::memory_order_relaxed);
+        if (keep > released) release_.store(keep, std::memory_order_release);
+    }
+
+    const size_t capacity_;
+    const size_t mask_;
+    const size_t history_;
+    std::unique_ptr<Line[]> lines_;
+    float* const samples_;
+
+    // Producer line.
+    alignas(kCacheLineSize) std::atomic<uint64_t> head_{0};
+    uint64_t cached_release_ = 0;
+    // Consumer line.
+    alignas(kCacheLineSize) std::atomic<uint64_t> tail_{0};
+    std::atomic<uint64_t> release_{0};  // everything before is free space
+    uint64_t cached_head_ = 0;
+    uint64_t pin_ = kNoPin;
+};
+
+}  // namespace ai_bridge
+
+#endif  // AI_BRIDGE_AUDIO_PCM_RING_H_
@@ -0,0 +1,47 @@
+#include "audio/vad.h"
+
+#include <algorithm>
+
+namespace ai_bridge {
+
+void VadFrameProcessor::process(float probability, std::vector<VadEvent>* events) {
+    const int64_t frame_start = position_;
+    position_ += options_.frame_samples;
+    const bool is_speech = probability >= options_.positive_speech_threshold;
+
+    if (is_speech && redemption_counter_ > 0) redemption_counter_ = 0;
+    if (is_speech && !speaking_) {
+        speaking_ = true;
+        speech_frames_ = 0;
+        segment_start_ = std::max<int64_t>(0, frame_start - int64_t{options_.pre_speech_pad_frames} * options_.frame_samples);
+        events->push_back({VadEvent::kSpeechStart, segment_start_, position_});
+    }
+    if (!speaking_) return;
+
+    if (is_speech && ++speech_frames_ == options_.min_speech_frames) {
+        events->push_back({VadEvent::kSpeechRealStart, segment_start_, position_});
+    }
+    if (probability < options_.negative_speech_threshold && ++redemption_counter_ >= options_.redemption_frames) {
+        end_segment(events);
+    }
+}
+
+void VadFrameProcessor::pause(std::vector<VadEvent>* events) {
+    if (!speaking_) return;
+    if (options_.submit_user_speech_on_pause) {
+        end_segment(events);
+    } else {
+        speaking_ = false;
+        redemption_counter_ = 0;
+    }
+}
+
+void VadFrameProcessor::end_segment(std::vector<VadEvent>* events) {
+    const VadEvent::Type type = speech_frames_ >= options_.min_speech_frames ? VadEvent::kSpeechEnd : VadEvent::kMisfire;
+    events->push_back({type, segment_start_, position_});
+    speaking_ = false;
+    speech_frames_ = 0;
+    redemption_counter_ = 0;
+}
+
+}  // namespace ai_bridge
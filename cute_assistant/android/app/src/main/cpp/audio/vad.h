@@ -0,0 +1,71 @@
+#ifndef AI_BRIDGE_AUDIO_VAD_H_
+#define AI_BRIDGE_AUDIO_VAD_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "audio/vad_gate.h"
+#include "audio/vad_model.h"
+
+namespace ai_bridge {
+
+// Mirrors VadSettings on the Dart side; defaults are its v5 defaults.
+struct VadOptions {
+    int32_t frame_samples = kVadFrameSamplesV5;
+    int32_t min_speech_frames = 8;
+    int32_t pre_speech_pad_frames = 30;
+    int32_t redemption_frames = 24;
+    float positive_speech_threshold = 0.5f;
+    float negative_speech_threshold = 0.35f;
+    bool submit_user_speech_on_pause = false;
+    // Native only: the pre-gate in front of the model.
+    VadGateOptions gate;
+};
+
+struct VadEvent {
+    enum Type {
+        kSpeechStart,      // first frame above the positive threshold
+        kSpeechRealStart,  // min_speech_frames speech frames reached
+        kSpeechEnd,        // segment long enough to transcribe
+        kMisfire,          // segment ended before min_speech_frames
+    };
+    Type type;
+    // Absolute sample positions: [start, end) of the segment including the
+    // pre-speech pad; `end` is the current position for start events.
+    int64_t start_sample;
+    int64_t end_sample;
+};
+
+// Speech segmentation over per-frame probabilities, with the semantics of
+// the vad package's frame processor: speech starts on a frame at or above
+// positive_speech_threshold and ends once redemption_frames consecutive
+// frames fall below negative_speech_threshold. Segments with fewer than
+// min_speech_frames speech frames are misfires. Segments start
+// pre_speech_pad_frames before the first speech frame.
+class VadFrameProcessor {
+public:
+    explicit VadFrameProcessor(const VadOptions& options) : options_(options) {}
+
+    // Consumes the probability of the next frame, appending any events.
+    void process(float probability, std::vector<VadEvent>* events);
+    // Capture paused or stopped: ends an open segment if the options submit
+    // speech on pause, otherwise drops it. Sample positions keep counting.
+    void pause(std::vector<VadEvent>* events);
+
+    bool speaking() const { return speaking_; }
+    int64_t position() const { return position_; }
+
+private:
+    void end_segment(std::vector<VadEvent>* events);
+
+    const VadOptions options_;
+    int64_t position_ = 0;  // samples consumed so far
+    bool speaking_ = false;
+    int64_t segment_start_ = 0;
+    int32_t speech_frames_ = 0;
+    int32_t redemption_counter_ = 0;
+};
+
+}  // namespace ai_bridge
+
+#endif  // AI_BRIDGE_AUDIO_VAD_H_
@@ -0,0 +1,33 @@
+#include "audio/vad_gate.h"
+
+namespace ai_bridge {
+
+namespace {
+
+constexpr float kFloorRiseDbPerSecond = 1.0f;
+
+}  // namespace
+
+VadPreGate::VadPreGate(const VadGateOptions& options, size_t frame_samples, int sample_rate)
+    : options_(options),
+      floor_rise_db_(kFloorRiseDbPerSecond * static_cast<float>(frame_samples) / static_cast<float>(sample_rate)),
+      noise_floor_db_(options.silence_db) {}
+
+bool VadPreGate::reject(const float* frame, size_t count) {
+    features_ = ComputeFrameFeatures(frame, count);
+    const float level = features_.rms_db;
+
+    const bool background = level < noise_floor_db_ + options_.noise_margin_db;
+    if (level < noise_floor_db_) {
+        noise_floor_db_ = level;
+    } else {
+        noise_floor_db_ += floor_rise_db_;
+    }
+    if (!options_.enabled) return false;
+
+    if (level < options_.silence_db || background) return true;
+    return level < options_.hiss_db && features_.zero_crossing_rate > options_.hiss_zero_crossing_rate &&
+           features_.high_band_ratio > options_.hiss_high_band_ratio;
+}
+
+}  // namespace ai_bridge
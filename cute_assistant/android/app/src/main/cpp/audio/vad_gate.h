@@ -0,0 +1,53 @@
+#ifndef AI_BRIDGE_AUDIO_VAD_GATE_H_
+#define AI_BRIDGE_AUDIO_VAD_GATE_H_
+
+#include <cstddef>
+
+#include "audio/frame_features.h"
+
+namespace ai_bridge {
+
+struct VadGateOptions {
+    bool enabled = true;
+    // Frames quieter than this are silence whatever the background.
+    float silence_db = -60.0f;
+    // Frames within this much of the tracked background level are
+    // background.
+    float noise_margin_db = 3.0f;
+    // Quiet, broadband frames are hiss rather than voice: below hiss_db with
+    // both a high zero-crossing rate and most energy in the upper band.
+    float hiss_db = -45.0f;
+    float hiss_zero_crossing_rate = 0.35f;
+    float hiss_high_band_ratio = 0.6f;
+};
+
+// Cheap screen in front of the VAD model. Each frame is summarized by
+// ComputeFrameFeatures (one SIMD pass) and rejected only when it is
+// clearly not speech; everything else goes to the model. A rejected frame
+// counts as probability 0, which is where the model would put it anyway.
+//
+// The background level follows the quietest recent frames: it starts at
+// silence_db, drops to any quieter frame at once and creeps up by 1 dB a
+// second otherwise. Talking right after start() therefore is never taken
+// for background, pauses between words pull the level back down, and a
+// louder room is learned within seconds.
+class VadPreGate {
+public:
+    VadPreGate(const VadGateOptions& options, size_t frame_samples, int sample_rate);
+
+    // True if `frame` can skip the model.
+    bool reject(const float* frame, size_t count);
+
+    float noise_floor_db() const { return noise_floor_db_; }
+    const FrameFeatures& last_features() const { return features_; }
+
+private:
+    const VadGateOptions options_;
+    const float floor_rise_db_;  // per frame
+    float noise_floor_db_;
+    FrameFeatures features_;
+};
+
+}  // namespace ai_bridge
+
+#endif  // AI_BRIDGE_AUDIO_VAD_GATE_H_
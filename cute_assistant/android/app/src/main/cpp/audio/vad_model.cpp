@@ -0,0 +1,20 @@
+#include "audio/vad_model.h"
+
+#include <cmath>
+
+namespace ai_bridge {
+
+float EnergyVadModel::speech_probability(const float* frame, size_t frame_samples) {
+    if (frame_samples == 0) return 0.0f;
+    double energy = 0.0;
+    for (size_t i = 0; i < frame_samples; ++i) energy += static_cast<double>(frame[i]) * frame[i];
+    const double rms = std::sqrt(energy / static_cast<double>(frame_samples));
+    const float db = rms > 1e-9 ? static_cast<float>(20.0 * std::log10(rms)) : -180.0f;
+    const float probability = 1.0f / (1.0f + std::exp((threshold_db_ - db) / slope_db_));
+    // Rise fast, decay slowly, like a recurrent model holding on through
+    // short pauses between words.
+    smoothed_ = probability > smoothed_ ? probability : 0.7f * smoothed_ + 0.3f * probability;
+    return smoothed_;
+}
+
+}  // namespace ai_bridge
@@ -0,0 +1,50 @@
+#ifndef AI_BRIDGE_AUDIO_VAD_MODEL_H_
+#define AI_BRIDGE_AUDIO_VAD_MODEL_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ai_bridge {
+
+constexpr int32_t kVadSampleRate = 16000;
+// Frame sizes of the Silero models the app offers (VadSettings.frameSamples).
+constexpr int32_t kVadFrameSamplesV5 = 512;
+constexpr int32_t kVadFrameSamplesLegacy = 1536;
+
+// Per-frame speech probability, shaped after Silero VAD: fixed-size frames
+// of 16 kHz mono float PCM, recurrent state carried from one frame to the
+// next until reset(). A Silero backend (v5: 512-sample frames plus 64
+// samples of context and a 2x128 state; legacy: 1536-sample frames with h/c
+// state) slots in behind this interface. Models are driven from one thread.
+class VadModel {
+public:
+    virtual ~VadModel() = default;
+
+    virtual const char* name() const = 0;
+    // Clears the recurrent state, e.g. when capture restarts.
+    virtual void reset() = 0;
+    // Probability in [0, 1] that `frame` (frame_samples samples) is speech.
+    virtual float speech_probability(const float* frame, size_t frame_samples) = 0;
+};
+
+// Placeholder model used until Silero weights are bundled: a logistic curve
+// over the frame's RMS level in dBFS, centred on `threshold_db`, smoothed
+// across frames the way the recurrent models are.
+class EnergyVadModel : public VadModel {
+public:
+    explicit EnergyVadModel(float threshold_db = -42.0f, float slope_db = 4.0f)
+        : threshold_db_(threshold_db), slope_db_(slope_db) {}
+
+    const char* name() const override { return "energy"; }
+    void reset() override { smoothed_ = 0.0f; }
+    float speech_probability(const float* frame, size_t frame_samples) override;
+
+private:
+    const float threshold_db_;
+    const float slope_db_;
+    float smoothed_ = 0.0f;
+};
+
+}  // namespace ai_bridge
+
+#endif  // AI_BRIDGE_AUDIO_VAD_MODEL_H_
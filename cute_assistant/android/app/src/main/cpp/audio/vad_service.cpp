@@ -0,0 +1,215 @@
+#include "audio/vad_service.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include "audio/frame_features.h"
+#include "core/dart_messages.h"
+#include "core/log.h"
+#include "core/turn_trace.h"
+
+namespace ai_bridge {
+
+namespace {
+
+// Two seconds of capture: the VAD thread may fall that far behind (model
+// stall, scheduling) before samples are dropped. Held-back audio comes on
+// top of this.
+constexpr size_t kRingSlackSeconds = 2;
+
+const char* EventTag(VadEvent::Type type) {
+    switch (type) {
+        case VadEvent::kSpeechStart: return "vad_speech_start";
+        case VadEvent::kSpeechRealStart: return "vad_speech_real_start";
+        case VadEvent::kSpeechEnd: return "vad_speech_end";
+        case VadEvent::kMisfire: return "vad_misfire";
+    }
+    return "vad_unknown";
+}
+
+}  // namespace
+
+VadService::~VadService() { stop(); }
+
+bool VadService::start(const VadOptions& options, Dart_Port events, bool native_capture, std::string* error) {
+    stop();
+    if (options.frame_samples != kVadFrameSamplesV5 && options.frame_samples != kVadFrameSamplesLegacy) {
+        *error = "VAD frames must be " + std::to_string(kVadFrameSamplesV5) + " (v5) or " +
+                 std::to_string(kVadFrameSamplesLegacy) + " (legacy) samples, not " + std::to_string(options.frame_samples);
+        return false;
+    }
+    if (options.negative_speech_threshold > options.positive_speech_threshold) {
+        *error = "VAD negative threshold must not exceed the positive threshold";
+        return false;
+    }
+    options_ = options;
+    port_ = events;
+    // A Silero backend replaces the placeholder here once its weights ship.
+    if (!model_) model_.reset(new EnergyVadModel());
+    model_->reset();
+    const size_t frame = static_cast<size_t>(options_.frame_samples);
+    // The pad plus the trigger frame: that frame is already consumed when
+    // speech starts, and the segment is pinned from before it.
+    const size_t history = static_cast<size_t>(std::max<int32_t>(options_.pre_speech_pad_frames, 0) + 1) * frame;
+    hold_samples_ = history + static_cast<size_t>(std::max<int32_t>(options_.redemption_frames, 0) +
+                                                  std::max<int32_t>(options_.min_speech_frames, 1)) * frame;
+    ring_.reset(new PcmRing(kRingSlackSeconds * kVadSampleRate + hold_samples_, history));
+
+    running_ = true;
+    thread_ = std::thread(&VadService::run, this);
+    if (native_capture && !capture_.start(kVadSampleRate, &VadService::OnCapture, this, error)) {
+        stop();
+        return false;
+    }
+    LOGI("VAD started (%s model, %d-sample frames, %s capture, %s pre-gate)",
+         model_->name(), options_.frame_samples, capture_.running() ? "native" : "pushed",
+         options_.gate.enabled ? FrameFeaturesBackend() : "no");
+    return true;
+}
+
+void VadService::stop() {
+    capture_.stop();
+    if (!thread_.joinable()) return;
+    running_ = false;
+    thread_.join();
+}
+
+size_t VadService::push(const float* samples, size_t count) {
+    if (!running_.load(std::memory_order_acquire) || !ring_) return 0;
+    return ring_->write(samples, count);
+}
+
+void VadService::OnCapture(const float* samples, int32_t count, void* user_data) {
+    auto* service = static_cast<VadService*>(user_data);
+    const size_t written = service->ring_->write(samples, static_cast<size_t>(count));
+    if (written < static_cast<size_t>(count)) {
+        service->samples_dropped_.fetch_add(count - static_cast<int64_t>(written), std::memory_order_relaxed);
+    }
+}
+
+void VadService::run() {
+    VadFrameProcessor processor(options_);
+    VadPreGate gate(options_.gate, static_cast<size_t>(options_.frame_samples), kVadSampleRate);
+    const size_t frame_samples = static_cast<size_t>(options_.frame_samples);
+    std::vector<float> scratch(frame_samples);  // for frames that wrap around the ring
+    std::vector<VadEvent> events;
+    bool confirmed = false;     // segment reached kSpeechRealStart
+    int64_t segment_start = 0;  // of the confirmed segment, as the sink saw it
+    uint64_t delivered = 0;     // sink has the confirmed segment up to here
+    // Half a frame: a full frame is never left waiting for long.
+    const auto idle_wait = std::chrono::microseconds(int64_t{500000} * options_.frame_samples / kVadSampleRate);
+
+    for (;;) {
+        // Check before reading so the frames captured before stop() are
+        // still processed.
+        const bool stopping = !running_.load(std::memory_order_acquire);
+        PcmSpan span;
+        if (!ring_->peek(frame_samples, &span)) {
+            if (stopping) break;
+            std::this_thread::sleep_for(idle_wait);
+            continue;
+        }
+        const float* frame = span.first;
+        if (!span.contiguous()) {
+            span.copy_to(scratch.data());
+            frame = scratch.data();
+        }
+        const auto started = std::chrono::steady_clock::now();
+        const bool rejected = gate.reject(frame, frame_samples);
+        const auto gated = std::chrono::steady_clock::now();
+        gate_ns_.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(gated - started).count(),
+                           std::memory_order_relaxed);
+        frames_processed_.fetch_add(1, std::memory_order_relaxed);
+        // The model does not see rejected frames. Its recurrent state is
+        // left as it was, which is how it stands after silence anyway.
+        float probability = 0.0f;
+        if (rejected) {
+            frames_gated_.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            probability = model_->speech_probability(frame, frame_samples);
+            model_us_.fetch_add(
+                std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - gated).count(),
+                std::memory_order_relaxed);
+        }
+
+        ring_->consume(frame_samples);
+
+        processor.process(probability, &events);
+        for (const VadEvent& event : events) {
+            const int64_t turn_id = post(event);
+            switch (event.type) {
+                case VadEvent::kSpeechStart:
+                    ring_->pin(static_cast<uint64_t>(event.start_sample));
+                    break;
+                case VadEvent::kSpeechRealStart:
+                    confirmed = true;
+                    // The pin may have been moved up; start from what is left.
+                    delivered = std::max(static_cast<uint64_t>(event.start_sample), ring_->oldest_readable());
+                    segment_start = static_cast<int64_t>(delivered);
+                    sink_ = next_sink_.load(std::memory_order_acquire);
+                    if (sink_) sink_->on_speech_start(segment_start);
+                    break;
+                case VadEvent::kSpeechEnd:
+                case VadEvent::kMisfire:
+                    if (confirmed) {
+                        deliver(delivered, static_cast<uint64_t>(event.end_sample));
+                        if (sink_) sink_->on_speech_end(segment_start, event.end_sample, true, turn_id);
+                    }
+                    confirmed = false;
+                    ring_->unpin();
+                    break;
+            }
+        }
+        events.clear();
+        if (confirmed) {
+            deliver(delivered, ring_->read_position());
+            delivered = ring_->read_position();
+            ring_->unpin();  // delivered; only the pad history is kept now
+        } else if (processor.speaking() && ring_->pinned() != PcmRing::kNoPin &&
+                   ring_->read_position() - ring_->pinned() > hold_samples_) {
+            // Confirmation is taking longer than the ring holds: give up the
+            // oldest pad rather than stall capture.
+            ring_->pin(ring_->read_position() - hold_samples_);
+        }
+    }
+    const bool was_confirmed = confirmed && processor.speaking();
+    processor.pause(&events);
+    for (const VadEvent& event : events) {
+        const int64_t turn_id = post(event);
+        if (confirmed && sink_) sink_->on_speech_end(segment_start, event.end_sample, true, turn_id);
+        confirmed = false;
+    }
+    if (was_confirmed && confirmed && sink_) sink_->on_speech_end(segment_start, processor.position(), false, 0);
+    ring_->unpin();
+}
+
+void VadService::deliver(uint64_t begin, uint64_t end) {
+    PcmSpan span;
+    if (sink_ == nullptr || begin >= end || !ring_->span(begin, end, &span)) return;
+    sink_->on_speech_audio(span);
+}
+
+int64_t VadService::post(const VadEvent& event) {
+    int64_t turn_id = 0;
+    if (event.type == VadEvent::kSpeechEnd) {
+        speech_segments_.fetch_add(1, std::memory_order_relaxed);
+        turn_id = VoiceTurnTrace().begin_turn(TurnTrace::NowMicros());
+    }
+    if (event.type == VadEvent::kMisfire) misfires_.fetch_add(1, std::memory_order_relaxed);
+    SendEventToDart(port_, EventTag(event.type), {event.start_sample, event.end_sample});
+    return turn_id;
+}
+
+VadStats VadService::stats() const {
+    VadStats stats;
+    stats.frames_processed = frames_processed_.load(std::memory_order_relaxed);
+    stats.speech_segments = speech_segments_.load(std::memory_order_relaxed);
+    stats.misfires = misfires_.load(std::memory_order_relaxed);
+    stats.frames_gated = frames_gated_.load(std::memory_order_relaxed);
+    stats.model_us = model_us_.load(std::memory_order_relaxed);
+    stats.gate_us = gate_ns_.load(std::memory_order_relaxed) / 1000;
+    stats.samples_dropped = samples_dropped_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+}  // namespace ai_bridge
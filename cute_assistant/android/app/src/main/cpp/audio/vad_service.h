@@ -0,0 +1,122 @@
+#ifndef AI_BRIDGE_AUDIO_VAD_SERVICE_H_
+#define AI_BRIDGE_AUDIO_VAD_SERVICE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "audio/audio_capture.h"
+#include "audio/pcm_ring.h"
+#include "audio/vad.h"
+#include "audio/vad_model.h"
+#include "dart_api_dl.h"
+
+namespace ai_bridge {
+
+struct VadStats {
+    int64_t frames_processed = 0;
+    int64_t frames_gated = 0;      // rejected by the pre-gate, model skipped
+    int64_t speech_segments = 0;   // kSpeechEnd events
+    int64_t misfires = 0;
+    int64_t samples_dropped = 0;   // capture outran the VAD thread
+    int64_t model_us = 0;          // total time inside VadModel
+    int64_t gate_us = 0;           // total time inside VadPreGate
+};
+
+// Receives the audio of confirmed speech, on the VAD thread. Spans point
+// straight into the capture ring and are only valid during the call, so a
+// sink takes what it needs before returning (or copies it).
+class SpeechSink {
+public:
+    virtual ~SpeechSink() = default;
+
+    // A segment reached min_speech_frames. Its audio so far, pre-speech pad
+    // included, follows through on_speech_audio.
+    virtual void on_speech_start(int64_t start_sample) = 0;
+    // The next samples of the current segment, in order and without gaps.
+    virtual void on_speech_audio(const PcmSpan& audio) = 0;
+    // The segment [start_sample, end_sample) ended. `submitted` is false if
+    // capture paused and the settings drop unfinished speech. `turn_id` is
+    // the VoiceTurnTrace turn the end opened, or 0 if it opened none.
+    virtual void on_speech_end(int64_t start_sample, int64_t end_sample, bool submitted, int64_t turn_id) = 0;
+};
+
+// Voice activity detection off the Dart isolate.
+//
+// PCM arrives in a PcmRing, from native capture or push(). A VAD thread
+// takes whole frames, screens them with the VadPreGate, runs the VadModel
+// on the rest and the frame processor on all, and posts only events to
+// Dart:
+//   ["vad_speech_start", start_sample, position]
+//   ["vad_speech_real_start", start_sample, position]
+//   ["vad_speech_end", start_sample, end_sample]
+//   ["vad_misfire", start_sample, end_sample]
+// Sample positions count from start(). Errors are posted as Strings on the
+// same port.
+//
+// The ring keeps the pre-speech pad behind the read position and pins a
+// segment's audio from its first speech frame until it is confirmed or
+// misfires; confirmed speech streams to the SpeechSink without copying.
+// The ring holds pre_speech_pad + redemption + min_speech frames on top of
+// the capture slack, so a segment awaiting confirmation never stalls
+// capture.
+class VadService {
+public:
+    VadService() = default;
+    ~VadService();
+
+    VadService(const VadService&) = delete;
+    VadService& operator=(const VadService&) = delete;
+
+    // Starts the VAD thread and, if `native_capture`, the microphone.
+    // Returns false with `error` set if the options or capture are invalid.
+    bool start(const VadOptions& options, Dart_Port events, bool native_capture, std::string* error);
+    // Stops capture, processes the frames already captured and ends any open
+    // segment as VadFrameProcessor::pause() does.
+    void stop();
+    bool running() const { return thread_.joinable(); }
+
+    // Where confirmed speech goes; null to drop it. Takes effect from the
+    // next confirmed segment, so the previous sink may still be called for
+    // the one in progress.
+    void set_speech_sink(SpeechSink* sink) { next_sink_.store(sink, std::memory_order_release); }
+
+    // Producer side for hosts without native capture. Returns the samples
+    // accepted; the caller retries the rest once the VAD has caught up.
+    size_t push(const float* samples, size_t count);
+
+    VadStats stats() const;
+
+private:
+    static void OnCapture(const float* samples, int32_t count, void* user_data);
+    void run();
+    // Returns the VoiceTurnTrace turn a speech end opens, otherwise 0.
+    int64_t post(const VadEvent& event);
+    void deliver(uint64_t begin, uint64_t end);
+
+    VadOptions options_;
+    Dart_Port port_ = ILLEGAL_PORT;
+    std::unique_ptr<VadModel> model_;
+    std::unique_ptr<PcmRing> ring_;
+    size_t hold_samples_ = 0;  // most a pinned segment may hold back
+    std::atomic<SpeechSink*> next_sink_{nullptr};
+    SpeechSink* sink_ = nullptr;  // VAD thread: sink of the current segment
+    AudioCapture capture_;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+
+    std::atomic<int64_t> frames_processed_{0};
+    std::atomic<int64_t> frames_gated_{0};
+    std::atomic<int64_t> speech_segments_{0};
+    std::atomic<int64_t> misfires_{0};
+    std::atomic<int64_t> model_us_{0};
+    std::atomic<int64_t> gate_ns_{0};
+    std::atomic<int64_t> samples_dropped_{0};
+};
+
+}  // namespace ai_bridge
+
+#endif  // AI_BRIDGE_AUDIO_VAD_SERVICE_H_
@@ -0,0 +1,74 @@
+#include "core/cpu_features.h"
+
+#include <sched.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <thread>
+
+namespace ai_bridge {
+
+namespace {
+
+// cpuinfo_max_freq of `cpu` in kHz, or 0 if it cannot be read.
+int64_t MaxFrequencyKhz(int32_t cpu) {
+    char path[96];
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cpufreq/cpuinfo_max_freq", cpu);
+    FILE* file = fopen(path, "r");
+    if (file == nullptr) return 0;
+    long long khz = 0;
+    if (fscanf(file, "%lld", &khz) != 1) khz = 0;
+    fclose(file);
+    return khz;
+}
+
+}  // namespace
+
+const CpuFeatures& GetCpuFeatures() {
+    static const CpuFeatures features = [] {
+        CpuFeatures f;
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_cpu_init();
+        f.sse2 = __builtin_cpu_supports("sse2");
+        f.avx2 = __builtin_cpu_supports("avx2");
+        f.fma = __builtin_cpu_supports("fma");
+        f.f16c = __builtin_cpu_supports("f16c");
+#endif
+#if defined(__ARM_NEON)
+        f.neon = true;
+#endif
+        return f;
+    }();
+    return features;
+}
+
+const CpuTopology& GetCpuTopology() {
+    static const CpuTopology topology = [] {
+        std::vector<int32_t> cpus;
+        cpu_set_t allowed;
+        CPU_ZERO(&allowed);
+        if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0) {
+            for (int32_t cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+                if (CPU_ISSET(cpu, &allowed)) cpus.push_back(cpu);
+            }
+        }
+        if (cpus.empty()) {
+            const int32_t count = static_cast<int32_t>(std::max(1u, std::thread::hardware_concurrency()));
+            for (int32_t cpu = 0; cpu < count; ++cpu) cpus.push_back(cpu);
+        }
+
+        CpuTopology t;
+        std::vector<int64_t> khz;
+        for (const int32_t cpu : cpus) khz.push_back(MaxFrequencyKhz(cpu));
+        const auto [slowest, fastest] = std::minmax_element(khz.begin(), khz.end());
+        if (*slowest == 0 || *slowest == *fastest) {
+            t.big = cpus;
+            return t;
+        }
+        for (size_t i = 0; i < cpus.size(); ++i) (khz[i] == *slowest ? t.little : t.big).push_back(cpus[i]);
+        return t;
+    }();
+    return topology;
+}
+
+}  // namespace ai_bridge
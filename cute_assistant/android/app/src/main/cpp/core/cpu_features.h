@@ -0,0 +1,37 @@
+#ifndef AI_BRIDGE_CORE_CPU_FEATURES_H_
+#define AI_BRIDGE_CORE_CPU_FEATURES_H_
+
+#include <cstdint>
+#include <vector>
+
+namespace ai_bridge {
+
+// SIMD support of the running CPU, probed once. Kernels compile the wider
+// x86 paths with __attribute__((target(...))) and pick them at runtime,
+// since the x86_64 Android ABI only guarantees SSE4.2. NEON is part of the
+// arm64-v8a ABI and of every armeabi-v7a device Android still supports, so
+// ARM kernels select it at compile time from __ARM_NEON.
+struct CpuFeatures {
+    bool sse2 = false;
+    bool avx2 = false;
+    bool fma = false;
+    bool f16c = false;
+    bool neon = false;
+};
+
+const CpuFeatures& GetCpuFeatures();
+
+// The cores the process may run on, by performance class, probed once from
+// cpufreq. On a device that mixes classes (big.LITTLE, DynamIQ) the cores
+// with the lowest maximum frequency are little and the rest big; otherwise,
+// or when cpufreq cannot be read, every core is big.
+struct CpuTopology {
+    std::vector<int32_t> big;
+    std::vector<int32_t> little;
+};
+
+const CpuTopology& GetCpuTopology();
+
+}  // namespace ai_bridge
+
+#endif  // AI_BRIDGE_CORE_CPU_FEATURES_H_
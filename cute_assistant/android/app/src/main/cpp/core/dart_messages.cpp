@@ -0,0 +1,99 @@
+#include "core/dart_messages.h"
+
+#include "core/log.h"
+#include "core/metrics.h"
+
+namespace {
+
+// Longest event record any subsystem sends; keeps SendEventToDart allocation-free.
+constexpr size_t kMaxEventValues = 15;
+constexpr size_t kMaxEventTexts = 4;
+
+bool Post(Dart_Port port_id, Dart_CObject* message) {
+    const bool posted = Dart_PostCObject_DL(port_id, message);
+    ai_bridge::MetricsRegistry& metrics = ai_bridge::Metrics();
+    metrics.add(ai_bridge::MetricCounter::kDartPosts);
+    if (!posted) metrics.add(ai_bridge::MetricCounter::kDartPostFailures);
+    return posted;
+}
+
+}  // namespace
+
+void SendStringToDart(Dart_Port port_id, const std::string& message) {
+    if (port_id == ILLEGAL_PORT) return;
+    Dart_CObject dart_object;
+    dart_object.type = Dart_CObject_kString;
+    dart_object.value.as_string = message.c_str();
+
+    const bool result = Post(port_id, &dart_object);
+    if (!result) {
+        LOGE("Dart_PostCObject_DL failed for string to port %lld", (long long)port_id);
+    }
+}
+
+bool SendEventToDart(Dart_Port port_id, const char* tag, std::initializer_list<int64_t> values) {
+    if (port_id == ILLEGAL_PORT) return false;
+    if (values.size() > kMaxEventValues) {
+        LOGE("Event %s has too many values (%zu)", tag, values.size());
+        return false;
+    }
+
+    Dart_CObject elements[kMaxEventValues + 1];
+    Dart_CObject* element_ptrs[kMaxEventValues + 1];
+    elements[0].type = Dart_CObject_kString;
+    elements[0].value.as_string = tag;
+    element_ptrs[0] = &elements[0];
+    size_t count = 1;
+    for (int64_t value : values) {
+        elements[count].type = Dart_CObject_kInt64;
+        elements[count].value.as_int64 = value;
+        element_ptrs[count] = &elements[count];
+        ++count;
+    }
+
+    Dart_CObject array;
+    array.type = Dart_CObject_kArray;
+    array.value.as_array.length = static_cast<intptr_t>(count);
+    array.value.as_array.values = element_ptrs;
+
+    const bool result = Post(port_id, &array);
+    if (!result) {
+        LOGE("Dart_PostCObject_DL failed for event %s to port %lld", tag, (long long)port_id);
+    }
+    return result;
+}
+
+bool SendTextEventToDart(Dart_Port port_id, const char* tag, int64_t id, std::initializer_list<std::string> texts) {
+    if (port_id == ILLEGAL_PORT) return false;
+    if (texts.size() > kMaxEventTexts) {
+        LOGE("Event %s has too many texts (%zu)", tag, texts.size());
+        return false;
+    }
+
+    Dart_CObject elements[kMaxEventTexts + 2];
+    Dart_CObject* element_ptrs[kMaxEventTexts + 2];
+    elements[0].type = Dart_CObject_kString;
+    elements[0].value.as_string = tag;
+    elements[1].type = Dart_CObject_kInt64;
+    elements[1].value.as_int64 = id;
+    element_ptrs[0] = &elements[0];
+    element_ptrs[1] = &elements[1];
+    size_t count = 2;
+    for (const std::string& text : texts) {
+        elements[count].type = Dart_CObject_kString;
+        elements[count].value.as_string = text.c_str();
+        element_ptrs[count] = &elements[count];
+        ++count;
+    }
+
+    Dart_CObject array;
+    array.type = Dart_CObject_kArray;
+    array.value.as_array.length = static_cast<intptr_t>(count);
+    array.value.as_array.values = element_ptrs;
+
+    const bool result = Post(port_id, &array);
+    if (!result) {
+        LOGE("Dart_PostCObject_DL failed for event %s to port %lld", tag, (long long)port_id);
+    }
+    return result;
+}
@@ -0,0 +1,21 @@
+#ifndef AI_BRIDGE_CORE_DART_MESSAGES_H_
+#define AI_BRIDGE_CORE_DART_MESSAGES_H_
+
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+
+#include "dart_api_dl.h"
+
+// Posts `message` as a Dart String. The VM copies it before returning.
+void SendStringToDart(Dart_Port port_id, const std::string& message);
+
+// Posts a List [tag, values...] where tag is a String and every value an int.
+// This is the shape of all metric/event records the bridge sends to Dart.
+bool SendEventToDart(Dart_Port port_id, const char* tag, std::initializer_list<int64_t> values);
+
+// Posts a List [tag, id, texts...]: events that carry text, such as
+// transcripts.
+bool SendTextEventToDart(Dart_Port port_id, const char* tag, int64_t id, std::initializer_list<std::string> texts);
+
+#endif  // AI_BRIDGE_CORE_DART_MESSAGES_H_
@@ -0,0 +1,53 @@
+#include "core/hdr_histogram.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ai_bridge {
+
+size_t HdrHistogram::BucketOf(int64_t value) {
+    if (value < kSubBuckets) return static_cast<size_t>(std::max<int64_t>(value, 0));
+    const int top_bit = std::min(63 - __builtin_clzll(static_cast<unsigned long long>(value)), kMaxValueBits - 1);
+    const int shift = top_bit - kSubBucketBits;
+    // Values past the range keep the last octave's top sub-bucket.
+    const int64_t sub = std::min((value >> shift) - kSubBuckets, kSubBuckets - 1);
+    return static_cast<size_t>(kSubBuckets * (shift + 1) + sub);
+}
+
+int64_t HdrHistogram::BucketUpperEdge(size_t bucket) {
+    const int64_t index = static_cast<int64_t>(bucket);
+    if (index < kSubBuckets) return index;
+    const int shift = static_cast<int>(index / kSubBuckets) - 1;
+    const int64_t sub = index % kSubBuckets;
+    return ((kSubBuckets + sub + 1) << shift) - 1;
+}
+
+void HdrHistogram::record(int64_t value) {
+    value = std::max<int64_t>(value, 0);
+    counts_[BucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(value, std::memory_order_relaxed);
+    int64_t seen = max_.load(std::memory_order_relaxed);
+    while (value > seen && !max_.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {
+    }
+}
+
+int64_t HdrHistogram::mean() const {
+    const int64_t n = count();
+    return n > 0 ? sum() / n : 0;
+}
+
+int64_t HdrHistogram::percentile(double percentile) const {
+    const int64_t n = count();
+    if (n == 0) return 0;
+    const double clamped = std::min(100.0, std::max(0.0, percentile));
+    const int64_t rank = std::max<int64_t>(1, static_cast<int64_t>(std::ceil(clamped / 100.0 * static_cast<double>(n))));
+    int64_t seen = 0;
+    for (size_t bucket = 0; bucket < kBuckets; ++bucket) {
+        seen += counts_[bucket].load(std::memory_order_relaxed);
+        if (seen >= rank) return std::min(BucketUpperEdge(bucket), max());
+    }
+    return max();
+}
+
+}  // namespace ai_bridge
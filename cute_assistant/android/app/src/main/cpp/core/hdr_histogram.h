@@ -0,0 +1,53 @@
+#ifndef AI_BRIDGE_CORE_HDR_HISTOGRAM_H_
+#define AI_BRIDGE_CORE_HDR_HISTOGRAM_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace ai_bridge {
+
+// Distribution of non-negative values (latencies in microseconds, rates),
+// HdrHistogram style: values below 16 get a bucket each, every power of two
+// above is split into 16 linear buckets, so a reported percentile is within
+// 1/16 (6.25%) of the true one up to 2^40 with a fixed 4.6 KB of counters.
+// Larger values land in the last bucket; negative ones count as 0.
+//
+// record() is a handful of relaxed atomic adds and may be called from any
+// number of threads; readers see a consistent-enough snapshot for
+// reporting, not an exact one.
+class HdrHistogram {
+public:
+    HdrHistogram() = default;
+    HdrHistogram(const HdrHistogram&) = delete;
+    HdrHistogram& operator=(const HdrHistogram&) = delete;
+
+    void record(int64_t value);
+
+    int64_t count() const { return count_.load(std::memory_order_relaxed); }
+    int64_t sum() const { return sum_.load(std::memory_order_relaxed); }
+    int64_t max() const { return max_.load(std::memory_order_relaxed); }
+    int64_t mean() const;
+    // Smallest recorded value at or below which `percentile` percent of the
+    // values fall, rounded up to its bucket's upper edge (never past max()).
+    // 0 while empty.
+    int64_t percentile(double percentile) const;
+
+private:
+    static constexpr int kSubBucketBits = 4;
+    static constexpr int64_t kSubBuckets = int64_t{1} << kSubBucketBits;
+    static constexpr int kMaxValueBits = 40;
+    static constexpr size_t kBuckets = static_cast<size_t>(kSubBuckets * (kMaxValueBits - kSubBucketBits + 1));
+
+    static size_t BucketOf(int64_t value);
+    static int64_t BucketUpperEdge(size_t bucket);
+
+    std::atomic<int64_t> counts_[kBuckets] = {};
+    std::atomic<int64_t> count_{0};
+    std::atomic<int64_t> sum_{0};
+    std::atomic<int64_t> max_{0};
+};
+
+}  // namespace ai_bridge
+
+#endif  // AI_BRIDGE_CORE_HDR_HISTOGRAM_H_
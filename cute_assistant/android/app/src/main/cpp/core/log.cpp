@@ -0,0 +1,343 @@
+#include "core/log.h"
+
+#include <pthread.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "core/metrics.h"
+#include "core/spsc_ring.h"
+
+namespace ai_bridge {
+
+namespace {
+
+constexpr size_t kRingSlots = 512;
+constexpr size_t kMaxArgs = 8;
+// String bytes one message keeps; sized so a record is five cache lines.
+constexpr size_t kTextBytes = 168;
+constexpr size_t kLineBytes = 1024;
+// The drainer sleeps until a message wakes it, or this long at most.
+constexpr auto kIdleWait = std::chrono::milliseconds(100);
+
+// A message as logged: strings are copied into `text` and their arguments
+// hold offset << 32 | length instead of a pointer.
+struct alignas(kCacheLineSize) Record {
+    std::atomic<size_t> sequence{0};
+    const LogSite* site = nullptr;
+    size_t count = 0;
+    LogArg args[kMaxArgs];
+    char text[kTextBytes];
+};
+
+int64_t AsInteger(const LogArg& arg) {
+    switch (arg.type) {
+        case LogArgType::kSigned: return arg.i;
+        case LogArgType::kUnsigned: return static_cast<int64_t>(arg.u);
+        case LogArgType::kDouble: return static_cast<int64_t>(arg.d);
+        case LogArgType::kPointer: return static_cast<int64_t>(reinterpret_cast<uintptr_t>(arg.p));
+        case LogArgType::kString: break;
+    }
+    return 0;
+}
+
+double AsDouble(const LogArg& arg) {
+    switch (arg.type) {
+        case LogArgType::kSigned: return static_cast<double>(arg.i);
+        case LogArgType::kUnsigned: return static_cast<double>(arg.u);
+        case LogArgType::kDouble: return arg.d;
+        case LogArgType::kPointer:
+        case LogArgType::kString: break;
+    }
+    return 0;
+}
+
+// Appends to a fixed line, truncating what does not fit.
+class LineWriter {
+public:
+    LineWriter(char* out, size_t capacity) : out_(out), capacity_(capacity) { out_[0] = '\0'; }
+
+    void append(const char* text, size_t length) {
+        const size_t copied = std::min(length, capacity_ - 1 - used_);
+        memcpy(out_ + used_, text, copied);
+        used_ += copied;
+        out_[used_] = '\0';
+    }
+
+    void appendf(const char* format, ...) {
+        va_list args;
+        va_start(args, format);
+        const int written = vsnprintf(out_ + used_, capacity_ - used_, format, args);
+        va_end(args);
+        if (written > 0) used_ = std::min(used_ + static_cast<size_t>(written), capacity_ - 1);
+    }
+
+private:
+    char* out_;
+    size_t capacity_;
+    size_t used_ = 0;
+};
+
+// printf over the record's stored arguments: each conversion is formatted
+// on its own, with its length modifier widened to the stored 64 bits.
+void Format(const Record& record, char* out, size_t capacity) {
+    LineWriter line(out, capacity);
+    const char* f = record.site->format;
+    size_t next_arg = 0;
+    while (*f != '\0') {
+        if (*f != '%') {
+            const char* start = f;
+            while (*f != '\0' && *f != '%') ++f;
+            line.append(start, static_cast<size_t>(f - start));
+            continue;
+        }
+        if (f[1] == '%') {
+            line.append("%", 1);
+            f += 2;
+            continue;
+        }
+        char spec[24];
+        size_t n = 0;
+        spec[n++] = *f++;
+        auto copy = [&] {
+            if (n < sizeof(spec) - 4) spec[n++] = *f;
+            ++f;
+        };
+        while (*f != '\0' && strchr("-+ #0", *f) != nullptr) copy();
+        while (*f >= '0' && *f <= '9') copy();
+        const size_t precision_at = n;
+        int precision = -1;
+        if (*f == '.') {
+            copy();
+            precision = 0;
+            while (*f >= '0' && *f <= '9') {
+                precision = precision * 10 + (*f - '0');
+                copy();
+            }
+        }
+        while (*f != '\0' && strchr("hljztLq", *f) != nullptr) ++f;
+        const char conversion = *f;
+        if (conversion == '\0') break;
+        ++f;
+        if (next_arg >= record.count) {
+            line.append("(missing)", 9);
+            continue;
+        }
+        const LogArg& arg = record.args[next_arg++];
+        switch (conversion) {
+            case 'd':
+            case 'i':
+                memcpy(spec + n, "lld", 4);
+                line.appendf(spec, static_cast<long long>(AsInteger(arg)));
+                break;
+            case 'u':
+            case 'x':
+            case 'X':
+            case 'o':
+                spec[n] = 'l';
+                spec[n + 1] = 'l';
+                spec[n + 2] = conversion;
+                spec[n + 3] = '\0';
+                line.appendf(spec, static_cast<unsigned long long>(AsInteger(arg)));
+                break;
+            case 'c':
+                memcpy(spec + n, "c", 2);
+                line.appendf(spec, static_cast<int>(AsInteger(arg)));
+                break;
+            case 'p':
+                memcpy(spec + n, "p", 2);
+                line.appendf(spec, reinterpret_cast<void*>(static_cast<uintptr_t>(AsInteger(arg))));
+                break;
+            case 's': {
+                if (arg.type != LogArgType::kString) {
+                    line.append("(not a string)", 14);
+                    break;
+                }
+                const char* text = record.text + (arg.u >> 32);
+                int length = static_cast<int>(arg.u & 0xffffffffu);
+                if (precision >= 0 && precision < length) length = precision;
+                memcpy(spec + precision_at, ".*s", 4);
+                line.appendf(spec, length, text);
+                break;
+            }
+            case 'f':
+            case 'F':
+            case 'e':
+            case 'E':
+            case 'g':
+            case 'G':
+            case 'a':
+            case 'A':
+                spec[n] = conversion;
+                spec[n + 1] = '\0';
+                line.appendf(spec, AsDouble(arg));
+                break;
+            default:
+                line.append(spec, n);
+                line.append(&conversion, 1);
+                break;
+        }
+    }
+}
+
+// Bounded multi-producer ring (one sequence number per slot) drained by a
+// single background thread.
+class LogRing {
+public:
+    LogRing() : slots_(new Record[kRingSlots]) {
+        for (size_t i = 0; i < kRingSlots; ++i) slots_[i].sequence.store(i, std::memory_order_relaxed);
+        thread_ = std::thread(&LogRing::run, this);
+    }
+
+    ~LogRing() {
+        stopping_.store(true, std::memory_order_release);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            idle_.store(false, std::memory_order_relaxed);
+        }
+        wake_.notify_one();
+        thread_.join();
+    }
+
+    bool write(const LogSite& site, const LogArg* args, size_t count) {
+        size_t position = enqueue_.load(std::memory_order_relaxed);
+        Record* record;
+        for (;;) {
+            record = &slots_[position & (kRingSlots - 1)];
+            const size_t sequence = record->sequence.load(std::memory_order_acquire);
+            const intptr_t lag = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+            if (lag == 0) {
+                if (enqueue_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) break;
+            } else if (lag < 0) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                Metrics().add(MetricCounter::kLogRecordsDropped);
+                return false;
+            } else {
+                position = enqueue_.load(std::memory_order_relaxed);
+            }
+        }
+
+        record->site = &site;
+        record->count = std::min(count, kMaxArgs);
+        size_t text_used = 0;
+        for (size_t i = 0; i < record->count; ++i) {
+            record->args[i] = args[i];
+            if (args[i].type != LogArgType::kString) continue;
+            const char* text = args[i].s != nullptr ? args[i].s : "(null)";
+            size_t length = strlen(text);
+            const size_t room = kTextBytes - text_used;
+            if (length > room) {
+                // Keep what fits and mark the cut.
+                length = room;
+                memcpy(record->text + text_used, text, length);
+                if (length >= 3) memcpy(record->text + text_used + length - 3, "...", 3);
+            } else {
+                memcpy(record->text + text_used, text, length);
+            }
+            record->args[i].u = static_cast<uint64_t>(text_used) << 32 | length;
+            text_used += length;
+        }
+        record->sequence.store(position + 1, std::memory_order_release);
+
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (idle_.load(std::memory_order_relaxed) && idle_.exchange(false, std::memory_order_relaxed)) {
+            wake_.notify_one();
+        }
+        return true;
+    }
+
+    void flush() {
+        const size_t target = enqueue_.load(std::memory_order_acquire);
+        std::unique_lock<std::mutex> lock(mutex_);
+        idle_.store(false, std::memory_order_relaxed);
+        wake_.notify_one();
+        while (drained_.load(std::memory_order_acquire) < target) {
+            written_.wait_for(lock, std::chrono::milliseconds(10));
+        }
+    }
+
+private:
+    Record& next() { return slots_[dequeue_ & (kRingSlots - 1)]; }
+    bool pending() { return next().sequence.load(std::memory_order_acquire) == dequeue_ + 1; }
+
+    void run() {
+        pthread_setname_np(pthread_self(), "ai_bridge_log");
+        char line[kLineBytes];
+        uint64_t reported_dropped = 0;
+        for (;;) {
+            bool wrote = false;
+            while (pending()) {
+                Record& record = next();
+                Format(record, line, sizeof(line));
+                const int priority = record.site->priority;
+                record.sequence.store(dequeue_ + kRingSlots, std::memory_order_release);
+                ++dequeue_;
+                __android_log_write(priority, APPNAME, line);
+                wrote = true;
+            }
+            const uint64_t dropped = dropped_.load(std::memory_order_relaxed);
+            if (dropped != reported_dropped) {
+                snprintf(line, sizeof(line), "%llu log messages dropped (ring full)",
+                         static_cast<unsigned long long>(dropped - reported_dropped));
+                __android_log_write(ANDROID_LOG_WARN, APPNAME, line);
+                reported_dropped = dropped;
+            }
+            if (wrote) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                drained_.store(dequeue_, std::memory_order_release);
+                written_.notify_all();
+            }
+            if (stopping_.load(std::memory_order_acquire)) {
+                if (pending()) continue;
+                break;
+            }
+
+            idle_.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (pending()) {
+                idle_.store(false, std::memory_order_relaxed);
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(mutex_);
+            // A producer that set idle_ between the check and the wait is
+            // picked up after kIdleWait at the latest.
+            wake_.wait_for(lock, kIdleWait, [this] {
+                return !idle_.load(std::memory_order_relaxed) || stopping_.load(std::memory_order_acquire);
+            });
+            idle_.store(false, std::memory_order_relaxed);
+        }
+    }
+
+    std::unique_ptr<Record[]> slots_;
+    alignas(kCacheLineSize) std::atomic<size_t> enqueue_{0};
+    alignas(kCacheLineSize) std::atomic<uint64_t> dropped_{0};
+    std::atomic<bool> idle_{false};
+    alignas(kCacheLineSize) size_t dequeue_ = 0;  // drainer thread
+    std::atomic<size_t> drained_{0};
+    std::atomic<bool> stopping_{false};
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable written_;
+    std::thread thread_;
+};
+
+LogRing& Ring() {
+    static LogRing ring;
+    return ring;
+}
+
+}  // namespace
+
+bool LogWrite(const LogSite& site, const LogArg* args, size_t count) { return Ring().write(site, args, count); }
+
+void FlushLog() { Ring().flush(); }
+
+}  // namespace ai_bridge
@@ -0,0 +1,111 @@
+#ifndef AI_BRIDGE_CORE_LOG_H_
+#define AI_BRIDGE_CORE_LOG_H_
+
+#include <android/log.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+// Logcat tag shared by every ai_bridge translation unit.
+#define APPNAME "AIBridgeCPP_LLM"
+
+// Lowest priority compiled in; LOG* calls below it generate no code at all.
+// Set by CMake (AI_BRIDGE_LOG_LEVEL), otherwise debug builds keep
+// ANDROID_LOG_DEBUG and release builds ANDROID_LOG_INFO.
+#ifndef AI_BRIDGE_LOG_LEVEL
+#ifdef NDEBUG
+#define AI_BRIDGE_LOG_LEVEL ANDROID_LOG_INFO
+#else
+#define AI_BRIDGE_LOG_LEVEL ANDROID_LOG_DEBUG
+#endif
+#endif
+
+// printf-style logging that never formats on the calling thread: the call
+// stores its site (priority and format) and raw arguments in a lock-free
+// ring, and a background thread formats and writes them to logcat, or to
+// stderr on host builds. Arguments are integers, floating point, pointers
+// and C strings; strings are copied, up to a per-message budget, so they
+// may be freed once the call returns. When the ring is full the message is
+// dropped and counted (MetricCounter::kLogRecordsDropped).
+#define AI_BRIDGE_LOG(priority, format, ...)                                         \
+    do {                                                                             \
+        if constexpr ((priority) >= AI_BRIDGE_LOG_LEVEL) {                           \
+            if (false) ::ai_bridge::CheckLogFormat(format, ##__VA_ARGS__);           \
+            static constexpr ::ai_bridge::LogSite ai_bridge_log_site{(priority), format}; \
+            ::ai_bridge::Log(ai_bridge_log_site, ##__VA_ARGS__);                     \
+        }                                                                            \
+    } while (0)
+
+#define LOGV(...) AI_BRIDGE_LOG(ANDROID_LOG_VERBOSE, __VA_ARGS__)
+#define LOGD(...) AI_BRIDGE_LOG(ANDROID_LOG_DEBUG, __VA_ARGS__)
+#define LOGI(...) AI_BRIDGE_LOG(ANDROID_LOG_INFO, __VA_ARGS__)
+#define LOGW(...) AI_BRIDGE_LOG(ANDROID_LOG_WARN, __VA_ARGS__)
+#define LOGE(...) AI_BRIDGE_LOG(ANDROID_LOG_ERROR, __VA_ARGS__)
+
+namespace ai_bridge {
+
+// One LOG* call site; its address identifies the message format.
+struct LogSite {
+    int priority;
+    const char* format;
+};
+
+enum class LogArgType : uint8_t { kSigned, kUnsigned, kDouble, kString, kPointer };
+
+struct LogArg {
+    LogArgType type;
+    union {
+        int64_t i;
+        uint64_t u;
+        double d;
+        const void* p;
+        const char* s;
+    };
+};
+
+// Never called: lets the compiler check the format against the arguments.
+inline void CheckLogFormat(const char*, ...) __attribute__((format(printf, 1, 2)));
+inline void CheckLogFormat(const char*, ...) {}
+
+template <typename T>
+LogArg MakeLogArg(T value) {
+    LogArg arg;
+    if constexpr (std::is_same_v<T, const char*> || std::is_same_v<T, char*>) {
+        arg.type = LogArgType::kString;
+        arg.s = value;
+    } else if constexpr (std::is_floating_point_v<T>) {
+        arg.type = LogArgType::kDouble;
+        arg.d = value;
+    } else if constexpr (std::is_enum_v<T>) {
+        arg.type = LogArgType::kSigned;
+        arg.i = static_cast<int64_t>(value);
+    } else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+        arg.type = LogArgType::kSigned;
+        arg.i = value;
+    } else if constexpr (std::is_integral_v<T>) {
+        arg.type = LogArgType::kUnsigned;
+        arg.u = value;
+    } else {
+        static_assert(std::is_pointer_v<T>, "LOG* arguments are numbers, pointers or C strings");
+        arg.type = LogArgType::kPointer;
+        arg.p = value;
+    }
+    return arg;
+}
+
+// Copies a message into the log ring; returns false if it was dropped.
+bool LogWrite(const LogSite& site, const LogArg* args, size_t count);
+
+template <typename... Args>
+void Log(const LogSite& site, Args... args) {
+    const LogArg encoded[sizeof...(Args) + 1] = {MakeLogArg(args)...};
+    LogWrite(site, encoded, sizeof...(Args));
+}
+
+// Blocks until every message logged before the call has been written.
+void FlushLog();
+
+}  // namespace ai_bridge
+
+#endif  // AI_BRIDGE_CORE_LOG_H_
@@ -0,0 +1,98 @@
+#include "core/metrics.h"
+
+#include <chrono>
+#include <cstring>
+
+namespace ai_bridge {
+
+namespace {
+
+// Header of a snapshot; see native_snapshot_metrics.
+struct SnapshotHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t counters;
+    uint16_t gauges;
+    uint16_t histograms;
+    uint32_t reserved;
+    int64_t taken_at_us;
+};
+static_assert(sizeof(SnapshotHeader) == 24, "snapshot header layout");
+
+constexpr size_t kGaugeFields = 2;      // value, max
+constexpr size_t kHistogramFields = 6;  // count, sum, max, p50, p90, p99
+
+}  // namespace
+
+MetricsRegistry::Shard& MetricsRegistry::shard() {
+    // A thread keeps its shard for life; threads beyond kShards share.
+    thread_local Shard* mine = nullptr;
+    thread_local const MetricsRegistry* owner = nullptr;
+    if (owner != this) {
+        mine = &shards_[next_shard_.fetch_add(1, std::memory_order_relaxed) % kShards];
+        owner = this;
+    }
+    return *mine;
+}
+
+void MetricsRegistry::set(MetricGauge gauge, int64_t value) {
+    Gauge& g = gauges_[static_cast<int32_t>(gauge)];
+    g.value.store(value, std::memory_order_relaxed);
+    int64_t seen = g.max.load(std::memory_order_relaxed);
+    while (value > seen && !g.max.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {
+    }
+}
+
+int64_t MetricsRegistry::counter(MetricCounter counter) const {
+    int64_t total = 0;
+    for (const Shard& s : shards_) total += s.counters[static_cast<int32_t>(counter)].load(std::memory_order_relaxed);
+    return total;
+}
+
+size_t MetricsRegistry::SnapshotSize() {
+    return sizeof(SnapshotHeader) +
+           sizeof(int64_t) * (kMetricCounterCount + kMetricGaugeCount * kGaugeFields +
+                              kMetricHistogramCount * kHistogramFields);
+}
+
+size_t MetricsRegistry::snapshot(uint8_t* out, size_t capacity) const {
+    const size_t size = SnapshotSize();
+    if (out == nullptr || capacity < size) return size;
+
+    SnapshotHeader header = {};
+    header.magic = kSnapshotMagic;
+    header.version = kSnapshotVersion;
+    header.counters = static_cast<uint16_t>(kMetricCounterCount);
+    header.gauges = static_cast<uint16_t>(kMetricGaugeCount);
+    header.histograms = static_cast<uint16_t>(kMetricHistogramCount);
+    header.taken_at_us =
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    memcpy(out, &header, sizeof(header));
+    uint8_t* cursor = out + sizeof(header);
+    auto put = [&cursor](int64_t value) {
+        memcpy(cursor, &value, sizeof(value));
+        cursor += sizeof(value);
+    };
+    for (int32_t c = 0; c < kMetricCounterCount; ++c) put(counter(static_cast<MetricCounter>(c)));
+    for (const Gauge& g : gauges_) {
+        put(g.value.load(std::memory_order_relaxed));
+        put(g.max.load(std::memory_order_relaxed));
+    }
+    for (const HdrHistogram& h : histograms_) {
+        put(h.count());
+        put(h.sum());
+        put(h.max());
+        put(h.percentile(50));
+        put(h.percentile(90));
+        put(h.percentile(99));
+    }
+    return size;
+}
+
+MetricsRegistry& Metrics() {
+    static MetricsRegistry registry;
+    return registry;
+}
+
+}  // namespace ai_bridge
@@ -0,0 +1,121 @@
+#ifndef AI_BRIDGE_CORE_METRICS_H_
+#define AI_BRIDGE_CORE_METRICS_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "core/hdr_histogram.h"
+#include "core/spsc_ring.h"
+
+namespace ai_bridge {
+
+// Values match AI_BRIDGE_METRIC_COUNTER_* in ai_bridge.h; append only.
+enum class MetricCounter : int32_t {
+    kTokensGenerated = 0,
+    kPrefillTokens,
+    kDecodeSteps,
+    kRequestsQueued,
+    kRequestsRejected,  // queue full or LLM not running
+    kRequestsCancelled,
+    kRepliesCompleted,
+    kRepliesFailed,
+    kDartPosts,
+    kDartPostFailures,  // Dart_PostCObject_DL returned false
+    kLogRecordsDropped,  // log ring full
+    kPoolTasksStolen,    // compute-pool tasks run by another worker than they were queued on
+    kPoolHelperYields,   // parallel_for helpers that gave their worker to more urgent work
+    kCount
+};
+
+// Values match AI_BRIDGE_METRIC_GAUGE_* in ai_bridge.h; append only.
+enum class MetricGauge : int32_t {
+    kQueueDepth = 0,      // LLM requests waiting
+    kActiveSessions,      // replies being generated or prefilled
+    kKvPagesInUse,        // reference-engine KV pages holding positions
+    kKvPagesShared,       // of those, pages more than one sequence holds
+    kCount
+};
+
+// Values match AI_BRIDGE_METRIC_HISTOGRAM_* in ai_bridge.h; append only.
+enum class MetricHistogram : int32_t {
+    kQueueWaitUs = 0,         // request queued -> taken by the scheduler
+    kFirstTokenUs,            // request queued -> first token
+    kDecodeStepUs,            // one engine decode call
+    kPrefillTokensPerSecond,  // per request: uncached prompt / (start -> first token)
+    kDecodeTokensPerSecond,   // per reply: tokens after the first / (first -> last token)
+    kPoolHighPriorityWaitUs,  // kHigh compute-pool task queued -> started
+    kCount
+};
+
+constexpr int32_t kMetricCounterCount = static_cast<int32_t>(MetricCounter::kCount);
+constexpr int32_t kMetricGaugeCount = static_cast<int32_t>(MetricGauge::kCount);
+constexpr int32_t kMetricHistogramCount = static_cast<int32_t>(MetricHistogram::kCount);
+
+// Process-wide counters, gauges and histograms, cheap enough to update from
+// the decode loop for every token instead of logging a line per event.
+//
+// Counters are sharded: each thread adds to the shard it was assigned on
+// first use, a cache line apart from the others, so the decode loop and the
+// flusher never bounce a line between cores; snapshot() sums the shards.
+// Gauges are a single value with its high-water mark. Histograms are
+// HdrHistograms. Every update is a relaxed atomic operation.
+//
+// snapshot() writes the compact binary layout native_snapshot_metrics
+// documents in ai_bridge.h.
+class MetricsRegistry {
+public:
+    static constexpr uint32_t kSnapshotMagic = 0x4d424941;  // "AIBM" little-endian
+    static constexpr uint16_t kSnapshotVersion = 1;
+
+    MetricsRegistry() = default;
+    MetricsRegistry(const MetricsRegistry&) = delete;
+    MetricsRegistry& operator=(const MetricsRegistry&) = delete;
+
+    void add(MetricCounter counter, int64_t delta = 1) {
+        shard().counters[static_cast<int32_t>(counter)].fetch_add(delta, std::memory_order_relaxed);
+    }
+    void set(MetricGauge gauge, int64_t value);
+    void record(MetricHistogram histogram, int64_t value) {
+        histograms_[static_cast<int32_t>(histogram)].record(value);
+    }
+
+    int64_t counter(MetricCounter counter) const;
+    int64_t gauge(MetricGauge gauge) const {
+        return gauges_[static_cast<int32_t>(gauge)].value.load(std::memory_order_relaxed);
+    }
+    const HdrHistogram& histogram(MetricHistogram histogram) const {
+        return histograms_[static_cast<int32_t>(histogram)];
+    }
+
+    // Bytes snapshot() writes.
+    static size_t SnapshotSize();
+    // Writes the snapshot to `out` if `capacity` holds SnapshotSize() bytes;
+    // returns SnapshotSize() either way.
+    size_t snapshot(uint8_t* out, size_t capacity) const;
+
+private:
+    static constexpr size_t kShards = 8;
+
+    struct alignas(kCacheLineSize) Shard {
+        std::atomic<int64_t> counters[kMetricCounterCount] = {};
+    };
+    struct Gauge {
+        std::atomic<int64_t> value{0};
+        std::atomic<int64_t> max{0};
+    };
+
+    Shard& shard();
+
+    Shard shards_[kShards];
+    std::atomic<size_t> next_shard_{0};
+    Gauge gauges_[kMetricGaugeCount];
+    HdrHistogram histograms_[kMetricHistogramCount];
+};
+
+// The process-wide registry.
+MetricsRegistry& Metrics();
+
+}  // namespace ai_bridge
+
+#endif  // AI_BRIDGE_CORE_METRICS_H_
@@ -0,0 +1,98 @@
+#ifndef AI_BRIDGE_CORE_SPSC_RING_H_
+#define AI_BRIDGE_CORE_SPSC_RING_H_
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+namespace ai_bridge {
+
+// Destructive interference size for the targets we ship (arm64, x86-64).
+constexpr size_t kCacheLineSize = 64;
+
+inline size_t RoundUpToPowerOfTwo(size_t value) {
+    size_t result = 1;
+    while (result < value) result <<= 1;
+    return result;
+}
+
+// Bounded single-producer/single-consumer ring of preallocated slots.
+//
+// Slots are filled in place: the producer claims the next free slot, writes
+// it, then publishes it; the consumer reads the oldest published slot in place
+// and pops it. Neither side allocates or blocks, and head/tail live on
+// separate cache lines so the two threads only share a line on publish/pop.
+template <typename T>
+class SpscRing {
+public:
+    explicit SpscRing(size_t capacity)
+        : capacity_(RoundUpToPowerOfTwo(capacity < 2 ? 2 : capacity)),
+          mask_(capacity_ - 1),
+          slots_(new T[capacity_]) {}
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    size_t capacity() const { return capacity_; }
+
+    // --- Producer side ---
+
+    // Returns the slot to fill next, or nullptr if the ring is full. Calling
+    // again before publish() returns the same slot.
+    T* try_claim() {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if (head - cached_tail_ >= capacity_) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            if (head - cached_tail_ >= capacity_) return nullptr;
+        }
+        return &slots_[head & mask_];
+    }
+
+    // Makes the slot returned by try_claim() visible to the consumer.
+    void publish() {
+        head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // --- Consumer side ---
+
+    // Returns the oldest published slot, or nullptr if the ring is empty.
+    T* front() {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail == cached_head_) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            if (tail == cached_head_) return nullptr;
+        }
+        return &slots_[tail & mask_];
+    }
+
+    // Releases the slot returned by front() back to the producer.
+    void pop() {
+        tail_.store(tail_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // --- Either side ---
+
+    bool empty() const {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+    }
+
+    size_t size() const {
+        const size_t tail = tail_.load(std::memory_order_acquire);
+        return head_.load(std::memory_order_acquire) - tail;
+    }
+
+private:
+    const size_t capacity_;
+    const size_t mask_;
+    std::unique_ptr<T[]> slots_;
+
+    alignas(kCacheLineSize) std::atomic<size_t> head_{0};
+    size_t cached_tail_ = 0;  // producer-local copy of tail_
+
+    alignas(kCacheLineSize) std::atomic<size_t> tail_{0};
+    size_t cached_head_ = 0;  // consumer-local copy of head_
+};
+
+}  // namespace ai_bridge
+
+#endif  // AI_BRIDGE_CORE_SPSC_RING_H_
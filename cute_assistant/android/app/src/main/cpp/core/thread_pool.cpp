@@ -0,0 +1,284 @@
+#include "core/thread_pool.h"
+
+#include <pthread.h>
+#include <sched.h>
+
+#include "core/cpu_features.h"
+#include "core/metrics.h"
+
+namespace ai_bridge {
+
+namespace {
+
+// The pool and worker index of the current thread, if it is a worker.
+thread_local const ThreadPool* tl_pool = nullptr;
+thread_local int32_t tl_worker = -1;
+
+int32_t HintIndex(CoreHint hint) { return static_cast<int32_t>(hint); }
+
+}  // namespace
+
+struct ThreadPool::Job {
+    const std::function<void(int32_t)>* task = nullptr;
+    int32_t count = 0;
+    TaskPriority priority = TaskPriority::kNormal;
+    std::atomic<int32_t> next{0};
+    std::atomic<int32_t> done{0};
+    std::mutex mutex;
+    std::condition_variable finished;
+
+    // Adds `ran` finished iterations; the last one wakes the caller.
+    void finish(int32_t ran) {
+        if (ran == 0 || done.fetch_add(ran, std::memory_order_acq_rel) + ran != count) return;
+        std::lock_guard<std::mutex> lock(mutex);
+        finished.notify_all();
+    }
+};
+
+ThreadPool::ThreadPool(int32_t workers) {
+    const size_t count = static_cast<size_t>(std::max(0, workers));
+    start(std::vector<std::vector<int32_t>>(count), std::vector<bool>(count, false));
+}
+
+ThreadPool::ThreadPool(const CpuTopology& topology) {
+    std::vector<std::vector<int32_t>> pins;
+    std::vector<bool> little;
+    // Pinning only keeps workers on their class; a uniform device is left
+    // to the scheduler.
+    const bool pin = !topology.big.empty() && !topology.little.empty();
+    for (size_t i = 0; i < topology.big.size(); ++i) {
+        pins.push_back(pin ? topology.big : std::vector<int32_t>());
+        little.push_back(false);
+    }
+    for (size_t i = 0; i < topology.little.size(); ++i) {
+        pins.push_back(topology.little);
+        little.push_back(true);
+    }
+    start(pins, little);
+}
+
+void ThreadPool::start(const std::vector<std::vector<int32_t>>& pins, const std::vector<bool>& little) {
+    for (size_t i = 0; i < little.size(); ++i) {
+        workers_.push_back(std::make_unique<Worker>());
+        workers_.back()->little = little[i];
+        (little[i] ? has_little_ : has_big_) = true;
+    }
+    for (size_t i = 0; i < workers_.size(); ++i) {
+        workers_[i]->thread = std::thread(&ThreadPool::run, this, static_cast<int32_t>(i), pins[i]);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for (const std::unique_ptr<Worker>& worker : workers_) worker->thread.join();
+}
+
+int32_t ThreadPool::queued_count(int32_t worker, int32_t priority) const {
+    const CoreHint own = workers_[worker]->little ? CoreHint::kLittle : CoreHint::kBig;
+    return queued_[priority][HintIndex(CoreHint::kAny)].load(std::memory_order_relaxed) +
+           queued_[priority][HintIndex(own)].load(std::memory_order_relaxed);
+}
+
+bool ThreadPool::more_urgent_queued(int32_t worker, TaskPriority priority) const {
+    for (int32_t p = 0; p < static_cast<int32_t>(priority); ++p) {
+        if (queued_count(worker, p) > 0) return true;
+    }
+    return false;
+}
+
+bool ThreadPool::runnable_queued(int32_t worker) const {
+    for (int32_t p = 0; p < kTaskPriorityCount; ++p) {
+        if (queued_count(worker, p) > 0) return true;
+    }
+    return false;
+}
+
+void ThreadPool::push(int32_t worker, TaskPriority priority, Task task) {
+    Worker& target = *workers_[worker];
+    std::lock_guard<std::mutex> lock(target.mutex);
+    queued_[static_cast<int32_t>(priority)][HintIndex(task.hint)].fetch_add(1, std::memory_order_relaxed);
+    target.queues[static_cast<int32_t>(priority)].push_back(std::move(task));
+}
+
+int32_t ThreadPool::place(CoreHint hint) {
+    auto runs = [hint](const Worker& worker) {
+        return hint == CoreHint::kAny || (hint == CoreHint::kLittle) == worker.little;
+    };
+    if (tl_pool == this && runs(*workers_[tl_worker])) return tl_worker;
+    const uint32_t count = static_cast<uint32_t>(workers_.size());
+    // Some worker of the class exists, since the hint would be kAny otherwise.
+    for (;;) {
+        const int32_t worker = static_cast<int32_t>(next_worker_.fetch_add(1, std::memory_order_relaxed) % count);
+        if (runs(*workers_[worker])) return worker;
+    }
+}
+
+void ThreadPool::wake_all() {
+    // Taking the lock orders the queued_ update before a sleeper's check.
+    { std::lock_guard<std::mutex> lock(sleep_mutex_); }
+    wake_.notify_all();
+}
+
+void ThreadPool::submit(TaskPriority priority, CoreHint hint, std::function<void()> task) {
+    if (workers_.empty()) {
+        task();
+        return;
+    }
+    Task queued;
+    queued.run = std::move(task);
+    queued.hint = has_big_ && has_little_ ? hint : CoreHint::kAny;
+    if (priority == TaskPriority::kHigh) queued.queued_at = std::chrono::steady_clock::now();
+    push(place(queued.hint), priority, std::move(queued));
+    wake_all();
+}
+
+void ThreadPool::run_sync(TaskPriority priority, CoreHint hint, const std::function<void()>& task) {
+    if (workers_.empty() || tl_pool == this) {
+        task();
+        return;
+    }
+    std::mutex mutex;
+    std::condition_variable finished;
+    bool done = false;
+    submit(priority, hint, [&] {
+        task();
+        // Notified under the lock: the waiter may return, destroying both,
+        // as soon as it can see `done`.
+        std::lock_guard<std::mutex> lock(mutex);
+        done = true;
+        finished.notify_one();
+    });
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [&] { return done; });
+}
+
+void ThreadPool::parallel_for(int32_t count, const std::function<void(int32_t)>& task, int32_t max_threads,
+                              TaskPriority priority) {
+    if (count <= 0) return;
+    const int32_t threads = std::min(max_threads > 0 ? std::min(max_threads, size()) : size(), count);
+    if (threads <= 1) {
+        for (int32_t i = 0; i < count; ++i) task(i);
+        return;
+    }
+
+    // Helpers may start after the loop is done; they share the job so
+    // they can see that, and only touch `task` for iterations they claim.
+    auto job = std::make_shared<Job>();
+    job->task = &task;
+    job->count = count;
+    job->priority = priority;
+    for (int32_t h = 1; h < threads; ++h) {
+        Task helper;
+        helper.run = [this, job] { help(job); };
+        push(place(CoreHint::kAny), priority, std::move(helper));
+    }
+    wake_all();
+
+    int32_t ran = 0;
+    for (int32_t i = job->next.fetch_add(1, std::memory_order_relaxed); i < count;
+         i = job->next.fetch_add(1, std::memory_order_relaxed)) {
+        task(i);
+        ++ran;
+    }
+    job->finish(ran);
+    std::unique_lock<std::mutex> lock(job->mutex);
+    job->finished.wait(lock, [&] { return job->done.load(std::memory_order_acquire) == count; });
+}
+
+void ThreadPool::help(const std::shared_ptr<Job>& job) {
+    int32_t ran = 0;
+    for (;;) {
+        if (more_urgent_queued(tl_worker, job->priority)) {
+            if (job->next.load(std::memory_order_relaxed) < job->count) {
+                // Back of the line at this priority; the urgent task is
+                // taken first.
+                Task helper;
+                helper.run = [this, job] { help(job); };
+                push(tl_worker, job->priority, std::move(helper));
+                Metrics().add(MetricCounter::kPoolHelperYields);
+            }
+            break;
+        }
+        const int32_t i = job->next.fetch_add(1, std::memory_order_relaxed);
+        if (i >= job->count) break;
+        (*job->task)(i);
+        ++ran;
+    }
+    job->finish(ran);
+}
+
+bool ThreadPool::take(int32_t worker, Task* task, TaskPriority* priority) {
+    const int32_t count = static_cast<int32_t>(workers_.size());
+    const bool little = workers_[worker]->little;
+    for (int32_t p = 0; p < kTaskPriorityCount; ++p) {
+        if (queued_count(worker, p) == 0) continue;
+        *priority = static_cast<TaskPriority>(p);
+        {
+            // Everything on a worker's own deques is runnable there.
+            Worker& own = *workers_[worker];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            std::deque<Task>& queue = own.queues[p];
+            if (!queue.empty()) {
+                *task = std::move(queue.back());
+                queue.pop_back();
+                queued_[p][HintIndex(task->hint)].fetch_sub(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        for (int32_t k = 1; k < count; ++k) {
+            Worker& victim = *workers_[(worker + k) % count];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            std::deque<Task>& queue = victim.queues[p];
+            for (auto it = queue.begin(); it != queue.end(); ++it) {
+                if (it->hint != CoreHint::kAny && (it->hint == CoreHint::kLittle) != little) continue;
+                *task = std::move(*it);
+                queue.erase(it);
+                queued_[p][HintIndex(task->hint)].fetch_sub(1, std::memory_order_relaxed);
+                Metrics().add(MetricCounter::kPoolTasksStolen);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void ThreadPool::run(int32_t worker, std::vector<int32_t> cpus) {
+    pthread_setname_np(pthread_self(), "ai_bridge_pool");
+    if (!cpus.empty()) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (const int32_t cpu : cpus) CPU_SET(cpu, &set);
+        sched_setaffinity(0, sizeof(set), &set);  // 0: this thread; a hint, so failure is fine
+    }
+    tl_pool = this;
+    tl_worker = worker;
+    for (;;) {
+        Task task;
+        TaskPriority priority;
+        if (take(worker, &task, &priority)) {
+            if (priority == TaskPriority::kHigh) {
+                Metrics().record(MetricHistogram::kPoolHighPriorityWaitUs,
+                                 std::chrono::duration_cast<std::chrono::microseconds>(
+                                     std::chrono::steady_clock::now() - task.queued_at)
+                                     .count());
+            }
+            task.run();
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleep_mutex_);
+        wake_.wait(lock, [&] { return stopping_ || runnable_queued(worker); });
+        // Queued work still runs, so nobody waits forever on run_sync.
+        if (stopping_ && !runnable_queued(worker)) return;
+    }
+}
+
+ThreadPool& ComputePool() {
+    static ThreadPool pool(GetCpuTopology());
+    return pool;
+}
+
+}  // namespace ai_bridge
@@ -0,0 +1,130 @@
+#ifndef AI_BRIDGE_CORE_THREAD_POOL_H_
+#define AI_BRIDGE_CORE_THREAD_POOL_H_
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ai_bridge {
+
+struct CpuTopology;
+
+// Which queued work a worker picks first. Voice stages post kHigh so the
+// sentence being spoken or the speech being transcribed never waits behind
+// a long prefill, which posts kBackground; generating replies is kNormal.
+enum class TaskPriority : int32_t {
+    kHigh = 0,
+    kNormal,
+    kBackground,
+};
+constexpr int32_t kTaskPriorityCount = 3;
+
+// Cores a task should run on. On a device without distinct core classes,
+// and for a class with no workers, every hint means kAny.
+enum class CoreHint : int32_t {
+    kAny = 0,
+    kBig,
+    kLittle,
+};
+
+// Work-stealing pool that every compute stage shares, so inference, ASR and
+// TTS together never run more compute threads than there are cores.
+//
+// Each worker owns a deque per priority. Tasks a worker posts go to its own
+// deques and run newest first (the data is still in its cache); others are
+// placed round-robin over the workers of their core class. An idle worker
+// takes the most urgent task it may run, from its own deques first, and
+// otherwise steals the oldest one from another worker's.
+//
+// parallel_for splits one data-parallel loop, such as the tiles of a prefill
+// GEMM, over the caller and helper tasks. Helpers hand their worker back
+// between iterations as soon as more urgent work is queued, so a kHigh task
+// waits for one iteration at most.
+class ThreadPool {
+public:
+    // `workers` unpinned workers, all treated as big cores.
+    explicit ThreadPool(int32_t workers);
+    // One worker per core of `topology`; on a device with little cores each
+    // worker is pinned to the cores of its class.
+    explicit ThreadPool(const CpuTopology& topology);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int32_t workers() const { return static_cast<int32_t>(workers_.size()); }
+    // Threads a parallel_for can use: the caller plus one fewer helpers
+    // than there are workers, so the loop takes no more cores than exist.
+    int32_t size() const { return std::max<int32_t>(1, workers()); }
+
+    // Queues `task` to run on a worker. Without workers it runs right away
+    // on the calling thread.
+    void submit(TaskPriority priority, CoreHint hint, std::function<void()> task);
+    // Runs `task` on a worker and returns once it has finished. Called from
+    // a worker of this pool, it runs `task` in place.
+    void run_sync(TaskPriority priority, CoreHint hint, const std::function<void()>& task);
+    // Runs task(i) for every i in [0, count) on at most `max_threads`
+    // threads (0 for size()), the caller being one of them, and returns once
+    // all have finished. Calls from different threads proceed concurrently.
+    void parallel_for(int32_t count, const std::function<void(int32_t)>& task, int32_t max_threads = 0,
+                      TaskPriority priority = TaskPriority::kNormal);
+
+private:
+    struct Task {
+        std::function<void()> run;
+        CoreHint hint = CoreHint::kAny;
+        std::chrono::steady_clock::time_point queued_at;  // kHigh only, for the wait metric
+    };
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> queues[kTaskPriorityCount];
+        bool little = false;
+        std::thread thread;
+    };
+    struct Job;
+
+    void start(const std::vector<std::vector<int32_t>>& pins, const std::vector<bool>& little);
+    void run(int32_t worker, std::vector<int32_t> cpus);
+    // Removes the most urgent task `worker` may run into `task`.
+    bool take(int32_t worker, Task* task, TaskPriority* priority);
+    // Whether a task more urgent than `priority` waits that `worker` may run.
+    bool more_urgent_queued(int32_t worker, TaskPriority priority) const;
+    bool runnable_queued(int32_t worker) const;
+    int32_t queued_count(int32_t worker, int32_t priority) const;
+    // Queues `task` on the deque of `worker` without waking anyone.
+    void push(int32_t worker, TaskPriority priority, Task task);
+    // Picks the worker a task posted from this thread goes to.
+    int32_t place(CoreHint hint);
+    void wake_all();
+    // Runs iterations of `job` until none are left or more urgent work is
+    // queued, in which case it requeues itself.
+    void help(const std::shared_ptr<Job>& job);
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    bool has_big_ = false;
+    bool has_little_ = false;
+    std::atomic<uint32_t> next_worker_{0};  // round-robin placement
+
+    // Queued tasks by priority and hint, for sleeping and yielding.
+    std::atomic<int32_t> queued_[kTaskPriorityCount][3] = {};
+
+    std::mutex sleep_mutex_;
+    std::condition_variable wake_;
+    bool stopping_ = false;
+};
+
+// The process-wide pool, one worker per core the process may run on,
+// created on first use.
+ThreadPool& ComputePool();
+
+}  // namespace ai_bridge
+
+#endif  // AI_BRIDGE_CORE_THREAD_POOL_H_
@@ -0,0 +1,149 @@
+#include "core/turn_trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+
+namespace ai_bridge {
+
+namespace {
+
+struct SpanInfo {
+    const char* name;
+    TurnStage from;
+    TurnStage to;
+    int32_t track;  // trace "thread" it is drawn on
+};
+
+constexpr SpanInfo kSpans[kTurnSpanCount] = {
+    {"transcribe", TurnStage::kSpeechEnd, TurnStage::kTranscriptFinal, 1},
+    {"first token", TurnStage::kTranscriptFinal, TurnStage::kFirstToken, 2},
+    {"generate", TurnStage::kFirstToken, TurnStage::kLastToken, 2},
+    {"first audio", TurnStage::kFirstToken, TurnStage::kFirstAudio, 3},
+    {"playback", TurnStage::kFirstAudio, TurnStage::kAudioDone, 3},
+    {"response", TurnStage::kSpeechEnd, TurnStage::kFirstAudio, 0},
+};
+
+constexpr const char* kTracks[] = {"turn", "speech", "llm", "tts"};
+
+}  // namespace
+
+const char* TurnSpanName(TurnSpan span) {
+    const int32_t index = static_cast<int32_t>(span);
+    return index >= 0 && index < kTurnSpanCount ? kSpans[index].name : "unknown";
+}
+
+int64_t TurnTrace::NowMicros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+int64_t TurnTrace::begin_turn(int64_t at_us) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const int64_t id = next_id_++;
+    Turn& turn = turns_[static_cast<size_t>(id) % kRecentTurns];
+    close(&turn);  // the oldest turn gives up its slot
+    turn = Turn();
+    turn.id = id;
+    turn.closed = false;
+    turn.at_us[static_cast<int32_t>(TurnStage::kSpeechEnd)] = at_us;
+    return id;
+}
+
+void TurnTrace::mark(int64_t turn_id, TurnStage stage, int64_t at_us) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stamp(find(turn_id), stage, at_us);
+}
+
+void TurnTrace::attach_request(int64_t turn_id, int64_t request_id) {
+    if (request_id == 0) return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    Turn* turn = find(turn_id);
+    if (turn != nullptr && !turn->closed && turn->request_id == 0) turn->request_id = request_id;
+}
+
+void TurnTrace::mark_request(int64_t request_id, TurnStage stage, int64_t at_us) {
+    if (request_id == 0) return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    stamp(find_request(request_id), stage, at_us);
+}
+
+void TurnTrace::abandon_request(int64_t request_id) {
+    if (request_id == 0) return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (Turn* turn = find_request(request_id)) close(turn);
+}
+
+TurnTrace::Turn* TurnTrace::find(int64_t turn_id) {
+    if (turn_id == 0) turn_id = next_id_ - 1;
+    if (turn_id <= 0) return nullptr;
+    Turn& turn = turns_[static_cast<size_t>(turn_id) % kRecentTurns];
+    return turn.id == turn_id ? &turn : nullptr;
+}
+
+TurnTrace::Turn* TurnTrace::find_request(int64_t request_id) {
+    for (Turn& turn : turns_) {
+        if (turn.request_id == request_id && !turn.closed) return &turn;
+    }
+    return nullptr;
+}
+
+void TurnTrace::stamp(Turn* turn, TurnStage stage, int64_t at_us) {
+    if (turn == nullptr || turn->closed) return;
+    int64_t& at = turn->at_us[static_cast<int32_t>(stage)];
+    if (at == 0) at = at_us;
+    if (stage == TurnStage::kAudioDone) close(turn);
+}
+
+void TurnTrace::close(Turn* turn) {
+    if (turn->closed) return;
+    turn->closed = true;
+    for (int32_t s = 0; s < kTurnSpanCount; ++s) {
+        const int64_t from = turn->at_us[static_cast<int32_t>(kSpans[s].from)];
+        const int64_t to = turn->at_us[static_cast<int32_t>(kSpans[s].to)];
+        if (from != 0 && to != 0) spans_[s].record(to - from);
+    }
+}
+
+std::string TurnTrace::chrome_trace() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::string json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    char event[256];
+    bool first = true;
+    auto append = [&](int length) {
+        if (length <= 0) return;
+        if (!first) json += ',';
+        json.append(event, static_cast<size_t>(std::min<int>(length, sizeof(event) - 1)));
+        first = false;
+    };
+    for (int32_t track = 0; track < static_cast<int32_t>(sizeof(kTracks) / sizeof(kTracks[0])); ++track) {
+        append(snprintf(event, sizeof(event),
+                        "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}", track,
+                        kTracks[track]));
+    }
+    // Oldest first, as trace viewers expect.
+    for (int64_t id = next_id_ - static_cast<int64_t>(kRecentTurns); id < next_id_; ++id) {
+        if (id <= 0) continue;
+        const Turn& turn = turns_[static_cast<size_t>(id) % kRecentTurns];
+        if (turn.id != id) continue;
+        for (int32_t s = 0; s < kTurnSpanCount; ++s) {
+            const int64_t from = turn.at_us[static_cast<int32_t>(kSpans[s].from)];
+            const int64_t to = turn.at_us[static_cast<int32_t>(kSpans[s].to)];
+            if (from == 0 || to == 0 || to < from) continue;
+            append(snprintf(event, sizeof(event),
+                            "{\"name\":\"%s\",\"cat\":\"turn\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%" PRId64
+                            ",\"dur\":%" PRId64 ",\"args\":{\"turn\":%" PRId64 ",\"request\":%" PRId64 "}}",
+                            kSpans[s].name, kSpans[s].track, from, to - from, turn.id, turn.request_id));
+        }
+    }
+    json += "]}";
+    return json;
+}
+
+TurnTrace& VoiceTurnTrace() {
+    static TurnTrace trace;
+    return trace;
+}
+
+}  // namespace ai_bridge
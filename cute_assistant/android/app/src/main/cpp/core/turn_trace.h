@@ -0,0 +1,108 @@
+#ifndef AI_BRIDGE_CORE_TURN_TRACE_H_
+#define AI_BRIDGE_CORE_TURN_TRACE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+#include "core/hdr_histogram.h"
+
+namespace ai_bridge {
+
+// Points of a voice turn, in the order they normally happen. Values match
+// AI_BRIDGE_TURN_STAGE_* in ai_bridge.h.
+enum class TurnStage : int32_t {
+    kSpeechEnd = 0,        // the VAD heard the user stop
+    kTranscriptFinal = 1,  // the final transcript is out
+    kFirstToken = 2,       // the reply's first token is generated
+    kLastToken = 3,        // and its last
+    kFirstAudio = 4,       // its first sample is played
+    kAudioDone = 5,        // its last sample is played
+};
+constexpr int32_t kTurnStageCount = 6;
+
+// Intervals of a turn reported as histograms and trace events. Values match
+// AI_BRIDGE_TURN_SPAN_* in ai_bridge.h.
+enum class TurnSpan : int32_t {
+    kTranscribe = 0,  // speech end -> final transcript
+    kFirstToken = 1,  // final transcript -> first token (queueing and prefill)
+    kGenerate = 2,    // first token -> last token
+    kFirstAudio = 3,  // first token -> first sample played
+    kPlayback = 4,    // first sample -> last sample played
+    kResponse = 5,    // speech end -> first sample played, the turn's latency
+};
+constexpr int32_t kTurnSpanCount = 6;
+
+const char* TurnSpanName(TurnSpan span);
+
+// Where the time of each voice turn goes, from the end of the user's speech
+// to the end of the spoken reply.
+//
+// Each stage is stamped with the monotonic (steady_clock) time it happened,
+// by whichever side observed it: the native VAD, recognizer, scheduler and
+// TTS stamp their own stages, and the Dart service stamps the ones the
+// platform recognizer and TTS report. A turn is opened at speech end and
+// picks up the LLM request that answers it through attach_request(); the
+// LLM and TTS stages are then stamped by request id. When the turn's audio
+// is done, its reply is abandoned (cancelled, failed, cut off) or it is
+// pushed out of the recent window unanswered, every span both of whose
+// stages were stamped goes into that span's histogram. The recent turns can be dumped in the
+// Chrome trace event format for chrome://tracing or Perfetto.
+//
+// Stamps arrive a few times per turn, so one mutex guards everything; no
+// caller stamps from a real-time audio callback.
+class TurnTrace {
+public:
+    static constexpr size_t kRecentTurns = 64;
+
+    TurnTrace() = default;
+    TurnTrace(const TurnTrace&) = delete;
+    TurnTrace& operator=(const TurnTrace&) = delete;
+
+    static int64_t NowMicros();
+
+    // Opens a turn whose speech ended at `at_us`; returns its id (> 0).
+    int64_t begin_turn(int64_t at_us);
+    // Stamps `stage` of turn `turn_id`, or of the newest turn for 0. Later
+    // stamps of the same stage are ignored, as are closed turns.
+    void mark(int64_t turn_id, TurnStage stage, int64_t at_us);
+    // Makes `request_id` the LLM request answering turn `turn_id` (0 for
+    // the newest), if it has none yet.
+    void attach_request(int64_t turn_id, int64_t request_id);
+    // Stamps `stage` of the turn answered by `request_id`, if any.
+    void mark_request(int64_t request_id, TurnStage stage, int64_t at_us);
+    // Closes the turn answered by `request_id` without further stamps: its
+    // reply was cancelled, failed or cut off.
+    void abandon_request(int64_t request_id);
+
+    // Spans of the turns closed so far.
+    const HdrHistogram& histogram(TurnSpan span) const { return spans_[static_cast<int32_t>(span)]; }
+    // The recent turns, closed or not, as Chrome trace event JSON.
+    std::string chrome_trace() const;
+
+private:
+    struct Turn {
+        int64_t id = 0;
+        int64_t request_id = 0;
+        int64_t at_us[kTurnStageCount] = {};  // 0 until stamped
+        bool closed = true;
+    };
+
+    Turn* find(int64_t turn_id);
+    Turn* find_request(int64_t request_id);
+    void stamp(Turn* turn, TurnStage stage, int64_t at_us);
+    void close(Turn* turn);
+
+    mutable std::mutex mutex_;
+    Turn turns_[kRecentTurns];
+    int64_t next_id_ = 1;
+    HdrHistogram spans_[kTurnSpanCount];
+};
+
+// The process-wide voice turn trace.
+TurnTrace& VoiceTurnTrace();
+
+}  // namespace ai_bridge
+
+#endif  // AI_BRIDGE_CORE_TURN_TRACE_H_
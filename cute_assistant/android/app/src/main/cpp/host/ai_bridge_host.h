@@ -0,0 +1,22 @@
+#ifndef AI_BRIDGE_HOST_AI_BRIDGE_HOST_H_
+#define AI_BRIDGE_HOST_AI_BRIDGE_HOST_H_
+
+// Hooks for driving ai_bridge from a host process (benchmarks, load
+// generators) instead of a Dart isolate.
+
+#include "dart_api_dl.h"
+
+// Called for every Dart_PostCObject_DL. The message and everything it points
+// to is only valid for the duration of the call. Return false to simulate a
+// closed port. External typed data is finalized right after the handler
+// returns true, as if the Dart GC had collected it immediately.
+typedef bool (*AiBridgeHostPostHandler)(Dart_Port port_id, Dart_CObject* message, void* user_data);
+
+// Installs the message sink for all ports. Passing nullptr restores the
+// default, which accepts and discards messages for any valid port.
+DART_EXPORT void ai_bridge_host_set_post_handler(AiBridgeHostPostHandler handler, void* user_data);
+
+// Minimum android_LogPriority written to stderr (default ANDROID_LOG_INFO).
+DART_EXPORT void ai_bridge_host_set_log_priority(int priority);
+
+#endif  // AI_BRIDGE_HOST_AI_BRIDGE_HOST_H_
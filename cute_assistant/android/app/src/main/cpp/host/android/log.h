@@ -0,0 +1,32 @@
+#ifndef AI_BRIDGE_HOST_ANDROID_LOG_H_
+#define AI_BRIDGE_HOST_ANDROID_LOG_H_
+
+// Host (plain Linux) stand-in for the NDK's <android/log.h>. Messages go to
+// stderr, filtered by ai_bridge_host_set_log_priority().
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum android_LogPriority {
+  ANDROID_LOG_UNKNOWN = 0,
+  ANDROID_LOG_DEFAULT,
+  ANDROID_LOG_VERBOSE,
+  ANDROID_LOG_DEBUG,
+  ANDROID_LOG_INFO,
+  ANDROID_LOG_WARN,
+  ANDROID_LOG_ERROR,
+  ANDROID_LOG_FATAL,
+  ANDROID_LOG_SILENT,
+} android_LogPriority;
+
+int __android_log_write(int prio, const char* tag, const char* text);
+
+int __android_log_print(int prio, const char* tag, const char* fmt, ...)
+    __attribute__((format(printf, 3, 4)));
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // AI_BRIDGE_HOST_ANDROID_LOG_H_
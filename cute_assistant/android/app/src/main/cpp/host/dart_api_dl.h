@@ -0,0 +1,110 @@
+#ifndef AI_BRIDGE_HOST_DART_API_DL_H_
+#define AI_BRIDGE_HOST_DART_API_DL_H_
+
+// Host (plain Linux) stand-in for the Dart SDK's dart_api_dl.h.
+//
+// Only the subset of the Dart native API that ai_bridge uses is declared here,
+// with the same names, values and struct layouts as the SDK headers, so the
+// bridge sources compile unchanged outside the Flutter/NDK build. Messages
+// posted to a port are delivered to the handler installed with
+// ai_bridge_host_set_post_handler() (see ai_bridge_host.h).
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+#define DART_EXTERN_C extern "C"
+#else
+#define DART_EXTERN_C extern
+#endif
+
+#define DART_EXPORT DART_EXTERN_C __attribute__((visibility("default"))) __attribute((used))
+
+typedef int64_t Dart_Port;
+#define ILLEGAL_PORT ((Dart_Port)0)
+
+typedef enum {
+  Dart_TypedData_kByteData = 0,
+  Dart_TypedData_kInt8,
+  Dart_TypedData_kUint8,
+  Dart_TypedData_kUint8Clamped,
+  Dart_TypedData_kInt16,
+  Dart_TypedData_kUint16,
+  Dart_TypedData_kInt32,
+  Dart_TypedData_kUint32,
+  Dart_TypedData_kInt64,
+  Dart_TypedData_kUint64,
+  Dart_TypedData_kFloat32,
+  Dart_TypedData_kFloat64,
+  Dart_TypedData_kInt32x4,
+  Dart_TypedData_kFloat32x4,
+  Dart_TypedData_kFloat64x2,
+  Dart_TypedData_kInvalid
+} Dart_TypedData_Type;
+
+typedef enum {
+  Dart_CObject_kNull = 0,
+  Dart_CObject_kBool,
+  Dart_CObject_kInt32,
+  Dart_CObject_kInt64,
+  Dart_CObject_kDouble,
+  Dart_CObject_kString,
+  Dart_CObject_kArray,
+  Dart_CObject_kTypedData,
+  Dart_CObject_kExternalTypedData,
+  Dart_CObject_kSendPort,
+  Dart_CObject_kCapability,
+  Dart_CObject_kNativePointer,
+  Dart_CObject_kUnmodifiableExternalTypedData,
+  Dart_CObject_kNumberOfTypes
+} Dart_CObject_Type;
+
+typedef void (*Dart_HandleFinalizer)(void* isolate_callback_data, void* peer);
+
+typedef struct _Dart_CObject {
+  Dart_CObject_Type type;
+  union {
+    bool as_bool;
+    int32_t as_int32;
+    int64_t as_int64;
+    double as_double;
+    const char* as_string;
+    struct {
+      Dart_Port id;
+      Dart_Port origin_id;
+    } as_send_port;
+    struct {
+      int64_t id;
+    } as_capability;
+    struct {
+      intptr_t length;
+      struct _Dart_CObject** values;
+    } as_array;
+    struct {
+      Dart_TypedData_Type type;
+      intptr_t length;
+      const uint8_t* values;
+    } as_typed_data;
+    struct {
+      Dart_TypedData_Type type;
+      intptr_t length;
+      uint8_t* data;
+      void* peer;
+      Dart_HandleFinalizer callback;
+    } as_external_typed_data;
+    struct {
+      intptr_t ptr;
+      intptr_t size;
+      Dart_HandleFinalizer callback;
+    } as_native_pointer;
+  } value;
+} Dart_CObject;
+
+DART_EXTERN_C intptr_t Dart_InitializeApiDL(void* data);
+
+// In the SDK this is a function pointer filled in by Dart_InitializeApiDL; a
+// plain function keeps the call syntax identical.
+DART_EXTERN_C bool Dart_PostCObject_DL(Dart_Port port_id, Dart_CObject* message);
+
+#endif  // AI_BRIDGE_HOST_DART_API_DL_H_
@@ -0,0 +1,93 @@
+// Host implementation of the Dart port API and Android logging used by
+// ai_bridge. See dart_api_dl.h and ai_bridge_host.h.
+
+#include <atomic>
+#include <cstdarg>
+#include <cstdio>
+#include <mutex>
+
+#include "ai_bridge_host.h"
+#include "android/log.h"
+
+namespace {
+
+std::atomic<AiBridgeHostPostHandler> g_post_handler{nullptr};
+std::atomic<void*> g_post_user_data{nullptr};
+std::atomic<int> g_log_priority{ANDROID_LOG_INFO};
+std::mutex g_stderr_mutex;
+
+char PriorityLetter(int prio) {
+    switch (prio) {
+        case ANDROID_LOG_VERBOSE: return 'V';
+        case ANDROID_LOG_DEBUG: return 'D';
+        case ANDROID_LOG_INFO: return 'I';
+        case ANDROID_LOG_WARN: return 'W';
+        case ANDROID_LOG_ERROR: return 'E';
+        case ANDROID_LOG_FATAL: return 'F';
+        default: return '?';
+    }
+}
+
+// Runs the finalizers of all external typed data in `message`, including
+// elements of arrays.
+void FinalizeExternalData(Dart_CObject* message) {
+    if (message->type == Dart_CObject_kArray) {
+        for (intptr_t i = 0; i < message->value.as_array.length; ++i) {
+            FinalizeExternalData(message->value.as_array.values[i]);
+        }
+    } else if (message->type == Dart_CObject_kExternalTypedData ||
+               message->type == Dart_CObject_kUnmodifiableExternalTypedData) {
+        auto& external = message->value.as_external_typed_data;
+        if (external.callback != nullptr) external.callback(nullptr, external.peer);
+    }
+}
+
+}  // namespace
+
+DART_EXPORT intptr_t Dart_InitializeApiDL(void* /*data*/) {
+    return 0;
+}
+
+DART_EXPORT bool Dart_PostCObject_DL(Dart_Port port_id, Dart_CObject* message) {
+    if (port_id == ILLEGAL_PORT || message == nullptr) return false;
+
+    AiBridgeHostPostHandler handler = g_post_handler.load(std::memory_order_acquire);
+    bool delivered = true;
+    if (handler != nullptr) {
+        delivered = handler(port_id, message, g_post_user_data.load(std::memory_order_acquire));
+    }
+
+    // Like the VM, take ownership of external typed data only on success.
+    if (delivered) FinalizeExternalData(message);
+    return delivered;
+}
+
+DART_EXPORT void ai_bridge_host_set_post_handler(AiBridgeHostPostHandler handler, void* user_data) {
+    g_post_user_data.store(user_data, std::memory_order_release);
+    g_post_handler.store(handler, std::memory_order_release);
+}
+
+DART_EXPORT void ai_bridge_host_set_log_priority(int priority) {
+    g_log_priority.store(priority, std::memory_order_relaxed);
+}
+
+extern "C" int __android_log_write(int prio, const char* tag, const char* text) {
+    if (prio < g_log_priority.load(std::memory_order_relaxed)) return 0;
+
+    std::lock_guard<std::mutex> lock(g_stderr_mutex);
+    return fprintf(stderr, "%c/%s: %s\n", PriorityLetter(prio), tag, text);
+}
+
+extern "C" int __android_log_print(int prio, const char* tag, const char* fmt, ...) {
+    if (prio < g_log_priority.load(std::memory_order_relaxed)) return 0;
+
+    char buffer[1024];
+    va_list args;
+    va_start(args, fmt);
+    int written = vsnprintf(buffer, sizeof(buffer), fmt, args);
+    va_end(args);
+
+    std::lock_guard<std::mutex> lock(g_stderr_mutex);
+    fprintf(stderr, "%c/%s: %s\n", PriorityLetter(prio), tag, buffer);
+    return written;
+}
@@ -0,0 +1,295 @@
+#include "llm/gemm.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "core/cpu_features.h"
+#include "core/thread_pool.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define AI_BRIDGE_X86_KERNELS 1
+#endif
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define AI_BRIDGE_NEON_GEMM 1
+#endif
+
+namespace ai_bridge {
+
+namespace {
+
+// Micro-kernel tile: kMr tokens by kNr weight rows, held in registers
+// (12 AVX2 or 24 NEON accumulators).
+constexpr int32_t kMr = 6;
+constexpr int32_t kNr = 16;
+// Cache blocking: a task computes up to kMc tokens by kNc weight rows,
+// kKc columns at a time. The packed weight block (kKc x kNc floats, 128 KB)
+// stays in L2 while every token panel streams past it; a packed token
+// panel (kKc x kMr floats, 6 KB) stays in L1.
+constexpr int32_t kKc = 256;
+constexpr int32_t kMc = 48;
+constexpr int32_t kNc = 128;
+// Quantized weights: rows per task, about 128 KB of Q8_0 at 2048 columns.
+constexpr int32_t kQuantRows = 64;
+
+int32_t DivCeil(int32_t a, int32_t b) { return (a + b - 1) / b; }
+int32_t RoundUp(int32_t a, int32_t b) { return DivCeil(a, b) * b; }
+
+// c (kMr x kNr, row stride ldc) = or += a-panel * b-panel over kc columns.
+// a holds kMr values per column, b kNr.
+using KernelFn = void (*)(int32_t kc, const float* a, const float* b, float* c, int32_t ldc, bool accumulate);
+
+void KernelScalar(int32_t kc, const float* a, const float* b, float* c, int32_t ldc, bool accumulate) {
+    float tile[kMr][kNr] = {};
+    for (int32_t k = 0; k < kc; ++k) {
+        for (int32_t i = 0; i < kMr; ++i) {
+            for (int32_t j = 0; j < kNr; ++j) tile[i][j] += a[i] * b[j];
+        }
+        a += kMr;
+        b += kNr;
+    }
+    for (int32_t i = 0; i < kMr; ++i) {
+        for (int32_t j = 0; j < kNr; ++j) c[i * ldc + j] = (accumulate ? c[i * ldc + j] : 0.0f) + tile[i][j];
+    }
+}
+
+#if defined(AI_BRIDGE_X86_KERNELS)
+
+__attribute__((target("avx2,fma"))) void StoreRowAvx2(float* c, __m256 lo, __m256 hi, bool accumulate) {
+    if (accumulate) {
+        lo = _mm256_add_ps(lo, _mm256_loadu_ps(c));
+        hi = _mm256_add_ps(hi, _mm256_loadu_ps(c + 8));
+    }
+    _mm256_storeu_ps(c, lo);
+    _mm256_storeu_ps(c + 8, hi);
+}
+
+__attribute__((target("avx2,fma"))) void KernelAvx2(int32_t kc, const float* a, const float* b, float* c, int32_t ldc,
+                                                  bool accumulate) {
+    __m256 c00 = _mm256_setzero_ps(), c01 = _mm256_setzero_ps();
+    __m256 c10 = _mm256_setzero_ps(), c11 = _mm256_setzero_ps();
+    __m256 c20 = _mm256_setzero_ps(), c21 = _mm256_setzero_ps();
+    __m256 c30 = _mm256_setzero_ps(), c31 = _mm256_setzero_ps();
+    __m256 c40 = _mm256_setzero_ps(), c41 = _mm256_setzero_ps();
+    __m256 c50 = _mm256_setzero_ps(), c51 = _mm256_setzero_ps();
+    for (int32_t k = 0; k < kc; ++k) {
+        const __m256 b0 = _mm256_loadu_ps(b);
+        const __m256 b1 = _mm256_loadu_ps(b + 8);
+        __m256 ak = _mm256_broadcast_ss(a);
+        c00 = _mm256_fmadd_ps(ak, b0, c00);
+        c01 = _mm256_fmadd_ps(ak, b1, c01);
+        ak = _mm256_broadcast_ss(a + 1);
+        c10 = _mm256_fmadd_ps(ak, b0, c10);
+        c11 = _mm256_fmadd_ps(ak, b1, c11);
+        ak = _mm256_broadcast_ss(a + 2);
+        c20 = _mm256_fmadd_ps(ak, b0, c20);
+        c21 = _mm256_fmadd_ps(ak, b1, c21);
+        ak = _mm256_broadcast_ss(a + 3);
+        c30 = _mm256_fmadd_ps(ak, b0, c30);
+        c31 = _mm256_fmadd_ps(ak, b1, c31);
+        ak = _mm256_broadcast_ss(a + 4);
+        c40 = _mm256_fmadd_ps(ak, b0, c40);
+        c41 = _mm256_fmadd_ps(ak, b1, c41);
+        ak = _mm256_broadcast_ss(a + 5);
+        c50 = _mm256_fmadd_ps(ak, b0, c50);
+        c51 = _mm256_fmadd_ps(ak, b1, c51);
+        a += kMr;
+        b += kNr;
+    }
+    StoreRowAvx2(c, c00, c01, accumulate);
+    StoreRowAvx2(c + ldc, c10, c11, accumulate);
+    StoreRowAvx2(c + 2 * ldc, c20, c21, accumulate);
+    StoreRowAvx2(c + 3 * ldc, c30, c31, accumulate);
+    StoreRowAvx2(c + 4 * ldc, c40, c41, accumulate);
+    StoreRowAvx2(c + 5 * ldc, c50, c51, accumulate);
+}
+
+#endif  // AI_BRIDGE_X86_KERNELS
+
+#if defined(AI_BRIDGE_NEON_GEMM)
+
+void KernelNeon(int32_t kc, const float* a, const float* b, float* c, int32_t ldc, bool accumulate) {
+    // Constant trip counts, so the tile is unrolled into 24 registers.
+    float32x4_t tile[kMr][kNr / 4];
+    for (int32_t i = 0; i < kMr; ++i) {
+        for (int32_t j = 0; j < kNr / 4; ++j) tile[i][j] = vdupq_n_f32(0.0f);
+    }
+    for (int32_t k = 0; k < kc; ++k) {
+        float32x4_t panel[kNr / 4];
+        for (int32_t j = 0; j < kNr / 4; ++j) panel[j] = vld1q_f32(b + 4 * j);
+        for (int32_t i = 0; i < kMr; ++i) {
+            for (int32_t j = 0; j < kNr / 4; ++j) tile[i][j] = vfmaq_n_f32(tile[i][j], panel[j], a[i]);
+        }
+        a += kMr;
+        b += kNr;
+    }
+    for (int32_t i = 0; i < kMr; ++i) {
+        float* row = c + i * ldc;
+        for (int32_t j = 0; j < kNr / 4; ++j) {
+            const float32x4_t value = accumulate ? vaddq_f32(tile[i][j], vld1q_f32(row + 4 * j)) : tile[i][j];
+            vst1q_f32(row + 4 * j, value);
+        }
+    }
+}
+
+#endif  // AI_BRIDGE_NEON_GEMM
+
+struct Backend {
+    KernelFn kernel;
+    const char* name;
+};
+
+const Backend& SelectedBackend() {
+    static const Backend backend = []() -> Backend {
+#if defined(AI_BRIDGE_NEON_GEMM)
+        return {KernelNeon, "neon"};
+#else
+#if defined(AI_BRIDGE_X86_KERNELS)
+        const CpuFeatures& cpu = GetCpuFeatures();
+        if (cpu.avx2 && cpu.fma) return {KernelAvx2, "avx2"};
+#endif
+        return {KernelScalar, "scalar"};
+#endif
+    }();
+    return backend;
+}
+
+// Tokens [i0, i0 + mc) by columns [p0, p0 + kc) of x, as kMr-token panels
+// column by column; the last panel is padded with zeros.
+void PackInputs(const float* x, int32_t cols, int32_t i0, int32_t mc, int32_t p0, int32_t kc, float* out) {
+    for (int32_t panel = 0; panel < mc; panel += kMr) {
+        for (int32_t ii = 0; ii < kMr; ++ii) {
+            float* dst = out + static_cast<size_t>(panel) * kc + ii;
+            if (panel + ii < mc) {
+                const float* src = x + static_cast<size_t>(i0 + panel + ii) * cols + p0;
+                for (int32_t k = 0; k < kc; ++k) dst[k * kMr] = src[k];
+            } else {
+                for (int32_t k = 0; k < kc; ++k) dst[k * kMr] = 0.0f;
+            }
+        }
+    }
+}
+
+// Weight rows [j0, j0 + nc) by columns [p0, p0 + kc), as kNr-row panels
+// column by column; the last panel is padded with zeros.
+void PackWeights(const float* w, int32_t cols, int32_t j0, int32_t nc, int32_t p0, int32_t kc, float* out) {
+    for (int32_t panel = 0; panel < nc; panel += kNr) {
+        for (int32_t jj = 0; jj < kNr; ++jj) {
+            float* dst = out + static_cast<size_t>(panel) * kc + jj;
+            if (panel + jj < nc) {
+                const float* src = w + static_cast<size_t>(j0 + panel + jj) * cols + p0;
+                for (int32_t k = 0; k < kc; ++k) dst[k * kNr] = src[k];
+            } else {
+                for (int32_t k = 0; k < kc; ++k) dst[k * kNr] = 0.0f;
+            }
+        }
+    }
+}
+
+// One task of the float32 GEMM: y tokens [i0, i0 + mc) by rows [j0, j0 + nc).
+void GemmTile(const float* w, const float* x, float* y, int32_t rows, int32_t cols, int32_t i0, int32_t mc, int32_t j0,
+              int32_t nc) {
+    thread_local std::vector<float> packed_x;
+    thread_local std::vector<float> packed_w;
+    const int32_t mc_padded = RoundUp(mc, kMr);
+    const int32_t nc_padded = RoundUp(nc, kNr);
+    packed_x.resize(static_cast<size_t>(mc_padded) * kKc);
+    packed_w.resize(static_cast<size_t>(nc_padded) * kKc);
+    const KernelFn kernel = SelectedBackend().kernel;
+    float edge[kMr * kNr];
+
+    for (int32_t p0 = 0; p0 < cols; p0 += kKc) {
+        const int32_t kc = std::min(kKc, cols - p0);
+        const bool accumulate = p0 > 0;
+        PackWeights(w, cols, j0, nc, p0, kc, packed_w.data());
+        PackInputs(x, cols, i0, mc, p0, kc, packed_x.data());
+        for (int32_t jr = 0; jr < nc; jr += kNr) {
+            const float* b = packed_w.data() + static_cast<size_t>(jr) * kc;
+            const int32_t nr = std::min(kNr, nc - jr);
+            for (int32_t ir = 0; ir < mc; ir += kMr) {
+                const float* a = packed_x.data() + static_cast<size_t>(ir) * kc;
+                const int32_t mr = std::min(kMr, mc - ir);
+                float* c = y + static_cast<size_t>(i0 + ir) * rows + j0 + jr;
+                if (mr == kMr && nr == kNr) {
+                    kernel(kc, a, b, c, rows, accumulate);
+                    continue;
+                }
+                // Partial tile: run the full kernel on a scratch tile.
+                for (int32_t i = 0; i < mr && accumulate; ++i) {
+                    std::memcpy(edge + i * kNr, c + static_cast<size_t>(i) * rows, sizeof(float) * nr);
+                }
+                kernel(kc, a, b, edge, kNr, accumulate);
+                for (int32_t i = 0; i < mr; ++i) {
+                    std::memcpy(c + static_cast<size_t>(i) * rows, edge + i * kNr, sizeof(float) * nr);
+                }
+            }
+        }
+    }
+}
+
+}  // namespace
+
+void MatMul(const WeightMatrix& w, const float* x, float* y, int32_t n, int32_t rows, int32_t cols,
+            ThreadPool* pool, int32_t threads, TaskPriority priority) {
+    if (n <= 0) return;
+    if (n == 1) {
+        thread_local std::vector<BlockQ8_0> scratch;
+        MatVec(w, x, y, rows, cols, &scratch);
+        return;
+    }
+    const int32_t workers = threads > 0 ? std::min(threads, pool->size()) : pool->size();
+    const int32_t token_blocks = DivCeil(n, kMc);
+
+    if (w.type == TensorType::kF32) {
+        // Narrow the weight blocks of small matrices so every thread gets
+        // a share; the packed block only gets cheaper.
+        const int32_t nc = std::min(kNc, std::max(kNr, RoundUp(DivCeil(rows * token_blocks, workers), kNr)));
+        const int32_t row_blocks = DivCeil(rows, nc);
+        const float* weights = static_cast<const float*>(w.data);
+        pool->parallel_for(
+            row_blocks * token_blocks,
+            [&](int32_t task) {
+                const int32_t i0 = (task % token_blocks) * kMc;
+                const int32_t j0 = (task / token_blocks) * nc;
+                GemmTile(weights, x, y, rows, cols, i0, std::min(kMc, n - i0), j0, std::min(nc, rows - j0));
+            },
+            workers, priority);
+        return;
+    }
+
+    const int32_t blocks = cols / kQuantBlock;
+    thread_local std::vector<BlockQ8_0> xq;
+    xq.resize(static_cast<size_t>(n) * blocks);
+    for (int32_t i = 0; i < n; ++i) {
+        QuantizeRow(TensorType::kQ8_0, x + static_cast<size_t>(i) * cols, &xq[static_cast<size_t>(i) * blocks], cols);
+    }
+    const size_t row_bytes = RowBytes(w.type, cols);
+    const uint8_t* weights = static_cast<const uint8_t*>(w.data);
+    const BlockQ8_0* inputs = xq.data();
+    const bool q8 = w.type == TensorType::kQ8_0;
+    const int32_t row_blocks = DivCeil(rows, kQuantRows);
+    pool->parallel_for(
+        row_blocks * token_blocks,
+        [&](int32_t task) {
+            const int32_t i0 = (task % token_blocks) * kMc;
+            const int32_t i1 = std::min(n, i0 + kMc);
+            const int32_t j0 = (task / token_blocks) * kQuantRows;
+            const int32_t j1 = std::min(rows, j0 + kQuantRows);
+            for (int32_t i = i0; i < i1; ++i) {
+                const BlockQ8_0* input = inputs + static_cast<size_t>(i) * blocks;
+                float* out = y + static_cast<size_t>(i) * rows;
+                for (int32_t j = j0; j < j1; ++j) {
+                    const void* row = weights + row_bytes * j;
+                    out[j] = q8 ? VecDotQ8_0(static_cast<const BlockQ8_0*>(row), input, blocks)
+                                : VecDotQ4_0(static_cast<const BlockQ4_0*>(row), input, blocks);
+                }
+            }
+        },
+        workers, priority);
+}
+
+const char* GemmKernelBackend() { return SelectedBackend().name; }
+
+}  // namespace ai_bridge
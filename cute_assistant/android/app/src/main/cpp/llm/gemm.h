@@ -0,0 +1,31 @@
+#ifndef AI_BRIDGE_LLM_GEMM_H_
+#define AI_BRIDGE_LLM_GEMM_H_
+
+#include <cstdint>
+
+#include "core/thread_pool.h"
+#include "llm/tensor_ops.h"
+
+namespace ai_bridge {
+
+// y[i][r] = dot(w row r, x row i) for `n` input rows: every token of a
+// prefill chunk through one weight matrix. x is n x cols, y is n x rows,
+// both row-major.
+//
+// Float32 weights go through a cache-blocked GEMM: panels of weights and
+// inputs are packed into L2-sized blocks, and a register-blocked
+// micro-kernel (AVX2 on x86, chosen at runtime, NEON on arm64) computes
+// 6 x 16 output tiles. Quantized weights quantize x to Q8_0 and run the
+// int8 dot products over blocks of weight rows, each block reused for a
+// block of tokens while it is cache-resident. The output tiles are spread
+// over `pool` (up to `threads` threads, 0 for all) at `priority`; n == 1
+// is a MatVec on the calling thread.
+void MatMul(const WeightMatrix& w, const float* x, float* y, int32_t n, int32_t rows, int32_t cols,
+            ThreadPool* pool, int32_t threads = 0, TaskPriority priority = TaskPriority::kNormal);
+
+// "avx2", "neon" or "scalar": the micro-kernel MatMul uses for float32.
+const char* GemmKernelBackend();
+
+}  // namespace ai_bridge
+
+#endif  // AI_BRIDGE_LLM_GEMM_H_
@@ -0,0 +1,97 @@
+#ifndef AI_BRIDGE_LLM_LLM_ENGINE_H_
+#define AI_BRIDGE_LLM_LLM_ENGINE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ai_bridge {
+
+using LlmToken = int32_t;
+
+struct LlmSpecialTokens {
+    LlmToken bos = -1;
+    LlmToken eos = -1;             // also closes a conversation turn
+    LlmToken user_turn = -1;       // precedes user text
+    LlmToken assistant_turn = -1;  // precedes the reply
+};
+
+// Tokens to evaluate in one LlmEngine::decode() call, possibly spanning
+// several sequences. Mirrors llama_batch.
+struct LlmBatch {
+    std::vector<LlmToken> tokens;
+    std::vector<int32_t> positions;
+    std::vector<int32_t> seq_ids;
+    std::vector<uint8_t> want_logits;
+
+    void clear() {
+        tokens.clear();
+        positions.clear();
+        seq_ids.clear();
+        want_logits.clear();
+    }
+
+    void add(LlmToken token, int32_t position, int32_t seq_id, bool logits) {
+        tokens.push_back(token);
+        positions.push_back(position);
+        seq_ids.push_back(seq_id);
+        want_logits.push_back(logits ? 1 : 0);
+    }
+
+    int32_t size() const { return static_cast<int32_t>(tokens.size()); }
+};
+
+// The inference backend behind llm_processing_loop, shaped after the llama.cpp
+// context API so a llama.cpp (or NPU) backend can slot in behind it. Each
+// sequence id owns an independent KV cache of up to context_length()
+// positions. Engines are driven from one thread at a time.
+class LlmEngine {
+public:
+    virtual ~LlmEngine() = default;
+
+    virtual const char* name() const = 0;
+    virtual int32_t vocab_size() const = 0;
+    virtual int32_t context_length() const = 0;
+    virtual int32_t max_sequences() const = 0;
+    virtual const LlmSpecialTokens& special_tokens() const = 0;
+
+    // Appends the tokens for `text` (no special tokens).
+    virtual void tokenize(const std::string& text, std::vector<LlmToken>* out) const = 0;
+    // Raw bytes of one token; may be a partial UTF-8 sequence. Special tokens
+    // render as "".
+    virtual std::string token_to_piece(LlmToken token) const = 0;
+
+    // Evaluates `batch`, appending every entry to its sequence's KV cache.
+    // Each entry's position must equal the sequence's current length at that
+    // point. Returns false, leaving the caches unchanged, on invalid input.
+    virtual bool decode(const LlmBatch& batch) = 0;
+    // vocab_size() logits for batch entry `batch_index` of the last decode();
+    // only valid for entries added with logits = true.
+    virtual const float* logits(int32_t batch_index) const = 0;
+
+    virtual int32_t kv_seq_length(int32_t seq_id) const = 0;
+    // Drops positions [p0, p1) of a sequence; p1 < 0 means through the end.
+    // Only suffixes may be removed (p1 < 0 or p1 == length).
+    virtual void kv_seq_remove(int32_t seq_id, int32_t p0, int32_t p1) = 0;
+    // Makes the empty sequence `dst` hold positions [0, p1) of `src`, as
+    // llama_kv_cache_seq_cp does; backends may share the cells rather than
+    // copy them.
+    virtual void kv_seq_copy(int32_t src, int32_t dst, int32_t p1) = 0;
+
+    // Identifies the weights behind the KV state, so state saved from one
+    // model is never restored into another.
+    virtual uint64_t model_fingerprint() const = 0;
+    // Serialized KV state of one sequence, as llama_state_seq_get_size /
+    // get_data / set_data. The blob is backend-specific. state_seq_get
+    // returns the bytes written (0 if `size` is too small); state_seq_set
+    // replaces the sequence's cache and returns false, leaving it empty, if
+    // the blob is not valid.
+    virtual size_t state_seq_size(int32_t seq_id) const = 0;
+    virtual size_t state_seq_get(int32_t seq_id, uint8_t* dst, size_t size) const = 0;
+    virtual bool state_seq_set(int32_t seq_id, const uint8_t* src, size_t size) = 0;
+};
+
+}  // namespace ai_bridge
+
+#endif  // AI_BRIDGE_LLM_LLM_ENGINE_H_
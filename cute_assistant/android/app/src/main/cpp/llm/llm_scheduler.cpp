@@ -0,0 +1,685 @@
+#include "llm/llm_scheduler.h"
+
+#include <algorithm>
+#include <string>
+#include <utility>
+
+#include "core/dart_messages.h"
+#include "core/log.h"
+#include "core/metrics.h"
+#include "core/turn_trace.h"
+#include "llm/session_file.h"
+
+namespace ai_bridge {
+
+namespace {
+
+// Greedy sampling; temperature/top-p samplers slot in here once a real
+// model is loaded.
+LlmToken SampleGreedy(const float* logits, int32_t vocab_size) {
+    int32_t best = 0;
+    for (int32_t i = 1; i < vocab_size; ++i) {
+        if (logits[i] > logits[best]) best = i;
+    }
+    return best;
+}
+
+int64_t MicrosSince(std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+}
+
+// Same clock as TurnTrace::NowMicros().
+int64_t SteadyMicros(std::chrono::steady_clock::time_point at) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(at.time_since_epoch()).count();
+}
+
+void UpdateMax(std::atomic<int64_t>& target, int64_t value) {
+    int64_t current = target.load(std::memory_order_relaxed);
+    while (value > current && !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+}  // namespace
+
+LlmScheduler::LlmScheduler(LlmEngine* engine, LlmRequestQueue* requests, TokenStream* tokens, LlmSchedulerPorts ports,
+                           const LlmSchedulerOptions& options)
+    : engine_(engine), requests_(requests), tokens_(tokens), ports_(std::move(ports)), options_(options) {
+    options_.max_active_sessions = std::max(1, std::min(options_.max_active_sessions, engine_->max_sequences()));
+    // Every generating session must fit in a batch, or some would starve.
+    options_.batch_token_budget = std::max(options_.batch_token_budget, options_.max_active_sessions);
+    options_.prefill_chunk = std::max(1, options_.prefill_chunk);
+    options_.max_remembered_sessions = std::max(options_.max_remembered_sessions, engine_->max_sequences());
+    slots_.resize(static_cast<size_t>(engine_->max_sequences()));
+}
+
+void LlmScheduler::set_system_prompt(const std::string& text) {
+    std::lock_guard<std::mutex> lock(system_prompt_mutex_);
+    system_prompt_ = text;
+}
+
+bool LlmScheduler::warm_up() {
+    std::unique_lock<std::mutex> lock = lock_state();
+    const int32_t seq = static_cast<int32_t>(slots_.size()) - 1;
+    KvSlot& slot = slots_[seq];
+    if (!slot.tokens.empty()) return true;  // a loaded session got there first
+
+    std::vector<LlmToken> prompt(1, engine_->special_tokens().bos);
+    {
+        std::lock_guard<std::mutex> prompt_lock(system_prompt_mutex_);
+        engine_->tokenize(system_prompt_, &prompt);
+    }
+    prompt.resize(std::min(prompt.size(), static_cast<size_t>(engine_->context_length() / 2)));
+    for (size_t done = 0; done < prompt.size();) {
+        const size_t chunk = std::min(prompt.size() - done, static_cast<size_t>(options_.batch_token_budget));
+        batch_.clear();
+        for (size_t i = 0; i < chunk; ++i) {
+            batch_.add(prompt[done + i], static_cast<int32_t>(done + i), seq, done + i + 1 == prompt.size());
+        }
+        if (!engine_->decode(batch_)) {
+            engine_->kv_seq_remove(seq, 0, -1);
+            slot.tokens.clear();
+            report_error("LLM warm-up decode failed");
+            return false;
+        }
+        slot.tokens.insert(slot.tokens.end(), prompt.begin() + static_cast<std::ptrdiff_t>(done),
+                           prompt.begin() + static_cast<std::ptrdiff_t>(done + chunk));
+        decode_steps_.fetch_add(1, std::memory_order_relaxed);
+        prefill_tokens_.fetch_add(static_cast<int64_t>(chunk), std::memory_order_relaxed);
+        done += chunk;
+    }
+    prefix_cache_.update(seq, slot.tokens.data(), slot.tokens.size());
+    return true;
+}
+
+void LlmScheduler::run(const std::atomic<bool>& running) {
+    LOGI("LLM scheduler: %d sessions, %d tokens per batch, %d-token prefill chunks",
+         options_.max_active_sessions, options_.batch_token_budget, options_.prefill_chunk);
+    std::unique_lock<std::mutex> lock(state_mutex_);
+    while (admit(running, &lock)) {
+        // Let a waiting save/load in between decode steps.
+        state_released_.wait(lock, [this] { return state_waiters_.load(std::memory_order_acquire) == 0; });
+        if (!running.load(std::memory_order_acquire) && active_.empty() && deferred_.empty()) break;
+
+        // Cancellation is honoured before every decode step.
+        const bool stopping = !running.load(std::memory_order_acquire);
+        for (size_t i = 0; i < active_.size();) {
+            Active& active = active_[i];
+            if (!stopping && !active.request.cancel_token->is_cancelled()) {
+                ++i;
+                continue;
+            }
+            // Whatever prompt was evaluated stays cached for reuse, but the
+            // turn never joins the conversation.
+            if (active.prompt_done < active.prompt.size()) {
+                session(active.request.session_id).pending = active.saved_pending;
+            }
+            report_cancellation(active.request, active.generated);
+            finish(i, kReplyCancelled);
+        }
+        for (size_t i = 0; i < deferred_.size();) {
+            LlmRequest& request = deferred_[i];
+            if (!stopping && !request.cancel_token->is_cancelled()) {
+                ++i;
+                continue;
+            }
+            cancel_unstarted(&request);
+            deferred_.erase(deferred_.begin() + static_cast<std::ptrdiff_t>(i));
+        }
+        if (active_.empty()) continue;
+
+        build_batch();
+        drop_invalid_sessions();
+        if (batch_.size() == 0) continue;
+        const auto step_start = std::chrono::steady_clock::now();
+        if (!engine_->decode(batch_)) {
+            fail_batch();
+            continue;
+        }
+        Metrics().record(MetricHistogram::kDecodeStepUs, MicrosSince(step_start, std::chrono::steady_clock::now()));
+        Metrics().add(MetricCounter::kDecodeSteps);
+        decode_steps_.fetch_add(1, std::memory_order_relaxed);
+        // Index freshly evaluated prompts so sessions waiting on them can
+        // copy instead of prefilling.
+        for (const Active& active : active_) {
+            if (active.prompt_done > 0 && active.generated == 0) {
+                const KvSlot& slot = slots_[active.seq];
+                prefix_cache_.update(active.seq, slot.tokens.data(), slot.tokens.size());
+            }
+        }
+        sample();
+    }
+}
+
+bool LlmScheduler::admit(const std::atomic<bool>& running, std::unique_lock<std::mutex>* lock) {
+    const size_t max_active = static_cast<size_t>(options_.max_active_sessions);
+    // Requests already popped go first, in the order they were popped.
+    for (size_t i = 0; i < deferred_.size() && active_.size() < max_active;) {
+        if (try_start(&deferred_[i])) {
+            deferred_.erase(deferred_.begin() + static_cast<std::ptrdiff_t>(i));
+        } else {
+            ++i;
+        }
+    }
+    while (active_.size() < max_active && deferred_.size() < max_active) {
+        LlmRequest request;
+        size_t queue_depth = 0;
+        // Only block when there is nothing else to do.
+        const bool idle = active_.empty() && deferred_.empty() && running.load(std::memory_order_acquire);
+        if (idle) {
+            lock->unlock();
+            const bool popped = requests_->pop(&request, &queue_depth);
+            lock->lock();
+            if (!popped) return false;  // closed and drained
+        } else if (!requests_->try_pop(&request, &queue_depth)) {
+            break;
+        }
+
+        const int64_t wait_us = MicrosSince(request.enqueued_at, std::chrono::steady_clock::now());
+        Metrics().record(MetricHistogram::kQueueWaitUs, wait_us);
+        SendEventToDart(ports_.metrics(), "llm_queue",
+                        {request.id, request.priority, static_cast<int64_t>(queue_depth), wait_us});
+        if (!try_start(&request)) deferred_.push_back(std::move(request));
+    }
+    return true;
+}
+
+bool LlmScheduler::try_start(LlmRequest* request) {
+    if (request->cancel_token->is_cancelled()) {
+        cancel_unstarted(request);
+        return true;
+    }
+    if (request->text.empty()) {
+        requests_->finish(request->id);
+        tokens_->end_reply(request->id, kReplyCompleted);
+        return true;
+    }
+    const LlmSpecialTokens& special = engine_->special_tokens();
+    Session& conversation = session(request->session_id);
+
+    std::vector<LlmToken> turn;
+    turn.push_back(special.user_turn);
+    engine_->tokenize(request->text, &turn);
+    turn.push_back(special.assistant_turn);
+
+    std::vector<LlmToken> fresh(1, special.bos);
+    {
+        std::lock_guard<std::mutex> lock(system_prompt_mutex_);
+        engine_->tokenize(system_prompt_, &fresh);
+    }
+    const size_t context = static_cast<size_t>(engine_->context_length());
+    // Even a fresh start cannot hold this turn: fail it alone, before the
+    // conversation is touched, instead of letting the engine reject the
+    // batch it would join.
+    if (fresh.size() + turn.size() >= context) {
+        reject_unstarted(request, "LLM request " + std::to_string(request->id) + ": a prompt of " +
+                                      std::to_string(fresh.size() + turn.size()) + " tokens does not fit the " +
+                                      std::to_string(context) + "-token context");
+        return true;
+    }
+    // Start the conversation over when this turn would not fit.
+    if (!conversation.tokens.empty() &&
+        conversation.tokens.size() + conversation.pending.size() + turn.size() >= context) {
+        LOGI("LLM session %lld context full (%zu tokens); starting over",
+             (long long)request->session_id, conversation.tokens.size());
+        conversation.tokens.clear();
+        conversation.pending.clear();
+    }
+    if (conversation.tokens.empty() && conversation.pending.empty()) conversation.pending = std::move(fresh);
+
+    std::vector<LlmToken> target(conversation.tokens);
+    target.insert(target.end(), conversation.pending.begin(), conversation.pending.end());
+    target.insert(target.end(), turn.begin(), turn.end());
+
+    // The last token is always evaluated: its logits start the reply.
+    const size_t reusable = target.size() - 1;
+    // A prefix another session is still prefilling (typically the system
+    // prompt of conversations starting together) is copied once it is done
+    // rather than evaluated twice.
+    if (static_cast<int32_t>(std::min(reusable, shared_prefill_length(target))) >
+        prefix_cache_.lookup(target.data(), reusable, -1).length) {
+        return false;
+    }
+
+    const int32_t seq = acquire_slot(request->session_id);
+    if (seq < 0) return false;
+
+    // Compiled out of release builds; the text is copied, not formatted, here.
+    LOGD("LLM request %lld received input: %s", (long long)request->id, request->text.c_str());
+
+    conversation.last_used = ++clock_;
+    KvSlot& slot = slots_[seq];
+    slot.busy = true;
+
+    // Reuse the longest prefix any slot holds, this one's own if it ties.
+    const PrefixCache::Match match = prefix_cache_.lookup(target.data(), reusable, seq);
+    if (match.seq_id == seq) {
+        truncate_slot(seq, static_cast<size_t>(match.length));
+    } else {
+        truncate_slot(seq, 0);
+        if (match.seq_id >= 0) {
+            engine_->kv_seq_copy(match.seq_id, seq, match.length);
+            slot.tokens.assign(target.begin(), target.begin() + match.length);
+            prefix_cache_.update(seq, slot.tokens.data(), slot.tokens.size());
+        }
+    }
+    reused_tokens_.fetch_add(static_cast<int64_t>(slot.tokens.size()), std::memory_order_relaxed);
+
+    Active active;
+    active.seq = seq;
+    const size_t start = slot.tokens.size();
+    active.saved_pending = conversation.pending;
+    active.prompt.assign(target.begin() + static_cast<std::ptrdiff_t>(start), target.end());
+    active.prompt_tokens = target.size();
+    active.started_at = std::chrono::steady_clock::now();
+    active.request = std::move(*request);
+    active_.push_back(std::move(active));
+    Metrics().set(MetricGauge::kActiveSessions, static_cast<int64_t>(active_.size()));
+    return true;
+}
+
+int32_t LlmScheduler::acquire_slot(int64_t session_id) {
+    for (size_t i = 0; i < slots_.size(); ++i) {
+        if (slots_[i].session_id == session_id) return slots_[i].busy ? -1 : static_cast<int32_t>(i);
+    }
+    int32_t chosen = -1;
+    for (size_t i = 0; i < slots_.size(); ++i) {
+        const KvSlot& slot = slots_[i];
+        if (slot.session_id < 0) {
+            chosen = static_cast<int32_t>(i);
+            break;
+        }
+        if (!slot.busy && (chosen < 0 || slot.last_used < slots_[chosen].last_used)) chosen = static_cast<int32_t>(i);
+    }
+    if (chosen < 0) return -1;
+
+    // The cache stays: whatever prefix the new session shares with it is
+    // reused by try_start().
+    KvSlot& slot = slots_[chosen];
+    if (slot.session_id >= 0) {
+        LOGD("LLM session %lld evicted from KV slot %d", (long long)slot.session_id, chosen);
+        sessions_evicted_.fetch_add(1, std::memory_order_relaxed);
+    }
+    slot.session_id = session_id;
+    return chosen;
+}
+
+LlmScheduler::Session& LlmScheduler::session(int64_t session_id) {
+    auto it = sessions_.find(session_id);
+    if (it != sessions_.end()) return it->second;
+
+    // Forget the least recently used conversation that holds no slot.
+    if (sessions_.size() >= static_cast<size_t>(options_.max_remembered_sessions)) {
+        auto oldest = sessions_.end();
+        for (auto candidate = sessions_.begin(); candidate != sessions_.end(); ++candidate) {
+            const int64_t id = candidate->first;
+            const bool in_slot = std::any_of(slots_.begin(), slots_.end(),
+                                             [id](const KvSlot& slot) { return slot.session_id == id; });
+            if (!in_slot && (oldest == sessions_.end() || candidate->second.last_used < oldest->second.last_used)) {
+                oldest = candidate;
+            }
+        }
+        if (oldest != sessions_.end()) sessions_.erase(oldest);
+    }
+    return sessions_[session_id];
+}
+
+size_t LlmScheduler::shared_prefill_length(const std::vector<LlmToken>& target) const {
+    size_t longest = 0;
+    for (const Active& active : active_) {
+        if (active.prompt_done == active.prompt.size()) continue;
+        // What the slot will hold once the prompt is evaluated.
+        const std::vector<LlmToken>& cached = slots_[active.seq].tokens;
+        size_t length = 0;
+        while (length < target.size() && length < cached.size() && cached[length] == target[length]) ++length;
+        if (length == cached.size()) {
+            size_t i = active.prompt_done;
+            while (length < target.size() && i < active.prompt.size() && active.prompt[i] == target[length]) {
+                ++length;
+                ++i;
+            }
+        }
+        longest = std::max(longest, length);
+    }
+    return longest;
+}
+
+void LlmScheduler::truncate_slot(int32_t seq, size_t length) {
+    KvSlot& slot = slots_[seq];
+    if (length >= slot.tokens.size()) return;
+    engine_->kv_seq_remove(seq, static_cast<int32_t>(length), -1);
+    slot.tokens.resize(length);
+    prefix_cache_.update(seq, slot.tokens.data(), slot.tokens.size());
+}
+
+void LlmScheduler::build_batch() {
+    batch_.clear();
+    int32_t budget = options_.batch_token_budget;
+    int64_t sessions = 0;
+    const size_t count = active_.size();
+    round_robin_ = count > 0 ? (round_robin_ + 1) % count : 0;
+
+    // Generating sessions first: one token each keeps their inter-token
+    // latency independent of how much prompt is waiting.
+    for (size_t k = 0; k < count; ++k) {
+        Active& active = active_[(round_robin_ + k) % count];
+        active.logits_index = -1;
+        if (active.prompt_done < active.prompt.size() || budget == 0) continue;
+        std::vector<LlmToken>& cached = slots_[active.seq].tokens;
+        active.logits_index = batch_.size();
+        batch_.add(active.next, static_cast<int32_t>(cached.size()), active.seq, true);
+        cached.push_back(active.next);
+        --budget;
+        ++sessions;
+    }
+    // The rest of the budget goes to prompts, one chunk per session in turn.
+    for (size_t k = 0; k < count && budget > 0; ++k) {
+        Active& active = active_[(round_robin_ + k) % count];
+        const size_t remaining = active.prompt.size() - active.prompt_done;
+        if (remaining == 0) continue;
+        std::vector<LlmToken>& cached = slots_[active.seq].tokens;
+        const size_t chunk = std::min(remaining, static_cast<size_t>(std::min(budget, options_.prefill_chunk)));
+        for (size_t j = 0; j < chunk; ++j) {
+            const LlmToken token = active.prompt[active.prompt_done++];
+            const bool last = active.prompt_done == active.prompt.size();
+            if (last) active.logits_index = batch_.size();
+            batch_.add(token, static_cast<int32_t>(cached.size()), active.seq, last);
+            cached.push_back(token);
+        }
+        budget -= static_cast<int32_t>(chunk);
+        prefill_tokens_.fetch_add(static_cast<int64_t>(chunk), std::memory_order_relaxed);
+        Metrics().add(MetricCounter::kPrefillTokens, static_cast<int64_t>(chunk));
+        ++sessions;
+    }
+    UpdateMax(max_batch_sessions_, sessions);
+}
+
+void LlmScheduler::sample() {
+    const LlmToken eos = engine_->special_tokens().eos;
+    for (size_t i = 0; i < active_.size();) {
+        Active& active = active_[i];
+        if (active.logits_index < 0) {
+            ++i;
+            continue;
+        }
+        const LlmToken token = SampleGreedy(engine_->logits(active.logits_index), engine_->vocab_size());
+        Session& conversation = session(active.request.session_id);
+        if (token == eos || slots_[active.seq].tokens.size() + 1 >= static_cast<size_t>(engine_->context_length()) ||
+            (options_.max_reply_tokens > 0 && active.generated >= options_.max_reply_tokens)) {
+            conversation.pending.assign({eos});
+            finish(i, kReplyCompleted);
+            continue;
+        }
+        // Until it is decoded, the token is owed to the cache with the EOS
+        // that closes this turn.
+        conversation.pending.assign({token, eos});
+        if (active.generated == 0) {
+            active.first_token_at = std::chrono::steady_clock::now();
+            MetricsRegistry& metrics = Metrics();
+            metrics.record(MetricHistogram::kFirstTokenUs, MicrosSince(active.request.enqueued_at, active.first_token_at));
+            const int64_t prefill_us = MicrosSince(active.started_at, active.first_token_at);
+            if (prefill_us > 0) {
+                metrics.record(MetricHistogram::kPrefillTokensPerSecond,
+                               static_cast<int64_t>(active.prompt.size()) * 1000000 / prefill_us);
+            }
+        }
+        const std::string piece = engine_->token_to_piece(token);
+        tokens_->publish(active.request.id, piece.data(), piece.size());
+        generated_tokens_.fetch_add(1, std::memory_order_relaxed);
+        Metrics().add(MetricCounter::kTokensGenerated);
+        ++active.generated;
+        active.next = token;
+        ++i;
+    }
+}
+
+void LlmScheduler::finish(size_t index, TokenReplyStatus status) {
+    Active& active = active_[index];
+    KvSlot& slot = slots_[active.seq];
+    slot.busy = false;
+    slot.last_used = ++clock_;
+    prefix_cache_.update(active.seq, slot.tokens.data(), slot.tokens.size());
+    // The turn joins the conversation once its prompt is in the cache.
+    if (status != kReplyFailed && active.prompt_done == active.prompt.size()) {
+        session(active.request.session_id).tokens = slot.tokens;
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+    const LlmRequest& request = active.request;
+    SendEventToDart(ports_.metrics(), "llm_reply",
+                    {request.id, request.session_id, static_cast<int64_t>(active.prompt_tokens), active.generated,
+                     active.generated > 0 ? MicrosSince(request.enqueued_at, active.first_token_at) : 0,
+                     MicrosSince(request.enqueued_at, now)});
+    // Stamped before the reply ends, so ahead of the TTS finishing it.
+    TurnTrace& trace = VoiceTurnTrace();
+    if (active.generated > 0) {
+        trace.mark_request(request.id, TurnStage::kFirstToken, SteadyMicros(active.first_token_at));
+        trace.mark_request(request.id, TurnStage::kLastToken, SteadyMicros(now));
+    }
+    if (status != kReplyCompleted) trace.abandon_request(request.id);
+    MetricsRegistry& metrics = Metrics();
+    if (status == kReplyCompleted) metrics.add(MetricCounter::kRepliesCompleted);
+    if (status == kReplyFailed) metrics.add(MetricCounter::kRepliesFailed);
+    const int64_t decode_us = active.generated > 1 ? MicrosSince(active.first_token_at, now) : 0;
+    if (decode_us > 0) {
+        metrics.record(MetricHistogram::kDecodeTokensPerSecond, (active.generated - 1) * 1000000 / decode_us);
+    }
+    requests_->finish(request.id);
+    tokens_->end_reply(request.id, status);
+    active_.erase(active_.begin() + static_cast<std::ptrdiff_t>(index));
+    metrics.set(MetricGauge::kActiveSessions, static_cast<int64_t>(active_.size()));
+}
+
+void LlmScheduler::cancel_unstarted(LlmRequest* request) {
+    report_cancellation(*request, 0);
+    VoiceTurnTrace().abandon_request(request->id);
+    requests_->finish(request->id);
+    tokens_->end_reply(request->id, kReplyCancelled);
+}
+
+void LlmScheduler::reject_unstarted(LlmRequest* request, const std::string& reason) {
+    report_error(reason);
+    Metrics().add(MetricCounter::kRepliesFailed);
+    VoiceTurnTrace().abandon_request(request->id);
+    requests_->finish(request->id);
+    tokens_->end_reply(request->id, kReplyFailed);
+}
+
+void LlmScheduler::drop_invalid_sessions() {
+    const int32_t context = engine_->context_length();
+    const int32_t vocab = engine_->vocab_size();
+    std::vector<int32_t> invalid;
+    for (int32_t i = 0; i < batch_.size(); ++i) {
+        if (batch_.positions[i] >= context || batch_.tokens[i] < 0 || batch_.tokens[i] >= vocab) {
+            invalid.push_back(batch_.seq_ids[i]);
+        }
+    }
+    if (invalid.empty()) return;
+    auto is_invalid = [&](int32_t seq) { return std::find(invalid.begin(), invalid.end(), seq) != invalid.end(); };
+
+    LlmBatch kept;
+    std::vector<int32_t> moved(static_cast<size_t>(batch_.size()), -1);
+    for (int32_t i = 0; i < batch_.size(); ++i) {
+        if (is_invalid(batch_.seq_ids[i])) continue;
+        moved[i] = kept.size();
+        kept.add(batch_.tokens[i], batch_.positions[i], batch_.seq_ids[i], batch_.want_logits[i] != 0);
+    }
+    std::swap(batch_, kept);
+    for (size_t i = 0; i < active_.size();) {
+        Active& active = active_[i];
+        if (!is_invalid(active.seq)) {
+            if (active.logits_index >= 0) active.logits_index = moved[active.logits_index];
+            ++i;
+            continue;
+        }
+        report_error("LLM request " + std::to_string(active.request.id) + " does not fit the " +
+                     std::to_string(context) + "-token context");
+        // Its entries never reach the engine, so the cache is as before this
+        // step; the mirror is dropped with it, as in fail_batch().
+        slots_[active.seq].tokens.clear();
+        engine_->kv_seq_remove(active.seq, 0, -1);
+        session(active.request.session_id).pending = active.saved_pending;
+        finish(i, kReplyFailed);
+    }
+}
+
+void LlmScheduler::fail_batch() {
+    report_error("LLM decode failed for a batch of " + std::to_string(batch_.size()) + " tokens");
+    // The engine left every cache as it was before the batch, which no longer
+    // matches the mirrors; drop the caches and keep each conversation as it
+    // was before the failed turn, to be prefilled again on its next turn.
+    while (!active_.empty()) {
+        Active& active = active_.back();
+        slots_[active.seq].tokens.clear();
+        engine_->kv_seq_remove(active.seq, 0, -1);
+        session(active.request.session_id).pending = active.saved_pending;
+        finish(active_.size() - 1, kReplyFailed);
+    }
+}
+
+void LlmScheduler::report_cancellation(const LlmRequest& request, int64_t generated) {
+    const int64_t cancelled_at = request.cancel_token->cancelled_at_us.load(std::memory_order_acquire);
+    const int64_t abort_us = cancelled_at > 0 ? CancellationToken::NowMicros() - cancelled_at : 0;
+    SendEventToDart(ports_.metrics(), "llm_cancel", {request.id, generated, abort_us});
+    Metrics().add(MetricCounter::kRequestsCancelled);
+    LOGI("LLM request %lld cancelled after %lld tokens (%lld us to abort)",
+         (long long)request.id, (long long)generated, (long long)abort_us);
+}
+
+void LlmScheduler::report_error(const std::string& message) {
+    LOGE("%s", message.c_str());
+    SendStringToDart(ports_.errors(), message);
+}
+
+std::unique_lock<std::mutex> LlmScheduler::lock_state() {
+    state_waiters_.fetch_add(1, std::memory_order_acq_rel);
+    std::unique_lock<std::mutex> lock(state_mutex_);
+    state_waiters_.fetch_sub(1, std::memory_order_acq_rel);
+    state_released_.notify_all();  // the scheduler resumes once `lock` is released
+    return lock;
+}
+
+bool LlmScheduler::save_sessions(const std::string& path) {
+    const auto started = std::chrono::steady_clock::now();
+    std::unique_lock<std::mutex> lock = lock_state();
+
+    SessionFileWriter writer(engine_->model_fingerprint());
+    for (const auto& entry : sessions_) {
+        // A reply being generated lives only in its slot until finish();
+        // save that session as the slot's tokens, then what sample() left
+        // pending: the sampled token not yet in the cache and the EOS that
+        // closes the turn if the reply stops here. Sessions still
+        // prefilling keep their pre-turn state, which is consistent.
+        const auto generating = std::find_if(active_.begin(), active_.end(), [&](const Active& active) {
+            return active.request.session_id == entry.first && active.generated > 0;
+        });
+        const std::vector<LlmToken>& tokens =
+            generating != active_.end() ? slots_[generating->seq].tokens : entry.second.tokens;
+        writer.add_session(entry.first, entry.second.last_used, tokens, entry.second.pending);
+    }
+    int64_t kv_tokens = 0;
+    for (size_t i = 0; i < slots_.size(); ++i) {
+        const KvSlot& slot = slots_[i];
+        if (slot.tokens.empty()) continue;
+        writer.add_slot(slot.session_id, slot.last_used, static_cast<int32_t>(i), slot.tokens, engine_);
+        kv_tokens += static_cast<int64_t>(slot.tokens.size());
+    }
+    std::string error;
+    const uint64_t bytes = writer.write(path, &error);
+    if (bytes == 0) {
+        report_error("LLM session not saved: " + error);
+        return false;
+    }
+
+    const int64_t elapsed_us = MicrosSince(started, std::chrono::steady_clock::now());
+    SendEventToDart(ports_.metrics(), "llm_session_save",
+                    {static_cast<int64_t>(sessions_.size()), kv_tokens, static_cast<int64_t>(bytes), elapsed_us});
+    LOGI("LLM session saved to %s: %zu conversations, %lld KV tokens, %llu bytes in %lld us",
+         path.c_str(), sessions_.size(), (long long)kv_tokens, (unsigned long long)bytes, (long long)elapsed_us);
+    return true;
+}
+
+bool LlmScheduler::load_sessions(const std::string& path) {
+    const auto started = std::chrono::steady_clock::now();
+    std::unique_lock<std::mutex> lock = lock_state();
+    if (!active_.empty() || !deferred_.empty()) {
+        report_error("LLM session not loaded: requests are in flight");
+        return false;
+    }
+    MappedSessionFile file;
+    std::string error;
+    if (!file.open(path, &error)) {
+        report_error("LLM session not loaded: " + error);
+        return false;
+    }
+    const SessionFileHeader& header = file.header();
+    if (header.model_fingerprint != engine_->model_fingerprint()) {
+        report_error("LLM session not loaded: " + path + " was saved with another model");
+        return false;
+    }
+
+    // The snapshot replaces everything cached so far.
+    for (size_t i = 0; i < slots_.size(); ++i) {
+        engine_->kv_seq_remove(static_cast<int32_t>(i), 0, -1);
+        prefix_cache_.erase(static_cast<int32_t>(i));
+        slots_[i] = KvSlot();
+    }
+    sessions_.clear();
+    clock_ = 0;
+    for (uint32_t i = 0; i < header.session_count; ++i) {
+        const SessionFileSession& saved = file.sessions()[i];
+        Session& conversation = sessions_[saved.session_id];
+        const LlmToken* tokens = file.tokens_at(saved.tokens_offset);
+        const LlmToken* pending = file.tokens_at(saved.pending_offset);
+        conversation.tokens.assign(tokens, tokens + saved.token_count);
+        conversation.pending.assign(pending, pending + saved.pending_count);
+        conversation.last_used = saved.last_used;
+        clock_ = std::max(clock_, saved.last_used);
+    }
+    int64_t kv_tokens = 0;
+    for (uint32_t i = 0; i < header.slot_count; ++i) {
+        const SessionFileSlot& saved = file.slots()[i];
+        const int32_t seq = saved.seq_id;
+        // A slot beyond this engine's sequences, or one it rejects, costs a
+        // prefill later rather than failing the load.
+        if (seq >= static_cast<int32_t>(slots_.size()) || !slots_[seq].tokens.empty() ||
+            !engine_->state_seq_set(seq, file.bytes_at(saved.state_offset), static_cast<size_t>(saved.state_size)) ||
+            engine_->kv_seq_length(seq) != static_cast<int32_t>(saved.token_count)) {
+            if (seq < static_cast<int32_t>(slots_.size()) && slots_[seq].tokens.empty()) {
+                engine_->kv_seq_remove(seq, 0, -1);
+            }
+            LOGW("LLM session: KV slot %d not restored", seq);
+            continue;
+        }
+        KvSlot& slot = slots_[seq];
+        const int64_t owner = saved.session_id;
+        const bool owned = std::any_of(slots_.begin(), slots_.end(),
+                                       [owner](const KvSlot& other) { return other.session_id == owner; });
+        slot.session_id = owner >= 0 && !owned && sessions_.count(owner) > 0 ? owner : -1;
+        const LlmToken* tokens = file.tokens_at(saved.tokens_offset);
+        slot.tokens.assign(tokens, tokens + saved.token_count);
+        slot.last_used = saved.last_used;
+        clock_ = std::max(clock_, saved.last_used);
+        prefix_cache_.update(seq, slot.tokens.data(), slot.tokens.size());
+        kv_tokens += static_cast<int64_t>(slot.tokens.size());
+    }
+
+    const int64_t elapsed_us = MicrosSince(started, std::chrono::steady_clock::now());
+    SendEventToDart(ports_.metrics(), "llm_session_load",
+                    {static_cast<int64_t>(sessions_.size()), kv_tokens, static_cast<int64_t>(file.size()), elapsed_us});
+    LOGI("LLM session loaded from %s: %zu conversations, %lld KV tokens in %lld us",
+         path.c_str(), sessions_.size(), (long long)kv_tokens, (long long)elapsed_us);
+    return true;
+}
+
+LlmSchedulerStats LlmScheduler::stats() const {
+    LlmSchedulerStats stats;
+    stats.decode_steps = decode_steps_.load(std::memory_order_relaxed);
+    stats.prefill_tokens = prefill_tokens_.load(std::memory_order_relaxed);
+    stats.reused_tokens = reused_tokens_.load(std::memory_order_relaxed);
+    stats.generated_tokens = generated_tokens_.load(std::memory_order_relaxed);
+    stats.max_batch_sessions = max_batch_sessions_.load(std::memory_order_relaxed);
+    stats.sessions_evicted = sessions_evicted_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+}  // namespace ai_bridge
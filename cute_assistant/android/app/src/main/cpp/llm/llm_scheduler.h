@@ -0,0 +1,207 @@
+#ifndef AI_BRIDGE_LLM_LLM_SCHEDULER_H_
+#define AI_BRIDGE_LLM_LLM_SCHEDULER_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "dart_api_dl.h"
+#include "llm/llm_engine.h"
+#include "llm/prefix_cache.h"
+#include "llm/request_queue.h"
+#include "llm/token_stream.h"
+
+namespace ai_bridge {
+
+struct LlmSchedulerOptions {
+    // Requests generating at once; capped at the engine's max_sequences().
+    int32_t max_active_sessions = 4;
+    // Most tokens evaluated by one decode() call across all sessions.
+    int32_t batch_token_budget = 256;
+    // Most prompt tokens one session adds to a single decode() call, so a
+    // long prompt cannot stall the sessions that are already generating.
+    int32_t prefill_chunk = 64;
+    // Conversations whose token history is remembered after they lose their
+    // KV slot, so a later turn can rebuild their context.
+    int32_t max_remembered_sessions = 64;
+    // A reply longer than this ends as if the model had sampled EOS; 0 for
+    // no limit other than the context.
+    int32_t max_reply_tokens = 512;
+};
+
+// Where the scheduler reports errors (as strings) and metric/event records.
+// Called for every report, mostly on the scheduler thread.
+struct LlmSchedulerPorts {
+    std::function<Dart_Port()> errors;
+    std::function<Dart_Port()> metrics;
+};
+
+struct LlmSchedulerStats {
+    int64_t decode_steps = 0;
+    int64_t prefill_tokens = 0;     // prompt tokens evaluated
+    int64_t reused_tokens = 0;      // prompt tokens served from the prefix cache
+    int64_t generated_tokens = 0;   // tokens sampled and published
+    int64_t max_batch_sessions = 0; // most sessions sharing one decode()
+    int64_t sessions_evicted = 0;   // idle KV slots reclaimed for new sessions
+};
+
+// Iteration-level continuous batching over one LlmEngine.
+//
+// Every request belongs to a session (a conversation) whose token history the
+// scheduler remembers. A session being served owns one engine sequence, its
+// KV slot; when all slots are taken, the least recently used idle one is
+// reassigned. A PrefixCache indexes what every slot holds, so a request only
+// prefills the part of its conversation that no slot already has: a
+// follow-up turn in its own slot evaluates just the new turn, the system
+// prompt is evaluated once per engine, and a session that lost its slot
+// rebuilds from the longest shared prefix.
+//
+// Each iteration admits queued requests up to max_active_sessions, then
+// builds one batch: one token for every session that is generating, and the
+// rest of batch_token_budget split round-robin into prefill chunks for
+// sessions still evaluating their prompt. Requests join and leave between
+// iterations, so a short reply never waits for a long one. Requests of the
+// same session are served one after another in queue order.
+//
+// Cancellation is checked every iteration: a cancelled request stops within
+// one decode step. A reply cut short stays in its session's history; a
+// prompt cut short is left out of it, though what was evaluated stays cached.
+class LlmScheduler {
+public:
+    LlmScheduler(LlmEngine* engine, LlmRequestQueue* requests, TokenStream* tokens, LlmSchedulerPorts ports,
+                 const LlmSchedulerOptions& options = LlmSchedulerOptions());
+
+    LlmScheduler(const LlmScheduler&) = delete;
+    LlmScheduler& operator=(const LlmScheduler&) = delete;
+
+    // Evaluates BOS and the system prompt into a free KV slot before the
+    // first request, so the engine's first decode (page faults, allocations)
+    // and the prefix every conversation starts with are paid at startup.
+    // Call on the scheduler thread before run(); returns false if the engine
+    // failed to decode.
+    bool warm_up();
+
+    // Serves requests until the queue is closed and drained. Clearing
+    // `running` cancels everything in flight.
+    void run(const std::atomic<bool>& running);
+
+    // Text every new conversation starts with. Safe from any thread; takes
+    // effect for conversations started afterwards.
+    void set_system_prompt(const std::string& text);
+
+    // Writes every remembered conversation and the KV state of every slot
+    // to `path` (see session_file.h), then posts
+    // ["llm_session_save", sessions, kv_tokens, bytes, elapsed_us]. Safe
+    // from any thread; waits for the decode step in progress, and saves a
+    // reply still being generated as if cut off there. Returns false after
+    // reporting the error.
+    bool save_sessions(const std::string& path);
+    // Replaces the remembered conversations and KV slots with what
+    // save_sessions() wrote, then posts ["llm_session_load", ...] in the
+    // same format. Refused while requests are active or waiting; a slot the
+    // engine cannot restore is dropped and its conversation prefilled again
+    // on its next turn.
+    bool load_sessions(const std::string& path);
+
+    // Safe from any thread.
+    LlmSchedulerStats stats() const;
+
+private:
+    struct Session {
+        // Conversation so far, exactly as its KV cache holds (or held) it.
+        std::vector<LlmToken> tokens;
+        // Tokens owed to the cache by the last reply: its last sampled token
+        // and the EOS closing the turn. They lead the next prompt instead of
+        // costing a decode step of their own.
+        std::vector<LlmToken> pending;
+        uint64_t last_used = 0;
+    };
+
+    // One engine sequence.
+    struct KvSlot {
+        int64_t session_id = -1;  // -1 while unassigned
+        bool busy = false;        // a request of the session is active
+        std::vector<LlmToken> tokens;  // mirror of the sequence's cache
+        uint64_t last_used = 0;
+    };
+
+    struct Active {
+        LlmRequest request;
+        int32_t seq = 0;
+        std::vector<LlmToken> prompt;  // what the cache still has to evaluate
+        size_t prompt_done = 0;
+        size_t prompt_tokens = 0;      // whole turn, cached or not
+        // Session debt before the prompt, restored if it is cut short.
+        std::vector<LlmToken> saved_pending;
+        LlmToken next = -1;          // sampled, not yet decoded
+        int32_t logits_index = -1;   // batch entry to sample from, or -1
+        int64_t generated = 0;
+        std::chrono::steady_clock::time_point started_at;  // taken into a slot
+        std::chrono::steady_clock::time_point first_token_at;
+    };
+
+    // Returns false once the queue is closed and drained. `lock` holds
+    // state_mutex_ and is released while blocked on an empty queue.
+    bool admit(const std::atomic<bool>& running, std::unique_lock<std::mutex>* lock);
+    std::unique_lock<std::mutex> lock_state();
+    bool try_start(LlmRequest* request);
+    int32_t acquire_slot(int64_t session_id);
+    Session& session(int64_t session_id);
+    size_t shared_prefill_length(const std::vector<LlmToken>& target) const;
+    void truncate_slot(int32_t seq, size_t length);
+    void build_batch();
+    void sample();
+    void finish(size_t index, TokenReplyStatus status);
+    void cancel_unstarted(LlmRequest* request);
+    // Ends a request that cannot start, such as a turn longer than the
+    // context, as failed.
+    void reject_unstarted(LlmRequest* request, const std::string& reason);
+    // Fails the sessions whose part of batch_ the engine would reject and
+    // drops their entries, so one bad prompt cannot fail the others.
+    void drop_invalid_sessions();
+    void fail_batch();
+    void report_cancellation(const LlmRequest& request, int64_t generated);
+    void report_error(const std::string& message);
+
+    LlmEngine* const engine_;
+    LlmRequestQueue* const requests_;
+    TokenStream* const tokens_;
+    const LlmSchedulerPorts ports_;
+    LlmSchedulerOptions options_;
+
+    std::vector<KvSlot> slots_;
+    std::unordered_map<int64_t, Session> sessions_;
+    PrefixCache prefix_cache_;
+    std::vector<Active> active_;
+    // Popped, waiting for their session, a slot, or a prefix being prefilled.
+    std::vector<LlmRequest> deferred_;
+    LlmBatch batch_;
+    size_t round_robin_ = 0;
+    uint64_t clock_ = 0;
+
+    // Held by the scheduler thread except while it waits for requests;
+    // save/load take it between decode steps.
+    std::mutex state_mutex_;
+    std::condition_variable state_released_;
+    std::atomic<int32_t> state_waiters_{0};
+
+    mutable std::mutex system_prompt_mutex_;
+    std::string system_prompt_;
+
+    std::atomic<int64_t> decode_steps_{0};
+    std::atomic<int64_t> prefill_tokens_{0};
+    std::atomic<int64_t> reused_tokens_{0};
+    std::atomic<int64_t> generated_tokens_{0};
+    std::atomic<int64_t> max_batch_sessions_{0};
+    std::atomic<int64_t> sessions_evicted_{0};
+};
+
+}  // namespace ai_bridge
+
+#endif  // AI_BRIDGE_LLM_LLM_SCHEDULER_H_
@@ -0,0 +1,207 @@
+#include "llm/model_file.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+namespace ai_bridge {
+
+namespace {
+
+uint64_t AlignUp(uint64_t offset) {
+    return (offset + kModelFileAlignment - 1) / kModelFileAlignment * kModelFileAlignment;
+}
+
+std::string ErrnoMessage(const std::string& what, const std::string& path) {
+    return what + " " + path + ": " + std::strerror(errno);
+}
+
+int64_t MicrosSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+bool WritePadding(FILE* file, uint64_t bytes) {
+    static const uint8_t kZeros[256] = {};
+    while (bytes > 0) {
+        const size_t chunk = static_cast<size_t>(std::min<uint64_t>(bytes, sizeof(kZeros)));
+        if (fwrite(kZeros, 1, chunk, file) != chunk) return false;
+        bytes -= chunk;
+    }
+    return true;
+}
+
+}  // namespace
+
+void ModelFileWriter::add_tensor(const std::string& name, TensorType type, int32_t layer, std::vector<int64_t> dims,
+                                 const void* data, uint64_t size) {
+    Tensor tensor;
+    std::memset(&tensor.entry, 0, sizeof(tensor.entry));
+    std::strncpy(tensor.entry.name, name.c_str(), sizeof(tensor.entry.name) - 1);
+    tensor.entry.type = type;
+    tensor.entry.layer = layer;
+    tensor.entry.n_dims = static_cast<uint32_t>(std::min<size_t>(dims.size(), 4));
+    for (uint32_t d = 0; d < 4; ++d) tensor.entry.dims[d] = d < tensor.entry.n_dims ? dims[d] : 1;
+    tensor.entry.size = size;
+    tensor.data = data;
+    tensors_.push_back(tensor);
+    if (layer >= 0) layer_count_ = std::max(layer_count_, static_cast<uint32_t>(layer) + 1);
+}
+
+uint64_t ModelFileWriter::write(const std::string& path, std::string* error) const {
+    ModelFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, kModelFileMagic, sizeof(header.magic));
+    header.version = kModelFileVersion;
+    header.header_size = sizeof(ModelFileHeader);
+    header.tensor_count = static_cast<uint32_t>(tensors_.size());
+    header.layer_count = layer_count_;
+
+    std::vector<ModelFileTensor> table;
+    table.reserve(tensors_.size());
+    uint64_t offset = AlignUp(sizeof(ModelFileHeader) + sizeof(ModelFileTensor) * tensors_.size());
+    for (const Tensor& tensor : tensors_) {
+        table.push_back(tensor.entry);
+        table.back().offset = offset;
+        offset = AlignUp(offset + tensor.entry.size);
+    }
+    header.file_size = offset;
+
+    FILE* file = std::fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        *error = ErrnoMessage("Cannot create", path);
+        return 0;
+    }
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+              (table.empty() || fwrite(table.data(), sizeof(ModelFileTensor), table.size(), file) == table.size());
+    uint64_t position = sizeof(ModelFileHeader) + sizeof(ModelFileTensor) * table.size();
+    for (size_t i = 0; ok && i < tensors_.size(); ++i) {
+        const ModelFileTensor& entry = table[i];
+        ok = WritePadding(file, entry.offset - position) &&
+             (entry.size == 0 || fwrite(tensors_[i].data, 1, entry.size, file) == entry.size);
+        position = entry.offset + entry.size;
+    }
+    ok = ok && WritePadding(file, header.file_size - position);
+    if (std::fclose(file) != 0) ok = false;
+    if (!ok) {
+        *error = ErrnoMessage("Cannot write", path);
+        std::remove(path.c_str());
+        return 0;
+    }
+    return header.file_size;
+}
+
+MappedModelFile::~MappedModelFile() {
+    if (data_ != nullptr) munmap(const_cast<uint8_t*>(data_), size_);
+}
+
+bool MappedModelFile::open(const std::string& path, int64_t* open_us, int64_t* map_us, std::string* error) {
+    auto started = std::chrono::steady_clock::now();
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        *error = ErrnoMessage("Cannot open", path);
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<uint64_t>(info.st_size) < sizeof(ModelFileHeader)) {
+        *error = path + " is not a model file";
+        ::close(fd);
+        return false;
+    }
+    *open_us = MicrosSince(started);
+
+    started = std::chrono::steady_clock::now();
+    size_ = static_cast<size_t>(info.st_size);
+    void* mapping = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);  // the mapping keeps the file alive
+    if (mapping == MAP_FAILED) {
+        *error = ErrnoMessage("Cannot map", path);
+        size_ = 0;
+        return false;
+    }
+    data_ = static_cast<const uint8_t*>(mapping);
+    // No access hint for the whole mapping: every weight is read again for
+    // every token, and MADV_SEQUENTIAL would have the kernel reclaim pages
+    // right after use, faulting them back in on the next token. The default
+    // readahead serves lazy faults; prefetch_layers() adds MADV_WILLNEED
+    // for what the first token needs.
+    if (!validate(error)) {
+        *error = path + ": " + *error;
+        return false;
+    }
+    *map_us = MicrosSince(started);
+    return true;
+}
+
+bool MappedModelFile::validate(std::string* error) const {
+    const ModelFileHeader& file = header();
+    if (std::memcmp(file.magic, kModelFileMagic, sizeof(file.magic)) != 0) {
+        *error = "not a model file";
+        return false;
+    }
+    if (file.version != kModelFileVersion || file.header_size != sizeof(ModelFileHeader)) {
+        *error = "unsupported model file version " + std::to_string(file.version);
+        return false;
+    }
+    if (file.file_size != size_ ||
+        sizeof(ModelFileHeader) + sizeof(ModelFileTensor) * uint64_t{file.tensor_count} > size_) {
+        *error = "truncated model file";
+        return false;
+    }
+    for (uint32_t i = 0; i < file.tensor_count; ++i) {
+        const ModelFileTensor& tensor = tensors()[i];
+        if (tensor.offset % kModelFileAlignment != 0 || tensor.offset > size_ || tensor.size > size_ - tensor.offset ||
+            tensor.name[sizeof(tensor.name) - 1] != '\0' || tensor.n_dims > 4) {
+            *error = "corrupt tensor entry " + std::to_string(i);
+            return false;
+        }
+    }
+    return true;
+}
+
+const ModelFileTensor* MappedModelFile::find(const char* name) const {
+    for (uint32_t i = 0; i < header().tensor_count; ++i) {
+        if (std::strcmp(tensors()[i].name, name) == 0) return &tensors()[i];
+    }
+    return nullptr;
+}
+
+uint64_t MappedModelFile::prefetch_layers(uint32_t layers) const {
+    // Everything up to the end of the last tensor of layer `layers - 1`;
+    // without a layer stack, the whole file.
+    uint64_t end = 0;
+    uint32_t i = 0;
+    for (; i < header().tensor_count; ++i) {
+        const ModelFileTensor& tensor = tensors()[i];
+        if (tensor.layer >= static_cast<int32_t>(layers)) break;
+        end = tensor.offset + tensor.size;
+    }
+    if (i == header().tensor_count) end = size_;
+    end = std::min<uint64_t>(AlignUp(end), size_);
+    if (end > 0) madvise(const_cast<uint8_t*>(data_), static_cast<size_t>(end), MADV_WILLNEED);
+    // The first token also needs what follows the stack: the output norm
+    // and, unless it is tied to the embeddings, the output head.
+    for (; i < header().tensor_count; ++i) {
+        const ModelFileTensor& tensor = tensors()[i];
+        if (tensor.layer >= 0 || tensor.size == 0) continue;
+        const uint64_t tensor_end = std::min<uint64_t>(AlignUp(tensor.offset + tensor.size), size_);
+        madvise(const_cast<uint8_t*>(data_ + tensor.offset), static_cast<size_t>(tensor_end - tensor.offset),
+                MADV_WILLNEED);
+    }
+    return end;
+}
+
+void MappedModelFile::page_in(uint64_t bytes) const {
+    bytes = std::min<uint64_t>(bytes, size_);
+    volatile uint8_t sink = 0;
+    for (uint64_t offset = 0; offset < bytes; offset += kModelFileAlignment) sink ^= data_[offset];
+    (void)sink;
+}
+
+}  // namespace ai_bridge
@@ -0,0 +1,115 @@
+#ifndef AI_BRIDGE_LLM_MODEL_FILE_H_
+#define AI_BRIDGE_LLM_MODEL_FILE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ai_bridge {
+
+// Model weights file, laid out to be mapped rather than read.
+//
+//   ModelFileHeader
+//   ModelFileTensor[tensor_count]
+//   tensor data, each tensor starting on a kModelFileAlignment boundary
+//
+// Tensors are stored in evaluation order (embeddings, then layer 0, 1, ...,
+// then the output head), so the weights needed for the first token form one
+// contiguous prefix of the file that can be prefetched on its own while the
+// rest pages in lazily. Offsets are from the start of the file; native byte
+// order.
+constexpr char kModelFileMagic[8] = {'A', 'I', 'B', 'M', 'O', 'D', 'E', 'L'};
+constexpr uint32_t kModelFileVersion = 1;
+// Page aligned, so madvise() ranges never straddle two tensors' pages.
+constexpr size_t kModelFileAlignment = 4096;
+
+// Values follow ggml's type ids. Quantized layouts are in llm/quant.h.
+enum class TensorType : uint32_t {
+    kF32 = 0,
+    kF16 = 1,
+    kQ4_0 = 2,
+    kQ8_0 = 8,
+};
+
+struct ModelFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;    // sizeof(ModelFileHeader)
+    uint32_t tensor_count;
+    uint32_t layer_count;
+    uint64_t file_size;
+    uint32_t reserved[10];
+};
+static_assert(sizeof(ModelFileHeader) == 72, "ModelFileHeader layout is part of the file format");
+
+struct ModelFileTensor {
+    char name[48];           // NUL-terminated, e.g. "blk.3.attn_q"
+    TensorType type;
+    int32_t layer;           // -1 for tensors outside the layer stack
+    uint32_t n_dims;
+    uint32_t reserved;
+    int64_t dims[4];         // innermost first, as ggml
+    uint64_t offset;
+    uint64_t size;           // bytes
+};
+static_assert(sizeof(ModelFileTensor) == 112, "ModelFileTensor layout is part of the file format");
+
+// Builds a model file; used by tools and the synthetic test models.
+class ModelFileWriter {
+public:
+    // `data` must outlive write(). Tensors are written in the order added.
+    void add_tensor(const std::string& name, TensorType type, int32_t layer, std::vector<int64_t> dims,
+                    const void* data, uint64_t size);
+    // Returns the file size, or 0 with `error` set.
+    uint64_t write(const std::string& path, std::string* error) const;
+
+private:
+    struct Tensor {
+        ModelFileTensor entry;
+        const void* data;
+    };
+    std::vector<Tensor> tensors_;
+    uint32_t layer_count_ = 0;
+};
+
+// Read-only mapping of a model file. Nothing is read at open() beyond the
+// header and tensor table; weights fault in on first touch unless prefetched.
+class MappedModelFile {
+public:
+    MappedModelFile() = default;
+    ~MappedModelFile();
+
+    MappedModelFile(const MappedModelFile&) = delete;
+    MappedModelFile& operator=(const MappedModelFile&) = delete;
+
+    // Opens and maps `path`; `open_us` and `map_us` receive how long the
+    // open() and mmap() (plus table validation) took.
+    bool open(const std::string& path, int64_t* open_us, int64_t* map_us, std::string* error);
+
+    // Asks the kernel to start reading the weights of layers [0, layers),
+    // everything stored before them, and the tensors outside the layer
+    // stack stored after it. Returns the length of the prefix in bytes.
+    uint64_t prefetch_layers(uint32_t layers) const;
+    // Faults in [0, bytes) of the mapping, one read per page, returning once
+    // it is resident.
+    void page_in(uint64_t bytes) const;
+
+    const ModelFileHeader& header() const { return *reinterpret_cast<const ModelFileHeader*>(data_); }
+    const ModelFileTensor* tensors() const {
+        return reinterpret_cast<const ModelFileTensor*>(data_ + sizeof(ModelFileHeader));
+    }
+    const ModelFileTensor* find(const char* name) const;
+    const void* tensor_data(const ModelFileTensor& tensor) const { return data_ + tensor.offset; }
+    size_t size() const { return size_; }
+
+private:
+    bool validate(std::string* error) const;
+
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+}  // namespace ai_bridge
+
+#endif  // AI_BRIDGE_LLM_MODEL_FILE_H_
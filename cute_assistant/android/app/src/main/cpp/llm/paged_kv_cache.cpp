@@ -0,0 +1,81 @@
+#include "llm/paged_kv_cache.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace ai_bridge {
+
+void PagedKvCache::configure(int32_t layers, int32_t kv_dim, int32_t max_sequences) {
+    layers_ = layers;
+    kv_dim_ = kv_dim;
+    page_floats_ = static_cast<size_t>(layers) * 2 * kPageTokens * kv_dim;
+    sequences_.assign(static_cast<size_t>(std::max(1, max_sequences)), Sequence());
+    chunks_.clear();
+    refs_.clear();
+    free_.clear();
+    pages_in_use_ = 0;
+    pages_shared_ = 0;
+}
+
+int32_t PagedKvCache::allocate() {
+    if (free_.empty()) {
+        const int32_t first = static_cast<int32_t>(refs_.size());
+        chunks_.emplace_back(new float[kChunkPages * page_floats_]);
+        refs_.resize(refs_.size() + kChunkPages, 0);
+        // Handed out lowest first.
+        for (int32_t page = first + kChunkPages - 1; page >= first; --page) free_.push_back(page);
+    }
+    const int32_t page = free_.back();
+    free_.pop_back();
+    refs_[page] = 1;
+    ++pages_in_use_;
+    return page;
+}
+
+void PagedKvCache::release(int32_t page) {
+    if (--refs_[page] == 0) {
+        free_.push_back(page);
+        --pages_in_use_;
+    } else if (refs_[page] == 1) {
+        --pages_shared_;
+    }
+}
+
+void PagedKvCache::prepare(int32_t seq, int32_t position) {
+    Sequence& sequence = sequences_[seq];
+    const size_t index = static_cast<size_t>(position / kPageTokens);
+    if (index == sequence.pages.size()) {
+        sequence.pages.push_back(allocate());
+        return;
+    }
+    const int32_t shared = sequence.pages[index];
+    if (refs_[shared] == 1) return;
+    // Copy on write. Only the rows before `position` hold this sequence's
+    // data, but copying the whole page is one memcpy.
+    const int32_t page = allocate();
+    std::memcpy(page_data(page), page_data(shared), page_bytes());
+    release(shared);
+    sequence.pages[index] = page;
+}
+
+void PagedKvCache::truncate(int32_t seq, int32_t length) {
+    Sequence& sequence = sequences_[seq];
+    sequence.length = std::max(0, std::min(length, sequence.length));
+    const size_t pages = static_cast<size_t>((sequence.length + kPageTokens - 1) / kPageTokens);
+    for (size_t i = pages; i < sequence.pages.size(); ++i) release(sequence.pages[i]);
+    sequence.pages.resize(std::min(pages, sequence.pages.size()));
+}
+
+void PagedKvCache::copy(int32_t src, int32_t dst, int32_t length) {
+    truncate(dst, 0);
+    const Sequence& from = sequences_[src];
+    Sequence& to = sequences_[dst];
+    to.length = std::max(0, std::min(length, from.length));
+    const size_t pages = static_cast<size_t>((to.length + kPageTokens - 1) / kPageTokens);
+    to.pages.assign(from.pages.begin(), from.pages.begin() + static_cast<std::ptrdiff_t>(pages));
+    for (const int32_t page : to.pages) {
+        if (refs_[page]++ == 1) ++pages_shared_;
+    }
+}
+
+}  // namespace ai_bridge
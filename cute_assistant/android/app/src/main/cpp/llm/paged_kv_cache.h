@@ -0,0 +1,98 @@
+#ifndef AI_BRIDGE_LLM_PAGED_KV_CACHE_H_
+#define AI_BRIDGE_LLM_PAGED_KV_CACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace ai_bridge {
+
+// The keys and values of every sequence of an engine, kept in fixed-size
+// pages of kPageTokens positions (all layers of them) instead of one
+// buffer per sequence and layer. A sequence is a table of page numbers, so
+// a cache never holds more than one partly used page per sequence, and
+// pages come from one allocator that recycles them across sequences.
+//
+// Pages are reference counted. copy() shares the source's pages instead of
+// copying them, which makes forking a conversation or reusing a cached
+// system prompt cost a few table entries; a page is copied only when a
+// sequence writes to a page another one still uses (copy-on-write), which
+// is at most the last, partly filled one.
+//
+// Not thread-safe: writes (prepare, truncate, copy) belong to the decode
+// thread, between which any number of threads may read rows.
+class PagedKvCache {
+public:
+    static constexpr int32_t kPageTokens = 16;
+
+    // Empties every sequence and sizes pages for the given shape. Memory
+    // already allocated is released.
+    void configure(int32_t layers, int32_t kv_dim, int32_t max_sequences);
+
+    int32_t max_sequences() const { return static_cast<int32_t>(sequences_.size()); }
+    int32_t length(int32_t seq) const { return sequences_[seq].length; }
+    void set_length(int32_t seq, int32_t length) { sequences_[seq].length = length; }
+
+    // Makes the rows of `position` of `seq` writable: allocates the page
+    // holding it, or copies that page if another sequence shares it.
+    // Positions must be prepared in order, without gaps.
+    void prepare(int32_t seq, int32_t position);
+    // Drops every position of `seq` from `length` on, releasing the pages
+    // it no longer uses.
+    void truncate(int32_t seq, int32_t length);
+    // Makes the empty sequence `dst` hold positions [0, length) of `src`
+    // by sharing its pages.
+    void copy(int32_t src, int32_t dst, int32_t length);
+
+    // kv_dim floats of keys or values of `position` of `seq` in `layer`.
+    // Rows of the positions on one page are consecutive.
+    float* key(int32_t seq, int32_t layer, int32_t position) { return row(seq, layer, position, 0); }
+    float* value(int32_t seq, int32_t layer, int32_t position) { return row(seq, layer, position, 1); }
+    const float* key(int32_t seq, int32_t layer, int32_t position) const {
+        return const_cast<PagedKvCache*>(this)->row(seq, layer, position, 0);
+    }
+    const float* value(int32_t seq, int32_t layer, int32_t position) const {
+        return const_cast<PagedKvCache*>(this)->row(seq, layer, position, 1);
+    }
+
+    size_t page_bytes() const { return sizeof(float) * page_floats_; }
+    // Pages referenced by at least one sequence, and of those the ones
+    // referenced by more than one.
+    int32_t pages_in_use() const { return pages_in_use_; }
+    int32_t pages_shared() const { return pages_shared_; }
+
+private:
+    // Pages are allocated this many at a time, so their addresses stay put.
+    static constexpr int32_t kChunkPages = 16;
+
+    struct Sequence {
+        int32_t length = 0;
+        std::vector<int32_t> pages;
+    };
+
+    float* row(int32_t seq, int32_t layer, int32_t position, int32_t kind) {
+        float* page = page_data(sequences_[seq].pages[position / kPageTokens]);
+        return page + ((static_cast<size_t>(layer) * 2 + kind) * kPageTokens + position % kPageTokens) * kv_dim_;
+    }
+    float* page_data(int32_t page) {
+        return chunks_[page / kChunkPages].get() + static_cast<size_t>(page % kChunkPages) * page_floats_;
+    }
+    int32_t allocate();
+    void release(int32_t page);
+
+    int32_t layers_ = 0;
+    int32_t kv_dim_ = 0;
+    size_t page_floats_ = 0;  // layers x {keys, values} x kPageTokens x kv_dim
+    std::vector<Sequence> sequences_;
+
+    std::vector<std::unique_ptr<float[]>> chunks_;
+    std::vector<int32_t> refs_;  // per page; 0 when free
+    std::vector<int32_t> free_;
+    int32_t pages_in_use_ = 0;
+    int32_t pages_shared_ = 0;
+};
+
+}  // namespace ai_bridge
+
+#endif  // AI_BRIDGE_LLM_PAGED_KV_CACHE_H_
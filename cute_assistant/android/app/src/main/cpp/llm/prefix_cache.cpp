@@ -0,0 +1,130 @@
+#include "llm/prefix_cache.h"
+
+#include <algorithm>
+
+namespace ai_bridge {
+
+struct PrefixCache::Node {
+    std::vector<LlmToken> edge;  // tokens leading here from the parent
+    std::vector<std::unique_ptr<Node>> children;  // distinct first edge tokens
+    std::vector<int32_t> seq_ids;  // sequences whose contents pass through
+
+    Node* child(LlmToken first) const {
+        for (const std::unique_ptr<Node>& node : children) {
+            if (node->edge.front() == first) return node.get();
+        }
+        return nullptr;
+    }
+};
+
+namespace {
+
+size_t CommonPrefix(const std::vector<LlmToken>& edge, const LlmToken* tokens, size_t count) {
+    const size_t limit = std::min(edge.size(), count);
+    size_t length = 0;
+    while (length < limit && edge[length] == tokens[length]) ++length;
+    return length;
+}
+
+}  // namespace
+
+PrefixCache::PrefixCache() : root_(new Node()) {}
+
+PrefixCache::~PrefixCache() = default;
+
+void PrefixCache::update(int32_t seq_id, const LlmToken* tokens, size_t count) {
+    if (seq_id < 0) return;
+    if (static_cast<size_t>(seq_id) >= contents_.size()) contents_.resize(static_cast<size_t>(seq_id) + 1);
+    std::vector<LlmToken>& contents = contents_[seq_id];
+    // Growing or shrinking in place is the common case; re-index either way.
+    erase(seq_id);
+    contents.assign(tokens, tokens + count);
+    insert(seq_id);
+}
+
+void PrefixCache::insert(int32_t seq_id) {
+    const std::vector<LlmToken>& contents = contents_[seq_id];
+    Node* node = root_.get();
+    size_t i = 0;
+    while (i < contents.size()) {
+        Node* next = node->child(contents[i]);
+        if (next == nullptr) {
+            std::unique_ptr<Node> leaf(new Node());
+            leaf->edge.assign(contents.begin() + static_cast<std::ptrdiff_t>(i), contents.end());
+            leaf->seq_ids.push_back(seq_id);
+            node->children.push_back(std::move(leaf));
+            ++node_count_;
+            return;
+        }
+        const size_t matched = CommonPrefix(next->edge, contents.data() + i, contents.size() - i);
+        if (matched < next->edge.size()) {
+            // Split the edge: `middle` takes the shared part and every
+            // sequence that passed through `next`.
+            std::unique_ptr<Node> middle(new Node());
+            middle->edge.assign(next->edge.begin(), next->edge.begin() + static_cast<std::ptrdiff_t>(matched));
+            middle->seq_ids = next->seq_ids;
+            for (std::unique_ptr<Node>& slot : node->children) {
+                if (slot.get() != next) continue;
+                next->edge.erase(next->edge.begin(), next->edge.begin() + static_cast<std::ptrdiff_t>(matched));
+                middle->children.push_back(std::move(slot));
+                slot = std::move(middle);
+                next = slot.get();
+                break;
+            }
+            ++node_count_;
+        }
+        next->seq_ids.push_back(seq_id);
+        node = next;
+        i += matched;
+    }
+}
+
+void PrefixCache::erase(int32_t seq_id) {
+    if (seq_id < 0 || static_cast<size_t>(seq_id) >= contents_.size()) return;
+    std::vector<LlmToken>& contents = contents_[seq_id];
+    Node* node = root_.get();
+    size_t i = 0;
+    while (i < contents.size()) {
+        Node* next = node->child(contents[i]);
+        if (next == nullptr) break;
+        next->seq_ids.erase(std::remove(next->seq_ids.begin(), next->seq_ids.end(), seq_id), next->seq_ids.end());
+        if (next->seq_ids.empty()) {
+            // Nothing below passes through either; drop the whole subtree.
+            auto it = std::find_if(node->children.begin(), node->children.end(),
+                                   [next](const std::unique_ptr<Node>& child) { return child.get() == next; });
+            std::vector<Node*> stack = {next};
+            while (!stack.empty()) {
+                Node* dead = stack.back();
+                stack.pop_back();
+                --node_count_;
+                for (const std::unique_ptr<Node>& child : dead->children) stack.push_back(child.get());
+            }
+            node->children.erase(it);
+            break;
+        }
+        i += next->edge.size();
+        node = next;
+    }
+    contents.clear();
+}
+
+PrefixCache::Match PrefixCache::lookup(const LlmToken* tokens, size_t count, int32_t preferred) const {
+    Match best;
+    const Node* node = root_.get();
+    size_t i = 0;
+    while (i < count) {
+        const Node* next = node->child(tokens[i]);
+        if (next == nullptr) break;
+        const size_t matched = CommonPrefix(next->edge, tokens + i, count - i);
+        const bool has_preferred =
+            std::find(next->seq_ids.begin(), next->seq_ids.end(), preferred) != next->seq_ids.end();
+        best.seq_id = has_preferred ? preferred : next->seq_ids.front();
+        best.length = static_cast<int32_t>(i + matched);
+        if (matched < next->edge.size()) break;
+        i += matched;
+        node = next;
+    }
+    return best;
+}
+
+}  // namespace ai_bridge
@@ -0,0 +1,62 @@
+#ifndef AI_BRIDGE_LLM_PREFIX_CACHE_H_
+#define AI_BRIDGE_LLM_PREFIX_CACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "llm/llm_engine.h"
+
+namespace ai_bridge {
+
+// Radix tree over the token contents of an engine's KV sequences.
+//
+// Each sequence's cache holds the KV state of one token string; the tree
+// indexes all of them by prefix, so lookup() finds the sequence whose cache
+// shares the longest prefix with a new prompt. Copying that prefix
+// (LlmEngine::kv_seq_copy) replaces prefilling it: a system prompt shared by
+// every conversation is evaluated once, and a conversation that lost its KV
+// slot is rebuilt from whatever other sequences still share with it.
+//
+// Every node lists the sequences whose contents pass through it. Nodes are
+// split on insert and removed once no sequence passes through them. Only the
+// scheduler thread uses a PrefixCache.
+class PrefixCache {
+public:
+    struct Match {
+        int32_t seq_id = -1;  // -1 when nothing matched
+        int32_t length = 0;   // tokens of the prompt held by seq_id
+    };
+
+    PrefixCache();
+    ~PrefixCache();
+
+    PrefixCache(const PrefixCache&) = delete;
+    PrefixCache& operator=(const PrefixCache&) = delete;
+
+    // Records that sequence `seq_id` now holds exactly tokens[0, count).
+    void update(int32_t seq_id, const LlmToken* tokens, size_t count);
+    // Forgets sequence `seq_id` (its cache was cleared).
+    void erase(int32_t seq_id);
+
+    // Longest prefix of tokens[0, count) held by any sequence. Among
+    // sequences sharing the longest prefix, `preferred` wins, so a sequence
+    // reusing its own cache needs no copy.
+    Match lookup(const LlmToken* tokens, size_t count, int32_t preferred) const;
+
+    size_t node_count() const { return node_count_; }
+
+private:
+    struct Node;
+
+    void insert(int32_t seq_id);
+
+    std::unique_ptr<Node> root_;
+    std::vector<std::vector<LlmToken>> contents_;  // per sequence, as indexed
+    size_t node_count_ = 0;
+};
+
+}  // namespace ai_bridge
+
+#endif  // AI_BRIDGE_LLM_PREFIX_CACHE_H_
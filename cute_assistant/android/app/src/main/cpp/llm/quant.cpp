@@ -0,0 +1,359 @@
+#include "llm/quant.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "core/cpu_features.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define AI_BRIDGE_X86_KERNELS 1
+#endif
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace ai_bridge {
+
+namespace {
+
+uint32_t FloatBits(float f) {
+    uint32_t bits;
+    std::memcpy(&bits, &f, sizeof(bits));
+    return bits;
+}
+
+float BitsFloat(uint32_t bits) {
+    float f;
+    std::memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+void QuantizeBlockQ8_0(const float* x, BlockQ8_0* y) {
+    float amax = 0.0f;
+    for (int32_t j = 0; j < kQuantBlock; ++j) amax = std::max(amax, std::fabs(x[j]));
+    const float d = amax / 127.0f;
+    const float id = d != 0.0f ? 1.0f / d : 0.0f;
+    y->d = FloatToFp16(d);
+    for (int32_t j = 0; j < kQuantBlock; ++j) y->qs[j] = static_cast<int8_t>(std::lround(x[j] * id));
+}
+
+void QuantizeBlockQ4_0(const float* x, BlockQ4_0* y) {
+    // The scale maps the largest magnitude to -8, the end of the range that
+    // has no positive counterpart, so that value is exact.
+    float amax = 0.0f;
+    float max = 0.0f;
+    for (int32_t j = 0; j < kQuantBlock; ++j) {
+        if (std::fabs(x[j]) > amax) {
+            amax = std::fabs(x[j]);
+            max = x[j];
+        }
+    }
+    const float d = max / -8.0f;
+    const float id = d != 0.0f ? 1.0f / d : 0.0f;
+    y->d = FloatToFp16(d);
+    for (int32_t j = 0; j < kQuantBlock / 2; ++j) {
+        const int32_t lo = std::min(15, static_cast<int32_t>(x[j] * id + 8.5f));
+        const int32_t hi = std::min(15, static_cast<int32_t>(x[j + kQuantBlock / 2] * id + 8.5f));
+        y->qs[j] = static_cast<uint8_t>(lo | (hi << 4));
+    }
+}
+
+#if defined(AI_BRIDGE_X86_KERNELS)
+
+__attribute__((target("avx2,fma,f16c"))) float HorizontalSum(__m256 v) {
+    __m128 sum = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_movehdup_ps(sum));
+    return _mm_cvtss_f32(sum);
+}
+
+// Sum of the 32 products w[i] * x[i] as eight int32 lanes converted to float.
+// maddubs multiplies unsigned by signed bytes, so the signs move from w to
+// x first; |w| <= 127 keeps the pairwise int16 sums from saturating.
+__attribute__((target("avx2,fma,f16c"))) __m256 DotBlock(__m256i w, __m256i x) {
+    const __m256i products = _mm256_maddubs_epi16(_mm256_sign_epi8(w, w), _mm256_sign_epi8(x, w));
+    return _mm256_cvtepi32_ps(_mm256_madd_epi16(products, _mm256_set1_epi16(1)));
+}
+
+// The 32 quants of a Q8_0 block.
+__attribute__((target("avx2,fma,f16c"))) __m256i LoadQ8_0(const BlockQ8_0& block) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block.qs));
+}
+
+// Unpacks a Q4_0 block to 32 signed bytes: low nibbles are elements 0-15,
+// high nibbles 16-31.
+__attribute__((target("avx2,fma,f16c"))) __m256i LoadQ4_0(const BlockQ4_0& block) {
+    const __m128i packed = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block.qs));
+    const __m256i both = _mm256_inserti128_si256(_mm256_castsi128_si256(packed), _mm_srli_epi16(packed, 4), 1);
+    return _mm256_sub_epi8(_mm256_and_si256(both, _mm256_set1_epi8(0x0f)), _mm256_set1_epi8(8));
+}
+
+// Two accumulators, so consecutive blocks' FMAs do not wait on each other.
+template <typename Block, __m256i (*Load)(const Block&)>
+__attribute__((target("avx2,fma,f16c"))) float VecDotAvx2(const Block* w, const BlockQ8_0* x, int32_t blocks) {
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    int32_t b = 0;
+    for (; b + 2 <= blocks; b += 2) {
+        const __m256 d0 = _mm256_set1_ps(_cvtsh_ss(w[b].d) * _cvtsh_ss(x[b].d));
+        const __m256 d1 = _mm256_set1_ps(_cvtsh_ss(w[b + 1].d) * _cvtsh_ss(x[b + 1].d));
+        acc0 = _mm256_fmadd_ps(d0, DotBlock(Load(w[b]), LoadQ8_0(x[b])), acc0);
+        acc1 = _mm256_fmadd_ps(d1, DotBlock(Load(w[b + 1]), LoadQ8_0(x[b + 1])), acc1);
+    }
+    if (b < blocks) {
+        const __m256 d = _mm256_set1_ps(_cvtsh_ss(w[b].d) * _cvtsh_ss(x[b].d));
+        acc0 = _mm256_fmadd_ps(d, DotBlock(Load(w[b]), LoadQ8_0(x[b])), acc0);
+    }
+    return HorizontalSum(_mm256_add_ps(acc0, acc1));
+}
+
+__attribute__((target("avx2,fma,f16c"))) float VecDotQ8_0Avx2(const BlockQ8_0* w, const BlockQ8_0* x, int32_t blocks) {
+    return VecDotAvx2<BlockQ8_0, LoadQ8_0>(w, x, blocks);
+}
+
+__attribute__((target("avx2,fma,f16c"))) float VecDotQ4_0Avx2(const BlockQ4_0* w, const BlockQ8_0* x, int32_t blocks) {
+    return VecDotAvx2<BlockQ4_0, LoadQ4_0>(w, x, blocks);
+}
+
+#endif  // AI_BRIDGE_X86_KERNELS
+
+#if defined(__ARM_NEON)
+
+float HorizontalSum(float32x4_t v) {
+#if defined(__aarch64__)
+    return vaddvq_f32(v);
+#else
+    const float32x2_t pair = vadd_f32(vget_low_f32(v), vget_high_f32(v));
+    return vget_lane_f32(vpadd_f32(pair, pair), 0);
+#endif
+}
+
+// Sum of the 32 products (w0 w1) . (x0 x1) as four int32 lanes.
+int32x4_t DotBlock(int8x16_t w0, int8x16_t w1, int8x16_t x0, int8x16_t x1) {
+#if defined(__ARM_FEATURE_DOTPROD)
+    return vdotq_s32(vdotq_s32(vdupq_n_s32(0), w0, x0), w1, x1);
+#else
+    // Two int8 products summed fit in int16 since |q| <= 127.
+    int16x8_t p0 = vmull_s8(vget_low_s8(w0), vget_low_s8(x0));
+    p0 = vmlal_s8(p0, vget_high_s8(w0), vget_high_s8(x0));
+    int16x8_t p1 = vmull_s8(vget_low_s8(w1), vget_low_s8(x1));
+    p1 = vmlal_s8(p1, vget_high_s8(w1), vget_high_s8(x1));
+    return vaddq_s32(vpaddlq_s16(p0), vpaddlq_s16(p1));
+#endif
+}
+
+float VecDotQ8_0Neon(const BlockQ8_0* w, const BlockQ8_0* x, int32_t blocks) {
+    float32x4_t acc = vdupq_n_f32(0.0f);
+    for (int32_t b = 0; b < blocks; ++b) {
+        const float d = Fp16ToFloat(w[b].d) * Fp16ToFloat(x[b].d);
+        const int32x4_t sum = DotBlock(vld1q_s8(w[b].qs), vld1q_s8(w[b].qs + 16), vld1q_s8(x[b].qs),
+                                       vld1q_s8(x[b].qs + 16));
+        acc = vmlaq_n_f32(acc, vcvtq_f32_s32(sum), d);
+    }
+    return HorizontalSum(acc);
+}
+
+float VecDotQ4_0Neon(const BlockQ4_0* w, const BlockQ8_0* x, int32_t blocks) {
+    const uint8x16_t low_nibbles = vdupq_n_u8(0x0f);
+    const int8x16_t offset = vdupq_n_s8(8);
+    float32x4_t acc = vdupq_n_f32(0.0f);
+    for (int32_t b = 0; b < blocks; ++b) {
+        const float d = Fp16ToFloat(w[b].d) * Fp16ToFloat(x[b].d);
+        const uint8x16_t packed = vld1q_u8(w[b].qs);
+        const int8x16_t lo = vsubq_s8(vreinterpretq_s8_u8(vandq_u8(packed, low_nibbles)), offset);
+        const int8x16_t hi = vsubq_s8(vreinterpretq_s8_u8(vshrq_n_u8(packed, 4)), offset);
+        const int32x4_t sum = DotBlock(lo, hi, vld1q_s8(x[b].qs), vld1q_s8(x[b].qs + 16));
+        acc = vmlaq_n_f32(acc, vcvtq_f32_s32(sum), d);
+    }
+    return HorizontalSum(acc);
+}
+
+#endif  // __ARM_NEON
+
+struct Backend {
+    float (*dot_q8_0)(const BlockQ8_0*, const BlockQ8_0*, int32_t);
+    float (*dot_q4_0)(const BlockQ4_0*, const BlockQ8_0*, int32_t);
+    const char* name;
+};
+
+const Backend& SelectedBackend() {
+    static const Backend backend = []() -> Backend {
+#if defined(__ARM_NEON)
+#if defined(__ARM_FEATURE_DOTPROD)
+        return {VecDotQ8_0Neon, VecDotQ4_0Neon, "neon-dotprod"};
+#else
+        return {VecDotQ8_0Neon, VecDotQ4_0Neon, "neon"};
+#endif
+#else
+#if defined(AI_BRIDGE_X86_KERNELS)
+        const CpuFeatures& cpu = GetCpuFeatures();
+        if (cpu.avx2 && cpu.fma && cpu.f16c) return {VecDotQ8_0Avx2, VecDotQ4_0Avx2, "avx2"};
+#endif
+        return {VecDotQ8_0Scalar, VecDotQ4_0Scalar, "scalar"};
+#endif
+    }();
+    return backend;
+}
+
+}  // namespace
+
+bool IsSupportedTensorType(TensorType type) {
+    return type == TensorType::kF32 || type == TensorType::kQ8_0 || type == TensorType::kQ4_0;
+}
+
+bool IsQuantized(TensorType type) { return type == TensorType::kQ8_0 || type == TensorType::kQ4_0; }
+
+const char* TensorTypeName(TensorType type) {
+    switch (type) {
+        case TensorType::kF32:
+            return "f32";
+        case TensorType::kF16:
+            return "f16";
+        case TensorType::kQ8_0:
+            return "q8_0";
+        case TensorType::kQ4_0:
+            return "q4_0";
+    }
+    return "unknown";
+}
+
+size_t RowBytes(TensorType type, int64_t n) {
+    const size_t count = static_cast<size_t>(n);
+    switch (type) {
+        case TensorType::kF32:
+            return count * sizeof(float);
+        case TensorType::kF16:
+            return count * sizeof(uint16_t);
+        case TensorType::kQ8_0:
+            return count / kQuantBlock * sizeof(BlockQ8_0);
+        case TensorType::kQ4_0:
+            return count / kQuantBlock * sizeof(BlockQ4_0);
+    }
+    return 0;
+}
+
+float Fp16ToFloat(uint16_t h) {
+    const uint32_t sign = static_cast<uint32_t>(h & 0x8000) << 16;
+    const uint32_t exponent = (h >> 10) & 0x1f;
+    const uint32_t mantissa = h & 0x3ff;
+    if (exponent == 0) {
+        // Zero or subnormal: mantissa * 2^-24.
+        const float magnitude = static_cast<float>(mantissa) * 5.9604645e-8f;
+        return sign != 0 ? -magnitude : magnitude;
+    }
+    if (exponent == 31) return BitsFloat(sign | 0x7f800000u | (mantissa << 13));
+    return BitsFloat(sign | ((exponent + 112) << 23) | (mantissa << 13));
+}
+
+uint16_t FloatToFp16(float f) {
+    const uint32_t bits = FloatBits(f);
+    const uint32_t sign = (bits >> 16) & 0x8000;
+    if ((bits & 0x7fffffff) > 0x7f800000) return static_cast<uint16_t>(sign | 0x7e00);  // NaN
+    const int32_t exponent = static_cast<int32_t>((bits >> 23) & 0xff) - 127 + 15;
+    uint32_t mantissa = bits & 0x7fffff;
+    if (exponent >= 31) return static_cast<uint16_t>(sign | 0x7c00);
+    if (exponent <= 0) {
+        if (exponent < -10) return static_cast<uint16_t>(sign);
+        mantissa |= 0x800000;
+        const int32_t shift = 14 - exponent;
+        uint32_t half = mantissa >> shift;
+        const uint32_t rest = mantissa & ((1u << shift) - 1);
+        const uint32_t halfway = 1u << (shift - 1);
+        if (rest > halfway || (rest == halfway && (half & 1) != 0)) ++half;
+        return static_cast<uint16_t>(sign | half);
+    }
+    // A carry out of the mantissa correctly bumps the exponent, up to inf.
+    uint32_t half = (static_cast<uint32_t>(exponent) << 10) | (mantissa >> 13);
+    const uint32_t rest = mantissa & 0x1fff;
+    if (rest > 0x1000 || (rest == 0x1000 && (half & 1) != 0)) ++half;
+    return static_cast<uint16_t>(sign | half);
+}
+
+void QuantizeRow(TensorType type, const float* src, void* dst, int64_t n) {
+    const int64_t blocks = n / kQuantBlock;
+    switch (type) {
+        case TensorType::kF32:
+            std::memcpy(dst, src, static_cast<size_t>(n) * sizeof(float));
+            break;
+        case TensorType::kQ8_0:
+            for (int64_t b = 0; b < blocks; ++b) {
+                QuantizeBlockQ8_0(src + b * kQuantBlock, static_cast<BlockQ8_0*>(dst) + b);
+            }
+            break;
+        case TensorType::kQ4_0:
+            for (int64_t b = 0; b < blocks; ++b) {
+                QuantizeBlockQ4_0(src + b * kQuantBlock, static_cast<BlockQ4_0*>(dst) + b);
+            }
+            break;
+        case TensorType::kF16:
+            for (int64_t i = 0; i < n; ++i) static_cast<uint16_t*>(dst)[i] = FloatToFp16(src[i]);
+            break;
+    }
+}
+
+void DequantizeRow(TensorType type, const void* src, float* dst, int64_t n) {
+    const int64_t blocks = n / kQuantBlock;
+    switch (type) {
+        case TensorType::kF32:
+            std::memcpy(dst, src, static_cast<size_t>(n) * sizeof(float));
+            break;
+        case TensorType::kQ8_0:
+            for (int64_t b = 0; b < blocks; ++b) {
+                const BlockQ8_0& block = static_cast<const BlockQ8_0*>(src)[b];
+                const float d = Fp16ToFloat(block.d);
+                for (int32_t j = 0; j < kQuantBlock; ++j) dst[b * kQuantBlock + j] = d * block.qs[j];
+            }
+            break;
+        case TensorType::kQ4_0:
+            for (int64_t b = 0; b < blocks; ++b) {
+                const BlockQ4_0& block = static_cast<const BlockQ4_0*>(src)[b];
+                const float d = Fp16ToFloat(block.d);
+                float* out = dst + b * kQuantBlock;
+                for (int32_t j = 0; j < kQuantBlock / 2; ++j) {
+                    out[j] = d * static_cast<float>((block.qs[j] & 0x0f) - 8);
+                    out[j + kQuantBlock / 2] = d * static_cast<float>((block.qs[j] >> 4) - 8);
+                }
+            }
+            break;
+        case TensorType::kF16:
+            for (int64_t i = 0; i < n; ++i) dst[i] = Fp16ToFloat(static_cast<const uint16_t*>(src)[i]);
+            break;
+    }
+}
+
+float VecDotQ8_0Scalar(const BlockQ8_0* w, const BlockQ8_0* x, int32_t blocks) {
+    float sum = 0.0f;
+    for (int32_t b = 0; b < blocks; ++b) {
+        int32_t dot = 0;
+        for (int32_t j = 0; j < kQuantBlock; ++j) dot += w[b].qs[j] * x[b].qs[j];
+        sum += Fp16ToFloat(w[b].d) * Fp16ToFloat(x[b].d) * static_cast<float>(dot);
+    }
+    return sum;
+}
+
+float VecDotQ4_0Scalar(const BlockQ4_0* w, const BlockQ8_0* x, int32_t blocks) {
+    float sum = 0.0f;
+    for (int32_t b = 0; b < blocks; ++b) {
+        int32_t dot = 0;
+        for (int32_t j = 0; j < kQuantBlock / 2; ++j) {
+            dot += ((w[b].qs[j] & 0x0f) - 8) * x[b].qs[j];
+            dot += ((w[b].qs[j] >> 4) - 8) * x[b].qs[j + kQuantBlock / 2];
+        }
+        sum += Fp16ToFloat(w[b].d) * Fp16ToFloat(x[b].d) * static_cast<float>(dot);
+    }
+    return sum;
+}
+
+float VecDotQ8_0(const BlockQ8_0* w, const BlockQ8_0* x, int32_t blocks) {
+    return SelectedBackend().dot_q8_0(w, x, blocks);
+}
+
+float VecDotQ4_0(const BlockQ4_0* w, const BlockQ8_0* x, int32_t blocks) {
+    return SelectedBackend().dot_q4_0(w, x, blocks);
+}
+
+const char* QuantKernelBackend() { return SelectedBackend().name; }
+
+}  // namespace ai_bridge
@@ -0,0 +1,67 @@
+#ifndef AI_BRIDGE_LLM_QUANT_H_
+#define AI_BRIDGE_LLM_QUANT_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "llm/model_file.h"
+
+namespace ai_bridge {
+
+// Block-quantized weight formats, laid out as ggml stores them so model
+// files can carry either. A row is split into blocks of kQuantBlock
+// elements that share one float16 scale:
+//
+//   Q8_0  x = d * q, q in [-127, 127]                       8.5 bits/weight
+//   Q4_0  x = d * (q - 8), q in [0, 15], two per byte       4.5 bits/weight
+//         (byte j holds element j in its low nibble and element j + 16 in
+//         its high one)
+//
+// Quantized matrices multiply vectors quantized to Q8_0, so the inner loop
+// is an int8 dot product and the scales are applied once per block.
+constexpr int32_t kQuantBlock = 32;
+
+struct BlockQ8_0 {
+    uint16_t d;  // float16
+    int8_t qs[kQuantBlock];
+};
+static_assert(sizeof(BlockQ8_0) == 34, "BlockQ8_0 layout is part of the file format");
+
+struct BlockQ4_0 {
+    uint16_t d;  // float16
+    uint8_t qs[kQuantBlock / 2];
+};
+static_assert(sizeof(BlockQ4_0) == 18, "BlockQ4_0 layout is part of the file format");
+
+// True for the types the kernels below handle (F32, Q8_0, Q4_0).
+bool IsSupportedTensorType(TensorType type);
+bool IsQuantized(TensorType type);
+// "f32", "f16", "q8_0", "q4_0".
+const char* TensorTypeName(TensorType type);
+// Bytes of a row of `n` elements; quantized rows need n % kQuantBlock == 0.
+size_t RowBytes(TensorType type, int64_t n);
+
+float Fp16ToFloat(uint16_t h);
+// Rounds to nearest even.
+uint16_t FloatToFp16(float f);
+
+// Quantizes `n` floats (a multiple of kQuantBlock) to `type`, writing
+// RowBytes(type, n) bytes.
+void QuantizeRow(TensorType type, const float* src, void* dst, int64_t n);
+void DequantizeRow(TensorType type, const void* src, float* dst, int64_t n);
+
+// Dot products of `blocks` blocks of a quantized weight row with an input
+// quantized to Q8_0. Vectorized with AVX2 on x86 (chosen at runtime) and
+// NEON, using the int8 dot-product instructions where the target has them,
+// on ARM.
+float VecDotQ8_0(const BlockQ8_0* w, const BlockQ8_0* x, int32_t blocks);
+float VecDotQ4_0(const BlockQ4_0* w, const BlockQ8_0* x, int32_t blocks);
+// The portable references the SIMD paths must match.
+float VecDotQ8_0Scalar(const BlockQ8_0* w, const BlockQ8_0* x, int32_t blocks);
+float VecDotQ4_0Scalar(const BlockQ4_0* w, const BlockQ8_0* x, int32_t blocks);
+// "avx2", "neon-dotprod", "neon" or "scalar": the path the kernels take.
+const char* QuantKernelBackend();
+
+}  // namespace ai_bridge
+
+#endif  // AI_BRIDGE_LLM_QUANT_H_
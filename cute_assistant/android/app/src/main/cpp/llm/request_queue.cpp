@@ -0,0 +1,144 @@
+#include "llm/request_queue.h"
+
+#include <algorithm>
+
+#include "core/metrics.h"
+
+namespace ai_bridge {
+
+namespace {
+
+// std::*_heap keeps the "largest" element at the front, so a request compares
+// lower when it should be served later.
+bool ServedLater(const LlmRequest& a, const LlmRequest& b) {
+    if (a.priority != b.priority) return a.priority < b.priority;
+    return a.sequence > b.sequence;
+}
+
+}  // namespace
+
+LlmRequestQueue::LlmRequestQueue(size_t capacity) : capacity_(capacity) {
+    heap_.reserve(capacity_);
+}
+
+LlmRequestQueue::PushResult LlmRequestQueue::push(std::string text, int32_t priority, int64_t session_id, int64_t* out_id) {
+    if (out_id != nullptr) *out_id = kInvalidRequestId;
+
+    LlmRequest request;
+    request.session_id = session_id;
+    request.priority = priority;
+    request.text = std::move(text);
+    request.cancel_token = std::make_shared<CancellationToken>();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (closed_) return PushResult::kClosed;
+        if (heap_.size() >= capacity_) return PushResult::kFull;
+        request.id = next_id_.fetch_add(1, std::memory_order_relaxed);
+        request.sequence = next_sequence_++;
+        request.enqueued_at = std::chrono::steady_clock::now();
+        if (out_id != nullptr) *out_id = request.id;
+        heap_.push_back(std::move(request));
+        std::push_heap(heap_.begin(), heap_.end(), ServedLater);
+        Metrics().set(MetricGauge::kQueueDepth, static_cast<int64_t>(heap_.size()));
+    }
+    cv_.notify_one();
+    return PushResult::kQueued;
+}
+
+bool LlmRequestQueue::pop(LlmRequest* out, size_t* out_depth_after) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this] { return !heap_.empty() || closed_; });
+    if (heap_.empty()) return false;
+    pop_locked(out, out_depth_after);
+    return true;
+}
+
+bool LlmRequestQueue::try_pop(LlmRequest* out, size_t* out_depth_after) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (heap_.empty()) return false;
+    pop_locked(out, out_depth_after);
+    return true;
+}
+
+void LlmRequestQueue::pop_locked(LlmRequest* out, size_t* out_depth_after) {
+    std::pop_heap(heap_.begin(), heap_.end(), ServedLater);
+    *out = std::move(heap_.back());
+    heap_.pop_back();
+    if (out_depth_after != nullptr) *out_depth_after = heap_.size();
+    Metrics().set(MetricGauge::kQueueDepth, static_cast<int64_t>(heap_.size()));
+
+    LlmRequest active;
+    active.id = out->id;
+    active.session_id = out->session_id;
+    active.cancel_token = out->cancel_token;
+    active_.push_back(std::move(active));
+}
+
+void LlmRequestQueue::finish(int64_t id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    active_.erase(std::remove_if(active_.begin(), active_.end(),
+                                 [id](const LlmRequest& request) { return request.id == id; }),
+                  active_.end());
+}
+
+bool LlmRequestQueue::cancel(int64_t id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (std::vector<LlmRequest>* requests : {&active_, &heap_}) {
+        for (LlmRequest& request : *requests) {
+            if (request.id == id) {
+                request.cancel_token->cancel();
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+size_t LlmRequestQueue::cancel_all() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t cancelled = 0;
+    for (std::vector<LlmRequest>* requests : {&active_, &heap_}) {
+        for (LlmRequest& request : *requests) {
+            if (!request.cancel_token->is_cancelled()) ++cancelled;
+            request.cancel_token->cancel();
+        }
+    }
+    return cancelled;
+}
+
+size_t LlmRequestQueue::cancel_session(int64_t session_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t cancelled = 0;
+    for (std::vector<LlmRequest>* requests : {&active_, &heap_}) {
+        for (LlmRequest& request : *requests) {
+            if (request.session_id != session_id) continue;
+            if (!request.cancel_token->is_cancelled()) ++cancelled;
+            request.cancel_token->cancel();
+        }
+    }
+    return cancelled;
+}
+
+void LlmRequestQueue::close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+        for (LlmRequest& request : heap_) request.cancel_token->cancel();
+        for (LlmRequest& request : active_) request.cancel_token->cancel();
+        heap_.clear();
+        Metrics().set(MetricGauge::kQueueDepth, 0);
+    }
+    cv_.notify_all();
+}
+
+void LlmRequestQueue::reopen() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    closed_ = false;
+}
+
+size_t LlmRequestQueue::depth() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return heap_.size();
+}
+
+}  // namespace ai_bridge
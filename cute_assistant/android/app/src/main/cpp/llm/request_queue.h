@@ -0,0 +1,108 @@
+#ifndef AI_BRIDGE_LLM_REQUEST_QUEUE_H_
+#define AI_BRIDGE_LLM_REQUEST_QUEUE_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace ai_bridge {
+
+// Request ids are positive; 0 means "not queued".
+constexpr int64_t kInvalidRequestId = 0;
+
+// Shared between whoever may cancel a request and the thread serving it.
+struct CancellationToken {
+    std::atomic<bool> cancelled{false};
+    // steady_clock time of the first cancel(), for abort-latency metrics.
+    std::atomic<int64_t> cancelled_at_us{0};
+
+    void cancel() {
+        if (cancelled.exchange(true, std::memory_order_acq_rel)) return;
+        cancelled_at_us.store(NowMicros(), std::memory_order_release);
+    }
+    bool is_cancelled() const { return cancelled.load(std::memory_order_acquire); }
+
+    static int64_t NowMicros() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+};
+
+struct LlmRequest {
+    int64_t id = kInvalidRequestId;
+    int64_t session_id = 0;  // conversation the request continues
+    int32_t priority = 0;    // higher is served first
+    std::string text;
+    std::shared_ptr<CancellationToken> cancel_token;
+    std::chrono::steady_clock::time_point enqueued_at;
+    uint64_t sequence = 0;  // FIFO order among equal priorities
+};
+
+// Bounded multi-producer/single-consumer queue of LLM requests.
+//
+// Any thread may push (FFI calls arrive on the Dart mutator thread, host load
+// generators use several); only the LLM thread pops. Requests are served by
+// descending priority, then in arrival order. A full queue rejects the new
+// request instead of overwriting an older one.
+//
+// The queue also tracks the requests the consumer is serving (from pop()
+// until finish()), so cancel() reaches a request wherever it is. Cancelled
+// requests stay queued; the consumer pops them and reports them cancelled
+// without running them.
+class LlmRequestQueue {
+public:
+    static constexpr size_t kDefaultCapacity = 32;
+
+    enum class PushResult { kQueued, kFull, kClosed };
+
+    explicit LlmRequestQueue(size_t capacity = kDefaultCapacity);
+
+    // Assigns the id, sequence, timestamp and cancellation token.
+    PushResult push(std::string text, int32_t priority, int64_t session_id, int64_t* out_id);
+
+    // Blocks until a request is available or the queue is closed and empty.
+    // The popped request counts as active until finish(id).
+    bool pop(LlmRequest* out, size_t* out_depth_after);
+    // Like pop(), but returns false at once when nothing is queued.
+    bool try_pop(LlmRequest* out, size_t* out_depth_after);
+    void finish(int64_t id);
+
+    // Cancels one pending or active request. Returns false for unknown or
+    // already finished ids.
+    bool cancel(int64_t id);
+    // Cancels every pending and active request; returns how many.
+    size_t cancel_all();
+    // Same, limited to the requests of one session.
+    size_t cancel_session(int64_t session_id);
+
+    // Rejects further pushes, cancels and discards everything pending, and
+    // wakes the consumer.
+    void close();
+    void reopen();
+
+    size_t depth() const;
+    size_t capacity() const { return capacity_; }
+
+private:
+    void pop_locked(LlmRequest* out, size_t* out_depth_after);
+
+    const size_t capacity_;
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::vector<LlmRequest> heap_;
+    std::vector<LlmRequest> active_;  // id, session_id and cancel_token only
+    bool closed_ = false;
+    uint64_t next_sequence_ = 0;
+    std::atomic<int64_t> next_id_{1};
+};
+
+}  // namespace ai_bridge
+
+#endif  // AI_BRIDGE_LLM_REQUEST_QUEUE_H_
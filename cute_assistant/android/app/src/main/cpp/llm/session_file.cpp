@@ -0,0 +1,233 @@
+#include "llm/session_file.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+namespace ai_bridge {
+
+namespace {
+
+uint64_t AlignUp(uint64_t offset) {
+    return (offset + kSessionFileAlignment - 1) / kSessionFileAlignment * kSessionFileAlignment;
+}
+
+uint64_t TokenBytes(size_t count) { return static_cast<uint64_t>(count) * sizeof(LlmToken); }
+
+// Writes `size` bytes at the current position, then zero padding up to
+// `section_end`.
+bool WriteSection(FILE* file, const void* data, uint64_t size, uint64_t section_end) {
+    static const uint8_t kZeros[kSessionFileAlignment] = {};
+    if (size > 0 && fwrite(data, 1, size, file) != size) return false;
+    const off_t position = ftello(file);
+    if (position < 0) return false;
+    uint64_t padding = section_end - static_cast<uint64_t>(position);
+    while (padding > 0) {
+        const size_t chunk = padding < sizeof(kZeros) ? static_cast<size_t>(padding) : sizeof(kZeros);
+        if (fwrite(kZeros, 1, chunk, file) != chunk) return false;
+        padding -= chunk;
+    }
+    return true;
+}
+
+std::string ErrnoMessage(const std::string& what, const std::string& path) {
+    return what + " " + path + ": " + std::strerror(errno);
+}
+
+}  // namespace
+
+void SessionFileWriter::add_session(int64_t session_id, uint64_t last_used, const std::vector<LlmToken>& tokens,
+                                    const std::vector<LlmToken>& pending) {
+    sessions_.push_back({session_id, last_used, &tokens, &pending});
+}
+
+void SessionFileWriter::add_slot(int64_t session_id, uint64_t last_used, int32_t seq_id,
+                                 const std::vector<LlmToken>& tokens, const LlmEngine* engine) {
+    slots_.push_back({session_id, last_used, seq_id, &tokens, engine});
+}
+
+uint64_t SessionFileWriter::write(const std::string& path, std::string* error) const {
+    SessionFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, kSessionFileMagic, sizeof(header.magic));
+    header.version = kSessionFileVersion;
+    header.header_size = sizeof(SessionFileHeader);
+    header.model_fingerprint = model_fingerprint_;
+    header.session_count = static_cast<uint32_t>(sessions_.size());
+    header.slot_count = static_cast<uint32_t>(slots_.size());
+    header.token_size = sizeof(LlmToken);
+
+    // Lay out the tables, then every data section on an aligned offset.
+    std::vector<SessionFileSession> session_table(sessions_.size());
+    std::vector<SessionFileSlot> slot_table(slots_.size());
+    const uint64_t tables_end = AlignUp(sizeof(SessionFileHeader) + sizeof(SessionFileSession) * sessions_.size() +
+                                        sizeof(SessionFileSlot) * slots_.size());
+    uint64_t offset = tables_end;
+    for (size_t i = 0; i < sessions_.size(); ++i) {
+        const Session& session = sessions_[i];
+        SessionFileSession& entry = session_table[i];
+        entry.session_id = session.session_id;
+        entry.last_used = session.last_used;
+        entry.token_count = static_cast<uint32_t>(session.tokens->size());
+        entry.pending_count = static_cast<uint32_t>(session.pending->size());
+        entry.tokens_offset = offset;
+        offset = AlignUp(offset + TokenBytes(session.tokens->size()));
+        entry.pending_offset = offset;
+        offset = AlignUp(offset + TokenBytes(session.pending->size()));
+    }
+    for (size_t i = 0; i < slots_.size(); ++i) {
+        const Slot& slot = slots_[i];
+        SessionFileSlot& entry = slot_table[i];
+        entry.session_id = slot.session_id;
+        entry.last_used = slot.last_used;
+        entry.seq_id = slot.seq_id;
+        entry.token_count = static_cast<uint32_t>(slot.tokens->size());
+        entry.tokens_offset = offset;
+        offset = AlignUp(offset + TokenBytes(slot.tokens->size()));
+        entry.state_offset = offset;
+        entry.state_size = slot.engine->state_seq_size(slot.seq_id);
+        offset = AlignUp(offset + entry.state_size);
+    }
+    header.file_size = offset;
+
+    const std::string temp_path = path + ".tmp";
+    FILE* file = std::fopen(temp_path.c_str(), "wb");
+    if (file == nullptr) {
+        *error = ErrnoMessage("Cannot create", temp_path);
+        return 0;
+    }
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    if (ok && !session_table.empty()) {
+        ok = fwrite(session_table.data(), sizeof(SessionFileSession), session_table.size(), file) == session_table.size();
+    }
+    if (ok && !slot_table.empty()) {
+        ok = fwrite(slot_table.data(), sizeof(SessionFileSlot), slot_table.size(), file) == slot_table.size();
+    }
+    ok = ok && WriteSection(file, nullptr, 0, tables_end);
+    for (size_t i = 0; ok && i < sessions_.size(); ++i) {
+        const Session& session = sessions_[i];
+        const SessionFileSession& entry = session_table[i];
+        ok = WriteSection(file, session.tokens->data(), TokenBytes(session.tokens->size()), entry.pending_offset) &&
+             WriteSection(file, session.pending->data(), TokenBytes(session.pending->size()),
+                          AlignUp(entry.pending_offset + TokenBytes(session.pending->size())));
+    }
+    std::vector<uint8_t> state;
+    for (size_t i = 0; ok && i < slots_.size(); ++i) {
+        const Slot& slot = slots_[i];
+        const SessionFileSlot& entry = slot_table[i];
+        state.resize(static_cast<size_t>(entry.state_size));
+        if (slot.engine->state_seq_get(slot.seq_id, state.data(), state.size()) != state.size()) {
+            std::fclose(file);
+            std::remove(temp_path.c_str());
+            *error = "LLM engine failed to serialize KV sequence " + std::to_string(slot.seq_id);
+            return 0;
+        }
+        ok = WriteSection(file, slot.tokens->data(), TokenBytes(slot.tokens->size()), entry.state_offset) &&
+             WriteSection(file, state.data(), state.size(), AlignUp(entry.state_offset + entry.state_size));
+    }
+    ok = ok && std::fflush(file) == 0 && fsync(fileno(file)) == 0;
+    if (!ok) *error = ErrnoMessage("Cannot write", temp_path);
+    if (std::fclose(file) != 0 && ok) {
+        ok = false;
+        *error = ErrnoMessage("Cannot write", temp_path);
+    }
+    if (ok && std::rename(temp_path.c_str(), path.c_str()) != 0) {
+        ok = false;
+        *error = ErrnoMessage("Cannot replace", path);
+    }
+    if (!ok) {
+        std::remove(temp_path.c_str());
+        return 0;
+    }
+    return header.file_size;
+}
+
+MappedSessionFile::~MappedSessionFile() {
+    if (data_ != nullptr) munmap(const_cast<uint8_t*>(data_), size_);
+}
+
+bool MappedSessionFile::open(const std::string& path, std::string* error) {
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        *error = ErrnoMessage("Cannot open", path);
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        *error = ErrnoMessage("Cannot stat", path);
+        ::close(fd);
+        return false;
+    }
+    if (static_cast<uint64_t>(info.st_size) < sizeof(SessionFileHeader)) {
+        *error = path + " is not an LLM session file";
+        ::close(fd);
+        return false;
+    }
+    size_ = static_cast<size_t>(info.st_size);
+    void* mapping = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);  // the mapping keeps the file alive
+    if (mapping == MAP_FAILED) {
+        *error = ErrnoMessage("Cannot map", path);
+        size_ = 0;
+        return false;
+    }
+    data_ = static_cast<const uint8_t*>(mapping);
+    // Everything is read right away; start paging it in.
+    madvise(mapping, size_, MADV_WILLNEED);
+    if (!validate(error)) {
+        *error = path + ": " + *error;
+        return false;
+    }
+    return true;
+}
+
+bool MappedSessionFile::section_fits(uint64_t offset, uint64_t bytes) const {
+    return offset % kSessionFileAlignment == 0 && offset <= size_ && bytes <= size_ - offset;
+}
+
+bool MappedSessionFile::validate(std::string* error) const {
+    const SessionFileHeader& file = header();
+    if (std::memcmp(file.magic, kSessionFileMagic, sizeof(file.magic)) != 0) {
+        *error = "not an LLM session file";
+        return false;
+    }
+    if (file.version != kSessionFileVersion || file.header_size != sizeof(SessionFileHeader) ||
+        file.token_size != sizeof(LlmToken)) {
+        *error = "unsupported session file version " + std::to_string(file.version);
+        return false;
+    }
+    if (file.file_size != size_) {
+        *error = "truncated session file";
+        return false;
+    }
+    const uint64_t tables = sizeof(SessionFileHeader) + sizeof(SessionFileSession) * uint64_t{file.session_count} +
+                            sizeof(SessionFileSlot) * uint64_t{file.slot_count};
+    if (tables > size_) {
+        *error = "corrupt session table";
+        return false;
+    }
+    for (uint32_t i = 0; i < file.session_count; ++i) {
+        const SessionFileSession& session = sessions()[i];
+        if (session.session_id < 0 || !section_fits(session.tokens_offset, TokenBytes(session.token_count)) ||
+            !section_fits(session.pending_offset, TokenBytes(session.pending_count))) {
+            *error = "corrupt session entry " + std::to_string(i);
+            return false;
+        }
+    }
+    for (uint32_t i = 0; i < file.slot_count; ++i) {
+        const SessionFileSlot& slot = slots()[i];
+        if (slot.seq_id < 0 || !section_fits(slot.tokens_offset, TokenBytes(slot.token_count)) ||
+            !section_fits(slot.state_offset, slot.state_size)) {
+            *error = "corrupt KV slot entry " + std::to_string(i);
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace ai_bridge
@@ -0,0 +1,136 @@
+#ifndef AI_BRIDGE_LLM_SESSION_FILE_H_
+#define AI_BRIDGE_LLM_SESSION_FILE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "llm/llm_engine.h"
+
+namespace ai_bridge {
+
+// On-disk snapshot of the LLM scheduler: every remembered conversation's
+// token history and the engine KV state of every KV slot.
+//
+// Layout (native byte order, which is little-endian on every supported ABI):
+//
+//   SessionFileHeader
+//   SessionFileSession[session_count]
+//   SessionFileSlot[slot_count]
+//   data sections: token arrays and engine state blobs
+//
+// Every data section starts on a kSessionFileAlignment boundary and every
+// offset is from the start of the file, so a mapped file is used in place:
+// resuming costs one mmap plus whatever the engine does with its state blobs.
+// The version changes whenever the layout does; files written by another
+// version or another model are refused rather than migrated.
+constexpr char kSessionFileMagic[8] = {'A', 'I', 'B', 'S', 'E', 'S', 'S', '\0'};
+constexpr uint32_t kSessionFileVersion = 1;
+constexpr size_t kSessionFileAlignment = 64;
+
+struct SessionFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;         // sizeof(SessionFileHeader)
+    uint64_t model_fingerprint;   // LlmEngine::model_fingerprint() of the writer
+    uint64_t file_size;
+    uint32_t session_count;
+    uint32_t slot_count;
+    uint32_t token_size;          // sizeof(LlmToken)
+    uint32_t reserved[5];
+};
+static_assert(sizeof(SessionFileHeader) == 64, "SessionFileHeader layout is part of the file format");
+
+struct SessionFileSession {
+    int64_t session_id;
+    uint64_t last_used;           // LRU order among sessions
+    uint64_t tokens_offset;       // conversation so far
+    uint64_t pending_offset;      // tokens owed to the cache by the last reply
+    uint32_t token_count;
+    uint32_t pending_count;
+};
+static_assert(sizeof(SessionFileSession) == 40, "SessionFileSession layout is part of the file format");
+
+struct SessionFileSlot {
+    int64_t session_id;           // -1 for a slot holding only a shared prefix
+    uint64_t last_used;
+    uint64_t tokens_offset;       // what the slot's cache holds
+    uint64_t state_offset;        // LlmEngine::state_seq_get() blob
+    uint64_t state_size;
+    int32_t seq_id;
+    uint32_t token_count;
+};
+static_assert(sizeof(SessionFileSlot) == 48, "SessionFileSlot layout is part of the file format");
+
+// Collects a snapshot and writes it in one pass. The token vectors are
+// referenced, not copied; they must outlive write().
+class SessionFileWriter {
+public:
+    explicit SessionFileWriter(uint64_t model_fingerprint) : model_fingerprint_(model_fingerprint) {}
+
+    void add_session(int64_t session_id, uint64_t last_used, const std::vector<LlmToken>& tokens,
+                     const std::vector<LlmToken>& pending);
+    // `engine` is asked for sequence `seq_id`'s state while writing.
+    void add_slot(int64_t session_id, uint64_t last_used, int32_t seq_id, const std::vector<LlmToken>& tokens,
+                  const LlmEngine* engine);
+
+    // Writes to `path` + ".tmp" and renames it over `path`, so a crash never
+    // leaves a torn snapshot behind. Returns the file size, or 0 with `error`
+    // set.
+    uint64_t write(const std::string& path, std::string* error) const;
+
+private:
+    struct Session {
+        int64_t session_id;
+        uint64_t last_used;
+        const std::vector<LlmToken>* tokens;
+        const std::vector<LlmToken>* pending;
+    };
+    struct Slot {
+        int64_t session_id;
+        uint64_t last_used;
+        int32_t seq_id;
+        const std::vector<LlmToken>* tokens;
+        const LlmEngine* engine;
+    };
+
+    const uint64_t model_fingerprint_;
+    std::vector<Session> sessions_;
+    std::vector<Slot> slots_;
+};
+
+// Read-only mapping of a session file. open() validates the header and every
+// table entry, so the accessors can be trusted without further bounds checks.
+class MappedSessionFile {
+public:
+    MappedSessionFile() = default;
+    ~MappedSessionFile();
+
+    MappedSessionFile(const MappedSessionFile&) = delete;
+    MappedSessionFile& operator=(const MappedSessionFile&) = delete;
+
+    bool open(const std::string& path, std::string* error);
+
+    const SessionFileHeader& header() const { return *reinterpret_cast<const SessionFileHeader*>(data_); }
+    const SessionFileSession* sessions() const {
+        return reinterpret_cast<const SessionFileSession*>(data_ + sizeof(SessionFileHeader));
+    }
+    const SessionFileSlot* slots() const {
+        return reinterpret_cast<const SessionFileSlot*>(sessions() + header().session_count);
+    }
+    const LlmToken* tokens_at(uint64_t offset) const { return reinterpret_cast<const LlmToken*>(data_ + offset); }
+    const uint8_t* bytes_at(uint64_t offset) const { return data_ + offset; }
+    size_t size() const { return size_; }
+
+private:
+    bool validate(std::string* error) const;
+    bool section_fits(uint64_t offset, uint64_t bytes) const;
+
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+}  // namespace ai_bridge
+
+#endif  // AI_BRIDGE_LLM_SESSION_FILE_H_
@@ -0,0 +1,184 @@
+#include "llm/sim_engine.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <utility>
+
+namespace ai_bridge {
+
+namespace {
+
+// Large enough that any temperature/top-p sampler still picks the scripted
+// token.
+constexpr float kScriptedLogit = 30.0f;
+
+}  // namespace
+
+SimLlmEngine::SimLlmEngine(int32_t max_sequences, int32_t context_length)
+    : context_length_(context_length),
+      sequences_(static_cast<size_t>(std::max(1, max_sequences))),
+      decode_step_us_(SimEngineTiming().decode_step_us),
+      per_token_us_(SimEngineTiming().per_token_us) {
+    special_.bos = kByteTokens;
+    special_.eos = kByteTokens + 1;
+    special_.user_turn = kByteTokens + 2;
+    special_.assistant_turn = kByteTokens + 3;
+}
+
+void SimLlmEngine::set_timing(const SimEngineTiming& timing) {
+    decode_step_us_.store(std::max(0, timing.decode_step_us), std::memory_order_relaxed);
+    per_token_us_.store(std::max(0, timing.per_token_us), std::memory_order_relaxed);
+}
+
+void SimLlmEngine::tokenize(const std::string& text, std::vector<LlmToken>* out) const {
+    out->reserve(out->size() + text.size());
+    for (unsigned char c : text) out->push_back(c);
+}
+
+std::string SimLlmEngine::token_to_piece(LlmToken token) const {
+    if (token < 0 || token >= kByteTokens) return std::string();
+    return std::string(1, static_cast<char>(token));
+}
+
+void SimLlmEngine::refresh_reply(Sequence* sequence) const {
+    sequence->reply.clear();
+    if (sequence->assistant_pos < 0) return;
+    // The user text is everything between the preceding user_turn and the
+    // assistant_turn.
+    int32_t start = sequence->assistant_pos;
+    while (start > 0 && sequence->tokens[start - 1] != special_.user_turn) --start;
+    std::string user_text;
+    for (int32_t i = start; i < sequence->assistant_pos; ++i) {
+        if (sequence->tokens[i] < kByteTokens) user_text.push_back(static_cast<char>(sequence->tokens[i]));
+    }
+    sequence->reply = "LLM got: " + user_text + ". Thinking... Response part 1. Response part 2.\n";
+}
+
+LlmToken SimLlmEngine::next_token(const Sequence& sequence, int32_t length) const {
+    if (sequence.assistant_pos < 0 || sequence.assistant_pos >= length) return special_.eos;
+    const size_t generated = static_cast<size_t>(length - 1 - sequence.assistant_pos);
+    if (generated >= sequence.reply.size()) return special_.eos;
+    return static_cast<unsigned char>(sequence.reply[generated]);
+}
+
+bool SimLlmEngine::decode(const LlmBatch& batch) {
+    // Validate first so a bad batch leaves every cache untouched.
+    std::vector<int32_t> lengths(sequences_.size());
+    for (size_t s = 0; s < sequences_.size(); ++s) lengths[s] = static_cast<int32_t>(sequences_[s].tokens.size());
+    for (int32_t i = 0; i < batch.size(); ++i) {
+        const int32_t seq = batch.seq_ids[i];
+        if (seq < 0 || seq >= max_sequences()) return false;
+        if (batch.positions[i] != lengths[seq] || lengths[seq] >= context_length_) return false;
+        if (batch.tokens[i] < 0 || batch.tokens[i] >= vocab_size()) return false;
+        ++lengths[seq];
+    }
+
+    logits_rows_.assign(static_cast<size_t>(batch.size()), -1);
+    int32_t rows = 0;
+    for (int32_t i = 0; i < batch.size(); ++i) {
+        if (batch.want_logits[i]) logits_rows_[i] = rows++;
+    }
+    logits_.assign(static_cast<size_t>(rows) * vocab_size(), 0.0f);
+
+    for (int32_t i = 0; i < batch.size(); ++i) {
+        Sequence& sequence = sequences_[batch.seq_ids[i]];
+        sequence.tokens.push_back(batch.tokens[i]);
+        if (batch.tokens[i] == special_.assistant_turn) {
+            sequence.assistant_pos = batch.positions[i];
+            refresh_reply(&sequence);
+        }
+        if (logits_rows_[i] >= 0) {
+            const LlmToken next = next_token(sequence, static_cast<int32_t>(sequence.tokens.size()));
+            logits_[static_cast<size_t>(logits_rows_[i]) * vocab_size() + next] = kScriptedLogit;
+        }
+    }
+
+    const int64_t cost_us = decode_step_us_.load(std::memory_order_relaxed) +
+                            static_cast<int64_t>(per_token_us_.load(std::memory_order_relaxed)) * batch.size();
+    if (cost_us > 0) std::this_thread::sleep_for(std::chrono::microseconds(cost_us));
+    return true;
+}
+
+const float* SimLlmEngine::logits(int32_t batch_index) const {
+    if (batch_index < 0 || batch_index >= static_cast<int32_t>(logits_rows_.size())) return nullptr;
+    const int32_t row = logits_rows_[batch_index];
+    return row < 0 ? nullptr : logits_.data() + static_cast<size_t>(row) * vocab_size();
+}
+
+int32_t SimLlmEngine::kv_seq_length(int32_t seq_id) const {
+    if (seq_id < 0 || seq_id >= max_sequences()) return 0;
+    return static_cast<int32_t>(sequences_[seq_id].tokens.size());
+}
+
+void SimLlmEngine::kv_seq_remove(int32_t seq_id, int32_t p0, int32_t p1) {
+    if (seq_id < 0 || seq_id >= max_sequences()) return;
+    Sequence& sequence = sequences_[seq_id];
+    const int32_t length = static_cast<int32_t>(sequence.tokens.size());
+    if (p1 >= 0 && p1 < length) return;  // only suffixes can be dropped
+    p0 = std::max(0, std::min(p0, length));
+    sequence.tokens.resize(static_cast<size_t>(p0));
+    if (sequence.assistant_pos >= p0) find_assistant_turn(&sequence);
+}
+
+void SimLlmEngine::kv_seq_copy(int32_t src, int32_t dst, int32_t p1) {
+    if (src < 0 || src >= max_sequences() || dst < 0 || dst >= max_sequences() || src == dst) return;
+    const Sequence& from = sequences_[src];
+    Sequence& to = sequences_[dst];
+    if (!to.tokens.empty()) return;
+    p1 = std::max(0, std::min(p1, static_cast<int32_t>(from.tokens.size())));
+    to.tokens.assign(from.tokens.begin(), from.tokens.begin() + p1);
+    find_assistant_turn(&to);
+}
+
+uint64_t SimLlmEngine::model_fingerprint() const {
+    // The "weights" are the vocabulary and the reply script; bump the
+    // revision whenever either changes.
+    constexpr uint64_t kScriptRevision = 1;
+    return (uint64_t{0x53494d} << 40) | (static_cast<uint64_t>(vocab_size()) << 8) | kScriptRevision;
+}
+
+// The state of a sequence is its token array: the scripted reply is derived
+// from it.
+size_t SimLlmEngine::state_seq_size(int32_t seq_id) const {
+    if (seq_id < 0 || seq_id >= max_sequences()) return 0;
+    return sequences_[seq_id].tokens.size() * sizeof(LlmToken);
+}
+
+size_t SimLlmEngine::state_seq_get(int32_t seq_id, uint8_t* dst, size_t size) const {
+    const size_t needed = state_seq_size(seq_id);
+    if (needed == 0 || size < needed) return 0;
+    std::memcpy(dst, sequences_[seq_id].tokens.data(), needed);
+    return needed;
+}
+
+bool SimLlmEngine::state_seq_set(int32_t seq_id, const uint8_t* src, size_t size) {
+    if (seq_id < 0 || seq_id >= max_sequences()) return false;
+    Sequence& sequence = sequences_[seq_id];
+    sequence.tokens.clear();
+    find_assistant_turn(&sequence);
+    const size_t count = size / sizeof(LlmToken);
+    if (size % sizeof(LlmToken) != 0 || count > static_cast<size_t>(context_length_)) return false;
+    std::vector<LlmToken> tokens(count);
+    std::memcpy(tokens.data(), src, size);
+    for (LlmToken token : tokens) {
+        if (token < 0 || token >= vocab_size()) return false;
+    }
+    sequence.tokens = std::move(tokens);
+    find_assistant_turn(&sequence);
+    return true;
+}
+
+void SimLlmEngine::find_assistant_turn(Sequence* sequence) const {
+    sequence->assistant_pos = -1;
+    for (int32_t i = static_cast<int32_t>(sequence->tokens.size()) - 1; i >= 0; --i) {
+        if (sequence->tokens[i] == special_.assistant_turn) {
+            sequence->assistant_pos = i;
+            break;
+        }
+    }
+    refresh_reply(sequence);
+}
+
+}  // namespace ai_bridge
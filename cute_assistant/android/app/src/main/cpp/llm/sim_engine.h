@@ -0,0 +1,79 @@
+#ifndef AI_BRIDGE_LLM_SIM_ENGINE_H_
+#define AI_BRIDGE_LLM_SIM_ENGINE_H_
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include "llm/llm_engine.h"
+
+namespace ai_bridge {
+
+// Cost model for SimLlmEngine::decode(): one call costs
+// decode_step_us + per_token_us * batch size. The fixed part stands for
+// streaming the weights once per step, which is why batching pays off.
+struct SimEngineTiming {
+    int32_t decode_step_us = 20000;
+    int32_t per_token_us = 100;
+};
+
+// Placeholder engine used until a model is loaded.
+//
+// Byte-level vocabulary (tokens 0-255 are bytes, then BOS/EOS/user/assistant)
+// with a real per-sequence token cache, so everything that manages KV state
+// behaves as it would with a model. Its "model" answers every user turn with
+// the reply the original placeholder loop produced, one byte per token, and
+// decode() sleeps according to SimEngineTiming.
+class SimLlmEngine : public LlmEngine {
+public:
+    static constexpr int32_t kByteTokens = 256;
+
+    explicit SimLlmEngine(int32_t max_sequences = 8, int32_t context_length = 8192);
+
+    void set_timing(const SimEngineTiming& timing);
+
+    const char* name() const override { return "sim"; }
+    int32_t vocab_size() const override { return kByteTokens + 4; }
+    int32_t context_length() const override { return context_length_; }
+    int32_t max_sequences() const override { return static_cast<int32_t>(sequences_.size()); }
+    const LlmSpecialTokens& special_tokens() const override { return special_; }
+
+    void tokenize(const std::string& text, std::vector<LlmToken>* out) const override;
+    std::string token_to_piece(LlmToken token) const override;
+
+    bool decode(const LlmBatch& batch) override;
+    const float* logits(int32_t batch_index) const override;
+
+    int32_t kv_seq_length(int32_t seq_id) const override;
+    void kv_seq_remove(int32_t seq_id, int32_t p0, int32_t p1) override;
+    void kv_seq_copy(int32_t src, int32_t dst, int32_t p1) override;
+
+    uint64_t model_fingerprint() const override;
+    size_t state_seq_size(int32_t seq_id) const override;
+    size_t state_seq_get(int32_t seq_id, uint8_t* dst, size_t size) const override;
+    bool state_seq_set(int32_t seq_id, const uint8_t* src, size_t size) override;
+
+private:
+    struct Sequence {
+        std::vector<LlmToken> tokens;
+        int32_t assistant_pos = -1;  // position of the last assistant_turn token
+        std::string reply;           // scripted reply for that turn
+    };
+
+    void refresh_reply(Sequence* sequence) const;
+    void find_assistant_turn(Sequence* sequence) const;
+    LlmToken next_token(const Sequence& sequence, int32_t length) const;
+
+    const int32_t context_length_;
+    LlmSpecialTokens special_;
+    std::vector<Sequence> sequences_;
+    std::atomic<int32_t> decode_step_us_;
+    std::atomic<int32_t> per_token_us_;
+
+    std::vector<float> logits_;          // one row per entry that wanted logits
+    std::vector<int32_t> logits_rows_;   // batch index -> row, or -1
+};
+
+}  // namespace ai_bridge
+
+#endif  // AI_BRIDGE_LLM_SIM_ENGINE_H_
@@ -0,0 +1,171 @@
+#include "llm/tensor_ops.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "core/cpu_features.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define AI_BRIDGE_X86_KERNELS 1
+#endif
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace ai_bridge {
+
+namespace {
+
+#if defined(AI_BRIDGE_X86_KERNELS)
+
+__attribute__((target("avx2,fma"))) float DotAvx2(const float* a, const float* b, int32_t n) {
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    int32_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc0);
+        acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8), acc1);
+    }
+    for (; i + 8 <= n; i += 8) acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc0);
+    const __m256 acc = _mm256_add_ps(acc0, acc1);
+    __m128 sum = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_movehdup_ps(sum));
+    float total = _mm_cvtss_f32(sum);
+    for (; i < n; ++i) total += a[i] * b[i];
+    return total;
+}
+
+#endif  // AI_BRIDGE_X86_KERNELS
+
+#if defined(__ARM_NEON)
+
+float DotNeon(const float* a, const float* b, int32_t n) {
+    float32x4_t acc0 = vdupq_n_f32(0.0f);
+    float32x4_t acc1 = vdupq_n_f32(0.0f);
+    int32_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        acc0 = vmlaq_f32(acc0, vld1q_f32(a + i), vld1q_f32(b + i));
+        acc1 = vmlaq_f32(acc1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+    }
+    const float32x4_t acc = vaddq_f32(acc0, acc1);
+#if defined(__aarch64__)
+    float total = vaddvq_f32(acc);
+#else
+    const float32x2_t pair = vadd_f32(vget_low_f32(acc), vget_high_f32(acc));
+    float total = vget_lane_f32(vpadd_f32(pair, pair), 0);
+#endif
+    for (; i < n; ++i) total += a[i] * b[i];
+    return total;
+}
+
+#endif  // __ARM_NEON
+
+using DotFn = float (*)(const float*, const float*, int32_t);
+
+DotFn SelectedDot() {
+    static const DotFn dot = []() -> DotFn {
+#if defined(__ARM_NEON)
+        return DotNeon;
+#else
+#if defined(AI_BRIDGE_X86_KERNELS)
+        const CpuFeatures& cpu = GetCpuFeatures();
+        if (cpu.avx2 && cpu.fma) return DotAvx2;
+#endif
+        return DotScalar;
+#endif
+    }();
+    return dot;
+}
+
+}  // namespace
+
+float Dot(const float* a, const float* b, int32_t n) { return SelectedDot()(a, b, n); }
+
+float DotScalar(const float* a, const float* b, int32_t n) {
+    // Four partial sums break the dependency chain strict float ordering
+    // would otherwise keep the compiler to.
+    float s0 = 0.0f, s1 = 0.0f, s2 = 0.0f, s3 = 0.0f;
+    int32_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        s0 += a[i] * b[i];
+        s1 += a[i + 1] * b[i + 1];
+        s2 += a[i + 2] * b[i + 2];
+        s3 += a[i + 3] * b[i + 3];
+    }
+    for (; i < n; ++i) s0 += a[i] * b[i];
+    return (s0 + s1) + (s2 + s3);
+}
+
+void MatVec(const float* w, const float* x, float* y, int32_t rows, int32_t cols) {
+    const DotFn dot = SelectedDot();
+    for (int32_t r = 0; r < rows; ++r) y[r] = dot(w + static_cast<int64_t>(r) * cols, x, cols);
+}
+
+void MatVec(const WeightMatrix& w, const float* x, float* y, int32_t rows, int32_t cols,
+            std::vector<BlockQ8_0>* scratch) {
+    if (w.type == TensorType::kF32) {
+        MatVec(static_cast<const float*>(w.data), x, y, rows, cols);
+        return;
+    }
+    const int32_t blocks = cols / kQuantBlock;
+    scratch->resize(static_cast<size_t>(blocks));
+    QuantizeRow(TensorType::kQ8_0, x, scratch->data(), cols);
+    if (w.type == TensorType::kQ8_0) {
+        const BlockQ8_0* rows_q = static_cast<const BlockQ8_0*>(w.data);
+        for (int32_t r = 0; r < rows; ++r) {
+            y[r] = VecDotQ8_0(rows_q + static_cast<int64_t>(r) * blocks, scratch->data(), blocks);
+        }
+    } else if (w.type == TensorType::kQ4_0) {
+        const BlockQ4_0* rows_q = static_cast<const BlockQ4_0*>(w.data);
+        for (int32_t r = 0; r < rows; ++r) {
+            y[r] = VecDotQ4_0(rows_q + static_cast<int64_t>(r) * blocks, scratch->data(), blocks);
+        }
+    }
+}
+
+void RmsNorm(const float* x, const float* weight, float* out, int32_t n, float eps) {
+    const float scale = 1.0f / std::sqrt(Dot(x, x, n) / static_cast<float>(n) + eps);
+    for (int32_t i = 0; i < n; ++i) out[i] = x[i] * scale * weight[i];
+}
+
+void ApplyRope(float* v, int32_t heads, int32_t head_dim, int32_t position, const float* inv_freq) {
+    for (int32_t pair = 0; pair < head_dim / 2; ++pair) {
+        const float angle = static_cast<float>(position) * inv_freq[pair];
+        const float c = std::cos(angle);
+        const float s = std::sin(angle);
+        for (int32_t h = 0; h < heads; ++h) {
+            float* p = v + h * head_dim + 2 * pair;
+            const float x0 = p[0];
+            const float x1 = p[1];
+            p[0] = x0 * c - x1 * s;
+            p[1] = x0 * s + x1 * c;
+        }
+    }
+}
+
+void Softmax(float* v, int32_t n) {
+    if (n <= 0) return;
+    const float max = *std::max_element(v, v + n);
+    float sum = 0.0f;
+    for (int32_t i = 0; i < n; ++i) {
+        v[i] = std::exp(v[i] - max);
+        sum += v[i];
+    }
+    const float inv = 1.0f / sum;
+    for (int32_t i = 0; i < n; ++i) v[i] *= inv;
+}
+
+void SwiGlu(const float* gate, const float* up, float* out, int32_t n) {
+    for (int32_t i = 0; i < n; ++i) {
+        const float g = gate[i];
+        out[i] = g / (1.0f + std::exp(-g)) * up[i];
+    }
+}
+
+void AddInPlace(float* x, const float* y, int32_t n) {
+    for (int32_t i = 0; i < n; ++i) x[i] += y[i];
+}
+
+}  // namespace ai_bridge
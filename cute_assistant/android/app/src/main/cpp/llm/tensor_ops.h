@@ -0,0 +1,51 @@
+#ifndef AI_BRIDGE_LLM_TENSOR_OPS_H_
+#define AI_BRIDGE_LLM_TENSOR_OPS_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "llm/quant.h"
+
+namespace ai_bridge {
+
+// Kernels of the transformer forward pass. Matrices are row-major with one
+// row per output, as ggml stores them (dims[0] is the row length).
+
+// Vectorized with AVX2 on x86 (chosen at runtime) and NEON on ARM.
+float Dot(const float* a, const float* b, int32_t n);
+// The portable reference the SIMD paths must match.
+float DotScalar(const float* a, const float* b, int32_t n);
+
+// y[r] = dot(w row r, x) for r in [0, rows).
+void MatVec(const float* w, const float* x, float* y, int32_t rows, int32_t cols);
+
+// A weight matrix in any IsSupportedTensorType() format.
+struct WeightMatrix {
+    const void* data = nullptr;
+    TensorType type = TensorType::kF32;
+};
+
+// As above; quantized weights first quantize `x` to Q8_0 in `scratch`, so
+// `cols` must be a multiple of kQuantBlock.
+void MatVec(const WeightMatrix& w, const float* x, float* y, int32_t rows, int32_t cols,
+            std::vector<BlockQ8_0>* scratch);
+
+// out = x / rms(x) * weight. `out` may alias `x`.
+void RmsNorm(const float* x, const float* weight, float* out, int32_t n, float eps);
+
+// Rotates each (even, odd) pair of every head of `v` by position *
+// inv_freq[pair], as the original LLaMA RoPE does.
+void ApplyRope(float* v, int32_t heads, int32_t head_dim, int32_t position, const float* inv_freq);
+
+// In place, numerically stable.
+void Softmax(float* v, int32_t n);
+
+// out = silu(gate) * up. `out` may alias either input.
+void SwiGlu(const float* gate, const float* up, float* out, int32_t n);
+
+// x += y.
+void AddInPlace(float* x, const float* y, int32_t n);
+
+}  // namespace ai_bridge
+
+#endif  // AI_BRIDGE_LLM_TENSOR_OPS_H_
@@ -0,0 +1,54 @@
+#include "llm/token_slab_pool.h"
+
+namespace ai_bridge {
+
+TokenSlabPool::TokenSlabPool(size_t slab_bytes, size_t initial_slabs) : slab_bytes_(slab_bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    grow_locked(initial_slabs);
+}
+
+void TokenSlabPool::grow_locked(size_t count) {
+    if (count == 0) return;
+    // One allocation per growth step; slabs are carved out of it back to back.
+    storage_.emplace_back(new uint8_t[slab_bytes_ * count]);
+    uint8_t* base = storage_.back().get();
+    for (size_t i = 0; i < count; ++i) {
+        slabs_.emplace_back();
+        TokenSlab& slab = slabs_.back();
+        slab.pool = this;
+        slab.capacity = slab_bytes_;
+        slab.data = base + i * slab_bytes_;
+        free_.push_back(&slab);
+    }
+}
+
+TokenSlab* TokenSlabPool::acquire() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (free_.empty()) grow_locked(slabs_.size());
+    TokenSlab* slab = free_.back();
+    free_.pop_back();
+    return slab;
+}
+
+void TokenSlabPool::release(TokenSlab* slab) {
+    if (slab == nullptr) return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    free_.push_back(slab);
+}
+
+void TokenSlabPool::Finalizer(void* /*isolate_callback_data*/, void* peer) {
+    auto* slab = static_cast<TokenSlab*>(peer);
+    if (slab != nullptr) slab->pool->release(slab);
+}
+
+size_t TokenSlabPool::slabs_allocated() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return slabs_.size();
+}
+
+size_t TokenSlabPool::slabs_in_flight() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return slabs_.size() - free_.size();
+}
+
+}  // namespace ai_bridge
@@ -0,0 +1,63 @@
+#ifndef AI_BRIDGE_LLM_TOKEN_SLAB_POOL_H_
+#define AI_BRIDGE_LLM_TOKEN_SLAB_POOL_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace ai_bridge {
+
+class TokenSlabPool;
+
+// A fixed-size byte buffer that a token batch is written into and, with the
+// external typed data transport, lent to Dart as a Uint8List view.
+struct TokenSlab {
+    TokenSlabPool* pool = nullptr;
+    size_t capacity = 0;
+    uint8_t* data = nullptr;
+};
+
+// Recycles TokenSlabs between the token flusher and the Dart VM.
+//
+// Slabs handed to Dart come back through Finalizer() when the view is
+// garbage collected, on whatever thread the VM runs finalizers on, so
+// acquire/release are thread-safe. The pool grows when every slab is in
+// flight and never shrinks; it must outlive any view Dart still holds, which
+// is why the bridge keeps it in a process-lifetime global.
+class TokenSlabPool {
+public:
+    static constexpr size_t kDefaultSlabBytes = 4096;
+    static constexpr size_t kDefaultInitialSlabs = 16;
+
+    explicit TokenSlabPool(size_t slab_bytes = kDefaultSlabBytes, size_t initial_slabs = kDefaultInitialSlabs);
+
+    TokenSlabPool(const TokenSlabPool&) = delete;
+    TokenSlabPool& operator=(const TokenSlabPool&) = delete;
+
+    size_t slab_bytes() const { return slab_bytes_; }
+
+    TokenSlab* acquire();
+    void release(TokenSlab* slab);
+
+    // Dart_HandleFinalizer for external typed data whose peer is a TokenSlab.
+    static void Finalizer(void* isolate_callback_data, void* peer);
+
+    size_t slabs_allocated() const;
+    size_t slabs_in_flight() const;
+
+private:
+    void grow_locked(size_t count);
+
+    const size_t slab_bytes_;
+    mutable std::mutex mutex_;
+    std::deque<TokenSlab> slabs_;  // deque keeps slab addresses stable
+    std::vector<std::unique_ptr<uint8_t[]>> storage_;
+    std::vector<TokenSlab*> free_;
+};
+
+}  // namespace ai_bridge
+
+#endif  // AI_BRIDGE_LLM_TOKEN_SLAB_POOL_H_
@@ -0,0 +1,342 @@
+#include "llm/token_stream.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#include "core/dart_messages.h"
+#include "core/log.h"
+#include "core/metrics.h"
+
+namespace ai_bridge {
+
+namespace {
+
+// Upper bound on how long a published token can sit in the ring if a wakeup
+// races with the flusher going to sleep.
+constexpr auto kFlusherIdleWait = std::chrono::milliseconds(5);
+
+// Length of the longest prefix of data[0, length) that does not end inside a
+// UTF-8 sequence. Malformed input is passed through rather than held back.
+size_t Utf8CompletePrefix(const char* data, size_t length) {
+    size_t lead = length;
+    size_t continuation = 0;
+    while (lead > 0 && continuation < 3 && (static_cast<unsigned char>(data[lead - 1]) & 0xC0) == 0x80) {
+        --lead;
+        ++continuation;
+    }
+    if (lead == 0) return length;
+    const unsigned char c = static_cast<unsigned char>(data[lead - 1]);
+    size_t expected;
+    if ((c & 0x80) == 0x00) return length;
+    else if ((c & 0xE0) == 0xC0) expected = 1;
+    else if ((c & 0xF0) == 0xE0) expected = 2;
+    else if ((c & 0xF8) == 0xF0) expected = 3;
+    else return length;
+    return continuation < expected ? lead - 1 : length;
+}
+
+int32_t AtLeastOne(int32_t value) {
+    return value < 1 ? 1 : value;
+}
+
+// Largest prefix of data[0, length) that is at most `limit` bytes and does not
+// end inside a UTF-8 sequence.
+size_t Utf8SafeSplit(const char* data, size_t length, size_t limit) {
+    if (length <= limit) return length;
+    size_t split = limit;
+    while (split > 0 && (static_cast<unsigned char>(data[split]) & 0xC0) == 0x80) --split;
+    return split == 0 ? limit : split;
+}
+
+}  // namespace
+
+TokenStream::TokenStream(size_t capacity) : ring_(capacity) {}
+
+TokenStream::~TokenStream() {
+    stop();
+    for (ReplyBatch& batch : batches_) slab_pool_.release(batch.slab);
+}
+
+void TokenStream::start(Dart_Port port) {
+    port_.store(port, std::memory_order_release);
+    if (running_.exchange(true)) return;
+    flusher_ = std::thread(&TokenStream::flush_loop, this);
+}
+
+void TokenStream::stop() {
+    if (!running_.exchange(false)) return;
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+    }
+    wake_cv_.notify_one();
+    if (flusher_.joinable()) flusher_.join();
+}
+
+void TokenStream::set_flush_policy(const TokenFlushPolicy& policy) {
+    max_tokens_.store(AtLeastOne(policy.max_tokens), std::memory_order_relaxed);
+    max_bytes_.store(AtLeastOne(policy.max_bytes), std::memory_order_relaxed);
+    max_delay_ms_.store(AtLeastOne(policy.max_delay_ms), std::memory_order_relaxed);
+}
+
+TokenFlushPolicy TokenStream::flush_policy() const {
+    TokenFlushPolicy policy;
+    policy.max_tokens = max_tokens_.load(std::memory_order_relaxed);
+    policy.max_bytes = max_bytes_.load(std::memory_order_relaxed);
+    policy.max_delay_ms = max_delay_ms_.load(std::memory_order_relaxed);
+    return policy;
+}
+
+void TokenStream::set_transport(TokenTransport transport) {
+    transport_.store(transport, std::memory_order_relaxed);
+}
+
+TokenSlot* TokenStream::claim_slot() {
+    TokenSlot* slot = ring_.try_claim();
+    while (slot == nullptr) {
+        if (!running_.load(std::memory_order_acquire)) return nullptr;
+        producer_stalls_.fetch_add(1, std::memory_order_relaxed);
+        std::this_thread::yield();
+        slot = ring_.try_claim();
+    }
+    return slot;
+}
+
+void TokenStream::commit_slot() {
+    ring_.publish();
+    // Pairs with the fence in flush_loop(): either the flusher sees the new
+    // head before sleeping, or we see it waiting and wake it.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (flusher_waiting_.load(std::memory_order_relaxed)) {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        wake_cv_.notify_one();
+    }
+}
+
+void TokenStream::publish(int64_t request_id, const char* data, size_t length) {
+    while (length > 0) {
+        TokenSlot* slot = claim_slot();
+        if (slot == nullptr) {
+            tokens_dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        const size_t chunk = Utf8SafeSplit(data, length, TokenSlot::kMaxBytes);
+        slot->request_id = request_id;
+        memcpy(slot->bytes, data, chunk);
+        slot->bytes[chunk] = '\0';
+        slot->length = static_cast<uint8_t>(chunk);
+        data += chunk;
+        length -= chunk;
+        slot->flags = length > 0 ? kTokenSlotContinues : 0;
+        commit_slot();
+    }
+    tokens_published_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void TokenStream::end_reply(int64_t request_id, TokenReplyStatus status) {
+    TokenSlot* slot = claim_slot();
+    if (slot == nullptr) return;
+    // The marker carries no text, so its first byte holds the status.
+    slot->request_id = request_id;
+    slot->bytes[0] = static_cast<char>(status);
+    slot->length = 0;
+    slot->flags = kTokenSlotEndOfReply;
+    commit_slot();
+}
+
+void TokenStream::post_batch(int64_t request_id, TokenSlab* slab, size_t length, TokenTransport transport) {
+    const Dart_Port port = port_.load(std::memory_order_acquire);
+    if (port == ILLEGAL_PORT) {
+        slab_pool_.release(slab);
+        return;
+    }
+
+    Dart_CObject id_object;
+    id_object.type = Dart_CObject_kInt64;
+    id_object.value.as_int64 = request_id;
+    Dart_CObject text_object;
+    if (transport == TokenTransport::kExternalTypedData) {
+        text_object.type = Dart_CObject_kExternalTypedData;
+        text_object.value.as_external_typed_data.type = Dart_TypedData_kUint8;
+        text_object.value.as_external_typed_data.length = static_cast<intptr_t>(length);
+        text_object.value.as_external_typed_data.data = slab->data;
+        text_object.value.as_external_typed_data.peer = slab;
+        text_object.value.as_external_typed_data.callback = TokenSlabPool::Finalizer;
+    } else {
+        slab->data[length] = '\0';
+        text_object.type = Dart_CObject_kString;
+        text_object.value.as_string = reinterpret_cast<const char*>(slab->data);
+    }
+    Dart_CObject* elements[] = {&id_object, &text_object};
+    Dart_CObject dart_object;
+    dart_object.type = Dart_CObject_kArray;
+    dart_object.value.as_array.length = 2;
+    dart_object.value.as_array.values = elements;
+
+    const bool posted = Dart_PostCObject_DL(port, &dart_object);
+    // On success the VM owns external data until it runs the finalizer; in
+    // every other case the slab is ours to recycle now.
+    if (!posted || transport != TokenTransport::kExternalTypedData) slab_pool_.release(slab);
+
+    Metrics().add(MetricCounter::kDartPosts);
+    if (posted) {
+        messages_posted_.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        post_failures_.fetch_add(1, std::memory_order_relaxed);
+        Metrics().add(MetricCounter::kDartPostFailures);
+        LOGE("Dart_PostCObject_DL failed for token batch to port %lld", (long long)port);
+    }
+}
+
+void TokenStream::post_end_of_reply(int64_t request_id, int64_t status) {
+    const Dart_Port port = port_.load(std::memory_order_acquire);
+    if (port == ILLEGAL_PORT) return;
+    if (!SendEventToDart(port, "reply_end", {request_id, status})) {
+        post_failures_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+TokenStream::ReplyBatch* TokenStream::find_batch(int64_t request_id) {
+    for (ReplyBatch& batch : batches_) {
+        if (batch.request_id == request_id) return &batch;
+    }
+    ReplyBatch batch;
+    batch.request_id = request_id;
+    batches_.push_back(batch);
+    return &batches_.back();
+}
+
+void TokenStream::append_to_batch(ReplyBatch* batch, const char* bytes, size_t length) {
+    while (length > 0) {
+        if (batch->slab == nullptr) {
+            batch->slab = slab_pool_.acquire();
+            batch->length = 0;
+        }
+        // Keep one byte spare for the string transport's terminator.
+        const size_t room = batch->slab->capacity - 1 - batch->length;
+        if (room == 0) {
+            flush_batch(batch, false);
+            continue;
+        }
+        const size_t chunk = length < room ? length : room;
+        memcpy(batch->slab->data + batch->length, bytes, chunk);
+        batch->length += chunk;
+        bytes += chunk;
+        length -= chunk;
+    }
+}
+
+void TokenStream::flush_batch(ReplyBatch* batch, bool end_of_reply) {
+    if (batch->slab == nullptr || batch->length == 0) {
+        batch->tokens = 0;
+        return;
+    }
+    const TokenTransport transport = transport_.load(std::memory_order_relaxed);
+    const char* text = reinterpret_cast<const char*>(batch->slab->data);
+    // Mid-reply, the string transport keeps an unfinished multi-byte character
+    // for the next batch.
+    const size_t complete = (end_of_reply || transport == TokenTransport::kExternalTypedData)
+                                ? batch->length
+                                : Utf8CompletePrefix(text, batch->length);
+    if (complete > 0) {
+        TokenSlab* posted = batch->slab;
+        const size_t tail = batch->length - complete;
+        batch->slab = nullptr;
+        batch->length = 0;
+        if (tail > 0) {
+            batch->slab = slab_pool_.acquire();
+            memcpy(batch->slab->data, posted->data + complete, tail);
+            batch->length = tail;
+        }
+        post_batch(batch->request_id, posted, complete, transport);
+    }
+    // Even when only an unfinished character is buffered, restart the clock
+    // rather than spinning on an expired deadline.
+    batch->tokens = 0;
+    batch->started = std::chrono::steady_clock::now();
+}
+
+bool TokenStream::drain(const TokenFlushPolicy& policy) {
+    bool drained = false;
+    TokenTap* const tap = tap_.load(std::memory_order_acquire);
+    while (TokenSlot* slot = ring_.front()) {
+        ReplyBatch* batch = find_batch(slot->request_id);
+        if (slot->length > 0) {
+            if (tap != nullptr) tap->on_token(slot->request_id, slot->bytes, slot->length);
+            if (batch->length == 0) batch->started = std::chrono::steady_clock::now();
+            append_to_batch(batch, slot->bytes, slot->length);
+            if (!(slot->flags & kTokenSlotContinues)) {
+                ++batch->tokens;
+                tokens_drained_.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        const bool end_of_reply = (slot->flags & kTokenSlotEndOfReply) != 0;
+        const int64_t status = static_cast<unsigned char>(slot->bytes[0]);
+        ring_.pop();
+        drained = true;
+
+        if (end_of_reply) {
+            if (tap != nullptr) tap->on_reply_end(batch->request_id, static_cast<int32_t>(status));
+            flush_batch(batch, true);
+            post_end_of_reply(batch->request_id, status);
+            replies_completed_.fetch_add(1, std::memory_order_relaxed);
+            slab_pool_.release(batch->slab);
+            *batch = batches_.back();
+            batches_.pop_back();
+        } else if (batch->tokens >= policy.max_tokens || static_cast<int32_t>(batch->length) >= policy.max_bytes) {
+            flush_batch(batch, false);
+        }
+    }
+    return drained;
+}
+
+void TokenStream::flush_loop() {
+    batches_.reserve(16);
+    while (true) {
+        const TokenFlushPolicy policy = flush_policy();
+        const bool drained = drain(policy);
+
+        auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(kFlusherIdleWait);
+        const auto now = std::chrono::steady_clock::now();
+        bool flushed = false;
+        for (ReplyBatch& batch : batches_) {
+            if (batch.tokens == 0) continue;
+            const auto deadline = batch.started + std::chrono::milliseconds(policy.max_delay_ms);
+            if (now >= deadline) {
+                flush_batch(&batch, false);
+                flushed = true;
+                continue;
+            }
+            wait = std::min(wait, std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now) +
+                                      std::chrono::milliseconds(1));
+        }
+        if (drained || flushed) continue;
+        if (!running_.load(std::memory_order_acquire)) break;
+
+        std::unique_lock<std::mutex> lock(wake_mutex_);
+        flusher_waiting_.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (ring_.empty() && running_.load(std::memory_order_acquire)) {
+            wake_cv_.wait_for(lock, wait);
+        }
+        flusher_waiting_.store(false, std::memory_order_relaxed);
+    }
+    drain(flush_policy());
+    for (ReplyBatch& batch : batches_) flush_batch(&batch, true);
+}
+
+TokenStreamStats TokenStream::stats() const {
+    TokenStreamStats stats;
+    stats.tokens_published = tokens_published_.load(std::memory_order_relaxed);
+    stats.tokens_dropped = tokens_dropped_.load(std::memory_order_relaxed);
+    stats.producer_stalls = producer_stalls_.load(std::memory_order_relaxed);
+    stats.tokens_drained = tokens_drained_.load(std::memory_order_relaxed);
+    stats.messages_posted = messages_posted_.load(std::memory_order_relaxed);
+    stats.post_failures = post_failures_.load(std::memory_order_relaxed);
+    stats.replies_completed = replies_completed_.load(std::memory_order_relaxed);
+    stats.slabs_allocated = static_cast<int64_t>(slab_pool_.slabs_allocated());
+    stats.slabs_in_flight = static_cast<int64_t>(slab_pool_.slabs_in_flight());
+    return stats;
+}
+
+}  // namespace ai_bridge
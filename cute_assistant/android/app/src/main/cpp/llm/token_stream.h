@@ -0,0 +1,188 @@
+#ifndef AI_BRIDGE_LLM_TOKEN_STREAM_H_
+#define AI_BRIDGE_LLM_TOKEN_STREAM_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "core/spsc_ring.h"
+#include "dart_api_dl.h"
+#include "llm/token_slab_pool.h"
+
+namespace ai_bridge {
+
+enum TokenSlotFlags : uint8_t {
+    kTokenSlotEndOfReply = 1 << 0,
+    kTokenSlotContinues = 1 << 1,  // the piece carries on in the next slot
+};
+
+// One token piece of reply `request_id`, NUL-terminated in place. Pieces
+// longer than kMaxBytes span several slots.
+struct alignas(kCacheLineSize) TokenSlot {
+    static constexpr size_t kMaxBytes = kCacheLineSize - sizeof(int64_t) - 3;
+
+    int64_t request_id = 0;
+    uint8_t length = 0;
+    uint8_t flags = 0;
+    char bytes[kMaxBytes + 1] = {};
+};
+
+// When the flusher turns buffered tokens into one Dart message: as soon as any
+// limit is reached, and always at the end of a reply. Values < 1 are clamped
+// to 1; max_tokens == 1 restores one message per token.
+struct TokenFlushPolicy {
+    int32_t max_tokens = 8;
+    int32_t max_bytes = 512;
+    int32_t max_delay_ms = 50;
+};
+
+// Reported with the end of each reply. Values match
+// AI_BRIDGE_REPLY_* in ai_bridge.h.
+enum TokenReplyStatus : int32_t {
+    kReplyCompleted = 0,
+    kReplyCancelled = 1,
+    kReplyFailed = 2,
+};
+
+// How a flushed batch crosses into Dart.
+enum class TokenTransport : int32_t {
+    // Dart_CObject_kString: the VM copies and validates the UTF-8.
+    kString = 0,
+    // Dart_CObject_kExternalTypedData: Dart gets a Uint8List view of a pooled
+    // TokenSlab and the VM returns it through the finalizer. Batches may split
+    // a UTF-8 sequence; the Dart side decodes with a chunked decoder.
+    kExternalTypedData = 1,
+};
+
+// Sees reply text as the flusher drains it, ahead of batching: every piece
+// and the end of every reply, on the flusher thread. Must not block for
+// long, or Dart posting falls behind.
+class TokenTap {
+public:
+    virtual ~TokenTap() = default;
+    virtual void on_token(int64_t request_id, const char* data, size_t length) = 0;
+    virtual void on_reply_end(int64_t request_id, int32_t status) = 0;
+};
+
+struct TokenStreamStats {
+    int64_t tokens_published = 0;
+    int64_t tokens_dropped = 0;
+    int64_t producer_stalls = 0;
+    int64_t tokens_drained = 0;
+    int64_t messages_posted = 0;
+    int64_t post_failures = 0;
+    int64_t replies_completed = 0;
+    int64_t slabs_allocated = 0;
+    int64_t slabs_in_flight = 0;
+};
+
+// Hands generated tokens from the inference thread to Dart.
+//
+// The decode loop only writes a preallocated TokenSlot and publishes its index
+// (see SpscRing); a dedicated flusher thread drains the ring and does the
+// Dart_PostCObject_DL calls, so a slow or blocked isolate never stalls
+// decoding. With no port attached the flusher still drains and discards, which
+// gives the decode-only throughput baseline.
+//
+// Replies of concurrent requests interleave in the ring. The flusher keeps one
+// batch per reply and coalesces its tokens into one [request_id, text]
+// message per TokenFlushPolicy, so the isolate wakes up (and the chat UI
+// rebuilds) once per batch rather than once per token, and follows the last
+// batch of every reply with a ["reply_end", request_id, status] event (see
+// TokenReplyStatus). Batches are assembled directly in a TokenSlab so the
+// external typed data transport posts them without any further copy. With
+// the string transport a trailing partial UTF-8 sequence is held back until
+// the next batch so every message is valid UTF-8.
+class TokenStream {
+public:
+    static constexpr size_t kDefaultCapacity = 1024;
+
+    explicit TokenStream(size_t capacity = kDefaultCapacity);
+    ~TokenStream();
+
+    TokenStream(const TokenStream&) = delete;
+    TokenStream& operator=(const TokenStream&) = delete;
+
+    // Starts the flusher thread posting to `port` (ILLEGAL_PORT discards).
+    void start(Dart_Port port);
+    // Posts everything already published, then joins the flusher.
+    void stop();
+
+    // May be called from any thread; takes effect on the next drained token.
+    void set_flush_policy(const TokenFlushPolicy& policy);
+    TokenFlushPolicy flush_policy() const;
+    void set_transport(TokenTransport transport);
+    // Also hands reply text to `tap` (nullptr for none). The tap must
+    // outlive the flusher or be replaced before it goes away.
+    void set_tap(TokenTap* tap) { tap_.store(tap, std::memory_order_release); }
+
+    // --- Producer side (inference thread only) ---
+
+    // Queues a token piece of reply `request_id`. Spins while the ring is
+    // full; drops the piece if the flusher is not running.
+    void publish(int64_t request_id, const char* data, size_t length);
+    // Marks the end of the reply to `request_id`.
+    void end_reply(int64_t request_id, TokenReplyStatus status);
+
+    TokenStreamStats stats() const;
+
+private:
+    // Tokens of one reply waiting to be posted.
+    struct ReplyBatch {
+        int64_t request_id = 0;
+        TokenSlab* slab = nullptr;
+        size_t length = 0;
+        int32_t tokens = 0;
+        std::chrono::steady_clock::time_point started;
+    };
+
+    TokenSlot* claim_slot();
+    void commit_slot();
+    void flush_loop();
+    bool drain(const TokenFlushPolicy& policy);
+    ReplyBatch* find_batch(int64_t request_id);
+    void append_to_batch(ReplyBatch* batch, const char* bytes, size_t length);
+    void flush_batch(ReplyBatch* batch, bool end_of_reply);
+    void post_batch(int64_t request_id, TokenSlab* slab, size_t length, TokenTransport transport);
+    void post_end_of_reply(int64_t request_id, int64_t status);
+
+    SpscRing<TokenSlot> ring_;
+    std::atomic<Dart_Port> port_{ILLEGAL_PORT};
+    std::atomic<bool> running_{false};
+    std::thread flusher_;
+
+    std::mutex wake_mutex_;
+    std::condition_variable wake_cv_;
+    std::atomic<bool> flusher_waiting_{false};
+
+    std::atomic<int32_t> max_tokens_{TokenFlushPolicy().max_tokens};
+    std::atomic<int32_t> max_bytes_{TokenFlushPolicy().max_bytes};
+    std::atomic<int32_t> max_delay_ms_{TokenFlushPolicy().max_delay_ms};
+    std::atomic<TokenTransport> transport_{TokenTransport::kString};
+    std::atomic<TokenTap*> tap_{nullptr};
+
+    TokenSlabPool slab_pool_;
+
+    // Flusher-thread batch state, one entry per reply with buffered bytes.
+    std::vector<ReplyBatch> batches_;
+
+    // Producer-owned counters.
+    alignas(kCacheLineSize) std::atomic<int64_t> tokens_published_{0};
+    std::atomic<int64_t> tokens_dropped_{0};
+    std::atomic<int64_t> producer_stalls_{0};
+
+    // Flusher-owned counters.
+    alignas(kCacheLineSize) std::atomic<int64_t> tokens_drained_{0};
+    std::atomic<int64_t> messages_posted_{0};
+    std::atomic<int64_t> post_failures_{0};
+    std::atomic<int64_t> replies_completed_{0};
+};
+
+}  // namespace ai_bridge
+
+#endif  // AI_BRIDGE_LLM_TOKEN_STREAM_H_
@@ -0,0 +1,531 @@
+#include "llm/transformer_engine.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "core/metrics.h"
+#include "core/thread_pool.h"
+#include "llm/gemm.h"
+#include "llm/tensor_ops.h"
+
+namespace ai_bridge {
+
+namespace {
+
+constexpr uint32_t kStateMagic = 0x564b4654;  // "TFKV"
+constexpr int32_t kHparamCount = 9;
+
+struct StateHeader {
+    uint32_t magic;
+    int32_t length;
+    int32_t layers;
+    int32_t kv_dim;
+};
+
+// splitmix64, so synthetic weights are the same on every platform.
+class WeightRandom {
+public:
+    explicit WeightRandom(uint64_t seed) : state_(seed) {}
+
+    // Uniform in [-scale, scale).
+    float next(float scale) {
+        uint64_t z = (state_ += 0x9e3779b97f4a7c15ull);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        z ^= z >> 31;
+        return (static_cast<float>(z >> 40) / static_cast<float>(1 << 24) * 2.0f - 1.0f) * scale;
+    }
+
+private:
+    uint64_t state_;
+};
+
+void Fnv1a(uint64_t* hash, const void* data, size_t size) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        *hash ^= bytes[i];
+        *hash *= 0x100000001b3ull;
+    }
+}
+
+std::string LayerTensor(int32_t layer, const char* name) { return "blk." + std::to_string(layer) + "." + name; }
+
+}  // namespace
+
+TransformerConfig TransformerConfig::Tiny() {
+    TransformerConfig config;
+    config.vocab_size = TransformerEngine::kByteTokens + 4;
+    config.dim = 256;
+    config.hidden_dim = 768;
+    config.layers = 4;
+    config.heads = 8;
+    config.kv_heads = 4;
+    config.context_length = 2048;
+    return config;
+}
+
+TransformerEngine::TransformerEngine(int32_t max_sequences) : max_sequences_(std::max(1, max_sequences)) {
+    kv_.configure(0, 0, max_sequences_);
+    special_.bos = kByteTokens;
+    special_.eos = kByteTokens + 1;
+    special_.user_turn = kByteTokens + 2;
+    special_.assistant_turn = kByteTokens + 3;
+}
+
+void TransformerEngine::set_config(const TransformerConfig& config) {
+    config_ = config;
+    const int32_t head_dim = config_.head_dim();
+    inv_freq_.resize(static_cast<size_t>(head_dim / 2));
+    for (int32_t i = 0; i < head_dim / 2; ++i) {
+        inv_freq_[i] = std::pow(config_.rope_theta, -2.0f * static_cast<float>(i) / static_cast<float>(head_dim));
+    }
+    kv_.configure(config_.layers, config_.kv_dim(), max_sequences_);
+    report_kv_pages();
+}
+
+void TransformerEngine::report_kv_pages() const {
+    Metrics().set(MetricGauge::kKvPagesInUse, kv_.pages_in_use());
+    Metrics().set(MetricGauge::kKvPagesShared, kv_.pages_shared());
+}
+
+std::unique_ptr<TransformerEngine> TransformerEngine::CreateSynthetic(const TransformerConfig& config, uint64_t seed,
+                                                                      TensorType weight_type, int32_t max_sequences) {
+    std::unique_ptr<TransformerEngine> engine(new TransformerEngine(max_sequences));
+    engine->set_config(config);
+    const int64_t dim = config.dim;
+    const int64_t kv_dim = config.kv_dim();
+    const int64_t hidden = config.hidden_dim;
+
+    // Each tensor is drawn as float32 and then stored in its own buffer,
+    // quantized if asked.
+    WeightRandom random(seed);
+    std::vector<float> values;
+    auto draw = [&](int64_t count, float scale) {
+        values.resize(static_cast<size_t>(count));
+        for (float& value : values) value = random.next(scale);
+    };
+    auto store = [&](int64_t rows, int64_t cols, TensorType type) {
+        std::vector<uint8_t> buffer(RowBytes(type, cols) * static_cast<size_t>(rows));
+        for (int64_t r = 0; r < rows; ++r) {
+            QuantizeRow(type, values.data() + r * cols, buffer.data() + RowBytes(type, cols) * r, cols);
+        }
+        engine->owned_.push_back(std::move(buffer));
+        return WeightMatrix{engine->owned_.back().data(), type};
+    };
+    auto matrix = [&](int64_t rows, int64_t cols, float scale) {
+        draw(rows * cols, scale);
+        return store(rows, cols, weight_type);
+    };
+    auto ones = [&](int64_t count) {
+        values.assign(static_cast<size_t>(count), 1.0f);
+        return static_cast<const float*>(store(1, count, TensorType::kF32).data);
+    };
+
+    draw(config.vocab_size * dim, 1.0f);
+    for (int32_t token = 0; token < config.vocab_size; ++token) {
+        if ((token >= 0x20 && token < 0x7f) || token == '\n' || token == engine->special_.eos) continue;
+        std::fill(values.begin() + token * dim, values.begin() + (token + 1) * dim, 0.0f);
+    }
+    engine->weights_.token_embd = store(config.vocab_size, dim, weight_type);
+    engine->weights_.layers.resize(static_cast<size_t>(config.layers));
+    const float in_scale = 1.0f / std::sqrt(static_cast<float>(dim));
+    const float hidden_scale = 1.0f / std::sqrt(static_cast<float>(hidden));
+    for (Layer& layer : engine->weights_.layers) {
+        layer.attn_norm = ones(dim);
+        layer.wq = matrix(dim, dim, in_scale);
+        layer.wk = matrix(kv_dim, dim, in_scale);
+        layer.wv = matrix(kv_dim, dim, in_scale);
+        layer.wo = matrix(dim, dim, in_scale);
+        layer.ffn_norm = ones(dim);
+        layer.ffn_gate = matrix(hidden, dim, in_scale);
+        layer.ffn_up = matrix(hidden, dim, in_scale);
+        layer.ffn_down = matrix(dim, hidden, hidden_scale);
+    }
+    engine->weights_.output_norm = ones(dim);
+    engine->weights_.output = engine->weights_.token_embd;
+
+    uint64_t hash = 0xcbf29ce484222325ull;
+    Fnv1a(&hash, &config, sizeof(config));
+    Fnv1a(&hash, &seed, sizeof(seed));
+    if (weight_type != TensorType::kF32) Fnv1a(&hash, &weight_type, sizeof(weight_type));
+    engine->fingerprint_ = hash;
+    return engine;
+}
+
+uint64_t TransformerEngine::WriteModel(const std::string& path, std::string* error) const {
+    const TransformerConfig& c = config_;
+    const float hparams[kHparamCount] = {
+        static_cast<float>(c.vocab_size), static_cast<float>(c.dim),   static_cast<float>(c.hidden_dim),
+        static_cast<float>(c.layers),     static_cast<float>(c.heads), static_cast<float>(c.kv_heads),
+        static_cast<float>(c.context_length), c.rope_theta,            c.norm_eps};
+    // The fingerprint rides along so sessions saved against the synthetic
+    // weights restore into the same weights loaded from the file.
+    float fingerprint[2];
+    std::memcpy(fingerprint, &fingerprint_, sizeof(fingerprint));
+    const int64_t dim = c.dim;
+    const int64_t kv_dim = c.kv_dim();
+    const int64_t hidden = c.hidden_dim;
+    auto bytes = [](int64_t count) { return static_cast<uint64_t>(count) * sizeof(float); };
+
+    ModelFileWriter writer;
+    // Matrices are {cols, rows}, innermost first.
+    auto add_matrix = [&writer](const std::string& name, int32_t layer, const WeightMatrix& w, int64_t rows,
+                                int64_t cols) {
+        writer.add_tensor(name, w.type, layer, {cols, rows}, w.data,
+                          RowBytes(w.type, cols) * static_cast<uint64_t>(rows));
+    };
+    writer.add_tensor("hparams", TensorType::kF32, -1, {kHparamCount}, hparams, sizeof(hparams));
+    writer.add_tensor("fingerprint", TensorType::kF32, -1, {2}, fingerprint, sizeof(fingerprint));
+    add_matrix("token_embd", -1, weights_.token_embd, c.vocab_size, dim);
+    for (int32_t l = 0; l < c.layers; ++l) {
+        const Layer& layer = weights_.layers[l];
+        writer.add_tensor(LayerTensor(l, "attn_norm"), TensorType::kF32, l, {dim}, layer.attn_norm, bytes(dim));
+        add_matrix(LayerTensor(l, "attn_q"), l, layer.wq, dim, dim);
+        add_matrix(LayerTensor(l, "attn_k"), l, layer.wk, kv_dim, dim);
+        add_matrix(LayerTensor(l, "attn_v"), l, layer.wv, kv_dim, dim);
+        add_matrix(LayerTensor(l, "attn_output"), l, layer.wo, dim, dim);
+        writer.add_tensor(LayerTensor(l, "ffn_norm"), TensorType::kF32, l, {dim}, layer.ffn_norm, bytes(dim));
+        add_matrix(LayerTensor(l, "ffn_gate"), l, layer.ffn_gate, hidden, dim);
+        add_matrix(LayerTensor(l, "ffn_up"), l, layer.ffn_up, hidden, dim);
+        add_matrix(LayerTensor(l, "ffn_down"), l, layer.ffn_down, dim, hidden);
+    }
+    writer.add_tensor("output_norm", TensorType::kF32, -1, {dim}, weights_.output_norm, bytes(dim));
+    if (weights_.output.data != weights_.token_embd.data) add_matrix("output", -1, weights_.output, c.vocab_size, dim);
+    return writer.write(path, error);
+}
+
+bool TransformerEngine::use_weights(const MappedModelFile& file, std::string* error) {
+    const ModelFileTensor* hparams = file.find("hparams");
+    if (hparams == nullptr || hparams->type != TensorType::kF32 || hparams->size != kHparamCount * sizeof(float)) {
+        *error = "no transformer hyperparameters";
+        return false;
+    }
+    const float* h = static_cast<const float*>(file.tensor_data(*hparams));
+    TransformerConfig config;
+    config.vocab_size = static_cast<int32_t>(h[0]);
+    config.dim = static_cast<int32_t>(h[1]);
+    config.hidden_dim = static_cast<int32_t>(h[2]);
+    config.layers = static_cast<int32_t>(h[3]);
+    config.heads = static_cast<int32_t>(h[4]);
+    config.kv_heads = static_cast<int32_t>(h[5]);
+    config.context_length = static_cast<int32_t>(h[6]);
+    config.rope_theta = h[7];
+    config.norm_eps = h[8];
+    if (config.vocab_size != kByteTokens + 4) {
+        *error = "vocabulary of " + std::to_string(config.vocab_size) + " tokens is not the byte vocabulary";
+        return false;
+    }
+    if (config.dim <= 0 || config.hidden_dim <= 0 || config.layers <= 0 || config.heads <= 0 || config.kv_heads <= 0 ||
+        config.dim % config.heads != 0 || config.head_dim() % 2 != 0 || config.heads % config.kv_heads != 0 ||
+        config.context_length <= 0) {
+        *error = "invalid transformer hyperparameters";
+        return false;
+    }
+
+    // Norms must be float32, matrices any supported format, and every
+    // tensor exactly the size the config implies.
+    auto vector = [&](const std::string& name, int64_t count) -> const float* {
+        const ModelFileTensor* entry = file.find(name.c_str());
+        if (entry == nullptr) {
+            if (error->empty()) *error = "missing tensor " + name;
+            return nullptr;
+        }
+        if (entry->type != TensorType::kF32 || entry->size != static_cast<uint64_t>(count) * sizeof(float)) {
+            if (error->empty()) *error = "tensor " + name + " is not float32 of the configured shape";
+            return nullptr;
+        }
+        return static_cast<const float*>(file.tensor_data(*entry));
+    };
+    auto matrix = [&](const std::string& name, int64_t rows, int64_t cols) -> WeightMatrix {
+        const ModelFileTensor* entry = file.find(name.c_str());
+        if (entry == nullptr) {
+            if (error->empty()) *error = "missing tensor " + name;
+            return {};
+        }
+        if (!IsSupportedTensorType(entry->type) || (IsQuantized(entry->type) && cols % kQuantBlock != 0)) {
+            if (error->empty()) *error = "tensor " + name + " is stored as unsupported " + TensorTypeName(entry->type);
+            return {};
+        }
+        if (entry->size != RowBytes(entry->type, cols) * static_cast<uint64_t>(rows)) {
+            if (error->empty()) *error = "tensor " + name + " does not have the configured shape";
+            return {};
+        }
+        return {file.tensor_data(*entry), entry->type};
+    };
+    error->clear();
+    const int64_t dim = config.dim;
+    const int64_t kv_dim = config.kv_dim();
+    const int64_t hidden = config.hidden_dim;
+    Weights weights;
+    weights.token_embd = matrix("token_embd", config.vocab_size, dim);
+    weights.layers.resize(static_cast<size_t>(config.layers));
+    for (int32_t l = 0; l < config.layers; ++l) {
+        Layer& layer = weights.layers[l];
+        layer.attn_norm = vector(LayerTensor(l, "attn_norm"), dim);
+        layer.wq = matrix(LayerTensor(l, "attn_q"), dim, dim);
+        layer.wk = matrix(LayerTensor(l, "attn_k"), kv_dim, dim);
+        layer.wv = matrix(LayerTensor(l, "attn_v"), kv_dim, dim);
+        layer.wo = matrix(LayerTensor(l, "attn_output"), dim, dim);
+        layer.ffn_norm = vector(LayerTensor(l, "ffn_norm"), dim);
+        layer.ffn_gate = matrix(LayerTensor(l, "ffn_gate"), hidden, dim);
+        layer.ffn_up = matrix(LayerTensor(l, "ffn_up"), hidden, dim);
+        layer.ffn_down = matrix(LayerTensor(l, "ffn_down"), dim, hidden);
+    }
+    weights.output_norm = vector("output_norm", dim);
+    weights.output = file.find("output") != nullptr ? matrix("output", config.vocab_size, dim) : weights.token_embd;
+    if (!error->empty()) return false;
+
+    uint64_t fingerprint = 0;
+    const ModelFileTensor* stored = file.find("fingerprint");
+    if (stored != nullptr && stored->size == sizeof(fingerprint)) {
+        std::memcpy(&fingerprint, file.tensor_data(*stored), sizeof(fingerprint));
+    } else {
+        fingerprint = 0xcbf29ce484222325ull;
+        Fnv1a(&fingerprint, &config, sizeof(config));
+        Fnv1a(&fingerprint, &file.header().file_size, sizeof(file.header().file_size));
+        Fnv1a(&fingerprint, weights.token_embd.data, RowBytes(weights.token_embd.type, dim));
+    }
+
+    weights_ = std::move(weights);
+    owned_.clear();
+    owned_.shrink_to_fit();
+    fingerprint_ = fingerprint;
+    set_config(config);
+    return true;
+}
+
+void TransformerEngine::tokenize(const std::string& text, std::vector<LlmToken>* out) const {
+    out->reserve(out->size() + text.size());
+    for (unsigned char c : text) out->push_back(c);
+}
+
+std::string TransformerEngine::token_to_piece(LlmToken token) const {
+    if (token < 0 || token >= kByteTokens) return std::string();
+    return std::string(1, static_cast<char>(token));
+}
+
+void TransformerEngine::attend(const LlmBatch& batch, int32_t i, int32_t layer) {
+    const TransformerConfig& c = config_;
+    const int32_t kv_dim = c.kv_dim();
+    const int32_t head_dim = c.head_dim();
+    const int32_t group = c.heads / c.kv_heads;
+    const float attn_scale = 1.0f / std::sqrt(static_cast<float>(head_dim));
+    // Later entries of the same sequence are already in the cache; the
+    // causal mask is just stopping at this entry's position.
+    const int32_t length = batch.positions[i] + 1;
+    const int32_t seq = batch.seq_ids[i];
+    constexpr int32_t kPage = PagedKvCache::kPageTokens;
+    thread_local std::vector<float> scores;
+    scores.resize(static_cast<size_t>(length));
+
+    for (int32_t h = 0; h < c.heads; ++h) {
+        const float* q = q_.data() + static_cast<size_t>(i) * c.dim + h * head_dim;
+        const int32_t kv_offset = (h / group) * head_dim;
+        // Page by page: the rows within a page are consecutive.
+        for (int32_t t0 = 0; t0 < length; t0 += kPage) {
+            const float* keys = kv_.key(seq, layer, t0) + kv_offset;
+            for (int32_t t = t0; t < std::min(length, t0 + kPage); ++t) {
+                scores[t] = Dot(q, keys + static_cast<size_t>(t - t0) * kv_dim, head_dim) * attn_scale;
+            }
+        }
+        Softmax(scores.data(), length);
+        float* out = attn_.data() + static_cast<size_t>(i) * c.dim + h * head_dim;
+        std::fill(out, out + head_dim, 0.0f);
+        for (int32_t t0 = 0; t0 < length; t0 += kPage) {
+            const float* values = kv_.value(seq, layer, t0) + kv_offset;
+            for (int32_t t = t0; t < std::min(length, t0 + kPage); ++t) {
+                const float* v = values + static_cast<size_t>(t - t0) * kv_dim;
+                const float weight = scores[t];
+                for (int32_t d = 0; d < head_dim; ++d) out[d] += weight * v[d];
+            }
+        }
+    }
+}
+
+void TransformerEngine::forward(const LlmBatch& batch) {
+    const TransformerConfig& c = config_;
+    const int32_t n = batch.size();
+    const int32_t dim = c.dim;
+    const int32_t kv_dim = c.kv_dim();
+    const int32_t hidden = c.hidden_dim;
+    const size_t rows = static_cast<size_t>(n);
+    ThreadPool* pool = &ComputePool();
+    // A batch carrying prompt tokens is prefill, which yields to replies
+    // being generated and to the voice stages.
+    const bool prefill = std::find(batch.want_logits.begin(), batch.want_logits.end(), 0) != batch.want_logits.end();
+    const TaskPriority priority = prefill ? TaskPriority::kBackground : TaskPriority::kNormal;
+    x_.resize(rows * dim);
+    xb_.resize(rows * dim);
+    q_.resize(rows * dim);
+    attn_.resize(rows * dim);
+    k_.resize(rows * kv_dim);
+    v_.resize(rows * kv_dim);
+    gate_.resize(rows * hidden);
+    up_.resize(rows * hidden);
+    // Entries of one sequence are in position order, so preparing their
+    // rows in batch order fills each sequence's pages front to back.
+    for (int32_t i = 0; i < n; ++i) kv_.prepare(batch.seq_ids[i], batch.positions[i]);
+
+    const TensorType embd_type = weights_.token_embd.type;
+    const uint8_t* embd = static_cast<const uint8_t*>(weights_.token_embd.data);
+    for (int32_t i = 0; i < n; ++i) {
+        const size_t row = static_cast<size_t>(i) * dim;
+        DequantizeRow(embd_type, embd + RowBytes(embd_type, dim) * batch.tokens[i], x_.data() + row, dim);
+    }
+    for (int32_t l = 0; l < c.layers; ++l) {
+        const Layer& layer = weights_.layers[l];
+
+        // Attention.
+        for (int32_t i = 0; i < n; ++i) {
+            const size_t row = static_cast<size_t>(i) * dim;
+            RmsNorm(x_.data() + row, layer.attn_norm, xb_.data() + row, dim, c.norm_eps);
+        }
+        MatMul(layer.wq, xb_.data(), q_.data(), n, dim, dim, pool, threads_, priority);
+        MatMul(layer.wk, xb_.data(), k_.data(), n, kv_dim, dim, pool, threads_, priority);
+        MatMul(layer.wv, xb_.data(), v_.data(), n, kv_dim, dim, pool, threads_, priority);
+        for (int32_t i = 0; i < n; ++i) {
+            const int32_t position = batch.positions[i];
+            float* k = k_.data() + static_cast<size_t>(i) * kv_dim;
+            const float* v = v_.data() + static_cast<size_t>(i) * kv_dim;
+            ApplyRope(q_.data() + static_cast<size_t>(i) * dim, c.heads, c.head_dim(), position, inv_freq_.data());
+            ApplyRope(k, c.kv_heads, c.head_dim(), position, inv_freq_.data());
+            const int32_t seq = batch.seq_ids[i];
+            std::memcpy(kv_.key(seq, l, position), k, sizeof(float) * kv_dim);
+            std::memcpy(kv_.value(seq, l, position), v, sizeof(float) * kv_dim);
+        }
+        if (n > 1) {
+            pool->parallel_for(n, [&](int32_t i) { attend(batch, i, l); }, threads_, priority);
+        } else {
+            attend(batch, 0, l);
+        }
+        MatMul(layer.wo, attn_.data(), xb_.data(), n, dim, dim, pool, threads_, priority);
+        AddInPlace(x_.data(), xb_.data(), n * dim);
+
+        // MLP.
+        for (int32_t i = 0; i < n; ++i) {
+            const size_t row = static_cast<size_t>(i) * dim;
+            RmsNorm(x_.data() + row, layer.ffn_norm, xb_.data() + row, dim, c.norm_eps);
+        }
+        MatMul(layer.ffn_gate, xb_.data(), gate_.data(), n, hidden, dim, pool, threads_, priority);
+        MatMul(layer.ffn_up, xb_.data(), up_.data(), n, hidden, dim, pool, threads_, priority);
+        SwiGlu(gate_.data(), up_.data(), gate_.data(), n * hidden);
+        MatMul(layer.ffn_down, gate_.data(), xb_.data(), n, dim, hidden, pool, threads_, priority);
+        AddInPlace(x_.data(), xb_.data(), n * dim);
+    }
+    for (int32_t i = 0; i < n; ++i) {
+        const int32_t seq = batch.seq_ids[i];
+        kv_.set_length(seq, std::max(kv_.length(seq), batch.positions[i] + 1));
+    }
+
+    // The output head, for the entries that want logits only.
+    int32_t wanted = 0;
+    for (int32_t i = 0; i < n; ++i) {
+        if (logits_rows_[i] < 0) continue;
+        RmsNorm(x_.data() + static_cast<size_t>(i) * dim, weights_.output_norm,
+                xb_.data() + static_cast<size_t>(logits_rows_[i]) * dim, dim, c.norm_eps);
+        ++wanted;
+    }
+    MatMul(weights_.output, xb_.data(), logits_.data(), wanted, c.vocab_size, dim, pool, threads_, priority);
+}
+
+bool TransformerEngine::decode(const LlmBatch& batch) {
+    // Validate first so a bad batch leaves every cache untouched.
+    std::vector<int32_t> lengths(static_cast<size_t>(max_sequences()));
+    for (int32_t s = 0; s < max_sequences(); ++s) lengths[s] = kv_.length(s);
+    for (int32_t i = 0; i < batch.size(); ++i) {
+        const int32_t seq = batch.seq_ids[i];
+        if (seq < 0 || seq >= max_sequences()) return false;
+        if (batch.positions[i] != lengths[seq] || lengths[seq] >= config_.context_length) return false;
+        if (batch.tokens[i] < 0 || batch.tokens[i] >= vocab_size()) return false;
+        ++lengths[seq];
+    }
+
+    logits_rows_.assign(static_cast<size_t>(batch.size()), -1);
+    int32_t rows = 0;
+    for (int32_t i = 0; i < batch.size(); ++i) {
+        if (batch.want_logits[i]) logits_rows_[i] = rows++;
+    }
+    logits_.resize(static_cast<size_t>(rows) * vocab_size());
+
+    if (batch.size() > 0) forward(batch);
+    report_kv_pages();
+    return true;
+}
+
+const float* TransformerEngine::logits(int32_t batch_index) const {
+    if (batch_index < 0 || batch_index >= static_cast<int32_t>(logits_rows_.size())) return nullptr;
+    const int32_t row = logits_rows_[batch_index];
+    return row < 0 ? nullptr : logits_.data() + static_cast<size_t>(row) * vocab_size();
+}
+
+int32_t TransformerEngine::kv_seq_length(int32_t seq_id) const {
+    if (seq_id < 0 || seq_id >= max_sequences()) return 0;
+    return kv_.length(seq_id);
+}
+
+void TransformerEngine::kv_seq_remove(int32_t seq_id, int32_t p0, int32_t p1) {
+    if (seq_id < 0 || seq_id >= max_sequences()) return;
+    if (p1 >= 0 && p1 < kv_.length(seq_id)) return;  // only suffixes can be dropped
+    kv_.truncate(seq_id, p0);
+    report_kv_pages();
+}
+
+void TransformerEngine::kv_seq_copy(int32_t src, int32_t dst, int32_t p1) {
+    if (src < 0 || src >= max_sequences() || dst < 0 || dst >= max_sequences() || src == dst) return;
+    if (kv_.length(dst) != 0) return;
+    kv_.copy(src, dst, p1);
+    report_kv_pages();
+}
+
+// The state of a sequence is its keys and values, layer by layer.
+size_t TransformerEngine::state_seq_size(int32_t seq_id) const {
+    if (seq_id < 0 || seq_id >= max_sequences()) return 0;
+    return sizeof(StateHeader) +
+           2 * sizeof(float) * static_cast<size_t>(kv_.length(seq_id)) * config_.kv_dim() * config_.layers;
+}
+
+size_t TransformerEngine::state_seq_get(int32_t seq_id, uint8_t* dst, size_t size) const {
+    const size_t needed = state_seq_size(seq_id);
+    if (needed == 0 || size < needed) return 0;
+    const int32_t length = kv_.length(seq_id);
+    const StateHeader header = {kStateMagic, length, config_.layers, config_.kv_dim()};
+    std::memcpy(dst, &header, sizeof(header));
+    uint8_t* out = dst + sizeof(header);
+    const size_t row_bytes = sizeof(float) * config_.kv_dim();
+    for (int32_t l = 0; l < config_.layers; ++l) {
+        for (int32_t t = 0; t < length; ++t, out += row_bytes) std::memcpy(out, kv_.key(seq_id, l, t), row_bytes);
+        for (int32_t t = 0; t < length; ++t, out += row_bytes) std::memcpy(out, kv_.value(seq_id, l, t), row_bytes);
+    }
+    return needed;
+}
+
+bool TransformerEngine::state_seq_set(int32_t seq_id, const uint8_t* src, size_t size) {
+    if (seq_id < 0 || seq_id >= max_sequences()) return false;
+    kv_seq_remove(seq_id, 0, -1);
+    StateHeader header;
+    if (size < sizeof(header)) return false;
+    std::memcpy(&header, src, sizeof(header));
+    if (header.magic != kStateMagic || header.layers != config_.layers || header.kv_dim != config_.kv_dim() ||
+        header.length < 0 || header.length > config_.context_length) {
+        return false;
+    }
+    const size_t row_bytes = sizeof(float) * config_.kv_dim();
+    if (size != sizeof(header) + 2 * row_bytes * header.length * config_.layers) return false;
+    for (int32_t t = 0; t < header.length; ++t) kv_.prepare(seq_id, t);
+    // The blob need not be float aligned.
+    const uint8_t* in = src + sizeof(header);
+    for (int32_t l = 0; l < config_.layers; ++l) {
+        for (int32_t t = 0; t < header.length; ++t, in += row_bytes) {
+            std::memcpy(kv_.key(seq_id, l, t), in, row_bytes);
+        }
+        for (int32_t t = 0; t < header.length; ++t, in += row_bytes) {
+            std::memcpy(kv_.value(seq_id, l, t), in, row_bytes);
+        }
+    }
+    kv_.set_length(seq_id, header.length);
+    report_kv_pages();
+    return true;
+}
+
+}  // namespace ai_bridge
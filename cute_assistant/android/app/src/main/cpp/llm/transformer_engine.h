@@ -0,0 +1,147 @@
+#ifndef AI_BRIDGE_LLM_TRANSFORMER_ENGINE_H_
+#define AI_BRIDGE_LLM_TRANSFORMER_ENGINE_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "llm/llm_engine.h"
+#include "llm/model_file.h"
+#include "llm/paged_kv_cache.h"
+#include "llm/tensor_ops.h"
+
+namespace ai_bridge {
+
+// Shape of a LLaMA-style decoder: RMSNorm, rotary attention with grouped
+// KV heads, SwiGLU MLP.
+struct TransformerConfig {
+    int32_t vocab_size = 0;
+    int32_t dim = 0;
+    int32_t hidden_dim = 0;      // MLP width
+    int32_t layers = 0;
+    int32_t heads = 0;
+    int32_t kv_heads = 0;        // divides heads
+    int32_t context_length = 0;
+    float rope_theta = 10000.0f;
+    float norm_eps = 1e-5f;
+
+    int32_t head_dim() const { return heads > 0 ? dim / heads : 0; }
+    int32_t kv_dim() const { return kv_heads * head_dim(); }
+
+    // The built-in synthetic model: about 3.2M parameters (13 MB of float32),
+    // big enough that a decode step is memory- and compute-bound like a real
+    // one, small enough to generate at startup.
+    static TransformerConfig Tiny();
+};
+
+// Self-contained CPU forward pass. A decode() evaluates its whole batch
+// layer by layer, so the tokens of a prefill chunk go through each weight
+// matrix as one GEMM (llm/gemm.h) spread over the compute pool, and their
+// attention runs in parallel too. Weight matrices may be float32 or
+// block-quantized (Q8_0, Q4_0; see llm/quant.h), each tensor in its own
+// format; norms are always float32.
+//
+// Weights come from a model file (tensors named as in WriteModel, which
+// also stores the config in an "hparams" tensor) or are generated from a
+// seed, which is how the engine runs with no model at all. The vocabulary
+// is SimLlmEngine's: bytes, then BOS/EOS/user/assistant. The KV caches of
+// all sequences share one PagedKvCache, so kv_seq_copy shares pages rather
+// than copying them.
+class TransformerEngine : public LlmEngine {
+public:
+    static constexpr int32_t kByteTokens = 256;
+
+    // Random weights drawn from `seed`, every matrix stored as `weight_type`
+    // (dim and hidden_dim must then be multiples of kQuantBlock). Embeddings
+    // are tied to the output, and tokens other than printable ASCII, newline
+    // and EOS get a zero embedding, so greedy decoding keeps to readable text.
+    static std::unique_ptr<TransformerEngine> CreateSynthetic(const TransformerConfig& config, uint64_t seed,
+                                                              TensorType weight_type = TensorType::kF32,
+                                                              int32_t max_sequences = 8);
+    // Writes this engine's weights as a model file; returns its size, or 0
+    // with `error` set.
+    uint64_t WriteModel(const std::string& path, std::string* error) const;
+
+    // Switches to the weights of `file`, which must outlive the engine or
+    // the next call, and empties every KV cache. Returns false, keeping the
+    // current weights, if the file does not hold a model this engine runs.
+    bool use_weights(const MappedModelFile& file, std::string* error);
+
+    const TransformerConfig& config() const { return config_; }
+    // Most compute-pool threads one decode() uses; 0 (the default) for all.
+    void set_threads(int32_t threads) { threads_ = threads; }
+    // Format of the layer matrices (of layer 0's attn_q, to be exact).
+    TensorType weight_type() const { return weights_.layers.empty() ? TensorType::kF32 : weights_.layers[0].wq.type; }
+
+    const char* name() const override { return "reference"; }
+    int32_t vocab_size() const override { return config_.vocab_size; }
+    int32_t context_length() const override { return config_.context_length; }
+    int32_t max_sequences() const override { return kv_.max_sequences(); }
+    const LlmSpecialTokens& special_tokens() const override { return special_; }
+
+    void tokenize(const std::string& text, std::vector<LlmToken>* out) const override;
+    std::string token_to_piece(LlmToken token) const override;
+
+    bool decode(const LlmBatch& batch) override;
+    const float* logits(int32_t batch_index) const override;
+
+    int32_t kv_seq_length(int32_t seq_id) const override;
+    void kv_seq_remove(int32_t seq_id, int32_t p0, int32_t p1) override;
+    void kv_seq_copy(int32_t src, int32_t dst, int32_t p1) override;
+
+    uint64_t model_fingerprint() const override { return fingerprint_; }
+    size_t state_seq_size(int32_t seq_id) const override;
+    size_t state_seq_get(int32_t seq_id, uint8_t* dst, size_t size) const override;
+    bool state_seq_set(int32_t seq_id, const uint8_t* src, size_t size) override;
+
+private:
+    struct Layer {
+        const float* attn_norm = nullptr;
+        WeightMatrix wq;
+        WeightMatrix wk;
+        WeightMatrix wv;
+        WeightMatrix wo;
+        const float* ffn_norm = nullptr;
+        WeightMatrix ffn_gate;
+        WeightMatrix ffn_up;
+        WeightMatrix ffn_down;
+    };
+    struct Weights {
+        WeightMatrix token_embd;
+        std::vector<Layer> layers;
+        const float* output_norm = nullptr;
+        WeightMatrix output;  // token_embd when tied
+    };
+    explicit TransformerEngine(int32_t max_sequences);
+
+    void set_config(const TransformerConfig& config);
+    // Publishes the page counts of kv_ as metrics gauges.
+    void report_kv_pages() const;
+    // Evaluates a validated batch, appending to the caches and filling
+    // logits_ for the entries that want them.
+    void forward(const LlmBatch& batch);
+    // Attention of batch entry `i` (its q_ row against its sequence's cache
+    // of layer `layer`) into its attn_ row.
+    void attend(const LlmBatch& batch, int32_t i, int32_t layer);
+
+    TransformerConfig config_;
+    Weights weights_;
+    std::vector<std::vector<uint8_t>> owned_;  // synthetic weights, one buffer per tensor
+    uint64_t fingerprint_ = 0;
+    LlmSpecialTokens special_;
+    int32_t max_sequences_;
+    PagedKvCache kv_;
+    std::vector<float> inv_freq_;
+    int32_t threads_ = 0;
+
+    // Activations of the batch being evaluated, one row per entry.
+    std::vector<float> x_, xb_, q_, k_, v_, attn_, gate_, up_;
+
+    std::vector<float> logits_;
+    std::vector<int32_t> logits_rows_;
+};
+
+}  // namespace ai_bridge
+
+#endif  // AI_BRIDGE_LLM_TRANSFORMER_ENGINE_H_
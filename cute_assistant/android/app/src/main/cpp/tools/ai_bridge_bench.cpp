@@ -0,0 +1,1083 @@
+// Host load generator for ai_bridge.
+//
+// Drives the exported FFI entry points the same way OnDeviceAIService does,
+// with the host shim standing in for the Dart isolate, and reports what
+// arrived on the token and error ports.
+//
+//   ai_bridge_bench [--requests N] [--interval-ms MS] [--timeout-ms MS]
+//                   [--token-delay-us US] [--input-words N] [--detached]
+//                   [--flush TOKENS,BYTES,MS] [--transport string|external]
+//                   [--barge-in] [--cancel-after-ms MS]
+//                   [--sessions N] [--scheduler SESSIONS,BUDGET,CHUNK]
+//                   [--system-words N] [--session-file PATH]
+//                   [--model PATH] [--prefetch-layers N] [--synthetic-model-mb MB]
+//                   [--engine sim|reference] [--write-reference-model]
+//                   [--weights f32|q8_0|q4_0] [--threads N]
+//                   [--vad-utterances N] [--vad-frame 512|1536]
+//                   [--vad-noise-db DB] [--vad-no-gate] [--vad-speed X]
+//                   [--vad-speech-s S] [--asr] [--tts] [--trace PATH]
+//
+// --detached passes ILLEGAL_PORT as the token port, so tokens are drained and
+// discarded natively; comparing tok/s against an attached run isolates the
+// cost of the Dart posting path. --barge-in lets every request preempt the
+// previous ones; --cancel-after-ms cancels each request MS after submitting
+// it. Both report how long the decode loop took to abort. --sessions spreads
+// the requests round-robin over N conversations, which the scheduler batches
+// together up to its SESSIONS limit. --system-words sets a system prompt of
+// N words; the "reused" count shows how much prefill the prefix cache saved.
+// --session-file saves the conversations to PATH after the run, restarts the
+// LLM, loads them back and sends one follow-up turn per session, reporting
+// what the follow-ups still had to prefill. --model maps a weights file at
+// startup (--synthetic-model-mb first writes a 16-layer one of that size to
+// PATH) and the startup line breaks down the cold start; the page cache is
+// whatever the host has, so drop it beforehand for a true cold read.
+// --engine reference runs the CPU transformer over its built-in synthetic
+// model instead of the scripted one (replies are gibberish, but every token
+// costs a real forward pass); --write-reference-model first writes that
+// model to --model PATH so the engine runs on the mapped file. --weights
+// stores that model's matrices quantized; the "llm kernel" line times one
+// matrix-vector product per format, SIMD against the scalar reference, on
+// a matrix too big for the caches, so the f32 row shows the bandwidth cost.
+// The "llm gemm" line pushes a 64-token prefill chunk through the same
+// matrix as one MatMul and as 64 MatVecs. --threads caps the compute-pool
+// threads both the engine and that line use (all cores by default). The
+// "compute pool" line shows how the workers shared by the LLM, ASR and TTS
+// balanced the load and how long ASR and TTS work waited for a worker.
+// With the reference engine, the "kv cache" line shows the KV pages the
+// sessions held and how many of them were shared prefixes.
+// --vad-utterances first pushes N synthetic utterances (voiced bursts of
+// 0.4-1.6 s between 1.2 s silences, 10 ms per push like a capture callback)
+// through the native VAD and reports the segments it found. The pauses
+// carry white noise at --vad-noise-db dBFS (-65 by default); the "vad gate"
+// line shows how many frames the pre-gate kept from the model, and
+// --vad-no-gate runs every frame through it for comparison. The "vad
+// kernel" line times the SIMD frame features against the scalar reference.
+// --vad-speed paces the pushes at X times real time (0, the default, pushes
+// as fast as the VAD takes them). --vad-speech-s makes every burst S
+// seconds long, e.g. 25 for a dictation. --asr also transcribes the
+// segments natively and reports partials and the delay from speech end to
+// final transcript; it paces at 4x real time unless --vad-speed says
+// otherwise. The "asr encoder" line compares the audio run through the
+// encoder with the speech transcribed, and "asr stability" counts partials
+// that rewrote text an earlier partial had marked stable. --tts speaks the
+// replies natively, pulling the PCM in real time as a speaker would; the
+// "tts" line compares how soon each reply became audible with how long it
+// took to generate, the wait a speak-the-whole-reply TTS would add, and
+// "tts output" tells underruns (synthesis fell behind) from late pulls (the
+// speaker thread was not scheduled) and shows how long audio sat buffered.
+// --trace treats every request as a voice turn whose transcript was final
+// as it was submitted, prints where the turns' time went (the "turn" lines)
+// and writes them to PATH as a Chrome trace.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ai_bridge.h"
+#include "ai_bridge_host.h"
+#include "audio/frame_features.h"
+#include "core/cpu_features.h"
+#include "core/thread_pool.h"
+#include "llm/gemm.h"
+#include "llm/model_file.h"
+#include "llm/paged_kv_cache.h"
+#include "llm/quant.h"
+#include "llm/session_file.h"
+#include "llm/tensor_ops.h"
+#include "llm/transformer_engine.h"
+#include <android/log.h>
+
+namespace {
+
+constexpr Dart_Port kTokenPort = 1;
+constexpr Dart_Port kErrorPort = 2;
+constexpr Dart_Port kMetricsPort = 3;
+constexpr Dart_Port kVadPort = 4;
+constexpr Dart_Port kAsrPort = 5;
+constexpr Dart_Port kTtsPort = 6;
+
+struct PortStats {
+    std::atomic<long long> token_messages{0};
+    std::atomic<long long> token_bytes{0};
+    std::atomic<long long> error_messages{0};
+    // "llm_queue" events.
+    std::atomic<long long> dequeued{0};
+    std::atomic<long long> max_queue_depth{0};
+    std::atomic<long long> total_wait_us{0};
+    std::atomic<long long> max_wait_us{0};
+    // "llm_cancel" events.
+    std::atomic<long long> cancelled{0};
+    std::atomic<long long> total_abort_us{0};
+    std::atomic<long long> max_abort_us{0};
+    // "llm_reply" events.
+    std::atomic<long long> replies{0};
+    std::atomic<long long> total_first_token_us{0};
+    std::atomic<long long> max_first_token_us{0};
+    std::atomic<long long> total_generation_us{0};  // first token to last
+    std::atomic<long long> last_prompt_tokens{0};
+    // "reply_end" events by status.
+    std::atomic<long long> replies_by_status[3] = {};
+    // "llm_session_save" / "llm_session_load" events: [sessions, kv_tokens, bytes, elapsed_us].
+    std::atomic<long long> saved_bytes{0};
+    std::atomic<long long> save_us{0};
+    std::atomic<long long> loaded_kv_tokens{0};
+    std::atomic<long long> load_us{0};
+    // "llm_startup" event: [open_us, map_us, first_layers_us, first_token_us, mapped_bytes, prefetched_bytes].
+    std::atomic<long long> startup[6] = {};
+    // VAD events.
+    std::atomic<long long> vad_starts{0};
+    std::atomic<long long> vad_segments{0};
+    std::atomic<long long> vad_misfires{0};
+    std::atomic<long long> vad_segment_samples{0};
+    // ASR events.
+    std::atomic<long long> asr_partials{0};
+    std::atomic<long long> asr_finals{0};
+    std::atomic<long long> asr_discarded{0};
+    std::atomic<long long> asr_total_finalize_us{0};
+    std::atomic<long long> asr_max_finalize_us{0};
+    std::atomic<long long> asr_words{0};
+    std::atomic<long long> asr_stable_rewrites{0};
+    // TTS events.
+    std::atomic<long long> tts_starts{0};
+    std::atomic<long long> tts_done{0};
+    std::atomic<long long> tts_interrupted{0};
+    std::atomic<long long> tts_replies{0};
+    std::atomic<long long> tts_total_first_audio_us{0};
+    std::atomic<long long> tts_max_first_audio_us{0};
+    std::mutex asr_text_mutex;
+    std::string asr_first_final;
+    std::string asr_stable;  // stable prefix of the last partial
+};
+
+void UpdateMax(std::atomic<long long>& target, long long value) {
+    long long current = target.load();
+    while (value > current && !target.compare_exchange_weak(current, value)) {
+    }
+}
+
+// Event records are List [tag, int...]; returns the tag or "" if malformed.
+const char* EventTag(const Dart_CObject* message) {
+    if (message->type != Dart_CObject_kArray || message->value.as_array.length < 1) return "";
+    const Dart_CObject* tag = message->value.as_array.values[0];
+    return tag->type == Dart_CObject_kString ? tag->value.as_string : "";
+}
+
+int64_t EventValue(const Dart_CObject* message, intptr_t index) {
+    if (index + 1 >= message->value.as_array.length) return 0;
+    return message->value.as_array.values[index + 1]->value.as_int64;
+}
+
+bool CountMessage(Dart_Port port_id, Dart_CObject* message, void* user_data) {
+    auto* stats = static_cast<PortStats*>(user_data);
+    if (port_id == kMetricsPort) {
+        if (strcmp(EventTag(message), "llm_queue") == 0) {
+            // [request_id, priority, depth_after_dequeue, wait_us]
+            stats->dequeued++;
+            UpdateMax(stats->max_queue_depth, EventValue(message, 2));
+            stats->total_wait_us += EventValue(message, 3);
+            UpdateMax(stats->max_wait_us, EventValue(message, 3));
+        } else if (strcmp(EventTag(message), "llm_cancel") == 0) {
+            // [request_id, tokens_generated, abort_latency_us]
+            stats->cancelled++;
+            stats->total_abort_us += EventValue(message, 2);
+            UpdateMax(stats->max_abort_us, EventValue(message, 2));
+        } else if (strcmp(EventTag(message), "llm_reply") == 0) {
+            // [request_id, session_id, prompt_tokens, generated_tokens, first_token_us, total_us]
+            stats->last_prompt_tokens = EventValue(message, 2);
+            if (EventValue(message, 3) > 0) {
+                stats->replies++;
+                stats->total_first_token_us += EventValue(message, 4);
+                UpdateMax(stats->max_first_token_us, EventValue(message, 4));
+                stats->total_generation_us += EventValue(message, 5) - EventValue(message, 4);
+            }
+        } else if (strcmp(EventTag(message), "llm_startup") == 0) {
+            for (int i = 0; i < 6; ++i) stats->startup[i] = EventValue(message, i);
+        } else if (strcmp(EventTag(message), "llm_session_save") == 0) {
+            stats->saved_bytes = EventValue(message, 2);
+            stats->save_us = EventValue(message, 3);
+        } else if (strcmp(EventTag(message), "llm_session_load") == 0) {
+            stats->loaded_kv_tokens = EventValue(message, 1);
+            stats->load_us = EventValue(message, 3);
+        } else if (strcmp(EventTag(message), "asr_utterance") == 0) {
+            // [utterance_id, audio_ms, encoded_ms, encode_us, decode_us, finalize_us]
+            stats->asr_total_finalize_us += EventValue(message, 5);
+            UpdateMax(stats->asr_max_finalize_us, EventValue(message, 5));
+        } else if (strcmp(EventTag(message), "tts_reply") == 0) {
+            // [request_id, first_audio_us, chunks, audio_ms, synthesize_us]
+            stats->tts_replies++;
+            stats->tts_total_first_audio_us += EventValue(message, 1);
+            UpdateMax(stats->tts_max_first_audio_us, EventValue(message, 1));
+        }
+        return true;
+    }
+    if (port_id == kTtsPort) {
+        if (strcmp(EventTag(message), "tts_start") == 0) {
+            stats->tts_starts++;
+        } else if (strcmp(EventTag(message), "tts_done") == 0) {
+            // [request_id, interrupted]
+            stats->tts_done++;
+            if (EventValue(message, 1) != 0) stats->tts_interrupted++;
+        } else if (message->type == Dart_CObject_kString) {
+            stats->error_messages++;
+            fprintf(stderr, "tts port: %s\n", message->value.as_string);
+        }
+        return true;
+    }
+    if (port_id == kVadPort) {
+        if (strcmp(EventTag(message), "vad_speech_start") == 0) {
+            stats->vad_starts++;
+        } else if (strcmp(EventTag(message), "vad_speech_end") == 0) {
+            stats->vad_segments++;
+            stats->vad_segment_samples += EventValue(message, 1) - EventValue(message, 0);
+        } else if (strcmp(EventTag(message), "vad_misfire") == 0) {
+            stats->vad_misfires++;
+        } else if (message->type == Dart_CObject_kString) {
+            stats->error_messages++;
+            fprintf(stderr, "vad port: %s\n", message->value.as_string);
+        }
+        return true;
+    }
+    if (port_id == kAsrPort) {
+        if (strcmp(EventTag(message), "asr_partial") == 0) {
+            // [utterance_id, text, stable]
+            stats->asr_partials++;
+            const std::string text = message->value.as_array.values[2]->value.as_string;
+            const std::string stable = message->value.as_array.values[3]->value.as_string;
+            std::lock_guard<std::mutex> lock(stats->asr_text_mutex);
+            if (text.compare(0, stable.size(), stable) != 0 ||
+                stable.compare(0, stats->asr_stable.size(), stats->asr_stable) != 0) {
+                stats->asr_stable_rewrites++;
+            }
+            stats->asr_stable = stable;
+        } else if (strcmp(EventTag(message), "asr_final") == 0) {
+            // [utterance_id, text]
+            stats->asr_finals++;
+            const char* text = message->value.as_array.values[2]->value.as_string;
+            long long words = *text != 0 ? 1 : 0;
+            for (const char* c = text; *c != 0; ++c) words += *c == ' ' ? 1 : 0;
+            stats->asr_words += words;
+            std::lock_guard<std::mutex> lock(stats->asr_text_mutex);
+            if (std::string(text).compare(0, stats->asr_stable.size(), stats->asr_stable) != 0) {
+                stats->asr_stable_rewrites++;
+            }
+            stats->asr_stable.clear();
+            if (stats->asr_first_final.empty()) stats->asr_first_final = text;
+        } else if (strcmp(EventTag(message), "asr_discarded") == 0) {
+            stats->asr_discarded++;
+        } else if (message->type == Dart_CObject_kString) {
+            stats->error_messages++;
+            fprintf(stderr, "asr port: %s\n", message->value.as_string);
+        }
+        return true;
+    }
+    if (port_id == kErrorPort) {
+        stats->error_messages++;
+        if (message->type == Dart_CObject_kString) {
+            fprintf(stderr, "error port: %s\n", message->value.as_string);
+        }
+        return true;
+    }
+    if (strcmp(EventTag(message), "reply_end") == 0) {
+        // [request_id, status]
+        const int64_t status = EventValue(message, 1);
+        if (status >= 0 && status < 3) stats->replies_by_status[status]++;
+        return true;
+    }
+    // Token batches are [request_id, text].
+    if (message->type != Dart_CObject_kArray || message->value.as_array.length != 2) return true;
+    const Dart_CObject* text = message->value.as_array.values[1];
+    if (text->type == Dart_CObject_kString) {
+        stats->token_messages++;
+        stats->token_bytes += static_cast<long long>(strlen(text->value.as_string));
+    } else if (text->type == Dart_CObject_kExternalTypedData) {
+        stats->token_messages++;
+        stats->token_bytes += static_cast<long long>(text->value.as_external_typed_data.length);
+    }
+    return true;
+}
+
+struct Options {
+    int requests = 3;
+    int interval_ms = 0;
+    int timeout_ms = 30000;
+    int token_delay_us = 20000;
+    int input_words = 2;
+    bool detached = false;
+    int flush_tokens = 0;  // 0 keeps the library default
+    int flush_bytes = 0;
+    int flush_ms = 0;
+    int transport = AI_BRIDGE_TOKEN_TRANSPORT_STRING;
+    bool barge_in = false;
+    int cancel_after_ms = -1;  // < 0 never cancels
+    int sessions = 1;
+    int scheduler_sessions = 0;  // 0 keeps the library defaults
+    int scheduler_budget = 0;
+    int scheduler_chunk = 0;
+    int system_words = 0;
+    const char* session_file = nullptr;
+    const char* model = nullptr;
+    int prefetch_layers = 2;
+    int synthetic_model_mb = 0;
+    int engine = AI_BRIDGE_LLM_ENGINE_SIM;
+    bool write_reference_model = false;
+    int weight_type = AI_BRIDGE_LLM_WEIGHTS_F32;
+    int threads = 0;
+    int vad_utterances = 0;
+    int vad_frame = 512;
+    double vad_noise_db = -65.0;
+    bool vad_gate = true;
+    double vad_speed = -1.0;  // unset: 0 without ASR, 4 with it
+    double vad_speech_s = 0.0;  // unset: 0.4-1.6 s
+    bool asr = false;
+    bool tts = false;
+    const char* trace = nullptr;
+};
+
+bool ParseOptions(int argc, char** argv, Options* options) {
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        if (strcmp(arg, "--detached") == 0) {
+            options->detached = true;
+            continue;
+        }
+        if (strcmp(arg, "--barge-in") == 0) {
+            options->barge_in = true;
+            continue;
+        }
+        if (strcmp(arg, "--write-reference-model") == 0) {
+            options->write_reference_model = true;
+            continue;
+        }
+        if (strcmp(arg, "--vad-no-gate") == 0) {
+            options->vad_gate = false;
+            continue;
+        }
+        if (strcmp(arg, "--asr") == 0) {
+            options->asr = true;
+            continue;
+        }
+        if (strcmp(arg, "--tts") == 0) {
+            options->tts = true;
+            continue;
+        }
+        const char* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        if (value == nullptr) return false;
+        if (strcmp(arg, "--requests") == 0) {
+            options->requests = atoi(value);
+        } else if (strcmp(arg, "--interval-ms") == 0) {
+            options->interval_ms = atoi(value);
+        } else if (strcmp(arg, "--timeout-ms") == 0) {
+            options->timeout_ms = atoi(value);
+        } else if (strcmp(arg, "--token-delay-us") == 0) {
+            options->token_delay_us = atoi(value);
+        } else if (strcmp(arg, "--system-words") == 0) {
+            options->system_words = atoi(value);
+        } else if (strcmp(arg, "--vad-utterances") == 0) {
+            options->vad_utterances = atoi(value);
+        } else if (strcmp(arg, "--vad-frame") == 0) {
+            options->vad_frame = atoi(value);
+        } else if (strcmp(arg, "--vad-speed") == 0) {
+            options->vad_speed = atof(value);
+        } else if (strcmp(arg, "--vad-speech-s") == 0) {
+            options->vad_speech_s = atof(value);
+        } else if (strcmp(arg, "--vad-noise-db") == 0) {
+            options->vad_noise_db = atof(value);
+
+        } else if (strcmp(arg, "--trace") == 0) {
+            options->trace = value;
+        } else if (strcmp(arg, "--model") == 0) {
+            options->model = value;
+        } else if (strcmp(arg, "--prefetch-layers") == 0) {
+            options->prefetch_layers = atoi(value);
+        } else if (strcmp(arg, "--synthetic-model-mb") == 0) {
+            options->synthetic_model_mb = atoi(value);
+        } else if (strcmp(arg, "--weights") == 0) {
+            if (strcmp(value, "f32") == 0) {
+                options->weight_type = AI_BRIDGE_LLM_WEIGHTS_F32;
+            } else if (strcmp(value, "q8_0") == 0) {
+                options->weight_type = AI_BRIDGE_LLM_WEIGHTS_Q8_0;
+            } else if (strcmp(value, "q4_0") == 0) {
+                options->weight_type = AI_BRIDGE_LLM_WEIGHTS_Q4_0;
+            } else {
+                return false;
+            }
+        } else if (strcmp(arg, "--threads") == 0) {
+            options->threads = atoi(value);
+        } else if (strcmp(arg, "--engine") == 0) {
+            if (strcmp(value, "sim") == 0) {
+                options->engine = AI_BRIDGE_LLM_ENGINE_SIM;
+            } else if (strcmp(value, "reference") == 0) {
+                options->engine = AI_BRIDGE_LLM_ENGINE_REFERENCE;
+            } else {
+                return false;
+            }
+        } else if (strcmp(arg, "--session-file") == 0) {
+            options->session_file = value;
+        } else if (strcmp(arg, "--sessions") == 0) {
+            options->sessions = atoi(value);
+        } else if (strcmp(arg, "--scheduler") == 0) {
+            if (sscanf(value, "%d,%d,%d", &options->scheduler_sessions, &options->scheduler_budget,
+                       &options->scheduler_chunk) != 3) {
+                return false;
+            }
+        } else if (strcmp(arg, "--cancel-after-ms") == 0) {
+            options->cancel_after_ms = atoi(value);
+        } else if (strcmp(arg, "--input-words") == 0) {
+            options->input_words = atoi(value);
+        } else if (strcmp(arg, "--transport") == 0) {
+            if (strcmp(value, "string") == 0) {
+                options->transport = AI_BRIDGE_TOKEN_TRANSPORT_STRING;
+            } else if (strcmp(value, "external") == 0) {
+                options->transport = AI_BRIDGE_TOKEN_TRANSPORT_EXTERNAL_TYPED_DATA;
+            } else {
+                return false;
+            }
+        } else if (strcmp(arg, "--flush") == 0) {
+            if (sscanf(value, "%d,%d,%d", &options->flush_tokens, &options->flush_bytes, &options->flush_ms) != 3) {
+                return false;
+            }
+        } else {
+            return false;
+        }
+        ++i;
+    }
+    return options->requests > 0 && options->sessions > 0 &&
+           (options->synthetic_model_mb == 0 || options->model != nullptr) &&
+           (!options->write_reference_model || options->model != nullptr);
+}
+
+// Embeddings, 16 equal layers and an output head totalling about `megabytes`.
+bool WriteSyntheticModel(const char* path, int megabytes) {
+    constexpr int kLayers = 16;
+    const uint64_t tensor_bytes = static_cast<uint64_t>(megabytes) * 1024 * 1024 / (kLayers + 2);
+    std::vector<uint8_t> weights(static_cast<size_t>(tensor_bytes), 0x3c);
+    const int64_t elements = static_cast<int64_t>(tensor_bytes / sizeof(float));
+    ai_bridge::ModelFileWriter writer;
+    writer.add_tensor("token_embd", ai_bridge::TensorType::kF32, -1, {elements}, weights.data(), tensor_bytes);
+    for (int layer = 0; layer < kLayers; ++layer) {
+        writer.add_tensor("blk." + std::to_string(layer) + ".ffn", ai_bridge::TensorType::kF32, layer, {elements},
+                          weights.data(), tensor_bytes);
+    }
+    writer.add_tensor("output", ai_bridge::TensorType::kF32, -1, {elements}, weights.data(), tensor_bytes);
+    std::string error;
+    if (writer.write(path, &error) == 0) {
+        fprintf(stderr, "%s\n", error.c_str());
+        return false;
+    }
+    return true;
+}
+
+// Largest difference, relative to the reference (absolute below 1), an
+// optimized kernel may show against its scalar reference. They differ only
+// in summation order.
+constexpr float kKernelTolerance = 1e-4f;
+
+bool WithinKernelTolerance(float value, float reference) {
+    return std::fabs(value - reference) <= kKernelTolerance * std::max(1.0f, std::fabs(reference));
+}
+
+// Pushes `utterances` voiced bursts separated by near-silence through the
+// native VAD, 10 ms at a time. Bursts are 200 ms syllables with 100 ms
+// breaks, short enough for the VAD to bridge. Returns the pushed duration
+// in seconds; *kernel_matches is cleared if the SIMD frame features are
+// off their scalar reference.
+double RunVad(const Options& options, bool* kernel_matches) {
+    constexpr int kRate = 16000;
+    constexpr int kChunk = kRate / 100;
+    // The v5 defaults for 512-sample frames, the legacy ones for 1536.
+    const bool legacy = options.vad_frame == 1536;
+    native_vad_configure(options.vad_frame, legacy ? 3 : 8, legacy ? 10 : 30, legacy ? 8 : 24, 0.5f, 0.35f, 1);
+    native_vad_configure_gate(options.vad_gate ? 1 : 0, -60.0f, 3.0f);
+    if (options.asr && !native_asr_start(kAsrPort, 300)) return 0.0;
+    if (!native_vad_start(kVadPort, 0)) return 0.0;
+
+    std::vector<float> audio;
+    uint32_t noise = 12345;
+    // Uniform noise in [-a/2, a/2] has an RMS of a / sqrt(12).
+    const float hiss_span = static_cast<float>(std::pow(10.0, options.vad_noise_db / 20.0) * std::sqrt(12.0));
+    auto push_span = [&](double seconds, float amplitude) {
+        const int samples = static_cast<int>(seconds * kRate);
+        for (int i = 0; i < samples; ++i) {
+            noise = noise * 1664525u + 1013904223u;
+            const float hiss = (static_cast<float>(noise >> 8) / 16777216.0f - 0.5f) * hiss_span;
+            const double t = static_cast<double>(audio.size()) / kRate;
+            const float envelope = std::fmod(t, 0.3) < 0.2 ? amplitude : 0.0f;
+            const float voice = envelope * static_cast<float>(std::sin(2 * M_PI * 180 * t) + 0.5 * std::sin(2 * M_PI * 360 * t));
+            audio.push_back(voice + hiss);
+        }
+    };
+    push_span(1.2, 0.0f);
+    for (int u = 0; u < options.vad_utterances; ++u) {
+        push_span(options.vad_speech_s > 0.0 ? options.vad_speech_s : 0.4 + 0.4 * (u % 4), 0.2f);
+        push_span(1.2, 0.0f);
+    }
+    const double speed = options.vad_speed >= 0.0 ? options.vad_speed : (options.asr ? 4.0 : 0.0);
+    const auto pushing_since = std::chrono::steady_clock::now();
+    for (size_t offset = 0; offset < audio.size();) {
+        if (speed > 0.0) {
+            std::this_thread::sleep_until(pushing_since + std::chrono::microseconds(static_cast<int64_t>(
+                                                              offset * 1e6 / kRate / speed)));
+        }
+        const int count = static_cast<int>(std::min<size_t>(kChunk, audio.size() - offset));
+        const int accepted = native_vad_push_pcm(audio.data() + offset, count);
+        offset += static_cast<size_t>(accepted);
+        if (accepted < count) std::this_thread::sleep_for(std::chrono::milliseconds(1));  // ring full
+    }
+    native_vad_stop();
+    if (options.asr) native_asr_stop();
+
+    // Kernel check on the same audio: SIMD against the scalar reference.
+    const size_t frame = static_cast<size_t>(options.vad_frame);
+    const size_t frames = audio.size() / frame;
+    float max_error = 0.0f;
+    bool matches = true;
+    double sink = 0.0;
+    auto time_ns = [&](ai_bridge::FrameFeatures (*compute)(const float*, size_t)) {
+        const auto started = std::chrono::steady_clock::now();
+        for (int pass = 0; pass < 20; ++pass) {
+            for (size_t f = 0; f < frames; ++f) sink += compute(audio.data() + f * frame, frame).high_band_ratio;
+        }
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - started).count() / (20.0 * frames);
+    };
+    for (size_t f = 0; f < frames; ++f) {
+        const ai_bridge::FrameFeatures simd = ai_bridge::ComputeFrameFeatures(audio.data() + f * frame, frame);
+        const ai_bridge::FrameFeatures scalar = ai_bridge::ComputeFrameFeaturesScalar(audio.data() + f * frame, frame);
+        max_error = std::max({max_error, std::fabs(simd.rms_db - scalar.rms_db),
+                              std::fabs(simd.zero_crossing_rate - scalar.zero_crossing_rate),
+                              std::fabs(simd.high_band_ratio - scalar.high_band_ratio)});
+        matches = matches && WithinKernelTolerance(simd.rms_db, scalar.rms_db) &&
+                  WithinKernelTolerance(simd.zero_crossing_rate, scalar.zero_crossing_rate) &&
+                  WithinKernelTolerance(simd.high_band_ratio, scalar.high_band_ratio);
+    }
+    const double simd_ns = time_ns(ai_bridge::ComputeFrameFeatures);
+    const double scalar_ns = time_ns(ai_bridge::ComputeFrameFeaturesScalar);
+    printf("vad kernel         %s %.0f ns/frame, scalar %.0f ns/frame, max difference %.2g%s%s\n",
+           ai_bridge::FrameFeaturesBackend(), simd_ns, scalar_ns, max_error, matches ? "" : " (FAILED)",
+           sink < 0 ? " " : "");
+    if (!matches) *kernel_matches = false;
+    return static_cast<double>(audio.size()) / kRate;
+}
+
+// Times y = W x for a kRows x kCols matrix in every weight format, through
+// the dispatched kernels and through the scalar references, then the
+// prefill GEMM against a loop of matvecs. Returns false if a kernel is off
+// its reference.
+bool ReportMatVecKernels(int threads) {
+    using ai_bridge::TensorType;
+    constexpr int32_t kRows = 2048;
+    constexpr int32_t kCols = 2048;
+    constexpr int32_t kBlocks = kCols / ai_bridge::kQuantBlock;
+    constexpr int kPasses = 20;
+    std::vector<float> w(static_cast<size_t>(kRows) * kCols);
+    std::vector<float> x(kCols);
+    uint32_t state = 1;
+    auto next = [&state] {
+        state = state * 1664525u + 1013904223u;
+        return static_cast<float>(state >> 8) / static_cast<float>(1 << 24) - 0.5f;
+    };
+    for (float& value : w) value = next();
+    for (float& value : x) value = next();
+    std::vector<ai_bridge::BlockQ8_0> xq(kBlocks);
+    ai_bridge::QuantizeRow(TensorType::kQ8_0, x.data(), xq.data(), kCols);
+
+    std::vector<float> simd(kRows);
+    std::vector<float> scalar(kRows);
+    auto time_ms = [](auto&& run) {
+        run();  // warm
+        const auto started = std::chrono::steady_clock::now();
+        for (int pass = 0; pass < kPasses; ++pass) run();
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count() / kPasses;
+    };
+
+    bool matches = true;
+    printf("llm kernel         %s, %dx%d matvec", ai_bridge::QuantKernelBackend(), kRows, kCols);
+    for (const TensorType type : {TensorType::kF32, TensorType::kQ8_0, TensorType::kQ4_0}) {
+        const size_t row_bytes = ai_bridge::RowBytes(type, kCols);
+        std::vector<uint8_t> stored(row_bytes * kRows);
+        for (int32_t r = 0; r < kRows; ++r) {
+            ai_bridge::QuantizeRow(type, w.data() + static_cast<size_t>(r) * kCols, stored.data() + row_bytes * r, kCols);
+        }
+        const ai_bridge::WeightMatrix matrix{stored.data(), type};
+        std::vector<ai_bridge::BlockQ8_0> scratch;
+        const double simd_ms =
+            time_ms([&] { ai_bridge::MatVec(matrix, x.data(), simd.data(), kRows, kCols, &scratch); });
+        const double scalar_ms = time_ms([&] {
+            for (int32_t r = 0; r < kRows; ++r) {
+                const uint8_t* row = stored.data() + row_bytes * r;
+                if (type == TensorType::kF32) {
+                    scalar[r] = ai_bridge::DotScalar(reinterpret_cast<const float*>(row), x.data(), kCols);
+                } else if (type == TensorType::kQ8_0) {
+                    scalar[r] = ai_bridge::VecDotQ8_0Scalar(reinterpret_cast<const ai_bridge::BlockQ8_0*>(row),
+                                                            xq.data(), kBlocks);
+                } else {
+                    scalar[r] = ai_bridge::VecDotQ4_0Scalar(reinterpret_cast<const ai_bridge::BlockQ4_0*>(row),
+                                                            xq.data(), kBlocks);
+                }
+            }
+        });
+        float max_error = 0.0f;
+        bool type_matches = true;
+        for (int32_t r = 0; r < kRows; ++r) {
+            max_error = std::max(max_error, std::fabs(simd[r] - scalar[r]));
+            type_matches = type_matches && WithinKernelTolerance(simd[r], scalar[r]);
+        }
+        printf("%s %s %.2f ms (%.1f GB/s, scalar %.2f ms, max difference %.2g%s)",
+               type == TensorType::kF32 ? ":" : ",", ai_bridge::TensorTypeName(type), simd_ms,
+               static_cast<double>(stored.size()) / simd_ms / 1e6, scalar_ms, max_error,
+               type_matches ? "" : ", FAILED");
+        matches = matches && type_matches;
+    }
+    printf("\n");
+
+    constexpr int32_t kTokens = 64;
+    std::vector<float> xs(static_cast<size_t>(kTokens) * kCols);
+    for (float& value : xs) value = next();
+    std::vector<float> gemm(static_cast<size_t>(kTokens) * kRows);
+    std::vector<float> matvec(gemm.size());
+    ai_bridge::ThreadPool& pool = ai_bridge::ComputePool();
+    printf("llm gemm           %s, %d threads, %d tokens", ai_bridge::GemmKernelBackend(),
+           threads > 0 ? std::min(threads, pool.size()) : pool.size(), kTokens);
+    for (const TensorType type : {TensorType::kF32, TensorType::kQ8_0, TensorType::kQ4_0}) {
+        const size_t row_bytes = ai_bridge::RowBytes(type, kCols);
+        std::vector<uint8_t> stored(row_bytes * kRows);
+        for (int32_t r = 0; r < kRows; ++r) {
+            ai_bridge::QuantizeRow(type, w.data() + static_cast<size_t>(r) * kCols, stored.data() + row_bytes * r, kCols);
+        }
+        const ai_bridge::WeightMatrix matrix{stored.data(), type};
+        std::vector<ai_bridge::BlockQ8_0> scratch;
+        const double gemm_ms = time_ms(
+            [&] { ai_bridge::MatMul(matrix, xs.data(), gemm.data(), kTokens, kRows, kCols, &pool, threads); });
+        const double matvec_ms = time_ms([&] {
+            for (int32_t t = 0; t < kTokens; ++t) {
+                ai_bridge::MatVec(matrix, xs.data() + static_cast<size_t>(t) * kCols,
+                                  matvec.data() + static_cast<size_t>(t) * kRows, kRows, kCols, &scratch);
+            }
+        });
+        float max_error = 0.0f;
+        bool type_matches = true;
+        for (size_t i = 0; i < gemm.size(); ++i) {
+            max_error = std::max(max_error, std::fabs(gemm[i] - matvec[i]));
+            type_matches = type_matches && WithinKernelTolerance(gemm[i], matvec[i]);
+        }
+        printf("%s %s %.2f ms (%.1f GFLOP/s, matvec loop %.2f ms, max difference %.2g%s)",
+               type == TensorType::kF32 ? ":" : ",", ai_bridge::TensorTypeName(type), gemm_ms,
+               2.0 * kTokens * kRows * kCols / gemm_ms / 1e6, matvec_ms, max_error, type_matches ? "" : ", FAILED");
+        matches = matches && type_matches;
+    }
+    printf("\n");
+    return matches;
+}
+
+// Polls until `expected` replies ended in total (token stats are cumulative
+// across LLM restarts) or the timeout passes.
+bool WaitForReplies(int expected, int timeout_ms, AiBridgeTokenStats* token_stats) {
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    while (std::chrono::steady_clock::now() < deadline) {
+        native_get_token_stats(token_stats);
+        if (token_stats->replies_completed >= expected) return true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return false;
+}
+
+// Session `session_id` of a session file: its history, then the tokens its
+// last reply still owed to the cache. Empty if the file or session is missing.
+std::vector<ai_bridge::LlmToken> ReadSessionTokens(const std::string& path, int64_t session_id,
+                                                   uint32_t* pending_count) {
+    std::vector<ai_bridge::LlmToken> tokens;
+    ai_bridge::MappedSessionFile file;
+    std::string error;
+    if (!file.open(path, &error)) return tokens;
+    for (uint32_t s = 0; s < file.header().session_count; ++s) {
+        const ai_bridge::SessionFileSession& session = file.sessions()[s];
+        if (session.session_id != session_id) continue;
+        const ai_bridge::LlmToken* history = file.tokens_at(session.tokens_offset);
+        const ai_bridge::LlmToken* pending = file.tokens_at(session.pending_offset);
+        tokens.assign(history, history + session.token_count);
+        tokens.insert(tokens.end(), pending, pending + session.pending_count);
+        *pending_count = session.pending_count;
+    }
+    return tokens;
+}
+
+// Saves a conversation in the middle of its first reply, resumes it in a
+// fresh engine and has it answer a follow-up. Then replays the conversation
+// without saving, the first reply cut off at the token the save kept, and
+// has it answer the same follow-up. Both must end with the same token
+// history. Leaves the reply cap at the cut. *cut_at is the reply tokens the save kept, or 0 if the reply
+// ended before the save and nothing was checked.
+bool CheckMidReplySave(const Options& options, int32_t* cut_at) {
+    constexpr int64_t kSession = 0;
+    constexpr const char* kTurn = "request 0 word0 word1";
+    constexpr const char* kFollowUp = "and then?";
+    const std::string mid_path = std::string(options.session_file) + ".mid";
+    const std::string resumed_path = std::string(options.session_file) + ".resumed";
+    const std::string replayed_path = std::string(options.session_file) + ".replayed";
+    PortStats stats;
+    ai_bridge_host_set_post_handler(CountMessage, &stats);
+    AiBridgeTokenStats token_stats = {};
+    auto start = [] {
+        native_initialize_metrics_port(kMetricsPort);
+        native_initialize_llm_ports(kTokenPort, kErrorPort);
+    };
+    // Submits `text` and waits for its reply to end.
+    auto ask = [&](const char* text) {
+        native_get_token_stats(&token_stats);
+        const int expected = static_cast<int>(token_stats.replies_completed) + 1;
+        return native_submit_llm_session_request(kSession, text, 0) != 0 &&
+               WaitForReplies(expected, options.timeout_ms, &token_stats);
+    };
+    *cut_at = 0;
+
+    // Save a few tokens into the reply, then drop the rest of it.
+    start();
+    native_get_token_stats(&token_stats);
+    const int expected = static_cast<int>(token_stats.replies_completed) + 1;
+    const int64_t published = token_stats.tokens_published;
+    bool ok = native_submit_llm_session_request(kSession, kTurn, 0) != 0;
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(options.timeout_ms);
+    while (ok && token_stats.tokens_published < published + 8 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        native_get_token_stats(&token_stats);
+    }
+    ok = ok && native_save_session(mid_path.c_str()) != 0;
+    native_cancel_all_llm_requests();
+    ok = ok && WaitForReplies(expected, options.timeout_ms, &token_stats);
+    native_dispose_llm();
+    uint32_t pending_count = 0;
+    const std::vector<ai_bridge::LlmToken> saved = ReadSessionTokens(mid_path, kSession, &pending_count);
+    // Only a reply still generating when the save ran is cut by the cancel.
+    if (!ok || saved.empty() || stats.replies_by_status[AI_BRIDGE_REPLY_CANCELLED] == 0) {
+        ai_bridge_host_set_post_handler(nullptr, nullptr);
+        return ok && !saved.empty() && stats.error_messages == 0;
+    }
+    // The history, then the sampled token and the EOS closing the turn.
+    *cut_at = static_cast<int32_t>(saved.size() - 1 - stats.last_prompt_tokens.load());
+
+    // The replay needs the reply cap at the cut; the follow-ups get it too.
+    native_set_llm_max_reply_tokens(*cut_at);
+    start();
+    ok = native_load_session(mid_path.c_str()) != 0 && ask(kFollowUp) && native_save_session(resumed_path.c_str()) != 0;
+    native_dispose_llm();
+
+    // The same conversation, never saved: its reply ends where the save cut it.
+    start();
+    ok = ok && ask(kTurn) && ask(kFollowUp) && native_save_session(replayed_path.c_str()) != 0;
+    native_dispose_llm();
+    ai_bridge_host_set_post_handler(nullptr, nullptr);
+
+    uint32_t resumed_pending = 0;
+    uint32_t replayed_pending = 0;
+    const std::vector<ai_bridge::LlmToken> resumed = ReadSessionTokens(resumed_path, kSession, &resumed_pending);
+    return ok && stats.error_messages == 0 && !resumed.empty() &&
+           resumed == ReadSessionTokens(replayed_path, kSession, &replayed_pending);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!ParseOptions(argc, argv, &options)) {
+        fprintf(stderr,
+                "usage: %s [--requests N] [--interval-ms MS] [--timeout-ms MS]\n"
+                "          [--token-delay-us US] [--input-words N] [--detached]\n"
+                "          [--flush TOKENS,BYTES,MS] [--transport string|external]\n"
+                "          [--barge-in] [--cancel-after-ms MS]\n"
+                "          [--sessions N] [--scheduler SESSIONS,BUDGET,CHUNK]\n"
+                "          [--system-words N] [--session-file PATH]\n"
+                "          [--model PATH] [--prefetch-layers N] [--synthetic-model-mb MB]\n"
+                "          [--engine sim|reference] [--write-reference-model]\n"
+                "          [--weights f32|q8_0|q4_0] [--threads N]\n"
+                "          [--vad-utterances N] [--vad-frame 512|1536]\n"
+                "          [--vad-noise-db DB] [--vad-no-gate] [--vad-speed X]\n"
+                "          [--vad-speech-s S] [--asr] [--tts] [--trace PATH]\n",
+                argv[0]);
+        return 2;
+    }
+
+    if (options.synthetic_model_mb > 0 && !WriteSyntheticModel(options.model, options.synthetic_model_mb)) return 1;
+
+    PortStats stats;
+    ai_bridge_host_set_log_priority(ANDROID_LOG_WARN);
+    ai_bridge_host_set_post_handler(CountMessage, &stats);
+
+    native_initialize_dart_api(nullptr);
+    native_initialize_metrics_port(kMetricsPort);
+    bool kernels_match = true;
+    const double vad_seconds = options.vad_utterances > 0 ? RunVad(options, &kernels_match) : 0.0;
+    native_set_sim_token_delay_us(options.token_delay_us);
+    native_set_llm_engine(options.engine);
+    native_set_llm_weight_type(options.weight_type);
+    native_set_llm_threads(options.threads);
+    if (options.engine == AI_BRIDGE_LLM_ENGINE_REFERENCE && !ReportMatVecKernels(options.threads)) {
+        kernels_match = false;
+    }
+    if (options.write_reference_model && native_write_reference_model(options.model) == 0) return 1;
+    native_set_token_transport(options.transport);
+    native_set_llm_barge_in(options.barge_in ? 1 : 0);
+    if (options.scheduler_sessions > 0) {
+        native_configure_llm_scheduler(options.scheduler_sessions, options.scheduler_budget, options.scheduler_chunk);
+    }
+    if (options.flush_tokens > 0) {
+        native_set_token_flush_policy(options.flush_tokens, options.flush_bytes, options.flush_ms);
+    }
+    std::string system_prompt;
+    for (int w = 0; w < options.system_words; ++w) system_prompt += "system" + std::to_string(w) + " ";
+    native_set_llm_system_prompt(system_prompt.c_str());
+    native_set_llm_model(options.model != nullptr ? options.model : "", options.prefetch_layers);
+    native_initialize_metrics_port(kMetricsPort);
+    native_initialize_llm_ports(options.detached ? ILLEGAL_PORT : kTokenPort, kErrorPort);
+
+    // The speaker: pulls 10 ms of speech every 10 ms.
+    std::atomic<bool> speaking{options.tts && native_tts_start(kTtsPort, 0) != 0};
+    std::thread speaker;
+    if (speaking) {
+        speaker = std::thread([&speaking] {
+            const int32_t chunk = native_tts_sample_rate() / 100;
+            std::vector<float> pcm(static_cast<size_t>(chunk));
+            auto next = std::chrono::steady_clock::now();
+            while (speaking.load()) {
+                native_tts_pull_pcm(pcm.data(), chunk);
+                next += std::chrono::milliseconds(10);
+                std::this_thread::sleep_until(next);
+            }
+        });
+    }
+
+    AiBridgeTokenStats token_stats = {};
+    int accepted = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < options.requests; ++i) {
+        std::string input = "request " + std::to_string(i);
+        for (int w = 0; w < options.input_words; ++w) input += " word" + std::to_string(w);
+        int64_t turn_id = 0;
+        if (options.trace != nullptr) {
+            turn_id = native_trace_begin_turn();
+            native_trace_mark(turn_id, AI_BRIDGE_TURN_STAGE_TRANSCRIPT_FINAL);
+        }
+        const int64_t request_id = native_submit_llm_session_request(i % options.sessions, input.c_str(), 0);
+        if (request_id != 0) ++accepted;
+        if (turn_id != 0) native_trace_attach_request(turn_id, request_id);
+        if (request_id != 0 && options.cancel_after_ms >= 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(options.cancel_after_ms));
+            native_cancel_request(request_id);
+        }
+        if (i + 1 < options.requests) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(options.interval_ms));
+        }
+    }
+
+    WaitForReplies(accepted, options.timeout_ms, &token_stats);
+    const double elapsed_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (speaker.joinable()) {
+        // Let the last reply play out.
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(options.timeout_ms);
+        while (stats.tts_done.load() < accepted && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        speaking = false;
+        speaker.join();
+        native_tts_stop();
+    }
+
+    if (options.session_file != nullptr) native_save_session(options.session_file);
+    native_dispose_llm();
+    native_get_token_stats(&token_stats);
+    AiBridgeSchedulerStats scheduler_stats = {};
+    native_get_llm_scheduler_stats(&scheduler_stats);
+    // The resume phase keeps counting; the report covers the requests above.
+    long long replies_by_status[3];
+    for (int s = 0; s < 3; ++s) replies_by_status[s] = stats.replies_by_status[s].load();
+
+    // Resume every conversation in a fresh engine, as a restarted app would.
+    AiBridgeSchedulerStats resume_stats = {};
+    bool resumed = true;
+    if (options.session_file != nullptr) {
+        native_initialize_metrics_port(kMetricsPort);
+        native_initialize_llm_ports(options.detached ? ILLEGAL_PORT : kTokenPort, kErrorPort);
+        resumed = native_load_session(options.session_file) != 0;
+        int follow_ups = 0;
+        for (int s = 0; s < options.sessions && resumed; ++s) {
+            if (native_submit_llm_session_request(s, "and then?", 0) != 0) ++follow_ups;
+        }
+        AiBridgeTokenStats resume_tokens = {};
+        resumed = resumed && WaitForReplies(static_cast<int>(token_stats.replies_completed) + follow_ups,
+                                            options.timeout_ms, &resume_tokens);
+        native_dispose_llm();
+        native_get_llm_scheduler_stats(&resume_stats);
+    }
+    ai_bridge_host_set_post_handler(nullptr, nullptr);
+
+    printf("requests sent      %d (%d accepted)\n", options.requests, accepted);
+    if (options.vad_utterances > 0) {
+        AiBridgeVadStats vad_stats = {};
+        native_get_vad_stats(&vad_stats);
+        printf("vad                %.1f s of audio, %lld frames, %lld starts, %lld segments (%.2f s mean), %lld misfires\n",
+               vad_seconds, (long long)vad_stats.frames_processed, stats.vad_starts.load(), stats.vad_segments.load(),
+               stats.vad_segments > 0 ? stats.vad_segment_samples.load() / 16000.0 / stats.vad_segments.load() : 0.0,
+               stats.vad_misfires.load());
+        const long long model_frames = vad_stats.frames_processed - vad_stats.frames_gated;
+        printf("vad gate           %lld of %lld frames skipped the model (%.0f%%), %.2f us/frame in the gate\n",
+               (long long)vad_stats.frames_gated, (long long)vad_stats.frames_processed,
+               vad_stats.frames_processed > 0 ? 100.0 * vad_stats.frames_gated / vad_stats.frames_processed : 0.0,
+               vad_stats.frames_processed > 0 ? (double)vad_stats.gate_us / vad_stats.frames_processed : 0.0);
+        printf("vad model          %.2f us/frame over %lld frames, %lld us total, %lld samples dropped\n",
+               model_frames > 0 ? (double)vad_stats.model_us / model_frames : 0.0, model_frames,
+               (long long)vad_stats.model_us, (long long)vad_stats.samples_dropped);
+    }
+    if (options.vad_utterances > 0 && options.asr) {
+        AiBridgeAsrStats asr_stats = {};
+        native_get_asr_stats(&asr_stats);
+        const long long finals = stats.asr_finals.load();
+        printf("asr                %lld finals (%lld words), %lld partials, %lld discarded; \"%s\"\n", finals,
+               stats.asr_words.load(), stats.asr_partials.load(), stats.asr_discarded.load(),
+               stats.asr_first_final.c_str());
+        printf("asr latency        speech end -> final mean %.1f ms, max %.1f ms\n",
+               finals > 0 ? stats.asr_total_finalize_us.load() / 1000.0 / finals : 0.0,
+               stats.asr_max_finalize_us.load() / 1000.0);
+        printf("asr encoder        %.1f s encoded for %.1f s of speech (%.1fx), encode %lld ms, decode %lld ms, %lld samples dropped\n",
+               asr_stats.encoded_ms / 1000.0, asr_stats.audio_ms / 1000.0,
+               asr_stats.audio_ms > 0 ? (double)asr_stats.encoded_ms / asr_stats.audio_ms : 0.0,
+               (long long)(asr_stats.encode_us / 1000), (long long)(asr_stats.decode_us / 1000),
+               (long long)asr_stats.samples_dropped);
+        printf("asr stability      %lld partials rewrote stable text\n", stats.asr_stable_rewrites.load());
+    }
+    printf("startup            open %.1f ms, map %.1f ms, first layers %.1f ms, first token %.1f ms"
+           " (%lld of %lld bytes prefetched)\n",
+           stats.startup[0].load() / 1000.0, stats.startup[1].load() / 1000.0, stats.startup[2].load() / 1000.0,
+           stats.startup[3].load() / 1000.0, stats.startup[5].load(), stats.startup[4].load());
+    printf("queue              max depth %lld, wait mean %.1f ms, max %.1f ms\n", stats.max_queue_depth.load(),
+           stats.dequeued > 0 ? stats.total_wait_us.load() / 1000.0 / stats.dequeued.load() : 0.0,
+           stats.max_wait_us.load() / 1000.0);
+    printf("replies completed  %lld (%lld finished, %lld cancelled, %lld failed)\n",
+           (long long)token_stats.replies_completed, replies_by_status[AI_BRIDGE_REPLY_COMPLETED],
+           replies_by_status[AI_BRIDGE_REPLY_CANCELLED], replies_by_status[AI_BRIDGE_REPLY_FAILED]);
+    printf("first token        mean %.1f ms, max %.1f ms\n",
+           stats.replies > 0 ? stats.total_first_token_us.load() / 1000.0 / stats.replies.load() : 0.0,
+           stats.max_first_token_us.load() / 1000.0);
+    if (options.tts) {
+        AiBridgeTtsStats tts_stats = {};
+        native_get_tts_stats(&tts_stats);
+        const long long spoken = stats.tts_replies.load();
+        printf("tts                %lld replies spoken (%lld cut off) in %lld chunks, %.1f s of speech, synthesis %.2fx real time\n",
+               spoken, stats.tts_interrupted.load(), (long long)tts_stats.chunks, tts_stats.audio_ms / 1000.0,
+               tts_stats.audio_ms > 0 ? tts_stats.synthesize_us / 1000.0 / tts_stats.audio_ms : 0.0);
+        printf("tts first audio    mean %.1f ms, max %.1f ms after the first token; replies took %.1f ms to generate\n",
+               spoken > 0 ? stats.tts_total_first_audio_us.load() / 1000.0 / spoken : 0.0,
+               stats.tts_max_first_audio_us.load() / 1000.0,
+               stats.replies > 0 ? stats.total_generation_us.load() / 1000.0 / stats.replies.load() : 0.0);
+        AiBridgeAudioOutputStats output = {};
+        native_get_audio_output_stats(&output);
+        const double ms_per_sample = 1000.0 / std::max(1, native_tts_sample_rate());
+        printf("tts output         %lld underruns (%.1f ms of silence), %lld of %lld pulls late (max gap %.1f ms), "
+               "fill %.0f-%.0f ms, buffered mean %.1f ms, max %.1f ms\n",
+               (long long)output.underruns, output.underrun_samples * ms_per_sample, (long long)output.late_callbacks,
+               (long long)output.callbacks, output.max_callback_gap_us / 1000.0, output.min_fill_samples * ms_per_sample,
+               output.max_fill_samples * ms_per_sample,
+               output.latency_samples > 0 ? output.latency_us_total / 1000.0 / output.latency_samples : 0.0,
+               output.latency_us_max / 1000.0);
+    }
+    printf("decode steps       %lld (%lld prefill + %lld generated tokens, up to %lld sessions/step, %lld evicted)\n",
+           (long long)scheduler_stats.decode_steps, (long long)scheduler_stats.prefill_tokens,
+           (long long)scheduler_stats.generated_tokens, (long long)scheduler_stats.max_batch_sessions,
+           (long long)scheduler_stats.sessions_evicted);
+    printf("prompt tokens      %lld prefilled, %lld reused from cached prefixes\n",
+           (long long)scheduler_stats.prefill_tokens, (long long)scheduler_stats.reused_tokens);
+    printf("cancellations      %lld, abort latency mean %.1f ms, max %.1f ms\n", stats.cancelled.load(),
+           stats.cancelled > 0 ? stats.total_abort_us.load() / 1000.0 / stats.cancelled.load() : 0.0,
+           stats.max_abort_us.load() / 1000.0);
+    printf("tokens published   %lld (%lld producer stalls, %lld dropped)\n", (long long)token_stats.tokens_published,
+           (long long)token_stats.producer_stalls, (long long)token_stats.tokens_dropped);
+    printf("token messages     %lld (%lld bytes, %lld post failures, %.2f tok/msg)\n", stats.token_messages.load(),
+           stats.token_bytes.load(), (long long)token_stats.post_failures,
+           stats.token_messages > 0 ? (double)token_stats.tokens_drained / stats.token_messages.load() : 0.0);
+    printf("token slabs        %lld allocated, %lld in flight\n", (long long)token_stats.slabs_allocated,
+           (long long)token_stats.slabs_in_flight);
+    {
+        // Read back through the binary snapshot, as the app does.
+        std::vector<uint8_t> snapshot(static_cast<size_t>(native_snapshot_metrics(nullptr, 0)));
+        native_snapshot_metrics(snapshot.data(), static_cast<int32_t>(snapshot.size()));
+        uint16_t counts[3];
+        memcpy(counts, snapshot.data() + 6, sizeof(counts));
+        auto value = [&](size_t index) {
+            int64_t v;
+            memcpy(&v, snapshot.data() + 24 + index * sizeof(int64_t), sizeof(v));
+            return static_cast<long long>(v);
+        };
+        const size_t gauges = counts[0];
+        const size_t histograms = gauges + counts[1] * 2;
+        auto histogram = [&](size_t h, size_t field) { return value(histograms + h * 6 + field); };
+        printf("metrics            %lld tokens, %lld post failures of %lld posts, queue depth max %lld, "
+               "prefill p50 %lld tok/s, decode p50 %lld tok/s, decode step p99 %.2f ms\n",
+               value(AI_BRIDGE_METRIC_COUNTER_TOKENS_GENERATED), value(AI_BRIDGE_METRIC_COUNTER_DART_POST_FAILURES),
+               value(AI_BRIDGE_METRIC_COUNTER_DART_POSTS), value(gauges + AI_BRIDGE_METRIC_GAUGE_QUEUE_DEPTH * 2 + 1),
+               histogram(AI_BRIDGE_METRIC_HISTOGRAM_PREFILL_TOKENS_PER_SECOND, 3),
+               histogram(AI_BRIDGE_METRIC_HISTOGRAM_DECODE_TOKENS_PER_SECOND, 3),
+               histogram(AI_BRIDGE_METRIC_HISTOGRAM_DECODE_STEP_US, 5) / 1000.0);
+        const ai_bridge::CpuTopology& cores = ai_bridge::GetCpuTopology();
+        printf("compute pool       %d workers (%zu big, %zu little cores), %lld tasks stolen, %lld helper yields, "
+               "high-priority wait p50 %lld us, p99 %lld us\n",
+               ai_bridge::ComputePool().workers(), cores.big.size(), cores.little.size(),
+               value(AI_BRIDGE_METRIC_COUNTER_POOL_TASKS_STOLEN), value(AI_BRIDGE_METRIC_COUNTER_POOL_HELPER_YIELDS),
+               histogram(AI_BRIDGE_METRIC_HISTOGRAM_POOL_HIGH_PRIORITY_WAIT_US, 3),
+               histogram(AI_BRIDGE_METRIC_HISTOGRAM_POOL_HIGH_PRIORITY_WAIT_US, 5));
+        if (options.engine == AI_BRIDGE_LLM_ENGINE_REFERENCE) {
+            const ai_bridge::TransformerConfig config = ai_bridge::TransformerConfig::Tiny();
+            const double page_mb = 2.0 * sizeof(float) * config.layers * config.kv_dim() *
+                                   ai_bridge::PagedKvCache::kPageTokens / (1024.0 * 1024.0);
+            auto gauge = [&](int g, int field) { return value(gauges + g * 2 + field); };
+            printf("kv cache           %lld pages in use (max %lld, %.1f MB), %lld shared (max %lld)\n",
+                   gauge(AI_BRIDGE_METRIC_GAUGE_KV_PAGES_IN_USE, 0), gauge(AI_BRIDGE_METRIC_GAUGE_KV_PAGES_IN_USE, 1),
+                   gauge(AI_BRIDGE_METRIC_GAUGE_KV_PAGES_IN_USE, 1) * page_mb,
+                   gauge(AI_BRIDGE_METRIC_GAUGE_KV_PAGES_SHARED, 0), gauge(AI_BRIDGE_METRIC_GAUGE_KV_PAGES_SHARED, 1));
+        }
+    }
+    if (options.session_file != nullptr) {
+        printf("session file       %lld bytes saved in %.1f ms, %lld KV tokens loaded in %.1f ms\n",
+               stats.saved_bytes.load(), stats.save_us.load() / 1000.0, stats.loaded_kv_tokens.load(),
+               stats.load_us.load() / 1000.0);
+        printf("resumed turns      %s, %lld prompt tokens prefilled, %lld reused\n", resumed ? "ok" : "FAILED",
+               (long long)resume_stats.prefill_tokens, (long long)resume_stats.reused_tokens);
+        // Runs engines of its own, so only after the stats above are read.
+        if (options.engine == AI_BRIDGE_LLM_ENGINE_REFERENCE) {
+            int32_t cut_at = 0;
+            const bool matches = CheckMidReplySave(options, &cut_at);
+            if (!matches) resumed = false;
+            if (matches && cut_at == 0) {
+                printf("mid-reply save     skipped, the reply ended before the save\n");
+            } else {
+                printf("mid-reply save     %s, saved %d tokens into the reply\n", matches ? "ok" : "FAILED", cut_at);
+            }
+        }
+    }
+    if (options.trace != nullptr) {
+        static const char* const kSpanNames[AI_BRIDGE_TURN_SPAN_COUNT] = {
+            "transcribe", "first token", "generate", "first audio", "playback", "response"};
+        AiBridgeTurnSpanStats spans[AI_BRIDGE_TURN_SPAN_COUNT] = {};
+        const int32_t span_count = native_get_turn_spans(spans, AI_BRIDGE_TURN_SPAN_COUNT);
+        for (int32_t s = 0; s < span_count; ++s) {
+            if (spans[s].count == 0) continue;
+            printf("turn %-13s %lld turns, p50 %.1f ms, p90 %.1f ms, p99 %.1f ms, max %.1f ms\n", kSpanNames[s],
+                   (long long)spans[s].count, spans[s].p50_us / 1000.0, spans[s].p90_us / 1000.0,
+                   spans[s].p99_us / 1000.0, spans[s].max_us / 1000.0);
+        }
+        std::vector<char> json(static_cast<size_t>(native_trace_dump_json(nullptr, 0)) + 1);
+        native_trace_dump_json(json.data(), static_cast<int32_t>(json.size()));
+        FILE* file = fopen(options.trace, "w");
+        if (file == nullptr || fputs(json.data(), file) < 0) fprintf(stderr, "could not write %s\n", options.trace);
+        if (file != nullptr) fclose(file);
+    }
+    printf("error messages     %lld\n", stats.error_messages.load());
+    printf("elapsed            %.3f s\n", elapsed_s);
+    printf("throughput         %.1f tok/s (%s)\n", elapsed_s > 0 ? token_stats.tokens_published / elapsed_s : 0.0,
+           options.detached ? "detached" : "attached");
+    return token_stats.replies_completed == accepted && resumed && kernels_match ? 0 : 1;
+}
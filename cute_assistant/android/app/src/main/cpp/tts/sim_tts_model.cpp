@@ -0,0 +1,78 @@
+#include "tts/sim_tts_model.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cctype>
+#include <cmath>
+#include <thread>
+
+namespace ai_bridge {
+
+namespace {
+
+constexpr double kSecondsPerLetter = 0.07;
+constexpr double kWordGapSeconds = 0.05;
+constexpr double kPunctuationPauseSeconds = 0.2;
+constexpr float kAmplitude = 0.25f;
+
+void SleepMicros(int64_t us) {
+    if (us > 0) std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+}  // namespace
+
+SimTtsModel::SimTtsModel()
+    : call_us_(SimTtsTiming().call_us), us_per_audio_second_(SimTtsTiming().us_per_audio_second) {}
+
+void SimTtsModel::set_timing(const SimTtsTiming& timing) {
+    call_us_.store(std::max(0, timing.call_us), std::memory_order_relaxed);
+    us_per_audio_second_.store(std::max(0, timing.us_per_audio_second), std::memory_order_relaxed);
+}
+
+bool SimTtsModel::synthesize(const std::string& text, std::vector<float>* pcm) {
+    pcm->clear();
+    const double rate = sample_rate();
+    auto silence = [&](double seconds) { pcm->resize(pcm->size() + static_cast<size_t>(seconds * rate), 0.0f); };
+    size_t i = 0;
+    while (i < text.size()) {
+        const unsigned char c = static_cast<unsigned char>(text[i]);
+        if (std::isspace(c)) {
+            ++i;
+            continue;
+        }
+        if (!std::isalnum(c) && c < 0x80) {
+            if (c == '.' || c == ',' || c == '!' || c == '?' || c == ';' || c == ':') silence(kPunctuationPauseSeconds);
+            ++i;
+            continue;
+        }
+        // One word: letters and any non-ASCII bytes up to the next space or
+        // punctuation.
+        size_t end = i;
+        int letter_sum = 0;
+        while (end < text.size()) {
+            const unsigned char w = static_cast<unsigned char>(text[end]);
+            if (w < 0x80 && !std::isalnum(w)) break;
+            letter_sum += w;
+            ++end;
+        }
+        const size_t samples = static_cast<size_t>(static_cast<double>(end - i) * kSecondsPerLetter * rate);
+        const double pitch = 110.0 + letter_sum % 120;
+        const size_t first = pcm->size();
+        pcm->resize(first + samples);
+        for (size_t s = 0; s < samples; ++s) {
+            // Raised-cosine envelope so words start and end without clicks.
+            const double envelope = 0.5 - 0.5 * std::cos(2.0 * M_PI * static_cast<double>(s) / samples);
+            const double t = static_cast<double>(s) / rate;
+            (*pcm)[first + s] = static_cast<float>(kAmplitude * envelope *
+                                                   (std::sin(2.0 * M_PI * pitch * t) + 0.3 * std::sin(4.0 * M_PI * pitch * t)));
+        }
+        silence(kWordGapSeconds);
+        i = end;
+    }
+    SleepMicros(call_us_.load(std::memory_order_relaxed) +
+                static_cast<int64_t>(us_per_audio_second_.load(std::memory_order_relaxed)) *
+                    static_cast<int64_t>(pcm->size()) / sample_rate());
+    return true;
+}
+
+}  // namespace ai_bridge
@@ -0,0 +1,43 @@
+#ifndef AI_BRIDGE_TTS_SIM_TTS_MODEL_H_
+#define AI_BRIDGE_TTS_SIM_TTS_MODEL_H_
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include "tts/tts_model.h"
+
+namespace ai_bridge {
+
+// Cost model for SimTtsModel: every synthesize() call costs call_us, plus
+// us_per_audio_second per second of speech it returns. The defaults are in
+// the range of a Piper medium voice on a phone CPU (real-time factor 0.2).
+struct SimTtsTiming {
+    int32_t call_us = 20000;
+    int32_t us_per_audio_second = 200000;
+};
+
+// Placeholder voice used until TTS weights are bundled.
+//
+// Speaks at about 14 characters per second: each word becomes a vowel-like
+// tone whose pitch follows its letters, words are separated by short gaps
+// and punctuation adds a pause.
+class SimTtsModel : public TtsModel {
+public:
+    SimTtsModel();
+
+    void set_timing(const SimTtsTiming& timing);
+
+    const char* name() const override { return "sim"; }
+    int32_t sample_rate() const override { return 16000; }
+
+    bool synthesize(const std::string& text, std::vector<float>* pcm) override;
+
+private:
+    std::atomic<int32_t> call_us_;
+    std::atomic<int32_t> us_per_audio_second_;
+};
+
+}  // namespace ai_bridge
+
+#endif  // AI_BRIDGE_TTS_SIM_TTS_MODEL_H_
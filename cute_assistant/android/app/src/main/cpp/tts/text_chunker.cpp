@@ -0,0 +1,55 @@
+#include "tts/text_chunker.h"
+
+namespace ai_bridge {
+
+namespace {
+
+bool IsSpace(char c) { return c == ' ' || c == '\n' || c == '\t' || c == '\r'; }
+bool IsSentenceEnd(char c) { return c == '.' || c == '!' || c == '?'; }
+bool IsClauseEnd(char c) { return c == ',' || c == ';' || c == ':'; }
+
+}  // namespace
+
+TtsTextChunker::TtsTextChunker(const TtsChunkOptions& options) : options_(options) {}
+
+void TtsTextChunker::reset() {
+    buffer_.clear();
+    scanned_ = 0;
+    first_ = true;
+}
+
+void TtsTextChunker::append(const char* data, size_t length, std::vector<std::string>* chunks) {
+    buffer_.append(data, length);
+    for (; scanned_ < buffer_.size(); ++scanned_) {
+        const char c = buffer_[scanned_];
+        if (!IsSpace(c) || scanned_ == 0) continue;
+        const char previous = buffer_[scanned_ - 1];
+        const size_t piece = scanned_;
+        const size_t clause_min =
+            static_cast<size_t>(first_ ? options_.first_chunk_min_chars : options_.clause_min_chars);
+        if (IsSentenceEnd(previous) || c == '\n' || (IsClauseEnd(previous) && piece >= clause_min) ||
+            piece >= static_cast<size_t>(options_.max_chunk_chars)) {
+            emit(scanned_ + 1, chunks);
+            scanned_ = 0;
+        }
+    }
+}
+
+void TtsTextChunker::finish(std::vector<std::string>* chunks) {
+    emit(buffer_.size(), chunks);
+    reset();
+}
+
+void TtsTextChunker::emit(size_t end, std::vector<std::string>* chunks) {
+    size_t begin = 0;
+    size_t last = end;
+    while (begin < last && IsSpace(buffer_[begin])) ++begin;
+    while (last > begin && IsSpace(buffer_[last - 1])) --last;
+    if (last > begin) {
+        chunks->push_back(buffer_.substr(begin, last - begin));
+        first_ = false;
+    }
+    buffer_.erase(0, end);
+}
+
+}  // namespace ai_bridge
@@ -0,0 +1,58 @@
+#ifndef AI_BRIDGE_TTS_TEXT_CHUNKER_H_
+#define AI_BRIDGE_TTS_TEXT_CHUNKER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ai_bridge {
+
+// Where streamed reply text is cut into pieces for the voice. Lengths are in
+// bytes.
+struct TtsChunkOptions {
+    // The first piece of a reply is cut at the first clause boundary (, ; :)
+    // past this length, so speech starts before the first sentence ends.
+    int32_t first_chunk_min_chars = 24;
+    // Later pieces are cut at sentence ends, and at clause boundaries past
+    // this length.
+    int32_t clause_min_chars = 80;
+    // With no boundary in sight a piece is cut at the first space past this
+    // length.
+    int32_t max_chunk_chars = 240;
+};
+
+// Cuts a reply's text, as it streams in, into sentences and clauses that
+// are synthesized one at a time. Sentence ends are . ! ? or a line break; a
+// terminator only counts once the following whitespace has arrived, so
+// "3.14" or "e.g" mid-token is not cut. Cuts only fall on ASCII
+// whitespace, never inside a UTF-8 sequence.
+class TtsTextChunker {
+public:
+    explicit TtsTextChunker(const TtsChunkOptions& options = TtsChunkOptions());
+
+    void set_options(const TtsChunkOptions& options) { options_ = options; }
+    // Forgets buffered text; the next piece is a first one again.
+    void reset();
+
+    // Appends `length` bytes of reply text and moves every piece completed
+    // by them to `chunks`.
+    void append(const char* data, size_t length, std::vector<std::string>* chunks);
+    // At the end of the reply: moves what is left, if not blank, to
+    // `chunks`.
+    void finish(std::vector<std::string>* chunks);
+
+    size_t buffered() const { return buffer_.size(); }
+
+private:
+    void emit(size_t end, std::vector<std::string>* chunks);
+
+    TtsChunkOptions options_;
+    std::string buffer_;
+    size_t scanned_ = 0;
+    bool first_ = true;
+};
+
+}  // namespace ai_bridge
+
+#endif  // AI_BRIDGE_TTS_TEXT_CHUNKER_H_
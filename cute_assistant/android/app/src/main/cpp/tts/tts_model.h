@@ -0,0 +1,28 @@
+#ifndef AI_BRIDGE_TTS_TTS_MODEL_H_
+#define AI_BRIDGE_TTS_TTS_MODEL_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ai_bridge {
+
+// Text-to-speech voice shaped after sentence-level neural TTS (Piper/VITS,
+// Kokoro): one call turns a sentence or clause into mono float PCM. A Piper
+// or Kokoro backend slots in behind this interface. Models are driven from
+// one thread.
+class TtsModel {
+public:
+    virtual ~TtsModel() = default;
+
+    virtual const char* name() const = 0;
+    virtual int32_t sample_rate() const = 0;
+
+    // Synthesizes `text`, replacing the contents of `pcm`. Returns false if
+    // the model failed.
+    virtual bool synthesize(const std::string& text, std::vector<float>* pcm) = 0;
+};
+
+}  // namespace ai_bridge
+
+#endif  // AI_BRIDGE_TTS_TTS_MODEL_H_
@@ -0,0 +1,274 @@
+#include "tts/tts_service.h"
+
+#include <algorithm>
+
+#include "core/dart_messages.h"
+#include "core/log.h"
+#include "core/thread_pool.h"
+#include "core/turn_trace.h"
+#include "tts/sim_tts_model.h"
+
+namespace ai_bridge {
+
+namespace {
+
+// Speech synthesized ahead of playback, sized for the highest voice rate.
+// Synthesis runs ahead until it is full, which is far more than a sentence.
+constexpr int32_t kMaxSampleRate = 48000;
+constexpr size_t kOutputRingSeconds = 10;
+// How often playback progress is checked while nothing else happens.
+constexpr auto kPlaybackPoll = std::chrono::milliseconds(10);
+
+int64_t MicrosSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+}  // namespace
+
+TtsService::TtsService() : audio_(kOutputRingSeconds * kMaxSampleRate) {}
+
+TtsService::~TtsService() { stop(); }
+
+bool TtsService::start(const TtsOptions& options, Dart_Port events, Dart_Port metrics, std::string* error) {
+    stop();
+    if (options.chunking.first_chunk_min_chars < 0 || options.chunking.clause_min_chars < 0 ||
+        options.chunking.max_chunk_chars <= 0) {
+        *error = "TTS chunk lengths must not be negative";
+        return false;
+    }
+    options_ = options;
+    event_port_ = events;
+    metrics_port_ = metrics;
+    // A Piper or Kokoro backend replaces the placeholder here once its
+    // weights ship.
+    if (!model_) model_.reset(new SimTtsModel());
+    sample_rate_ = model_->sample_rate();
+    if (sample_rate_ <= 0 || sample_rate_ > kMaxSampleRate) {
+        *error = "TTS voice rate " + std::to_string(sample_rate_) + " Hz is not supported";
+        return false;
+    }
+    chunker_.set_options(options_.chunking);
+    audio_.set_sample_rate(sample_rate_);
+    if (options_.native_playback && !playback_.start(sample_rate_, &TtsService::OnPlayback, this, error)) {
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        events_.clear();
+        interrupt_requested_ = false;
+    }
+    running_.store(true, std::memory_order_release);
+    thread_ = std::thread(&TtsService::run, this);
+    LOGI("TTS started (%s voice, %d Hz, %s playback)", model_->name(),
+         sample_rate_, options_.native_playback ? "native" : "pulled");
+    return true;
+}
+
+void TtsService::stop() {
+    if (thread_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            running_.store(false, std::memory_order_release);
+        }
+        wake_.notify_one();
+        thread_.join();
+    }
+    playback_.stop();
+}
+
+void TtsService::interrupt() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        interrupt_requested_ = true;
+    }
+    wake_.notify_one();
+}
+
+void TtsService::on_token(int64_t request_id, const char* data, size_t length) {
+    if (!running()) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // Tokens the synthesis thread has not picked up yet are joined.
+        if (!events_.empty() && events_.back().request_id == request_id && !events_.back().end) {
+            events_.back().text.append(data, length);
+        } else {
+            TextEvent event;
+            event.request_id = request_id;
+            event.text.assign(data, length);
+            event.at = std::chrono::steady_clock::now();
+            events_.push_back(std::move(event));
+        }
+    }
+    wake_.notify_one();
+}
+
+void TtsService::on_reply_end(int64_t request_id, int32_t status) {
+    if (!running()) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        TextEvent event;
+        event.request_id = request_id;
+        event.end = true;
+        event.status = status;
+        event.at = std::chrono::steady_clock::now();
+        events_.push_back(std::move(event));
+    }
+    wake_.notify_one();
+}
+
+void TtsService::OnPlayback(float* samples, int32_t count, void* user_data) {
+    static_cast<TtsService*>(user_data)->pull(samples, static_cast<size_t>(count));
+}
+
+void TtsService::run() {
+    // Nothing from an earlier run is spoken.
+    chunker_.reset();
+    chunks_.clear();
+    request_id_ = 0;
+    active_ = false;
+    audio_.flush();
+
+    std::deque<TextEvent> events;
+    for (;;) {
+        bool interrupt = false;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            // Wake up now and then to follow playback.
+            if (events_.empty() && !interrupt_requested_ && chunks_.empty() && running()) {
+                wake_.wait_for(lock, kPlaybackPoll);
+            }
+            events.swap(events_);
+            interrupt = interrupt_requested_;
+            interrupt_requested_ = false;
+        }
+        if (!running()) break;
+        if (interrupt) cut_off();
+        for (TextEvent& event : events) handle(event);
+        events.clear();
+        if (!chunks_.empty()) speak_next();
+        check_playback();
+    }
+    audio_.flush();
+}
+
+void TtsService::handle(TextEvent& event) {
+    if (event.request_id < request_id_ || (event.request_id == request_id_ && !active_)) return;
+    if (event.request_id > request_id_) {
+        cut_off();  // a newer reply replaces the one being spoken
+        request_id_ = event.request_id;
+        active_ = true;
+        text_done_ = false;
+        started_ = false;
+        audio_start_ = audio_.written();
+        audio_.watch(audio_start_);
+        audio_.set_streaming(true);
+        chunk_index_ = 0;
+        first_token_at_ = event.at;
+        reply_audio_ms_ = reply_synthesize_us_ = 0;
+        chunker_.reset();
+    }
+    std::vector<std::string> pieces;
+    if (!event.text.empty()) chunker_.append(event.text.data(), event.text.size(), &pieces);
+    if (event.end) {
+        if (event.status != kReplyCompleted) {
+            cut_off();
+            return;
+        }
+        chunker_.finish(&pieces);
+        text_done_ = true;
+    }
+    for (std::string& piece : pieces) chunks_.push_back(std::move(piece));
+}
+
+void TtsService::speak_next() {
+    const std::string text = std::move(chunks_.front());
+    chunks_.pop_front();
+    // On the compute pool, ahead of any prefill: this is what the user
+    // hears next.
+    const auto synthesize_start = std::chrono::steady_clock::now();
+    bool synthesized = false;
+    ComputePool().run_sync(TaskPriority::kHigh, CoreHint::kBig,
+                           [&] { synthesized = model_->synthesize(text, &pcm_); });
+    if (!synthesized) {
+        SendStringToDart(event_port_, "TTS failed to synthesize \"" + text + "\"");
+        return;
+    }
+    const int64_t synthesize_us = MicrosSince(synthesize_start);
+    const int64_t audio_ms = static_cast<int64_t>(pcm_.size()) * 1000 / sample_rate_;
+    SendEventToDart(metrics_port_, "tts_chunk",
+                    {request_id_, chunk_index_, static_cast<int64_t>(text.size()), audio_ms, synthesize_us});
+    ++chunk_index_;
+    reply_audio_ms_ += audio_ms;
+    reply_synthesize_us_ += synthesize_us;
+    chunks_synthesized_.fetch_add(1, std::memory_order_relaxed);
+    audio_ms_.fetch_add(audio_ms, std::memory_order_relaxed);
+    synthesize_us_.fetch_add(synthesize_us, std::memory_order_relaxed);
+
+    size_t offset = 0;
+    for (;;) {
+        offset += audio_.write(pcm_.data() + offset, pcm_.size() - offset);
+        check_playback();
+        if (offset == pcm_.size()) return;
+        // Synthesis is a whole output ring ahead of playback: wait for it,
+        // unless the reply is cut off meanwhile.
+        std::unique_lock<std::mutex> lock(mutex_);
+        wake_.wait_for(lock, kPlaybackPoll);
+        if (interrupt_requested_ || !running()) return;
+    }
+}
+
+void TtsService::check_playback() {
+    if (!active_) return;
+    const uint64_t written = audio_.written();
+    int64_t heard_at_us = 0;
+    if (!started_ && written > audio_start_ && audio_.reached(audio_start_, &heard_at_us)) {
+        started_ = true;
+        const int64_t first_token_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                                           first_token_at_.time_since_epoch())
+                                           .count();
+        first_audio_us_ = heard_at_us - first_token_us;
+        SendEventToDart(event_port_, "tts_start", {request_id_});
+        VoiceTurnTrace().mark_request(request_id_, TurnStage::kFirstAudio, heard_at_us);
+    }
+    if (!text_done_ || !chunks_.empty()) return;
+    // All of it is in the ring: running dry now is the end, not an underrun.
+    audio_.set_streaming(false);
+    if (audio_.read_position() >= written) finish_reply();
+}
+
+void TtsService::cut_off() {
+    if (!active_) return;
+    active_ = false;
+    chunks_.clear();
+    chunker_.reset();
+    audio_.set_streaming(false);
+    audio_.flush();
+    interrupted_.fetch_add(1, std::memory_order_relaxed);
+    SendEventToDart(event_port_, "tts_done", {request_id_, 1});
+    VoiceTurnTrace().abandon_request(request_id_);
+}
+
+void TtsService::finish_reply() {
+    active_ = false;
+    SendEventToDart(event_port_, "tts_done", {request_id_, 0});
+    VoiceTurnTrace().mark_request(request_id_, TurnStage::kAudioDone, TurnTrace::NowMicros());
+    if (!started_) return;  // nothing to say
+    SendEventToDart(metrics_port_, "tts_reply",
+                    {request_id_, first_audio_us_, chunk_index_, reply_audio_ms_, reply_synthesize_us_});
+    replies_.fetch_add(1, std::memory_order_relaxed);
+    first_audio_us_total_.fetch_add(first_audio_us_, std::memory_order_relaxed);
+}
+
+TtsStats TtsService::stats() const {
+    TtsStats stats;
+    stats.replies = replies_.load(std::memory_order_relaxed);
+    stats.interrupted = interrupted_.load(std::memory_order_relaxed);
+    stats.chunks = chunks_synthesized_.load(std::memory_order_relaxed);
+    stats.audio_ms = audio_ms_.load(std::memory_order_relaxed);
+    stats.synthesize_us = synthesize_us_.load(std::memory_order_relaxed);
+    stats.first_audio_us = first_audio_us_total_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+}  // namespace ai_bridge
@@ -0,0 +1,157 @@
+#ifndef AI_BRIDGE_TTS_TTS_SERVICE_H_
+#define AI_BRIDGE_TTS_TTS_SERVICE_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "audio/audio_playback.h"
+#include "audio/pcm_output_ring.h"
+#include "dart_api_dl.h"
+#include "llm/token_stream.h"
+#include "tts/text_chunker.h"
+#include "tts/tts_model.h"
+
+namespace ai_bridge {
+
+struct TtsOptions {
+    TtsChunkOptions chunking;
+    // Play through AAudio; otherwise the host pulls PCM with pull().
+    bool native_playback = true;
+};
+
+struct TtsStats {
+    int64_t replies = 0;          // replies spoken to the end (empty ones not counted)
+    int64_t interrupted = 0;      // replies cut off by interrupt() or a newer reply
+    int64_t chunks = 0;           // pieces synthesized
+    int64_t audio_ms = 0;         // speech synthesized
+    int64_t synthesize_us = 0;
+    int64_t first_audio_us = 0;   // total, first reply token to its first audible sample
+};
+
+// Speaks LLM replies as they are generated.
+//
+// Registered as the TokenStream's tap: reply text reaches it on the token
+// flusher thread, never on the decode loop, and is queued for a synthesis
+// thread. That thread cuts the text into sentences and clauses
+// (TtsTextChunker) and synthesizes them one at a time into the output ring,
+// which the playback callback drains, so piece N+1 is synthesized while
+// piece N plays and the first words are heard once the first clause has
+// been generated rather than the whole reply.
+//
+// One reply is spoken at a time, the newest: tokens of a later request cut
+// off the one being spoken, and a cancelled reply stops at once. On the
+// event port:
+//   ["tts_start", request_id]           its first sample is played
+//   ["tts_done", request_id, interrupted]  its last sample is played, or
+//                                       it was cut off (interrupted 1)
+// and on the metrics port:
+//   ["tts_chunk", request_id, index, chars, audio_ms, synthesize_us]
+//   ["tts_reply", request_id, first_audio_us, chunks, audio_ms,
+//    synthesize_us]  per reply spoken to the end; first_audio_us runs from
+//                    its first token to its first played sample
+class TtsService : public TokenTap {
+public:
+    TtsService();
+    ~TtsService() override;
+
+    TtsService(const TtsService&) = delete;
+    TtsService& operator=(const TtsService&) = delete;
+
+    bool start(const TtsOptions& options, Dart_Port events, Dart_Port metrics, std::string* error);
+    // Stops playback and drops whatever was not spoken.
+    void stop();
+    bool running() const { return running_.load(std::memory_order_acquire); }
+
+    // Cuts off the reply being spoken and everything queued (barge-in).
+    void interrupt();
+
+    // Playback side without native playback: copies up to `count` samples
+    // to be played to `out`, pads the rest with silence and returns how
+    // many were speech.
+    size_t pull(float* out, size_t count) { return audio_.read(out, count); }
+
+    TtsModel* model() { return model_.get(); }
+    int32_t sample_rate() const { return sample_rate_; }
+    bool native_playback() const { return playback_.running(); }
+    TtsStats stats() const;
+    // Underruns, fill level and buffer latency of the output ring.
+    PcmOutputStats output_stats() const { return audio_.stats(); }
+
+    // TokenTap, called on the token flusher thread. Ignored while stopped.
+    void on_token(int64_t request_id, const char* data, size_t length) override;
+    void on_reply_end(int64_t request_id, int32_t status) override;
+
+private:
+    // Reply text handed from the flusher to the synthesis thread.
+    struct TextEvent {
+        int64_t request_id = 0;
+        std::string text;
+        bool end = false;
+        int32_t status = 0;
+        std::chrono::steady_clock::time_point at;
+    };
+
+    static void OnPlayback(float* samples, int32_t count, void* user_data);
+
+    void run();
+    void handle(TextEvent& event);
+    // Synthesizes the next piece into the ring.
+    void speak_next();
+    void check_playback();
+    // Drops the current reply's text and audio and reports it interrupted.
+    void cut_off();
+    void finish_reply();
+
+    TtsOptions options_;
+    Dart_Port event_port_ = ILLEGAL_PORT;
+    Dart_Port metrics_port_ = ILLEGAL_PORT;
+    std::unique_ptr<TtsModel> model_;
+    int32_t sample_rate_ = 0;
+    AudioPlayback playback_;
+
+    // Synthesis thread -> playback. Allocated once so a late pull() never
+    // touches freed memory.
+    PcmOutputRing audio_;
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::deque<TextEvent> events_;
+    bool interrupt_requested_ = false;
+
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+
+    // Synthesis thread.
+    TtsTextChunker chunker_;
+    std::deque<std::string> chunks_;
+    std::vector<float> pcm_;
+    int64_t request_id_ = 0;       // newest reply seen
+    bool active_ = false;          // and it is being spoken
+    bool text_done_ = false;       // its end was seen
+    bool started_ = false;         // tts_start posted
+    uint64_t audio_start_ = 0;     // ring position of its first sample
+    int32_t chunk_index_ = 0;
+    std::chrono::steady_clock::time_point first_token_at_;
+    int64_t first_audio_us_ = 0;
+    int64_t reply_audio_ms_ = 0;
+    int64_t reply_synthesize_us_ = 0;
+
+    std::atomic<int64_t> replies_{0};
+    std::atomic<int64_t> interrupted_{0};
+    std::atomic<int64_t> chunks_synthesized_{0};
+    std::atomic<int64_t> audio_ms_{0};
+    std::atomic<int64_t> synthesize_us_{0};
+    std::atomic<int64_t> first_audio_us_total_{0};
+};
+
+}  // namespace ai_bridge
+
+#endif  // AI_BRIDGE_TTS_TTS_SERVICE_H_
@@ -0,0 +1,763 @@
+// dart:ffi bindings for the native ai_bridge library
+// (android/app/src/main/cpp). See ai_bridge.h for the C side of every call.
+
+import 'dart:async';
+import 'dart:convert';
+import 'dart:ffi';
+import 'dart:io' show Platform;
+import 'dart:isolate';
+import 'dart:typed_data';
+
+import 'package:ffi/ffi.dart';
+
+/// How token batches cross from native code into Dart.
+/// Indices match AI_BRIDGE_TOKEN_TRANSPORT_* in ai_bridge.h.
+enum TokenTransport { string, externalTypedData }
+
+/// Inference backend. Indices match AI_BRIDGE_LLM_ENGINE_* in ai_bridge.h.
+enum LlmEngineKind { sim, reference }
+
+/// Storage of the built-in reference model's weight matrices: float32,
+/// Q8_0 (8.5 bits per weight) or Q4_0 (4.5 bits per weight).
+/// Indices match AI_BRIDGE_LLM_WEIGHTS_* in ai_bridge.h.
+enum LlmWeightType { f32, q8, q4 }
+
+/// How a reply ended. Indices match AI_BRIDGE_REPLY_* in ai_bridge.h.
+enum ReplyStatus { completed, cancelled, failed }
+
+/// A batch of generated text from one reply.
+class ReplyChunk {
+  const ReplyChunk(this.requestId, this.text);
+
+  final int requestId;
+  final String text;
+}
+
+/// Posted after the last token batch of every reply.
+class ReplyEnd {
+  const ReplyEnd(this.requestId, this.status);
+
+  final int requestId;
+  final ReplyStatus status;
+}
+
+/// Kinds of native VAD event, in the order the `vad` package reports them.
+enum NativeVadEventType { speechStart, speechRealStart, speechEnd, misfire }
+
+/// A voice activity event. Positions count 16 kHz samples from
+/// [AiBridge.startVad]; for the two start events [endSample] is the position
+/// the event was detected at.
+class NativeVadEvent {
+  const NativeVadEvent(this.type, this.startSample, this.endSample);
+
+  final NativeVadEventType type;
+  final int startSample;
+  final int endSample;
+}
+
+const _vadEventTags = {
+  'vad_speech_start': NativeVadEventType.speechStart,
+  'vad_speech_real_start': NativeVadEventType.speechRealStart,
+  'vad_speech_end': NativeVadEventType.speechEnd,
+  'vad_misfire': NativeVadEventType.misfire,
+};
+
+/// A transcript of one utterance from the native recognizer. Partials of
+/// an utterance may still change past their [stable] prefix, which later
+/// partials and the final transcript keep; the final transcript replaces
+/// them.
+class AsrTranscript {
+  const AsrTranscript(this.utteranceId, this.text,
+      {required this.isFinal, String? stable})
+      : stable = stable ?? (isFinal ? text : '');
+
+  final int utteranceId;
+  final String text;
+  final bool isFinal;
+  final String stable;
+}
+
+/// Playback of one reply by the native TTS: it became audible ([done]
+/// false), or it played out or was cut off ([done] true, [interrupted]
+/// telling which).
+class TtsEvent {
+  const TtsEvent(this.requestId, {required this.done, this.interrupted = false});
+
+  final int requestId;
+  final bool done;
+  final bool interrupted;
+}
+
+/// Points of a voice turn. Indices match AI_BRIDGE_TURN_STAGE_* in
+/// ai_bridge.h.
+enum TurnStage {
+  speechEnd,
+  transcriptFinal,
+  firstToken,
+  lastToken,
+  firstAudio,
+  audioDone,
+}
+
+/// Intervals of a voice turn. Indices match AI_BRIDGE_TURN_SPAN_* in
+/// ai_bridge.h; [response] (speech end to first audio) is the one users
+/// feel.
+enum TurnSpan { transcribe, firstToken, generate, firstAudio, playback, response }
+
+/// Distribution of one [TurnSpan] over the voice turns finished so far, in
+/// microseconds.
+class TurnSpanStats {
+  const TurnSpanStats(this.count, this.meanUs, this.p50Us, this.p90Us,
+      this.p99Us, this.maxUs);
+
+  final int count;
+  final int meanUs;
+  final int p50Us;
+  final int p90Us;
+  final int p99Us;
+  final int maxUs;
+}
+
+final class _AiBridgeTurnSpanStats extends Struct {
+  @Int64()
+  external int count;
+  @Int64()
+  external int meanUs;
+  @Int64()
+  external int p50Us;
+  @Int64()
+  external int p90Us;
+  @Int64()
+  external int p99Us;
+  @Int64()
+  external int maxUs;
+}
+
+/// Counters of [MetricsSnapshot.counters]. Indices match
+/// AI_BRIDGE_METRIC_COUNTER_* in ai_bridge.h.
+enum MetricCounter {
+  tokensGenerated,
+  prefillTokens,
+  decodeSteps,
+  requestsQueued,
+  requestsRejected,
+  requestsCancelled,
+  repliesCompleted,
+  repliesFailed,
+  dartPosts,
+  dartPostFailures,
+  logRecordsDropped,
+  poolTasksStolen,
+  poolHelperYields,
+}
+
+/// Gauges of [MetricsSnapshot.gauges]. Indices match
+/// AI_BRIDGE_METRIC_GAUGE_* in ai_bridge.h.
+enum MetricGauge { queueDepth, activeSessions, kvPagesInUse, kvPagesShared }
+
+/// Histograms of [MetricsSnapshot.histograms]. Indices match
+/// AI_BRIDGE_METRIC_HISTOGRAM_* in ai_bridge.h.
+enum MetricHistogram {
+  queueWaitUs,
+  firstTokenUs,
+  decodeStepUs,
+  prefillTokensPerSecond,
+  decodeTokensPerSecond,
+  poolHighPriorityWaitUs,
+}
+
+class GaugeValue {
+  const GaugeValue(this.value, this.max);
+
+  final int value;
+  final int max;
+}
+
+class HistogramValue {
+  const HistogramValue(
+      this.count, this.sum, this.max, this.p50, this.p90, this.p99);
+
+  final int count;
+  final int sum;
+  final int max;
+  final int p50;
+  final int p90;
+  final int p99;
+
+  double get mean => count == 0 ? 0 : sum / count;
+}
+
+/// The native metrics at [takenAtUs] (monotonic clock), decoded from the
+/// binary layout native_snapshot_metrics documents. Metrics this build of
+/// the app does not know are skipped; ones the library does not have yet
+/// are missing from the maps.
+class MetricsSnapshot {
+  const MetricsSnapshot(
+      this.takenAtUs, this.counters, this.gauges, this.histograms);
+
+  static const _magic = 0x4d424941;
+  static const _version = 1;
+  static const _headerBytes = 24;
+
+  /// Null if [bytes] is not a snapshot this version understands.
+  static MetricsSnapshot? tryParse(Uint8List bytes) {
+    if (bytes.length < _headerBytes) return null;
+    final data = ByteData.sublistView(bytes);
+    if (data.getUint32(0, Endian.little) != _magic ||
+        data.getUint16(4, Endian.little) != _version) {
+      return null;
+    }
+    final counterCount = data.getUint16(6, Endian.little);
+    final gaugeCount = data.getUint16(8, Endian.little);
+    final histogramCount = data.getUint16(10, Endian.little);
+    final values = counterCount + gaugeCount * 2 + histogramCount * 6;
+    if (bytes.length < _headerBytes + 8 * values) return null;
+    var offset = _headerBytes;
+    int next() {
+      final value = data.getInt64(offset, Endian.little);
+      offset += 8;
+      return value;
+    }
+
+    final counters = <MetricCounter, int>{};
+    for (var i = 0; i < counterCount; ++i) {
+      final value = next();
+      if (i < MetricCounter.values.length) {
+        counters[MetricCounter.values[i]] = value;
+      }
+    }
+    final gauges = <MetricGauge, GaugeValue>{};
+    for (var i = 0; i < gaugeCount; ++i) {
+      final gauge = GaugeValue(next(), next());
+      if (i < MetricGauge.values.length) gauges[MetricGauge.values[i]] = gauge;
+    }
+    final histograms = <MetricHistogram, HistogramValue>{};
+    for (var i = 0; i < histogramCount; ++i) {
+      final histogram =
+          HistogramValue(next(), next(), next(), next(), next(), next());
+      if (i < MetricHistogram.values.length) {
+        histograms[MetricHistogram.values[i]] = histogram;
+      }
+    }
+    return MetricsSnapshot(
+        data.getInt64(16, Endian.little), counters, gauges, histograms);
+  }
+
+  final int takenAtUs;
+  final Map<MetricCounter, int> counters;
+  final Map<MetricGauge, GaugeValue> gauges;
+  final Map<MetricHistogram, HistogramValue> histograms;
+}
+
+/// Thin wrapper around libai_bridge.
+///
+/// Generated text arrives on [tokens] in batches tagged with the request id,
+/// and [replyDone] fires after the last batch of each reply, including
+/// replies cut short by [cancel]. Replies of different sessions may
+/// interleave. With [TokenTransport.externalTypedData] every batch is a
+/// Uint8List view over a pooled native buffer: it is decoded in place by a
+/// per-reply chunked UTF-8 decoder, which also joins characters split across
+/// batches, and the buffer goes back to the native pool when the view is
+/// garbage collected.
+class AiBridge {
+  AiBridge._(this._lib);
+
+  /// Opens the native library, or returns null where it is not bundled.
+  static AiBridge? tryOpen() {
+    if (!Platform.isAndroid) return null;
+    try {
+      return AiBridge._(DynamicLibrary.open('libai_bridge.so'));
+    } on ArgumentError {
+      return null;
+    }
+  }
+
+  final DynamicLibrary _lib;
+
+  late final _initializeDartApi = _lib.lookupFunction<
+      Void Function(Pointer<Void>),
+      void Function(Pointer<Void>)>('native_initialize_dart_api');
+  late final _initializeLlmPorts = _lib.lookupFunction<
+      Void Function(Int64, Int64),
+      void Function(int, int)>('native_initialize_llm_ports');
+  late final _submitLlmSessionRequest = _lib.lookupFunction<
+      Int64 Function(Int64, Pointer<Utf8>, Int32),
+      int Function(int, Pointer<Utf8>, int)>('native_submit_llm_session_request');
+  late final _initializeMetricsPort = _lib.lookupFunction<Void Function(Int64),
+      void Function(int)>('native_initialize_metrics_port');
+  late final _cancelRequest = _lib.lookupFunction<Int32 Function(Int64),
+      int Function(int)>('native_cancel_request');
+  late final _setBargeIn = _lib.lookupFunction<Void Function(Int32),
+      void Function(int)>('native_set_llm_barge_in');
+  late final _setSystemPrompt = _lib.lookupFunction<
+      Void Function(Pointer<Utf8>),
+      void Function(Pointer<Utf8>)>('native_set_llm_system_prompt');
+  late final _setModel = _lib.lookupFunction<
+      Void Function(Pointer<Utf8>, Int32),
+      void Function(Pointer<Utf8>, int)>('native_set_llm_model');
+  late final _setEngine = _lib.lookupFunction<Void Function(Int32),
+      void Function(int)>('native_set_llm_engine');
+  late final _setWeightType = _lib.lookupFunction<Void Function(Int32),
+      void Function(int)>('native_set_llm_weight_type');
+  late final _setThreads = _lib.lookupFunction<Void Function(Int32),
+      void Function(int)>('native_set_llm_threads');
+  late final _setMaxReplyTokens = _lib.lookupFunction<Void Function(Int32),
+      void Function(int)>('native_set_llm_max_reply_tokens');
+  late final _writeReferenceModel = _lib.lookupFunction<
+      Int32 Function(Pointer<Utf8>),
+      int Function(Pointer<Utf8>)>('native_write_reference_model');
+  late final _saveSession = _lib.lookupFunction<Int32 Function(Pointer<Utf8>),
+      int Function(Pointer<Utf8>)>('native_save_session');
+  late final _loadSession = _lib.lookupFunction<Int32 Function(Pointer<Utf8>),
+      int Function(Pointer<Utf8>)>('native_load_session');
+  late final _disposeLlm = _lib
+      .lookupFunction<Void Function(), void Function()>('native_dispose_llm');
+  late final _setTokenFlushPolicy = _lib.lookupFunction<
+      Void Function(Int32, Int32, Int32),
+      void Function(int, int, int)>('native_set_token_flush_policy');
+  late final _setTokenTransport = _lib.lookupFunction<Void Function(Int32),
+      void Function(int)>('native_set_token_transport');
+  late final _vadConfigure = _lib.lookupFunction<
+      Void Function(Int32, Int32, Int32, Int32, Float, Float, Int32),
+      void Function(
+          int, int, int, int, double, double, int)>('native_vad_configure');
+  late final _vadConfigureGate = _lib.lookupFunction<
+      Void Function(Int32, Float, Float),
+      void Function(int, double, double)>('native_vad_configure_gate');
+  late final _vadStart = _lib.lookupFunction<Int32 Function(Int64, Int32),
+      int Function(int, int)>('native_vad_start');
+  late final _vadStop =
+      _lib.lookupFunction<Void Function(), void Function()>('native_vad_stop');
+  late final _asrStart = _lib.lookupFunction<Int32 Function(Int64, Int32),
+      int Function(int, int)>('native_asr_start');
+  late final _asrStop =
+      _lib.lookupFunction<Void Function(), void Function()>('native_asr_stop');
+  late final _ttsConfigure = _lib.lookupFunction<
+      Void Function(Int32, Int32, Int32),
+      void Function(int, int, int)>('native_tts_configure');
+  late final _ttsStart = _lib.lookupFunction<Int32 Function(Int64, Int32),
+      int Function(int, int)>('native_tts_start');
+  late final _ttsStop =
+      _lib.lookupFunction<Void Function(), void Function()>('native_tts_stop');
+  late final _ttsInterrupt = _lib.lookupFunction<Void Function(),
+      void Function()>('native_tts_interrupt');
+  late final _traceBeginTurn = _lib.lookupFunction<Int64 Function(),
+      int Function()>('native_trace_begin_turn');
+  late final _traceMark = _lib.lookupFunction<Void Function(Int64, Int32),
+      void Function(int, int)>('native_trace_mark');
+  late final _traceAttachRequest = _lib.lookupFunction<
+      Void Function(Int64, Int64),
+      void Function(int, int)>('native_trace_attach_request');
+  late final _traceMarkRequest = _lib.lookupFunction<
+      Void Function(Int64, Int32),
+      void Function(int, int)>('native_trace_mark_request');
+  late final _traceAbandonRequest = _lib.lookupFunction<Void Function(Int64),
+      void Function(int)>('native_trace_abandon_request');
+  late final _getTurnSpans = _lib.lookupFunction<
+      Int32 Function(Pointer<_AiBridgeTurnSpanStats>, Int32),
+      int Function(Pointer<_AiBridgeTurnSpanStats>, int)>(
+      'native_get_turn_spans');
+  late final _traceDumpJson = _lib.lookupFunction<
+      Int32 Function(Pointer<Utf8>, Int32),
+      int Function(Pointer<Utf8>, int)>('native_trace_dump_json');
+  late final _snapshotMetrics = _lib.lookupFunction<
+      Int32 Function(Pointer<Uint8>, Int32),
+      int Function(Pointer<Uint8>, int)>('native_snapshot_metrics');
+  late final _postMetricsSnapshot = _lib.lookupFunction<Int32 Function(Int64),
+      int Function(int)>('native_post_metrics_snapshot');
+
+  final _tokenPort = ReceivePort();
+  final _errorPort = ReceivePort();
+  final _metricsPort = ReceivePort();
+  final _vadPort = ReceivePort();
+  StreamSubscription<dynamic>? _vadSubscription;
+  final _asrPort = ReceivePort();
+  StreamSubscription<dynamic>? _asrSubscription;
+  final _ttsPort = ReceivePort();
+  StreamSubscription<dynamic>? _ttsSubscription;
+  final _tokenController = StreamController<ReplyChunk>.broadcast();
+  final _replyDoneController = StreamController<ReplyEnd>.broadcast();
+  final _errorController = StreamController<String>.broadcast();
+  final _metricsController = StreamController<List<Object?>>.broadcast();
+  final _metricsSnapshotController =
+      StreamController<MetricsSnapshot>.broadcast();
+  final _vadController = StreamController<NativeVadEvent>.broadcast();
+  final _asrController = StreamController<AsrTranscript>.broadcast();
+  final _ttsController = StreamController<TtsEvent>.broadcast();
+
+  final _utf8Sinks = <int, ByteConversionSink>{};
+
+  Stream<ReplyChunk> get tokens => _tokenController.stream;
+  Stream<ReplyEnd> get replyDone => _replyDoneController.stream;
+  Stream<String> get errors => _errorController.stream;
+
+  /// Metric/event records from native code, each `[String tag, int...]`,
+  /// e.g. `['llm_queue', requestId, priority, depthAfterDequeue, waitUs]` or
+  /// `['llm_cancel', requestId, tokensGenerated, abortLatencyUs]` or
+  /// `['llm_reply', requestId, sessionId, promptTokens, generatedTokens,
+  /// firstTokenUs, totalUs]`.
+  Stream<List<Object?>> get metrics => _metricsController.stream;
+
+  /// Snapshots asked for with [postMetricsSnapshot].
+  Stream<MetricsSnapshot> get metricsSnapshots =>
+      _metricsSnapshotController.stream;
+
+  /// Events of the native VAD started by [startVad], with its errors as
+  /// stream errors.
+  Stream<NativeVadEvent> get vadEvents => _vadController.stream;
+
+  /// Transcripts from the recognizer started by [startAsr], with its errors
+  /// as stream errors.
+  Stream<AsrTranscript> get transcripts => _asrController.stream;
+
+  /// Playback events of the TTS started by [startTts], with its errors as
+  /// stream errors.
+  Stream<TtsEvent> get ttsEvents => _ttsController.stream;
+
+  /// Connects the native side to this isolate and starts the LLM thread.
+  void start({TokenTransport transport = TokenTransport.externalTypedData}) {
+    _initializeDartApi(NativeApi.initializeApiDLData);
+    _setTokenTransport(transport.index);
+    _tokenPort.listen(_onTokenMessage);
+    _errorPort.listen((message) {
+      if (message is String) _errorController.add(message);
+    });
+    _metricsPort.listen((message) {
+      if (message is List) {
+        _metricsController.add(message);
+      } else if (message is Uint8List) {
+        final snapshot = MetricsSnapshot.tryParse(message);
+        if (snapshot != null) _metricsSnapshotController.add(snapshot);
+      }
+    });
+    _initializeMetricsPort(_metricsPort.sendPort.nativePort);
+    _initializeLlmPorts(
+        _tokenPort.sendPort.nativePort, _errorPort.sendPort.nativePort);
+  }
+
+  /// See native_set_token_flush_policy.
+  void setTokenFlushPolicy(
+      {int maxTokens = 8, int maxBytes = 512, int maxDelayMs = 50}) {
+    _setTokenFlushPolicy(maxTokens, maxBytes, maxDelayMs);
+  }
+
+  /// Queues [text] as the next turn of conversation [sessionId] and returns
+  /// its request id, or 0 if the native queue rejected it (the reason
+  /// arrives on [errors]).
+  int send(String text, {int priority = 0, int sessionId = 0}) {
+    final nativeText = text.toNativeUtf8();
+    try {
+      return _submitLlmSessionRequest(sessionId, nativeText, priority);
+    } finally {
+      malloc.free(nativeText);
+    }
+  }
+
+  /// Stops request [requestId] before its next decode step. Returns false if
+  /// it already finished.
+  bool cancel(int requestId) => _cancelRequest(requestId) != 0;
+
+  /// When enabled, every [send] first cancels all earlier requests.
+  void setBargeIn(bool enabled) => _setBargeIn(enabled ? 1 : 0);
+
+  /// Sets the text every new conversation starts with. It is evaluated once
+  /// and shared by all sessions through the native prefix cache.
+  void setSystemPrompt(String text) {
+    final nativeText = text.toNativeUtf8();
+    try {
+      _setSystemPrompt(nativeText);
+    } finally {
+      malloc.free(nativeText);
+    }
+  }
+
+  /// Weights file mapped by the next [start], with its first
+  /// [prefetchLayers] layers paged in ahead of the rest. Startup runs on the
+  /// native LLM thread and reports an `llm_startup` event on [metrics].
+  void setModel(String path, {int prefetchLayers = 2}) {
+    final nativePath = path.toNativeUtf8();
+    try {
+      _setModel(nativePath, prefetchLayers);
+    } finally {
+      malloc.free(nativePath);
+    }
+  }
+
+  /// Backend run by the next [start].
+  void setEngine(LlmEngineKind engine) => _setEngine(engine.index);
+
+  /// Format of the built-in model used by the next [start] and
+  /// [writeReferenceModel]. Model files carry their own formats.
+  void setWeightType(LlmWeightType type) => _setWeightType(type.index);
+
+  /// Most threads a reference-engine decode step used by the next [start]
+  /// runs on; 0 uses one per core.
+  void setThreads(int threads) => _setThreads(threads);
+
+  /// Ends every reply after [maxTokens] generated tokens, as completed;
+  /// 0 lets replies run until end of text or the context fills.
+  void setMaxReplyTokens(int maxTokens) => _setMaxReplyTokens(maxTokens);
+
+  /// Writes the reference engine's built-in model to [path], for
+  /// [setModel]. Returns false if it failed (the reason arrives on
+  /// [errors]).
+  bool writeReferenceModel(String path) =>
+      _withNativePath(path, _writeReferenceModel);
+
+  /// Writes every conversation and its KV cache to [path]. Returns false if
+  /// it failed (the reason arrives on [errors]).
+  bool saveSession(String path) => _withNativePath(path, _saveSession);
+
+  /// Restores what [saveSession] wrote, so the next turn of a saved
+  /// conversation does not prefill its history again. Call after [start] and
+  /// before sending; returns false if the file was rejected.
+  bool loadSession(String path) => _withNativePath(path, _loadSession);
+
+  /// Starts voice activity detection on a native thread, capturing the
+  /// microphone itself so no audio crosses into Dart; only [vadEvents] do.
+  /// The parameters mean what they do in the `vad` package. With [preGate]
+  /// frames that are plainly silence or background noise skip the model.
+  /// Returns false if
+  /// native capture or the settings were rejected (the reason arrives as an
+  /// error on [vadEvents]).
+  bool startVad({
+    int frameSamples = 512,
+    int minSpeechFrames = 8,
+    int preSpeechPadFrames = 30,
+    int redemptionFrames = 24,
+    double positiveSpeechThreshold = 0.5,
+    double negativeSpeechThreshold = 0.35,
+    bool submitUserSpeechOnPause = false,
+    bool preGate = true,
+  }) {
+    _initializeDartApi(NativeApi.initializeApiDLData);
+    _vadSubscription ??= _vadPort.listen((message) {
+      if (message is String) {
+        _vadController.addError(message);
+      } else if (message is List && message.length == 3) {
+        final type = _vadEventTags[message[0]];
+        if (type != null) {
+          _vadController
+              .add(NativeVadEvent(type, message[1] as int, message[2] as int));
+        }
+      }
+    });
+    _vadConfigure(
+        frameSamples,
+        minSpeechFrames,
+        preSpeechPadFrames,
+        redemptionFrames,
+        positiveSpeechThreshold,
+        negativeSpeechThreshold,
+        submitUserSpeechOnPause ? 1 : 0);
+    _vadConfigureGate(preGate ? 1 : 0, -60, 3);
+    return _vadStart(_vadPort.sendPort.nativePort, 1) != 0;
+  }
+
+  /// Stops capture; a segment still open ends per `submitUserSpeechOnPause`.
+  void stopVad() => _vadStop();
+
+  /// Transcribes the native VAD's speech as it is captured: partial
+  /// transcripts every [partialIntervalMs] of new speech, each costing
+  /// about the same however long the utterance runs, and a final one as
+  /// soon as the VAD hears the speech end, with no recognizer to start per
+  /// utterance. Returns false if it could not start (the reason arrives as
+  /// an error on [transcripts]).
+  bool startAsr({int partialIntervalMs = 300}) {
+    _initializeDartApi(NativeApi.initializeApiDLData);
+    _asrSubscription ??= _asrPort.listen((message) {
+      if (message is String) {
+        _asrController.addError(message);
+      } else if (message is List && message.length >= 3) {
+        final id = message[1] as int;
+        final text = message[2] as String;
+        if (message[0] == 'asr_partial') {
+          _asrController.add(AsrTranscript(id, text,
+              isFinal: false,
+              stable: message.length > 3 ? message[3] as String : null));
+        } else if (message[0] == 'asr_final') {
+          _asrController.add(AsrTranscript(id, text, isFinal: true));
+        }
+      }
+    });
+    return _asrStart(_asrPort.sendPort.nativePort, partialIntervalMs) != 0;
+  }
+
+  void stopAsr() => _asrStop();
+
+  /// Speaks replies natively while they are generated: the reply text is
+  /// cut at sentence and clause boundaries and the next piece is
+  /// synthesized while the current one plays, so speech starts once the
+  /// first clause exists. The newest reply is spoken; a newer one, a
+  /// cancelled reply or [interruptTts] cuts it off. Returns false if it
+  /// could not start (the reason arrives as an error on [ttsEvents]).
+  bool startTts({
+    int firstChunkMinChars = 24,
+    int clauseMinChars = 80,
+    int maxChunkChars = 240,
+  }) {
+    _initializeDartApi(NativeApi.initializeApiDLData);
+    _ttsSubscription ??= _ttsPort.listen((message) {
+      if (message is String) {
+        _ttsController.addError(message);
+      } else if (message is List && message.length >= 2) {
+        final id = message[1] as int;
+        if (message[0] == 'tts_start') {
+          _ttsController.add(TtsEvent(id, done: false));
+        } else if (message[0] == 'tts_done') {
+          _ttsController.add(TtsEvent(id,
+              done: true,
+              interrupted: message.length > 2 && message[2] != 0));
+        }
+      }
+    });
+    _ttsConfigure(firstChunkMinChars, clauseMinChars, maxChunkChars);
+    return _ttsStart(_ttsPort.sendPort.nativePort, 1) != 0;
+  }
+
+  void interruptTts() => _ttsInterrupt();
+
+  void stopTts() => _ttsStop();
+
+  /// Opens a voice turn whose speech ended now, for a VAD that is not the
+  /// native one (which opens its own), and returns its id. The native
+  /// recognizer, LLM and TTS stamp their stages of a turn themselves; the
+  /// app stamps what the platform recognizer and TTS report. A [turnId] of 0
+  /// means the newest turn.
+  int beginTurn() => _traceBeginTurn();
+
+  void markTurn(TurnStage stage, {int turnId = 0}) =>
+      _traceMark(turnId, stage.index);
+
+  /// Makes [requestId] the reply to the turn, so its LLM and TTS stages are
+  /// stamped by request.
+  void attachTurnRequest(int requestId, {int turnId = 0}) =>
+      _traceAttachRequest(turnId, requestId);
+
+  void markTurnRequest(int requestId, TurnStage stage) =>
+      _traceMarkRequest(requestId, stage.index);
+
+  /// Ends the turn answered by [requestId] where it is, e.g. when its reply
+  /// was cut off.
+  void abandonTurnRequest(int requestId) => _traceAbandonRequest(requestId);
+
+  /// Where the time of the finished voice turns went, span by span.
+  Map<TurnSpan, TurnSpanStats> turnSpans() {
+    final spans = malloc<_AiBridgeTurnSpanStats>(TurnSpan.values.length);
+    try {
+      final count = _getTurnSpans(spans, TurnSpan.values.length);
+      return {
+        for (var i = 0; i < count; ++i)
+          TurnSpan.values[i]: TurnSpanStats(spans[i].count, spans[i].meanUs,
+              spans[i].p50Us, spans[i].p90Us, spans[i].p99Us, spans[i].maxUs),
+      };
+    } finally {
+      malloc.free(spans);
+    }
+  }
+
+  /// The recent voice turns as Chrome trace event JSON, for
+  /// chrome://tracing or Perfetto.
+  String dumpTurnTrace() {
+    final length = _traceDumpJson(nullptr, 0);
+    final buffer = malloc<Uint8>(length + 1);
+    try {
+      _traceDumpJson(buffer.cast<Utf8>(), length + 1);
+      return buffer.cast<Utf8>().toDartString(length: length);
+    } finally {
+      malloc.free(buffer);
+    }
+  }
+
+  /// The native counters, gauges and histograms as of now.
+  MetricsSnapshot? snapshotMetrics() {
+    final length = _snapshotMetrics(nullptr, 0);
+    final buffer = malloc<Uint8>(length);
+    try {
+      _snapshotMetrics(buffer, length);
+      return MetricsSnapshot.tryParse(
+          Uint8List.fromList(buffer.asTypedList(length)));
+    } finally {
+      malloc.free(buffer);
+    }
+  }
+
+  /// Has the native side post a snapshot to [metricsSnapshots] (after
+  /// [start]), for periodic export without copying it on this isolate.
+  bool postMetricsSnapshot() =>
+      _postMetricsSnapshot(_metricsPort.sendPort.nativePort) != 0;
+
+  bool _withNativePath(String path, int Function(Pointer<Utf8>) call) {
+    final nativePath = path.toNativeUtf8();
+    try {
+      return call(nativePath) != 0;
+    } finally {
+      malloc.free(nativePath);
+    }
+  }
+
+  void _onTokenMessage(dynamic message) {
+    if (message is! List) return;
+    if (message.length == 3 && message[0] == 'reply_end') {
+      final requestId = message[1] as int;
+      final status = message[2] as int;
+      _utf8Sinks.remove(requestId)?.close();
+      _replyDoneController.add(ReplyEnd(requestId,
+          ReplyStatus.values[status.clamp(0, ReplyStatus.values.length - 1)]));
+    } else if (message.length == 2) {
+      final requestId = message[0] as int;
+      final text = message[1];
+      if (text is Uint8List) {
+        _utf8Sinks
+            .putIfAbsent(
+                requestId,
+                () => const Utf8Decoder(allowMalformed: true)
+                    .startChunkedConversion(
+                        _ControllerSink(_tokenController, requestId)))
+            .addSlice(text, 0, text.length, false);
+      } else if (text is String) {
+        _tokenController.add(ReplyChunk(requestId, text));
+      }
+    }
+  }
+
+  void dispose() {
+    _ttsStop();
+    _asrStop();
+    _vadStop();
+    _disposeLlm();
+    _tokenPort.close();
+    _errorPort.close();
+    _metricsPort.close();
+    _vadPort.close();
+    _asrPort.close();
+    _ttsPort.close();
+    for (final sink in _utf8Sinks.values) {
+      sink.close();
+    }
+    _utf8Sinks.clear();
+    _tokenController.close();
+    _replyDoneController.close();
+    _errorController.close();
+    _metricsController.close();
+    _metricsSnapshotController.close();
+    _vadController.close();
+    _asrController.close();
+    _ttsController.close();
+  }
+}
+
+class _ControllerSink implements Sink<String> {
+  _ControllerSink(this._controller, this._requestId);
+
+  final StreamController<ReplyChunk> _controller;
+  final int _requestId;
+
+  @override
+  void add(String data) {
+    if (data.isNotEmpty) _controller.add(ReplyChunk(_requestId, data));
+  }
+
+  @override
+  void close() {}
+}
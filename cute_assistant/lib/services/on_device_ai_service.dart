@@ -1,13 +1,10 @@
 // Simplified OnDeviceAIService
-// LLM integration is commented out. The service now echoes user input back
-// to the chat and TTS. Once the native bridge is ready, replace the marked
-// sections with real FFI calls.
+// User text goes to the native ai_bridge LLM loop over FFI when the library
+// is available; otherwise the service echoes the input back to the chat and
+// TTS.
 
 import 'dart:async';
-import 'dart:io' show Platform;
-// import 'dart:ffi'; // TODO: Re‑enable when native bridge is ready
 
-import 'package:ffi/ffi.dart';
 import 'package:flutter_tts/flutter_tts.dart';
 import 'package:permission_handler/permission_handler.dart';
 import 'package:speech_to_text/speech_to_text.dart' as stt;
@@ -16,11 +13,12 @@ import 'package:speech_to_text/speech_recognition_error.dart';
 import 'package:vad/vad.dart';
 
 import '../vad/vad_settings.dart'; // Adjust import to your path
+import 'ai_bridge_ffi.dart';
 
 /// TTS playback state
 enum TtsState { playing, stopped, paused, continued }
 
-/// Core service that wires together VAD → STT → (LLM placeholder) → TTS.
+/// Core service that wires together VAD → STT → LLM (native bridge) → TTS.
 class OnDeviceAIService {
   // -------- Public streams for the UI layer --------
   final _transcriptController = StreamController<String>.broadcast();
@@ -38,10 +36,32 @@ class OnDeviceAIService {
   final stt.SpeechToText _stt = stt.SpeechToText();
   bool _sttReady = false;
   bool _isVadListening = false;
+  // VAD runs inside ai_bridge when it can capture natively (Android 8+),
+  // otherwise through the vad package.
+  bool _nativeVad = false;
+  // Transcribe the native VAD's speech in ai_bridge instead of starting the
+  // platform recognizer after every utterance. Off until ASR weights ship:
+  // the native recognizer is a placeholder model for now.
+  bool useNativeAsr = false;
+  bool _nativeAsr = false;
   bool _isSttListening = false;
 
   final FlutterTts _tts = FlutterTts();
   TtsState _ttsState = TtsState.stopped;
+  // Speak replies in ai_bridge while they are generated instead of handing
+  // the finished reply to FlutterTts. Off until TTS weights ship: the
+  // native voice is a placeholder for now.
+  bool useNativeTts = false;
+  bool _nativeTts = false;
+
+  // Null when libai_bridge is not bundled for this platform.
+  final AiBridge? _bridge = AiBridge.tryOpen();
+  final _reply = StringBuffer();
+  // Request whose reply is streaming or being spoken; 0 when idle.
+  int _activeRequestId = 0;
+  // Voice turn waiting for its reply to be requested (0: the one the native
+  // VAD opened); null when the next text is not from speech.
+  int? _turnId;
 
   // Settings (exposed so the UI dialog can modify them)
   VadSettings vadSettings = VadSettings();
@@ -54,12 +74,18 @@ class OnDeviceAIService {
     await _initSTT();
     await _initTTS();
     _initVAD();
+    _initLLM();
   }
 
   // ---------------- VAD ----------------
   void _initVAD() {
+    // Barge-in: the user talking over a reply stops generation and playback.
+    _vad.onSpeechStart.listen((_) {
+      if (_activeRequestId != 0 || _ttsState == TtsState.playing) _interrupt();
+    });
     _vad.onSpeechEnd.listen((samples) {
       if (_isVadListening) {
+        _turnId = _bridge?.beginTurn();
         _startSTT();
       }
     });
@@ -67,6 +93,26 @@ class OnDeviceAIService {
       _transcriptController.addError('VAD error: \$err');
       _stopAll();
     });
+    _bridge?.vadEvents.listen((event) {
+      if (event.type == NativeVadEventType.speechStart) {
+        if (_activeRequestId != 0 || _ttsState == TtsState.playing) _interrupt();
+      } else if (event.type == NativeVadEventType.speechEnd &&
+          _isVadListening) {
+        _turnId = 0;
+        if (!_nativeAsr) _startSTT();
+      }
+    }, onError: (err) {
+      // A failed start already fell back to the vad package.
+      if (!_nativeVad) return;
+      _transcriptController.addError('VAD error: $err');
+      _stopAll();
+    });
+    _bridge?.transcripts.listen((transcript) {
+      _transcriptController.add(transcript.text);
+      if (transcript.isFinal && transcript.text.isNotEmpty) {
+        _handleText(transcript.text);
+      }
+    }, onError: (err) => _transcriptController.addError('ASR error: $err'));
   }
 
   // ---------------- STT ----------------
@@ -97,6 +143,10 @@ class OnDeviceAIService {
     if (res.finalResult) {
       _isSttListening = false;
       _isOverallListeningController.add(false);
+      final turnId = _turnId;
+      if (turnId != null) {
+        _bridge?.markTurn(TurnStage.transcriptFinal, turnId: turnId);
+      }
       if (res.recognizedWords.isNotEmpty) {
         _handleText(res.recognizedWords);
       }
@@ -114,26 +164,102 @@ class OnDeviceAIService {
     _stopAll();
   }
 
-  // ---------------- LLM Placeholder ----------------
-  Future<void> _handleText(String text) async {
-    // TODO: Replace this block with an FFI call that streams tokens
-    _llmResponseController.add(text); // Echo the user text
-    await _speak(text);
+  // ---------------- LLM ----------------
+  void _initLLM() {
+    final bridge = _bridge;
+    if (bridge == null) return;
+    bridge.tokens.listen((chunk) {
+      if (chunk.requestId != _activeRequestId) return;
+      _reply.write(chunk.text);
+      _llmResponseController.add(chunk.text);
+    });
+    bridge.replyDone.listen((end) {
+      final text = _reply.toString();
+      _reply.clear();
+      if (end.requestId != _activeRequestId) return;
+      if (end.status != ReplyStatus.completed) {
+        _activeRequestId = 0;
+      } else if (_nativeTts) {
+        // Already being spoken; ttsEvents reports when it has played out.
+      } else if (text.trim().isNotEmpty) {
+        _speak(text);
+      } else {
+        _activeRequestId = 0;
+      }
+    });
+    bridge.ttsEvents.listen((event) {
+      if (!event.done) {
+        _ttsState = TtsState.playing;
+        _isSpeakingController.add(true);
+        return;
+      }
+      if (event.requestId == _activeRequestId) _activeRequestId = 0;
+      _ttsState = TtsState.stopped;
+      _isSpeakingController.add(false);
+    }, onError: (err) => _llmResponseController.addError('TTS error: $err'));
+    bridge.errors.listen((err) => _llmResponseController.addError('LLM error: $err'));
+    bridge.start();
+    bridge.setBargeIn(true);
+  }
+
+  Future<void> _handleText(String text, {bool spoken = true}) async {
+    final turnId = spoken ? _turnId : null;
+    _turnId = null;
+    final bridge = _bridge;
+    if (bridge == null) {
+      _llmResponseController.add(text); // Echo the user text
+      await _speak(text);
+      return;
+    }
+    // Reply streams back through _initLLM's listeners, and is spoken as it
+    // streams when the native TTS runs.
+    if (useNativeTts && !_nativeTts) _nativeTts = bridge.startTts();
+    _activeRequestId = bridge.send(text);
+    if (turnId != null && _activeRequestId != 0) {
+      bridge.attachTurnRequest(_activeRequestId, turnId: turnId);
+    }
+  }
+
+  void _interrupt() {
+    final bridge = _bridge;
+    if (bridge != null && _activeRequestId != 0) {
+      bridge.cancel(_activeRequestId);
+      bridge.abandonTurnRequest(_activeRequestId);
+    }
+    _activeRequestId = 0;
+    if (_nativeTts) {
+      bridge?.interruptTts();
+    } else if (_ttsState == TtsState.playing) {
+      _tts.stop();
+    }
   }
 
   // ---------------- TTS ----------------
   Future<void> _initTTS() async {
+    _tts.setCancelHandler(() {
+      _ttsState = TtsState.stopped;
+      _isSpeakingController.add(false);
+    });
     _tts.setStartHandler(() {
+      if (_activeRequestId != 0) {
+        _bridge?.markTurnRequest(_activeRequestId, TurnStage.firstAudio);
+      }
       _ttsState = TtsState.playing;
       _isSpeakingController.add(true);
     });
     _tts.setCompletionHandler(() {
+      if (_activeRequestId != 0) {
+        _bridge?.markTurnRequest(_activeRequestId, TurnStage.audioDone);
+      }
       _ttsState = TtsState.stopped;
+      _activeRequestId = 0;
       _isSpeakingController.add(false);
     });
     _tts.setErrorHandler((msg) {
       _llmResponseController.addError('TTS error: \$msg');
+      if (_activeRequestId != 0) _bridge?.abandonTurnRequest(_activeRequestId);
       _ttsState = TtsState.stopped;
+      _activeRequestId = 0;
       _isSpeakingController.add(false);
     });
     await _tts.setSpeechRate(0.8);
@@ -153,6 +279,20 @@ class OnDeviceAIService {
     }
     _isOverallListeningController.add(true);
     _isVadListening = true;
+    _nativeVad = _bridge?.startVad(
+          frameSamples: vadSettings.frameSamples,
+          minSpeechFrames: vadSettings.minSpeechFrames,
+          preSpeechPadFrames: vadSettings.preSpeechPadFrames,
+          redemptionFrames: vadSettings.redemptionFrames,
+          positiveSpeechThreshold: vadSettings.positiveSpeechThreshold,
+          negativeSpeechThreshold: vadSettings.negativeSpeechThreshold,
+          submitUserSpeechOnPause: vadSettings.submitUserSpeechOnPause,
+        ) ??
+        false;
+    if (_nativeVad) {
+      _nativeAsr = useNativeAsr && _bridge!.startAsr();
+      return;
+    }
     _vad.startListening(
       frameSamples: vadSettings.frameSamples,
       minSpeechFrames: vadSettings.minSpeechFrames,
@@ -170,7 +310,14 @@ class OnDeviceAIService {
 
   void _stopAll() {
     if (_isVadListening) {
-      _vad.stopListening();
+      if (_nativeVad) {
+        _bridge?.stopVad();
+        if (_nativeAsr) _bridge?.stopAsr();
+        _nativeVad = false;
+        _nativeAsr = false;
+      } else {
+        _vad.stopListening();
+      }
       _isVadListening = false;
     }
     if (_isSttListening) {
@@ -182,14 +329,28 @@ class OnDeviceAIService {
 
   Future<void> sendText(String text) async {
     if (text.trim().isEmpty) return;
-    await _handleText(text);
+    await _handleText(text, spoken: false);
   }
 
+  /// Where the time of recent voice turns went, from the end of the user's
+  /// speech to the end of the spoken reply; empty without the native
+  /// library.
+  Map<TurnSpan, TurnSpanStats> turnLatencies() => _bridge?.turnSpans() ?? {};
+
+  /// The recent voice turns as Chrome trace JSON, or null without the native
+  /// library.
+  String? turnTraceJson() => _bridge?.dumpTurnTrace();
+
+  /// Token rates, queue depth and other native counters, or null without the
+  /// native library.
+  MetricsSnapshot? nativeMetrics() => _bridge?.snapshotMetrics();
+
   // ---------------- Cleanup ----------------
   void dispose() {
     _vad.dispose();
     _stt.cancel();
     _tts.stop();
+    _bridge?.dispose();
 
     _transcriptController.close();
     _llmResponseController.close();